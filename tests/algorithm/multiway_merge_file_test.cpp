@@ -0,0 +1,233 @@
+/*******************************************************************************
+ * tests/algorithm/multiway_merge_file_test.cpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <tlx/algorithm/multiway_merge_file.hpp>
+#include <tlx/die.hpp>
+
+//! Item sorted by key only, the payload checks stability.
+struct Item {
+    uint32_t key, payload;
+
+    bool operator < (const Item& other) const { return key < other.key; }
+    bool operator == (const Item& other) const {
+        return key == other.key && payload == other.payload;
+    }
+};
+
+template <typename ValueType>
+void write_file(const std::string& path, const std::vector<ValueType>& v) {
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(v.data()),
+              static_cast<std::streamsize>(v.size() * sizeof(ValueType)));
+    die_unless(out.good());
+}
+
+std::string run_path(size_t i) {
+    return "multiway_merge_file_test_" + std::to_string(i) + ".dat";
+}
+
+//! Writes num_runs sorted runs of random length, including empty ones, merges
+//! them with multiway_merge_files(), and compares with std::stable_sort.
+void test_merge_files(size_t num_runs, size_t max_length, size_t block_size,
+                      size_t read_ahead, size_t io_threads) {
+    std::mt19937 prng(static_cast<unsigned>(num_runs * 31 + block_size));
+    std::vector<std::string> paths;
+    std::vector<Item> all;
+
+    for (size_t r = 0; r < num_runs; ++r) {
+        std::vector<Item> run(prng() % (max_length + 1));
+        for (Item& x : run) {
+            x.key = prng() % 1000;
+            x.payload = static_cast<uint32_t>(r);
+        }
+        std::sort(run.begin(), run.end());
+        all.insert(all.end(), run.begin(), run.end());
+        paths.push_back(run_path(r));
+        write_file(paths.back(), run);
+    }
+    std::stable_sort(all.begin(), all.end());
+
+    const std::string output = run_path(num_runs);
+    size_t count = tlx::multiway_merge_files<Item, /* Stable */ true>(
+        paths, output, std::less<Item>(), block_size, read_ahead, io_threads);
+    die_unequal(count, all.size());
+
+    // read the output back with a FileBlockReader
+    {
+        tlx::ThreadPool pool(1);
+        tlx::FileBlockReader<Item> reader(output, pool, block_size, 1);
+        die_unequal(reader.size(), all.size());
+        for (const Item& x : all) {
+            die_unless(!reader.empty());
+            die_unless(reader.current() == x);
+            reader.advance();
+        }
+        die_unless(reader.empty());
+    }
+
+    for (const std::string& p : paths) std::remove(p.c_str());
+    std::remove(output.c_str());
+}
+
+//! Merges in-memory streams and file readers into a lambda sink.
+void test_stream_merge() {
+    tlx::ThreadPool pool(2);
+    std::vector<std::vector<uint64_t> > runs(5);
+    std::vector<uint64_t> all;
+    std::mt19937_64 prng(7);
+    for (size_t r = 0; r < runs.size(); ++r) {
+        runs[r].resize(1000 + 100 * r);
+        for (uint64_t& x : runs[r]) x = prng() % 100000;
+        std::sort(runs[r].begin(), runs[r].end(), std::greater<uint64_t>());
+        write_file(run_path(r), runs[r]);
+        all.insert(all.end(), runs[r].begin(), runs[r].end());
+    }
+    std::sort(all.begin(), all.end(), std::greater<uint64_t>());
+
+    std::vector<tlx::FileBlockReader<uint64_t> > readers;
+    for (size_t r = 0; r < runs.size(); ++r)
+        readers.emplace_back(run_path(r), pool, 64 * sizeof(uint64_t), 3);
+
+    std::vector<uint64_t> out;
+    size_t count = tlx::stream_multiway_merge(
+        readers.begin(), readers.end(),
+        [&out](const uint64_t& x) { out.push_back(x); },
+        std::greater<uint64_t>());
+    die_unequal(count, all.size());
+    die_unless(out == all);
+
+    for (size_t r = 0; r < runs.size(); ++r) std::remove(run_path(r).c_str());
+}
+
+//! A stream with only the interface documented by stream_multiway_merge().
+struct VectorStream {
+    using value_type = uint64_t;
+
+    std::vector<uint64_t> items;
+    size_t pos = 0;
+
+    bool empty() const { return pos == items.size(); }
+    const uint64_t& current() const { return items[pos]; }
+    void advance() { ++pos; }
+};
+
+//! Merges file readers and writes the output from inside a job of their own
+//! one-thread pool, whose I/O jobs are then run by the waiting thread, and
+//! merges custom streams.
+void test_merge_in_pool() {
+    tlx::ThreadPool pool(1);
+    std::vector<uint64_t> all;
+    std::vector<VectorStream> streams(4);
+    for (size_t r = 0; r < streams.size(); ++r) {
+        for (uint64_t i = 0; i < 500 * r; ++i)
+            streams[r].items.push_back(i * streams.size() + r);
+        write_file(run_path(r), streams[r].items);
+        all.insert(all.end(), streams[r].items.begin(), streams[r].items.end());
+    }
+    std::sort(all.begin(), all.end());
+
+    size_t count = 0;
+    pool.enqueue(
+        [&]() {
+            std::vector<tlx::FileBlockReader<uint64_t> > readers;
+            for (size_t r = 0; r < streams.size(); ++r)
+                readers.emplace_back(run_path(r), pool, 100, 2);
+            tlx::FileBlockWriter<uint64_t> writer(
+                run_path(streams.size()), pool, 100, 2);
+            count = tlx::stream_multiway_merge(
+                readers.begin(), readers.end(), writer);
+            writer.close();
+        });
+    pool.loop_until_empty();
+    die_unequal(count, all.size());
+
+    {
+        tlx::FileBlockReader<uint64_t> reader(
+            run_path(streams.size()), pool, 100, 2);
+        std::vector<uint64_t> out;
+        for ( ; !reader.empty(); reader.advance())
+            out.push_back(reader.current());
+        die_unless(out == all);
+    }
+
+    std::vector<uint64_t> out;
+    die_unequal(tlx::stream_multiway_merge(
+                    streams.begin(), streams.end(),
+                    [&out](const uint64_t& x) { out.push_back(x); }),
+                all.size());
+    die_unless(out == all);
+
+    for (size_t r = 0; r <= streams.size(); ++r)
+        std::remove(run_path(r).c_str());
+}
+
+//! Files whose size is not a multiple of the item size, or which do not exist,
+//! are rejected, and reads beyond the end of a file fail.
+void test_errors() {
+    tlx::ThreadPool pool(1);
+    write_file(run_path(0), std::vector<char>(7));
+
+    bool thrown = false;
+    try {
+        tlx::FileBlockReader<uint32_t> reader(run_path(0), pool);
+    }
+    catch (std::runtime_error&) {
+        thrown = true;
+    }
+    die_unless(thrown);
+
+    // reads beyond the end of a file name the offset and size
+    thrown = false;
+    try {
+        tlx::BlockFile file(run_path(0), false);
+        char buffer[8];
+        file.read(buffer, 8, 2);
+    }
+    catch (std::runtime_error& e) {
+        thrown = std::string(e.what()).find("8 bytes at offset 2") !=
+                 std::string::npos;
+    }
+    die_unless(thrown);
+    std::remove(run_path(0).c_str());
+
+    thrown = false;
+    try {
+        tlx::FileBlockReader<uint32_t> reader(run_path(0), pool);
+    }
+    catch (std::runtime_error&) {
+        thrown = true;
+    }
+    die_unless(thrown);
+}
+
+int main() {
+    test_merge_files(1, 1000, 4096, 2, 1);
+    test_merge_files(5, 1000, sizeof(Item), 0, 1);
+    test_merge_files(17, 3000, 3 * sizeof(Item), 1, 2);
+    test_merge_files(100, 500, 1000, 4, 4);
+    test_merge_files(300, 2000, 64 * 1024, 2, 4);
+    test_merge_files(3, 0, 4096, 2, 1);
+    test_stream_merge();
+    test_merge_in_pool();
+    test_errors();
+
+    return 0;
+}
+
+/******************************************************************************/
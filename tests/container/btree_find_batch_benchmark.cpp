@@ -0,0 +1,182 @@
+/*******************************************************************************
+ * tests/container/btree_find_batch_benchmark.cpp
+ *
+ * Benchmark batched BTree lookups using find_batch() against scalar find(), and
+ * the same on a FrozenBTree built by freeze().
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <tlx/cmdline_parser.hpp>
+#include <tlx/container/btree_map.hpp>
+#include <tlx/die.hpp>
+#include <tlx/timestamp.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+//! Traits used for the benchmark, slot counts are the defaults.
+struct btree_traits_bench : tlx::btree_default_traits<
+        uint64_t, std::pair<uint64_t, uint64_t> > {
+    static const bool self_verify = false;
+    static const bool debug = false;
+};
+
+typedef tlx::btree_map<uint64_t, uint64_t, std::less<uint64_t>,
+                       btree_traits_bench> btree_type;
+
+//! number of lookups per find_batch() call
+size_t g_batch = 1024;
+
+//! number of repetitions of the query set
+unsigned g_repeat = 3;
+
+void print_result(const std::string& op, size_t items, size_t queries,
+                  bool sorted, double time, size_t hits) {
+    std::cout << "RESULT"
+              << " op=" << op
+              << " items=" << items
+              << " queries=" << queries
+              << " batch=" << g_batch
+              << " sorted=" << sorted
+              << " hits=" << hits
+              << " time=" << std::fixed << std::setprecision(6) << time
+              << " ns_per_query="
+              << std::setprecision(3) << time * 1e9 / queries
+              << std::endl;
+}
+
+void benchmark(const btree_type& bt, const btree_type::frozen_type& fz,
+               size_t items, std::vector<uint64_t> queries, bool sorted) {
+    if (sorted) {
+        // sort each batch, as a caller with sorted requests would.
+        for (size_t i = 0; i < queries.size(); i += g_batch) {
+            std::sort(queries.begin() + i,
+                      queries.begin() + std::min(i + g_batch, queries.size()));
+        }
+    }
+
+    std::vector<btree_type::const_iterator> results(g_batch);
+    std::vector<btree_type::frozen_type::const_iterator> fz_results(g_batch);
+
+    for (unsigned r = 0; r < g_repeat; ++r)
+    {
+        // scalar find() of each key
+        size_t hits = 0;
+        double ts1 = tlx::timestamp();
+        for (size_t i = 0; i < queries.size(); ++i)
+            hits += (bt.find(queries[i]) != bt.end());
+        double ts2 = tlx::timestamp();
+
+        print_result("find", items, queries.size(), sorted, ts2 - ts1, hits);
+
+        // find_batch() in batches of g_batch keys
+        size_t batch_hits = 0;
+        ts1 = tlx::timestamp();
+        for (size_t i = 0; i < queries.size(); i += g_batch)
+        {
+            size_t n = std::min(g_batch, queries.size() - i);
+            bt.find_batch(queries.begin() + i, queries.begin() + i + n,
+                          results.begin());
+            for (size_t j = 0; j < n; ++j)
+                batch_hits += (results[j] != bt.end());
+        }
+        ts2 = tlx::timestamp();
+
+        print_result("find_batch", items, queries.size(), sorted, ts2 - ts1,
+                     batch_hits);
+
+        die_unequal(hits, batch_hits);
+
+        // scalar find() on the frozen tree
+        size_t fz_hits = 0;
+        ts1 = tlx::timestamp();
+        for (size_t i = 0; i < queries.size(); ++i)
+            fz_hits += (fz.find(queries[i]) != fz.end());
+        ts2 = tlx::timestamp();
+
+        print_result("frozen_find", items, queries.size(), sorted, ts2 - ts1,
+                     fz_hits);
+
+        die_unequal(hits, fz_hits);
+
+        // find_batch() on the frozen tree
+        size_t fz_batch_hits = 0;
+        ts1 = tlx::timestamp();
+        for (size_t i = 0; i < queries.size(); i += g_batch)
+        {
+            size_t n = std::min(g_batch, queries.size() - i);
+            fz.find_batch(queries.begin() + i, queries.begin() + i + n,
+                          fz_results.begin());
+            for (size_t j = 0; j < n; ++j)
+                fz_batch_hits += (fz_results[j] != fz.end());
+        }
+        ts2 = tlx::timestamp();
+
+        print_result("frozen_find_batch", items, queries.size(), sorted,
+                     ts2 - ts1, fz_batch_hits);
+
+        die_unequal(hits, fz_batch_hits);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t min_items = 1024, max_items = 64 * 1024 * 1024;
+    size_t num_queries = 4 * 1024 * 1024;
+
+    tlx::CmdlineParser cp;
+    cp.set_description("TLX BTree find_batch() and freeze() benchmark");
+
+    cp.add_size_t('n', "min-items", min_items,
+                  "minimum number of items in the tree, default: 1024");
+    cp.add_size_t('N', "max-items", max_items,
+                  "maximum number of items in the tree, default: 64 Mi");
+    cp.add_size_t('q', "queries", num_queries,
+                  "number of lookups per benchmark, default: 4 Mi");
+    cp.add_size_t('b', "batch", g_batch,
+                  "number of keys per find_batch() call, default: 1024");
+    cp.add_uint('r', "repeat", g_repeat,
+                "number of repetitions of each benchmark, default: 3");
+
+    if (!cp.process(argc, argv))
+        return EXIT_FAILURE;
+
+    if (g_batch == 0) g_batch = 1;
+
+    for (size_t items = min_items; items <= max_items; items *= 4)
+    {
+        std::mt19937_64 rng(123456);
+
+        // insert even keys, such that half of the queries are misses.
+        std::vector<std::pair<uint64_t, uint64_t> > pairs(items);
+        for (size_t i = 0; i < items; ++i)
+            pairs[i] = std::make_pair(2 * i, i);
+
+        btree_type bt;
+        bt.bulk_load(pairs.begin(), pairs.end());
+        std::vector<std::pair<uint64_t, uint64_t> >().swap(pairs);
+
+        btree_type::frozen_type fz = bt.freeze();
+
+        std::vector<uint64_t> queries(num_queries);
+        for (size_t i = 0; i < num_queries; ++i)
+            queries[i] = rng() % (2 * items);
+
+        benchmark(bt, fz, items, queries, false);
+        benchmark(bt, fz, items, queries, true);
+    }
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,307 @@
+/*******************************************************************************
+ * tests/container/btree_frozen_test.cpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <tlx/container/btree_map.hpp>
+#include <tlx/container/btree_multimap.hpp>
+#include <tlx/container/btree_multiset.hpp>
+#include <tlx/container/btree_set.hpp>
+
+#include <tlx/die.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/******************************************************************************/
+
+//! compare all lookups of a frozen tree against its source B+ tree
+template <typename BTree>
+void check_frozen(const BTree& bt, const typename BTree::frozen_type& fz,
+                  const std::vector<typename BTree::key_type>& queries) {
+    typedef typename BTree::frozen_type frozen_type;
+
+    die_unequal(fz.size(), bt.size());
+    die_unequal(fz.empty(), bt.empty());
+    die_unless(std::equal(bt.begin(), bt.end(), fz.begin()));
+    die_unless(std::equal(bt.rbegin(), bt.rend(), fz.rbegin()));
+    die_unequal(static_cast<size_t>(fz.end() - fz.begin()), bt.size());
+
+    std::vector<typename frozen_type::const_iterator> batch(queries.size());
+    fz.find_batch(queries.begin(), queries.end(), batch.begin());
+
+    for (size_t i = 0; i < queries.size(); ++i)
+    {
+        const typename BTree::key_type& k = queries[i];
+
+        die_unequal(
+            static_cast<size_t>(fz.lower_bound(k) - fz.begin()),
+            static_cast<size_t>(std::distance(bt.begin(), bt.lower_bound(k))));
+        die_unequal(
+            static_cast<size_t>(fz.upper_bound(k) - fz.begin()),
+            static_cast<size_t>(std::distance(bt.begin(), bt.upper_bound(k))));
+        die_unequal(fz.count(k), bt.count(k));
+        die_unequal(fz.exists(k), bt.exists(k));
+
+        typename frozen_type::const_iterator it = fz.find(k);
+        if (bt.exists(k))
+            die_unless(it == fz.lower_bound(k));
+        else
+            die_unless(it == fz.end());
+        die_unless(batch[i] == it);
+
+        die_unless(fz.equal_range(k) ==
+                   std::make_pair(fz.lower_bound(k), fz.upper_bound(k)));
+    }
+}
+
+template <typename KeyType>
+void test_multiset(size_t n, size_t modulo) {
+    typedef tlx::btree_multiset<KeyType> btree_type;
+
+    std::mt19937 rng(1234 + n);
+    btree_type bt;
+    for (size_t i = 0; i < n; ++i)
+        bt.insert(static_cast<KeyType>(rng() % modulo));
+
+    std::vector<KeyType> queries;
+    for (size_t i = 0; i <= modulo + 1 && i < 4000; ++i)
+        queries.push_back(static_cast<KeyType>(i));
+    for (size_t i = 0; i < 1000; ++i)
+        queries.push_back(static_cast<KeyType>(rng() % (modulo + 2)));
+
+    typename btree_type::frozen_type fz = bt.freeze();
+    check_frozen(bt, fz, queries);
+
+    // copy, move and assignment
+    typename btree_type::frozen_type fz2 = fz;
+    check_frozen(bt, fz2, queries);
+    typename btree_type::frozen_type fz3 = std::move(fz2);
+    check_frozen(bt, fz3, queries);
+    fz2 = fz3;
+    check_frozen(bt, fz2, queries);
+}
+
+void test_set_sizes() {
+    // all sizes around the block boundaries of 16 and 8 keys
+    for (size_t n = 0; n < 600; n += (n < 300 ? 1 : 7))
+    {
+        tlx::btree_set<uint32_t> bt;
+        for (uint32_t i = 0; i < n; ++i)
+            bt.insert(3 * i);
+
+        std::vector<uint32_t> queries;
+        for (uint32_t i = 0; i < 3 * n + 3; ++i)
+            queries.push_back(i);
+
+        check_frozen(bt, bt.freeze(), queries);
+
+        tlx::btree_set<double> bd;
+        std::vector<double> dqueries;
+        for (uint32_t i = 0; i < n; ++i)
+            bd.insert(i * 0.5);
+        for (uint32_t i = 0; i < 2 * n + 2; ++i)
+            dqueries.push_back(i * 0.25);
+
+        check_frozen(bd, bd.freeze(), dqueries);
+    }
+}
+
+void test_map() {
+    typedef tlx::btree_map<uint64_t, std::string> btree_type;
+    static_assert(!btree_type::frozen_type::keys_in_values,
+                  "maps store separate keys");
+
+    btree_type bt;
+    std::vector<uint64_t> queries;
+    for (uint64_t i = 0; i < 5000; ++i) {
+        bt.insert2(i * 2, std::to_string(i));
+        queries.push_back(i);
+        queries.push_back(10000 + i);
+    }
+
+    btree_type::frozen_type fz = bt.freeze();
+    check_frozen(bt, fz, queries);
+
+    die_unequal(fz.find(4242)->second, "2121");
+    die_unless(fz.find(4243) == fz.end());
+
+    // memory block is cache line aligned
+    die_unequal(reinterpret_cast<uintptr_t>(&*fz.begin()) % 64, 0u);
+}
+
+void test_strings() {
+    typedef tlx::btree_multimap<std::string, int> btree_type;
+    static_assert(!btree_type::frozen_type::simd_search,
+                  "strings cannot use SIMD");
+
+    btree_type bt;
+    std::vector<std::string> queries;
+    for (int i = 0; i < 3000; ++i) {
+        bt.insert2(std::to_string(i % 700), i);
+        queries.push_back(std::to_string(i));
+    }
+
+    check_frozen(bt, bt.freeze(), queries);
+}
+
+//! check that mapping path fails with a std::runtime_error
+template <typename FrozenType>
+void check_map_fails(const std::string& path) {
+    bool failed = false;
+    try {
+        FrozenType::map_file(path);
+    }
+    catch (std::runtime_error&) {
+        failed = true;
+    }
+    die_unless(failed);
+}
+
+//! read or overwrite the 64-bit field at offset of the file at path
+uint64_t read_field(const std::string& path, size_t offset) {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    in.seekg(static_cast<std::streamoff>(offset));
+    uint64_t value = 0;
+    in.read(reinterpret_cast<char*>(&value), sizeof(value));
+    return value;
+}
+
+void write_field(const std::string& path, size_t offset, uint64_t value) {
+    std::fstream out(path.c_str(),
+                     std::ios::binary | std::ios::in | std::ios::out);
+    out.seekp(static_cast<std::streamoff>(offset));
+    out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void test_file() {
+    typedef tlx::btree_map<uint64_t, uint32_t> btree_type;
+    typedef btree_type::frozen_type frozen_type;
+    typedef tlx::btree_set<uint32_t>::frozen_type set_frozen_type;
+
+    const std::string path = "btree_frozen_test.tmp";
+
+    for (size_t n : { 0, 1, 100, 5000 })
+    {
+        btree_type bt;
+        std::vector<uint64_t> queries;
+        for (size_t i = 0; i < n; ++i) {
+            bt.insert2(3 * i, static_cast<uint32_t>(i));
+            queries.push_back(i);
+            queries.push_back(3 * n - i);
+        }
+
+        bt.freeze().save_file(path);
+
+        frozen_type fz = frozen_type::map_file(path);
+        die_unless(fz.is_mapped());
+        check_frozen(bt, fz, queries);
+
+        // copies are built in memory, moves keep the mapping
+        frozen_type copy = fz;
+        die_unless(!copy.is_mapped());
+        check_frozen(bt, copy, queries);
+
+        frozen_type moved = std::move(fz);
+        die_unless(moved.is_mapped());
+        check_frozen(bt, moved, queries);
+
+        // a file of different types is rejected
+        check_map_fails<set_frozen_type>(path);
+    }
+
+    // saving a mapped tree writes the same tree again
+    {
+        tlx::btree_set<uint32_t> bs;
+        for (uint32_t i = 0; i < 1000; ++i)
+            bs.insert(i * i);
+        bs.freeze().save_file(path);
+
+        set_frozen_type fz = set_frozen_type::map_file(path);
+        fz.save_file(path + "2");
+        set_frozen_type fz2 = set_frozen_type::map_file(path + "2");
+        check_frozen(bs, fz2, std::vector<uint32_t>(bs.begin(), bs.end()));
+        std::remove((path + "2").c_str());
+    }
+
+    // truncated and corrupt files are rejected
+    {
+        std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+        out << "tlxFBT01";
+    }
+    check_map_fails<set_frozen_type>(path);
+    {
+        std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+        out << std::string(8192, 'x');
+    }
+    check_map_fails<set_frozen_type>(path);
+
+
+    // headers and levels not matching the layout of the size are rejected.
+    // The header has eleven fields of 8 bytes: magic, byte_order, key_size,
+    // value_size, block_slots, size, inner_slots, leaf_slots, num_levels,
+    // data_offset and data_size, followed by (offset, children) per level.
+    {
+        std::vector<uint32_t> items(100000);
+        for (size_t i = 0; i < items.size(); ++i)
+            items[i] = static_cast<uint32_t>(2 * i);
+        set_frozen_type fz(items.begin(), items.end());
+
+        fz.save_file(path);
+        uint64_t num_levels = read_field(path, 64);
+        die_unless(num_levels >= 2);
+        for (size_t i = 0; i < num_levels; ++i)
+            write_field(path, 88 + 16 * i + 8, uint64_t(1) << 40);
+        check_map_fails<set_frozen_type>(path);
+
+        const size_t fields[] = { 40, 48, 56, 64, 80 };
+        const uint64_t values[] = { 0, 1, uint64_t(1) << 40, ~uint64_t(0) };
+        for (size_t field : fields)
+        {
+            for (uint64_t value : values)
+            {
+                fz.save_file(path);
+                write_field(path, field, read_field(path, field) + value);
+                if (value != 0)
+                    check_map_fails<set_frozen_type>(path);
+                else
+                    set_frozen_type::map_file(path);
+            }
+        }
+
+        fz.save_file(path);
+        write_field(path, 88, read_field(path, 88) + 1);
+        check_map_fails<set_frozen_type>(path);
+    }
+
+    std::remove(path.c_str());
+    check_map_fails<set_frozen_type>(path);
+}
+
+int main() {
+    test_set_sizes();
+
+    test_multiset<uint32_t>(100000, 1000000);
+    test_multiset<int64_t>(30000, 1000);
+    test_multiset<float>(30000, 100);
+
+    test_map();
+    test_strings();
+
+    test_file();
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -8,12 +8,19 @@
  * All rights reserved. Published under the Boost Software License, Version 1.0
  ******************************************************************************/
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <cstdlib>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <mutex>
 #include <random>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include <set>
 #include <tlx/container/btree_multiset.hpp>
@@ -21,10 +28,16 @@
 #include <unordered_set>
 
 #include <map>
+#include <tlx/container/btree_map.hpp>
 #include <tlx/container/btree_multimap.hpp>
+#include <tlx/container/btree_set.hpp>
+#include <tlx/container/concurrent_btree_map.hpp>
 #include <unordered_map>
 
+#include <tlx/allocator_base.hpp>
+#include <tlx/cmdline_parser.hpp>
 #include <tlx/die.hpp>
+#include <tlx/slab_allocator.hpp>
 #include <tlx/timestamp.hpp>
 
 // *** Settings
@@ -236,6 +249,37 @@ public:
     }
 };
 
+//! Test a generic map type with a mix of erasures and insertions of random
+//! keys at constant size, which frees and allocates nodes all over the tree.
+template <typename MapType>
+class Test_Map_InsertEraseMix
+{
+public:
+    Test_Map_InsertEraseMix(size_t) { }
+
+    static const char * op() { return "map_insert_erase_mix"; }
+
+    void run(size_t items) {
+        MapType map;
+        std::vector<size_t> keys(items);
+
+        std::default_random_engine rng(seed);
+        for (size_t i = 0; i < items; i++) {
+            keys[i] = rng();
+            map.insert(std::make_pair(keys[i], keys[i]));
+        }
+
+        for (size_t i = 0; i < 4 * items; i++) {
+            size_t j = rng() % items;
+            map.erase(map.find(keys[j]));
+            keys[j] = rng();
+            map.insert(std::make_pair(keys[j], keys[j]));
+        }
+
+        die_unless(map.size() == items);
+    }
+};
+
 //! Construct different map types for a generic test class
 template <template <typename MapType> class TestClass>
 struct TestFactory_Map {
@@ -261,6 +305,27 @@ struct TestFactory_Map {
     void call_testrunner(size_t items);
 };
 
+//! Compare the node allocators of the B+ tree on an insert/erase mix.
+struct TestFactory_Alloc {
+    //! B+ tree with std::allocator
+    template <int Slots>
+    using BtreeMap = Test_Map_InsertEraseMix<
+              tlx::btree_multimap<
+                  size_t, size_t, std::less<size_t>,
+                  btree_traits_speed<Slots, Slots> > >;
+
+    //! B+ tree with nodes from slabs
+    template <int Slots>
+    using BtreeMapSlab = Test_Map_InsertEraseMix<
+              tlx::btree_multimap<
+                  size_t, size_t, std::less<size_t>,
+                  btree_traits_speed<Slots, Slots>,
+                  tlx::SlabAllocator<std::pair<size_t, size_t> > > >;
+
+    //! Run tests on both allocators
+    void call_testrunner(size_t items);
+};
+
 // -----------------------------------------------------------------------------
 
 size_t repeat_until;
@@ -381,8 +446,604 @@ void TestFactory_Map<TestClass>::call_testrunner(size_t items) {
 #endif
 }
 
+void TestFactory_Alloc::call_testrunner(size_t items) {
+
+    testrunner_loop<Test_Map_InsertEraseMix<std::multimap<size_t, size_t> > >(
+        items, "std::multimap");
+
+    testrunner_loop<BtreeMap<16> >(
+        items, "tlx::btree_multimap<16> slots=16");
+    testrunner_loop<BtreeMapSlab<16> >(
+        items, "tlx::btree_multimap<16>+slab slots=16");
+    testrunner_loop<BtreeMap<64> >(
+        items, "tlx::btree_multimap<64> slots=64");
+    testrunner_loop<BtreeMapSlab<64> >(
+        items, "tlx::btree_multimap<64>+slab slots=64");
+    testrunner_loop<BtreeMap<256> >(
+        items, "tlx::btree_multimap<256> slots=256");
+    testrunner_loop<BtreeMapSlab<256> >(
+        items, "tlx::btree_multimap<256>+slab slots=256");
+}
+
+// -----------------------------------------------------------------------------
+
+//! Adapter for tlx::btree_map protected by a single global mutex, which is how
+//! the sequential B+ tree has to be shared between threads.
+template <int Slots>
+class LockedBtreeMap
+{
+public:
+    static const char * name() { return "tlx::btree_map+mutex"; }
+
+    bool insert(size_t key, size_t value) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return map_.insert(std::make_pair(key, value)).second;
+    }
+
+    bool find(size_t key) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return map_.find(key) != map_.end();
+    }
+
+    bool erase(size_t key) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return map_.erase(key) != 0;
+    }
+
+    size_t size() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return map_.size();
+    }
+
+private:
+    tlx::btree_map<size_t, size_t, std::less<size_t>,
+                   btree_traits_speed<Slots, Slots> > map_;
+    std::mutex mutex_;
+};
+
+//! Adapter for tlx::concurrent_btree_map.
+template <int Slots>
+class ConcurrentBtreeMap
+{
+public:
+    static const char * name() { return "tlx::concurrent_btree_map"; }
+
+    bool insert(size_t key, size_t value) {
+        return map_.insert(key, value);
+    }
+
+    bool find(size_t key) {
+        return map_.find(key);
+    }
+
+    bool erase(size_t key) {
+        return map_.erase(key);
+    }
+
+    size_t size() {
+        return map_.size();
+    }
+
+private:
+    tlx::concurrent_btree_map<size_t, size_t, std::less<size_t>,
+                              btree_traits_speed<Slots, Slots> > map_;
+};
+
+//! Run func(thread_id) on num_threads threads and return the wall time.
+template <typename Functor>
+double run_threads(size_t num_threads, const Functor& func) {
+    double ts1 = tlx::timestamp();
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t)
+        threads.emplace_back(func, t);
+    for (std::thread& t : threads) t.join();
+    return tlx::timestamp() - ts1;
+}
+
+//! Multi-threaded test: num_threads threads insert, find and erase disjoint
+//! sets of random keys in one shared map.
+template <typename MapType>
+void mt_testrunner(size_t num_threads, size_t items) {
+    MapType map;
+
+    // generate keys for each thread, made disjoint by their residue
+    std::vector<std::vector<size_t> > keys(num_threads);
+    for (size_t t = 0; t < num_threads; ++t) {
+        std::default_random_engine rng(seed + t);
+        keys[t].resize(items / num_threads);
+        for (size_t& k : keys[t])
+            k = static_cast<size_t>(rng()) * num_threads + t;
+    }
+
+    double time_insert = run_threads(
+        num_threads, [&](size_t t) {
+            for (const size_t& k : keys[t]) map.insert(k, k);
+        });
+
+    double time_find = run_threads(
+        num_threads, [&](size_t t) {
+            for (const size_t& k : keys[t]) die_unless(map.find(k));
+        });
+
+    double time_erase = run_threads(
+        num_threads, [&](size_t t) {
+            for (const size_t& k : keys[t]) map.erase(k);
+        });
+
+    die_unless(map.size() == 0);
+
+    size_t total = num_threads * (items / num_threads);
+    const char* ops[3] = { "mt_insert", "mt_find", "mt_erase" };
+    double times[3] = { time_insert, time_find, time_erase };
+
+    for (size_t i = 0; i < 3; ++i) {
+        std::cout << "RESULT"
+                  << " container=" << MapType::name()
+                  << " op=" << ops[i]
+                  << " threads=" << num_threads
+                  << " items=" << total
+                  << " time="
+                  << std::fixed << std::setprecision(10) << times[i]
+                  << " items_per_sec=" << total / times[i]
+                  << std::endl;
+    }
+}
+
+//! Scaling test of the concurrent B+ tree against a mutex-protected btree_map
+//! with thread counts 1, 2, 4, ..., max_threads.
+void mt_speedtest(size_t items, size_t max_threads) {
+    for (size_t p = 1; ; p = std::min(2 * p, max_threads))
+    {
+        std::cout << "map: multi-threaded " << items
+                  << " threads " << p << "\n";
+
+        mt_testrunner<LockedBtreeMap<64> >(p, items);
+        mt_testrunner<ConcurrentBtreeMap<64> >(p, items);
+
+        if (p == max_threads) break;
+    }
+}
+
+// -----------------------------------------------------------------------------
+
+// *** Tuning harness: sweep the node size and binsearch_threshold for a few
+// *** key and value sizes, and report throughput and memory per item.
+
+//! 16-byte key compared lexicographically, which is not searched with SIMD.
+struct Key16 {
+    uint64_t hi, lo;
+
+    bool operator < (const Key16& b) const {
+        return hi < b.hi || (hi == b.hi && lo < b.lo);
+    }
+};
+
+//! Number of bytes currently allocated by all CountingAllocators.
+static size_t counting_bytes = 0;
+
+//! std::allocator replacement counting the bytes allocated by the B+ tree.
+template <typename Type>
+class CountingAllocator : public tlx::AllocatorBase<Type>
+{
+public:
+    //! required rebind.
+    template <typename Other>
+    struct rebind { using other = CountingAllocator<Other>; };
+
+    CountingAllocator() noexcept = default;
+
+    template <typename Other>
+    CountingAllocator(const CountingAllocator<Other>&) noexcept { }
+
+    Type * allocate(size_t n, const void* /* hint */ = nullptr) {
+        counting_bytes += n * sizeof(Type);
+        return static_cast<Type*>(::operator new (n * sizeof(Type)));
+    }
+
+    void deallocate(Type* p, size_t n) noexcept {
+        counting_bytes -= n * sizeof(Type);
+        ::operator delete (p);
+    }
+
+    template <typename Other>
+    bool operator == (const CountingAllocator<Other>&) const noexcept {
+        return true;
+    }
+
+    template <typename Other>
+    bool operator != (const CountingAllocator<Other>&) const noexcept {
+        return false;
+    }
+};
+
+//! Key of a tuning configuration, the value of a set is the key itself.
+template <typename Key>
+Key tune_key(std::mt19937_64& rng) {
+    return static_cast<Key>(rng());
+}
+
+template <>
+Key16 tune_key<Key16>(std::mt19937_64& rng) {
+    Key16 k;
+    k.hi = rng(), k.lo = rng();
+    return k;
+}
+
+//! Traits sized like btree_default_traits, but for a node size of NodeBytes
+//! instead of 256 bytes, and the given binsearch_threshold.
+template <typename Key, typename Value, int NodeBytes, size_t Threshold>
+struct btree_traits_tune : tlx::btree_default_traits<Key, Value> {
+    static const bool self_verify = false;
+    static const bool debug = false;
+
+    static const int leaf_slots =
+        TLX_BTREE_MAX(8, NodeBytes / (sizeof(Value)));
+    static const int inner_slots =
+        TLX_BTREE_MAX(8, NodeBytes / (sizeof(Key) + sizeof(void*)));
+
+    static const size_t binsearch_threshold = Threshold;
+};
+
+//! Result of one tuning configuration.
+struct TuneResult {
+    std::string config;
+    size_t key_size, value_size;
+    int node_bytes;
+    size_t threshold;
+    int leaf_slots, inner_slots;
+    size_t items;
+    //! throughput of insert, find, iterate and erase in items per second
+    double ops[4];
+    double bytes_per_item;
+
+    //! geometric mean of the throughputs, used to pick the best configuration
+    double score() const {
+        return std::pow(ops[0] * ops[1] * ops[2] * ops[3], 0.25);
+    }
+};
+
+static const char* tune_ops[4] = { "insert", "find", "iterate", "erase" };
+
+//! Key of the items of a set or map, which is the item itself for sets.
+template <typename Key>
+const Key& tune_key_of(const Key& k) { return k; }
+
+template <typename Key, typename Data>
+const Key& tune_key_of(const std::pair<Key, Data>& p) { return p.first; }
+
+//! Item of a set or map with the given key.
+template <typename Value, typename Key>
+Value tune_item(const Key& k, std::true_type /* is set */) { return k; }
+
+template <typename Value, typename Key>
+Value tune_item(const Key& k, std::false_type /* is set */) {
+    return Value(k, typename Value::second_type());
+}
+
+//! Run insert, find, iterate and erase of items random keys on one
+//! configuration, taking the best time of repeat runs.
+template <typename Tree>
+TuneResult tune_run(const std::string& config, size_t items, size_t repeat) {
+    typedef typename Tree::key_type key_type;
+    typedef typename Tree::value_type value_type;
+    typedef typename Tree::btree_impl btree_impl;
+    typedef std::is_same<key_type, value_type> is_set;
+
+    std::mt19937_64 rng(seed);
+    std::vector<key_type> keys(items);
+    for (size_t i = 0; i < items; ++i)
+        keys[i] = tune_key<key_type>(rng);
+    std::vector<key_type> order = keys;
+    std::shuffle(order.begin(), order.end(), rng);
+
+    TuneResult r;
+    r.config = config;
+    r.key_size = sizeof(key_type);
+    r.value_size = sizeof(value_type);
+    r.leaf_slots = btree_impl::leaf_slotmax;
+    r.inner_slots = btree_impl::inner_slotmax;
+    r.items = items;
+    std::fill(r.ops, r.ops + 4, 0.0);
+
+    for (size_t rep = 0; rep < repeat; ++rep)
+    {
+        double ts[5];
+        size_t found = 0, visited = 0;
+        Tree tree;
+
+        ts[0] = tlx::timestamp();
+        for (size_t i = 0; i < items; ++i)
+            tree.insert(tune_item<value_type>(keys[i], is_set()));
+        ts[1] = tlx::timestamp();
+        for (size_t i = 0; i < items; ++i)
+            found += tree.find(order[i]) != tree.end();
+        ts[2] = tlx::timestamp();
+        for (typename Tree::const_iterator it = tree.begin();
+             it != tree.end(); ++it)
+            visited += (tune_key_of(*it) < order[0]) ? 1 : 0;
+        ts[3] = tlx::timestamp();
+
+        r.bytes_per_item =
+            static_cast<double>(counting_bytes) / static_cast<double>(items);
+
+        for (size_t i = 0; i < items; ++i)
+            tree.erase(order[i]);
+        ts[4] = tlx::timestamp();
+
+        die_unless(found == items && tree.empty() && visited < items);
+
+        for (size_t op = 0; op < 4; ++op) {
+            r.ops[op] = std::max(
+                r.ops[op], static_cast<double>(items) / (ts[op + 1] - ts[op]));
+        }
+    }
+
+    return r;
+}
+
+//! Tune the node sizes of one key/value configuration.
+template <template <typename Traits> class Tree,
+          typename Key, typename Value, int NodeBytes, size_t Threshold>
+void tune_config(const std::string& config, size_t items, size_t repeat,
+                 std::vector<TuneResult>& results) {
+    typedef btree_traits_tune<Key, Value, NodeBytes, Threshold> traits;
+    TuneResult r = tune_run<Tree<traits> >(config, items, repeat);
+    r.node_bytes = NodeBytes;
+    r.threshold = Threshold;
+    std::cerr << config << " node_bytes=" << NodeBytes
+              << " threshold=" << Threshold
+              << " score=" << r.score() << std::endl;
+    results.push_back(r);
+}
+
+//! Tune one node size with a binary search down to 64 bytes, the default 256
+//! bytes, and a linear scan of the whole node.
+template <template <typename Traits> class Tree,
+          typename Key, typename Value, int NodeBytes>
+void tune_node(const std::string& config, size_t items, size_t repeat,
+               std::vector<TuneResult>& results) {
+    tune_config<Tree, Key, Value, NodeBytes, 64>(
+        config, items, repeat, results);
+    tune_config<Tree, Key, Value, NodeBytes, 256>(
+        config, items, repeat, results);
+    tune_config<Tree, Key, Value, NodeBytes, 256 * 1024 * 1024>(
+        config, items, repeat, results);
+}
+
+//! Sweep all node sizes and thresholds of one key/value configuration.
+template <template <typename Traits> class Tree, typename Key, typename Value>
+void tune_sweep(const std::string& config, size_t items, size_t repeat,
+                std::vector<TuneResult>& results) {
+    tune_node<Tree, Key, Value, 128>(config, items, repeat, results);
+    tune_node<Tree, Key, Value, 256>(config, items, repeat, results);
+    tune_node<Tree, Key, Value, 512>(config, items, repeat, results);
+    tune_node<Tree, Key, Value, 1024>(config, items, repeat, results);
+    tune_node<Tree, Key, Value, 2048>(config, items, repeat, results);
+}
+
+template <typename Key>
+struct TuneSet {
+    template <typename Traits>
+    using type = tlx::btree_set<Key, std::less<Key>, Traits,
+                                CountingAllocator<Key> >;
+};
+
+template <typename Key, typename Data>
+struct TuneMap {
+    template <typename Traits>
+    using type = tlx::btree_map<Key, Data, std::less<Key>, Traits,
+                                CountingAllocator<std::pair<Key, Data> > >;
+};
+
+//! Write the results as CSV with a header line.
+void tune_write_csv(std::ostream& os, const std::vector<TuneResult>& results) {
+    os << "config,key_size,value_size,node_bytes,binsearch_threshold,"
+       << "leaf_slots,inner_slots,items";
+    for (size_t op = 0; op < 4; ++op)
+        os << "," << tune_ops[op] << "_per_sec";
+    os << ",bytes_per_item\n";
+
+    for (const TuneResult& r : results) {
+        os << r.config << "," << r.key_size << "," << r.value_size << ","
+           << r.node_bytes << "," << r.threshold << ","
+           << r.leaf_slots << "," << r.inner_slots << "," << r.items;
+        for (size_t op = 0; op < 4; ++op)
+            os << "," << std::fixed << std::setprecision(0) << r.ops[op];
+        os << "," << std::setprecision(2) << r.bytes_per_item << "\n";
+    }
+}
+
+//! Write the results as a JSON array of objects.
+void tune_write_json(std::ostream& os, const std::vector<TuneResult>& results) {
+    os << "[\n";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const TuneResult& r = results[i];
+        os << "  { \"config\": \"" << r.config << "\""
+           << ", \"key_size\": " << r.key_size
+           << ", \"value_size\": " << r.value_size
+           << ", \"node_bytes\": " << r.node_bytes
+           << ", \"binsearch_threshold\": " << r.threshold
+           << ", \"leaf_slots\": " << r.leaf_slots
+           << ", \"inner_slots\": " << r.inner_slots
+           << ", \"items\": " << r.items;
+        for (size_t op = 0; op < 4; ++op) {
+            os << ", \"" << tune_ops[op] << "_per_sec\": "
+               << std::fixed << std::setprecision(0) << r.ops[op];
+        }
+        os << ", \"bytes_per_item\": " << std::setprecision(2)
+           << r.bytes_per_item << " }"
+           << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "]\n";
+}
+
+//! Write a header with traits using the best configuration for each key and
+//! value size, and the default traits for all other sizes.
+void tune_write_header(std::ostream& os,
+                       const std::vector<TuneResult>& results) {
+    // pick the configuration with the best score for each key/value size
+    std::vector<TuneResult> best;
+    for (const TuneResult& r : results)
+    {
+        size_t i = 0;
+        while (i < best.size() && (best[i].key_size != r.key_size ||
+                                   best[i].value_size != r.value_size))
+            ++i;
+        if (i == best.size())
+            best.push_back(r);
+        else if (r.score() > best[i].score())
+            best[i] = r;
+    }
+
+    os << "// Generated by btree_speedtest --tune with "
+       << (results.empty() ? 0 : results[0].items) << " items.\n"
+       << "\n"
+       << "#ifndef TLX_BTREE_TUNED_TRAITS_HEADER\n"
+       << "#define TLX_BTREE_TUNED_TRAITS_HEADER\n"
+       << "\n"
+       << "#include <tlx/container/btree.hpp>\n"
+       << "\n"
+       << "//! Node size in bytes and binsearch_threshold for each key and "
+       << "value size.\n"
+       << "template <size_t KeySize, size_t ValueSize>\n"
+       << "struct btree_tuned_sizes {\n"
+       << "    static const int node_bytes = 256;\n"
+       << "    static const size_t binsearch_threshold = 256;\n"
+       << "};\n";
+
+    for (const TuneResult& r : best) {
+        os << "\n"
+           << "//! " << r.config << ": " << std::fixed << std::setprecision(0)
+           << r.ops[0] << " inserts/s, " << r.ops[1] << " finds/s, "
+           << std::setprecision(2) << r.bytes_per_item << " bytes/item\n"
+           << "template <>\n"
+           << "struct btree_tuned_sizes<" << r.key_size << ", "
+           << r.value_size << "> {\n"
+           << "    static const int node_bytes = " << r.node_bytes << ";\n"
+           << "    static const size_t binsearch_threshold = "
+           << r.threshold << ";\n"
+           << "};\n";
+    }
+
+    os << "\n"
+       << "//! B+ tree traits with the tuned node sizes of the host.\n"
+       << "template <typename Key, typename Value>\n"
+       << "struct btree_tuned_traits\n"
+       << "    : public tlx::btree_default_traits<Key, Value> {\n"
+       << "    typedef btree_tuned_sizes<sizeof(Key), sizeof(Value)> sizes;\n"
+       << "\n"
+       << "    static const int leaf_slots =\n"
+       << "        TLX_BTREE_MAX(8, sizes::node_bytes / (sizeof(Value)));\n"
+       << "    static const int inner_slots =\n"
+       << "        TLX_BTREE_MAX(8, sizes::node_bytes /\n"
+       << "                      (sizeof(Key) + sizeof(void*)));\n"
+       << "    static const size_t binsearch_threshold =\n"
+       << "        sizes::binsearch_threshold;\n"
+       << "};\n"
+       << "\n"
+       << "#endif // !TLX_BTREE_TUNED_TRAITS_HEADER\n";
+}
+
+//! Run the tuning sweep and write the results and the traits header.
+void tune_speedtest(size_t items, size_t repeat, const std::string& format,
+                    const std::string& output, const std::string& header) {
+    std::vector<TuneResult> results;
+
+    tune_sweep<TuneSet<uint32_t>::type, uint32_t, uint32_t>(
+        "set_u32", items, repeat, results);
+    tune_sweep<TuneSet<uint64_t>::type, uint64_t, uint64_t>(
+        "set_u64", items, repeat, results);
+    tune_sweep<TuneMap<uint64_t, uint64_t>::type,
+               uint64_t, std::pair<uint64_t, uint64_t> >(
+        "map_u64_u64", items, repeat, results);
+    tune_sweep<TuneSet<Key16>::type, Key16, Key16>(
+        "set_k16", items, repeat, results);
+    tune_sweep<TuneMap<Key16, uint64_t>::type,
+               Key16, std::pair<Key16, uint64_t> >(
+        "map_k16_u64", items, repeat, results);
+
+    std::ofstream file;
+    if (!output.empty()) {
+        file.open(output.c_str());
+        die_unless(file.good());
+    }
+    std::ostream& os = output.empty() ? std::cout : file;
+
+    if (format == "json")
+        tune_write_json(os, results);
+    else
+        tune_write_csv(os, results);
+
+    if (!header.empty()) {
+        std::ofstream hfile(header.c_str());
+        die_unless(hfile.good());
+        tune_write_header(hfile, results);
+    }
+}
+
 //! Speed test them!
-int main() {
+int main(int argc, char* argv[]) {
+    tlx::CmdlineParser cp;
+
+    bool multi_threaded = false, alloc_test = false, tune = false;
+    size_t mt_items = 1024000 * 4;
+    size_t mt_threads = std::thread::hardware_concurrency();
+    size_t tune_repeat = 1;
+    std::string tune_format = "csv", tune_output, tune_header;
+
+    cp.add_flag('t', "threads", multi_threaded,
+                "Run the multi-threaded scaling test of "
+                "concurrent_btree_map instead of the sequential tests.");
+    cp.add_flag('a', "alloc", alloc_test,
+                "Run the insert/erase mix of btree_multimap with "
+                "std::allocator and tlx::SlabAllocator instead of the "
+                "sequential tests.");
+    cp.add_flag('T', "tune", tune,
+                "Sweep the node size and binsearch_threshold for several "
+                "key and value sizes, and report the throughput of insert, "
+                "find, iterate and erase, and the memory per item.");
+    cp.add_size_t('n', "items", mt_items,
+                  "Number of items in the multi-threaded and tuning tests, "
+                  "maximum number of items in the allocator test.");
+    cp.add_size_t('r', "repeat", tune_repeat,
+                  "Repetitions of each tuning run, the best is reported.");
+    cp.add_string('f', "format", tune_format,
+                  "Format of the tuning results: csv (default) or json.");
+    cp.add_string('o', "output", tune_output,
+                  "Write the tuning results to this file instead of stdout.");
+    cp.add_string('H', "header", tune_header,
+                  "Write a header with B+ tree traits using the best node "
+                  "sizes of the tuning run to this file.");
+    cp.add_size_t('p', "max-threads", mt_threads,
+                  "Maximum number of threads in the multi-threaded test, "
+                  "default: hardware concurrency.");
+
+    if (!cp.process(argc, argv))
+        return -1;
+
+    if (multi_threaded) {
+        mt_speedtest(mt_items, std::max<size_t>(mt_threads, 1));
+        return 0;
+    }
+
+    if (tune) {
+        tune_speedtest(mt_items, std::max<size_t>(tune_repeat, 1),
+                       tune_format, tune_output, tune_header);
+        return 0;
+    }
+
+    if (alloc_test) {
+        repeat_until = min_items;
+
+        for (size_t items = min_items; items <= mt_items; items *= 4)
+        {
+            std::cout << "map: insert/erase mix " << items << "\n";
+            TestFactory_Alloc().call_testrunner(items);
+        }
+        return 0;
+    }
+
     {   // Set - speed test only insertion
 
         repeat_until = min_items;
@@ -14,11 +14,22 @@
 #include <tlx/container/btree_set.hpp>
 
 #include <tlx/die.hpp>
+#include <tlx/thread_pool.hpp>
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <iostream>
+#include <iterator>
+#include <list>
+#include <numeric>
+#include <random>
 #include <set>
+#include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #if TLX_MORE_TESTS
@@ -1594,11 +1605,1213 @@ void test_bulkload() {
     test_bulkload_map_instance(117649, 100000);
 }
 
+/******************************************************************************/
+// Test Parallel Bulk Load
+
+namespace tlx {
+
+//! Compares the internal structure of two B+ trees, granted access by the
+//! default TLX_BTREE_FRIENDS macro.
+class btree_friend
+{
+public:
+    template <typename Container>
+    static void die_unless_same_tree(const Container& a, const Container& b) {
+        typedef typename Container::btree_impl btree_impl;
+
+        die_unequal(a.tree_.stats_.size, b.tree_.stats_.size);
+        die_unequal(a.tree_.stats_.leaves, b.tree_.stats_.leaves);
+        die_unequal(a.tree_.stats_.inner_nodes, b.tree_.stats_.inner_nodes);
+
+        die_unless((a.tree_.root_ == nullptr) == (b.tree_.root_ == nullptr));
+        if (a.tree_.root_)
+            die_unless_same_node<btree_impl>(a.tree_.root_, b.tree_.root_);
+    }
+
+    template <typename BTree>
+    static void die_unless_same_node(const typename BTree::node* a,
+                                     const typename BTree::node* b) {
+        die_unequal(a->level, b->level);
+        die_unequal(a->slotuse, b->slotuse);
+
+        if (a->is_leafnode()) {
+            typedef typename BTree::LeafNode LeafNode;
+            const LeafNode* la = static_cast<const LeafNode*>(a);
+            const LeafNode* lb = static_cast<const LeafNode*>(b);
+
+            for (unsigned short s = 0; s < la->slotuse; ++s)
+                die_unless(la->slotdata[s] == lb->slotdata[s]);
+            die_unequal(la->next_leaf == nullptr, lb->next_leaf == nullptr);
+            die_unequal(la->prev_leaf == nullptr, lb->prev_leaf == nullptr);
+        }
+        else {
+            typedef typename BTree::InnerNode InnerNode;
+            const InnerNode* ia = static_cast<const InnerNode*>(a);
+            const InnerNode* ib = static_cast<const InnerNode*>(b);
+
+            for (unsigned short s = 0; s < ia->slotuse; ++s)
+                die_unless(ia->slotkey[s] == ib->slotkey[s]);
+            for (unsigned short s = 0; s <= ia->slotuse; ++s) {
+                die_unless_same_node<BTree>(
+                    ia->childid[s], ib->childid[s]);
+            }
+        }
+    }
+
+    //! True if the inner nodes of the B+ tree are not larger than the node
+    //! header, keys and child pointers, hence carry no subtree counts.
+    template <typename Container>
+    static bool inner_node_has_no_counts() {
+        typedef typename Container::btree_impl BTree;
+        typedef typename BTree::InnerNode InnerNode;
+        return sizeof(InnerNode) <=
+               sizeof(typename BTree::node) + sizeof(InnerNode::slotkey) +
+               sizeof(InnerNode::childid) + sizeof(void*);
+    }
+};
+
+} // namespace tlx
+
+void test_bulkload_parallel_set(size_t numkeys, tlx::ThreadPool& pool) {
+    typedef tlx::btree_multiset<
+            unsigned int,
+            std::less<unsigned int>, traits_nodebug<unsigned int> > btree_type;
+
+    std::vector<unsigned int> keys(numkeys);
+
+    std::mt19937 rng(34234235);
+    for (size_t i = 0; i < numkeys; i++)
+        keys[i] = rng() % 10000;
+
+    std::sort(keys.begin(), keys.end());
+
+    btree_type bt1, bt2, bt3;
+    bt1.bulk_load(keys.begin(), keys.end());
+    bt2.bulk_load(keys.begin(), keys.end(), pool);
+    bt3.bulk_load(keys.begin(), keys.end(), 3);
+
+    tlx::btree_friend::die_unless_same_tree(bt1, bt2);
+    tlx::btree_friend::die_unless_same_tree(bt1, bt3);
+
+    die_unless(std::equal(bt2.begin(), bt2.end(), keys.begin()));
+    die_unless(std::equal(bt2.rbegin(), bt2.rend(), keys.rbegin()));
+}
+
+void test_bulkload_parallel_map(size_t numkeys, tlx::ThreadPool& pool) {
+    typedef tlx::btree_map<
+            int, std::string,
+            std::less<int>, traits_nodebug<int> > btree_type;
+
+    std::vector<std::pair<int, std::string> > pairs(numkeys);
+
+    for (size_t i = 0; i < numkeys; i++) {
+        pairs[i].first = static_cast<int>(3 * i);
+        pairs[i].second = std::to_string(i);
+    }
+
+    btree_type bt1, bt2;
+    bt1.bulk_load(pairs.begin(), pairs.end());
+    bt2.bulk_load(pairs.begin(), pairs.end(), pool);
+
+    tlx::btree_friend::die_unless_same_tree(bt1, bt2);
+}
+
+void test_bulkload_parallel() {
+    tlx::ThreadPool pool(4);
+
+    for (size_t n = 0; n < 200; ++n)
+        test_bulkload_parallel_set(n, pool);
+
+    test_bulkload_parallel_set(31996, pool);
+    test_bulkload_parallel_set(117649, pool);
+
+    test_bulkload_parallel_map(0, pool);
+    test_bulkload_parallel_map(7, pool);
+    test_bulkload_parallel_map(32000, pool);
+
+    // bulk_load() waits only for its own jobs, hence it may run in a job of
+    // the same pool, whose only thread is then busy.
+    tlx::ThreadPool single(1);
+    single.enqueue([&single]() { test_bulkload_parallel_set(31996, single); });
+    single.loop_until_empty();
+}
+
+/******************************************************************************/
+// Test Batched Lookup
+
+template <typename BTree>
+void test_find_batch_instance(const BTree& bt,
+                              const std::vector<unsigned int>& queries) {
+    typedef typename BTree::const_iterator const_iterator;
+
+    std::vector<const_iterator> results;
+    bt.find_batch(queries.begin(), queries.end(),
+                  std::back_inserter(results));
+
+    die_unequal(results.size(), queries.size());
+    for (size_t i = 0; i < queries.size(); ++i)
+        die_unless(results[i] == bt.find(queries[i]));
+}
+
+void test_find_batch() {
+    typedef tlx::btree_multiset<
+            unsigned int,
+            std::less<unsigned int>, traits_nodebug<unsigned int> > btree_type;
+
+    std::mt19937 rng(34234235);
+
+    btree_type bt;
+    std::vector<unsigned int> queries;
+
+    // empty tree
+    queries.push_back(42);
+    test_find_batch_instance(bt, queries);
+
+    for (size_t n : { 1, 5, 100, 5000 })
+    {
+        bt.clear();
+        for (size_t i = 0; i < n; ++i)
+            bt.insert(rng() % (2 * n));
+
+        // random unsorted queries, including missing keys
+        queries.clear();
+        for (size_t i = 0; i < 3 * n + 17; ++i)
+            queries.push_back(rng() % (2 * n + 10));
+        test_find_batch_instance(bt, queries);
+
+        // sorted queries with duplicates, which reuse the previous leaf
+        std::sort(queries.begin(), queries.end());
+        test_find_batch_instance(bt, queries);
+
+        // mutable iterators
+        std::vector<btree_type::iterator> results(queries.size());
+        die_unless(bt.find_batch(queries.begin(), queries.end(),
+                                 results.begin()) == results.end());
+        for (size_t i = 0; i < queries.size(); ++i)
+            die_unless(results[i] == bt.find(queries[i]));
+    }
+}
+
+/******************************************************************************/
+// Test Order Statistics
+
+template <typename KeyType>
+struct traits_order_statistics : tlx::btree_default_traits<KeyType, KeyType> {
+    static const bool self_verify = true;
+    static const bool debug = false;
+
+    static const int leaf_slots = 4;
+    static const int inner_slots = 4;
+
+    static const bool order_statistics = true;
+};
+
+//! check rank(), select(), index_of() and count_range() against a sorted
+//! reference vector
+template <typename BTree>
+void check_order_statistics(const BTree& bt,
+                            const std::vector<unsigned int>& ref) {
+    die_unequal(bt.size(), ref.size());
+
+    typename BTree::const_iterator it = bt.begin();
+    for (size_t i = 0; i < ref.size(); ++i, ++it)
+    {
+        die_unless(bt.select(i) == it);
+        die_unequal(bt.index_of(it), i);
+        die_unequal(bt.rank(ref[i]), static_cast<size_t>(
+                        std::lower_bound(ref.begin(), ref.end(), ref[i]) -
+                        ref.begin()));
+    }
+    die_unless(bt.select(ref.size()) == bt.end());
+    die_unequal(bt.index_of(bt.end()), ref.size());
+
+    die_unequal(bt.count_range(bt.begin(), bt.end()), ref.size());
+    if (!ref.empty()) {
+        unsigned int k = ref[ref.size() / 2];
+        die_unequal(bt.count_range(bt.lower_bound(k), bt.upper_bound(k)),
+                    static_cast<size_t>(
+                        std::upper_bound(ref.begin(), ref.end(), k) -
+                        std::lower_bound(ref.begin(), ref.end(), k)));
+    }
+}
+
+void test_order_statistics() {
+    typedef tlx::btree_multiset<
+            unsigned int, std::less<unsigned int>,
+            traits_order_statistics<unsigned int> > btree_type;
+
+    std::mt19937 rng(34234235);
+
+    btree_type bt;
+    std::vector<unsigned int> ref;
+
+    // insertions with many duplicates, which split leaves and inner nodes
+    for (size_t i = 0; i < 2000; ++i) {
+        unsigned int k = rng() % 500;
+        bt.insert(k);
+        ref.insert(std::upper_bound(ref.begin(), ref.end(), k), k);
+    }
+    check_order_statistics(bt, ref);
+
+    // erase by key and by iterator, which merges and shifts nodes
+    for (size_t i = 0; i < 1500; ++i) {
+        unsigned int k = rng() % 500;
+        if (i % 2 == 0) {
+            bool found = bt.erase_one(k);
+            std::vector<unsigned int>::iterator r =
+                std::lower_bound(ref.begin(), ref.end(), k);
+            die_unequal(found, r != ref.end() && *r == k);
+            if (found) ref.erase(r);
+        }
+        else if (!ref.empty()) {
+            size_t idx = rng() % ref.size();
+            bt.erase(bt.select(idx));
+            ref.erase(ref.begin() + idx);
+        }
+    }
+    check_order_statistics(bt, ref);
+
+    // copy construction
+    btree_type bt2 = bt;
+    check_order_statistics(bt2, ref);
+
+    // sequential and parallel bulk_load
+    btree_type bt3, bt4;
+    bt3.bulk_load(ref.begin(), ref.end());
+    check_order_statistics(bt3, ref);
+    bt4.bulk_load(ref.begin(), ref.end(), 2);
+    check_order_statistics(bt4, ref);
+
+    // erase everything
+    while (!ref.empty()) {
+        bt.erase(bt.select(0));
+        ref.erase(ref.begin());
+    }
+    check_order_statistics(bt, ref);
+
+    // without order_statistics, inner nodes carry no counts
+    die_unless(tlx::btree_friend::inner_node_has_no_counts<
+                   tlx::btree_multiset<unsigned int> >());
+    die_unless(!tlx::btree_friend::inner_node_has_no_counts<btree_type>());
+}
+
+/******************************************************************************/
+// Test Copy-on-Write Snapshots
+
+template <typename KeyType, typename ValueType>
+struct traits_copy_on_write : tlx::btree_default_traits<KeyType, ValueType> {
+    static const bool self_verify = true;
+    static const bool debug = false;
+
+    static const int leaf_slots = 4;
+    static const int inner_slots = 4;
+
+    static const bool order_statistics = true;
+    static const bool copy_on_write = true;
+};
+
+//! check iteration and searches of a snapshot against a reference multiset
+template <typename Snapshot>
+void check_snapshot(const Snapshot& snap,
+                    const std::multiset<unsigned int>& ref) {
+    die_unequal(snap.size(), ref.size());
+    die_unequal(snap.empty(), ref.empty());
+    die_unless(std::equal(ref.begin(), ref.end(), snap.begin()));
+    die_unequal(static_cast<size_t>(
+                    std::distance(snap.begin(), snap.end())), ref.size());
+
+    for (unsigned int k = 0; k < 520; k += 7)
+    {
+        die_unequal(snap.count(k), ref.count(k));
+        die_unequal(snap.exists(k), ref.count(k) != 0);
+
+        typename Snapshot::const_iterator si = snap.lower_bound(k);
+        std::multiset<unsigned int>::const_iterator ri = ref.lower_bound(k);
+        die_unless(si == snap.end() ? ri == ref.end() : *si == *ri);
+
+        si = snap.upper_bound(k);
+        ri = ref.upper_bound(k);
+        die_unless(si == snap.end() ? ri == ref.end() : *si == *ri);
+    }
+}
+
+void test_snapshot_multiset() {
+    typedef tlx::btree_multiset<
+            unsigned int, std::less<unsigned int>,
+            traits_copy_on_write<unsigned int, unsigned int> > btree_type;
+    typedef btree_type::snapshot_type snapshot_type;
+
+    std::mt19937 rng(34234235);
+
+    btree_type bt;
+    std::multiset<unsigned int> ref;
+    std::vector<std::pair<snapshot_type, std::multiset<unsigned int> > > snaps;
+
+    for (size_t round = 0; round < 24; ++round)
+    {
+        // take a snapshot, and drop the oldest one once in a while
+        snaps.emplace_back(bt.snapshot(), ref);
+        if (round % 5 == 4) snaps.erase(snaps.begin());
+
+        // insertions with duplicates, erase by key and by iterator. These
+        // split, shift and merge nodes shared with the snapshots.
+        for (size_t i = 0; i < 200; ++i) {
+            unsigned int k = rng() % 500;
+            if (rng() % 3 != 0 || round < 3) {
+                bt.insert(k);
+                ref.insert(k);
+            }
+            else if (i % 2 == 0) {
+                die_unequal(bt.erase_one(k), ref.count(k) != 0);
+                if (ref.count(k)) ref.erase(ref.find(k));
+            }
+            else if (bt.exists(k)) {
+                btree_type::iterator it = bt.upper_bound(k);
+                bt.erase(--it);
+                ref.erase(ref.find(k));
+            }
+        }
+
+        die_unequal(bt.size(), ref.size());
+        die_unless(std::equal(ref.begin(), ref.end(), bt.begin()));
+        die_unless(std::equal(ref.rbegin(), ref.rend(), bt.rbegin()));
+
+        for (size_t s = 0; s < snaps.size(); ++s)
+            check_snapshot(snaps[s].first, snaps[s].second);
+    }
+
+    // copies and assignments share the nodes
+    snapshot_type copy = snaps.back().first;
+    check_snapshot(copy, snaps.back().second);
+    copy = snaps.front().first;
+    check_snapshot(copy, snaps.front().second);
+
+    // erase everything through the tree, then destroy it before the snapshots
+    while (!bt.empty())
+        bt.erase(bt.begin());
+    bt.verify();
+
+    {
+        std::vector<unsigned int> keys(ref.begin(), ref.end());
+        btree_type bt2;
+        bt2.bulk_load(keys.begin(), keys.end());
+        snapshot_type s2 = bt2.snapshot();
+        bt2.clear();
+        check_snapshot(s2, ref);
+    }
+
+    for (size_t s = 0; s < snaps.size(); ++s)
+        check_snapshot(snaps[s].first, snaps[s].second);
+
+    check_snapshot(snapshot_type(), std::multiset<unsigned int>());
+}
+
+void test_snapshot_map() {
+    typedef tlx::btree_map<
+            unsigned int, unsigned int, std::less<unsigned int>,
+            traits_copy_on_write<
+                unsigned int, std::pair<unsigned int, unsigned int> > >
+        btree_type;
+
+    btree_type bt;
+    for (unsigned int i = 0; i < 1000; ++i)
+        bt.insert2(i, i);
+
+    // changing values with operator[] must not show up in the snapshot
+    btree_type::snapshot_type snap = bt.snapshot();
+    for (unsigned int i = 0; i < 1000; i += 3)
+        bt[i] = i + 1;
+
+    unsigned int i = 0;
+    for (btree_type::snapshot_type::const_iterator it = snap.begin();
+         it != snap.end(); ++it, ++i)
+    {
+        die_unequal(it->first, i);
+        die_unequal(it->second, i);
+        die_unequal(bt[i], i % 3 == 0 ? i + 1 : i);
+    }
+    die_unequal(i, 1000u);
+    die_unequal(snap.find(999)->second, 999u);
+    die_unless(snap.find(1000) == snap.end());
+}
+
+//! readers iterate snapshots while the tree is modified concurrently
+void test_snapshot_concurrent() {
+    typedef tlx::btree_set<
+            unsigned int, std::less<unsigned int>,
+            traits_copy_on_write<unsigned int, unsigned int> > btree_type;
+
+    btree_type bt;
+    for (unsigned int i = 0; i < 4000; ++i)
+        bt.insert(2 * i);
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 2; ++t) {
+        btree_type::snapshot_type s = bt.snapshot();
+        threads.emplace_back(
+            [t](btree_type::snapshot_type snap) {
+                for (size_t r = 0; r < 20; ++r) {
+                    unsigned int i = 0;
+                    for (btree_type::snapshot_type::const_iterator it =
+                             snap.begin(); it != snap.end(); ++it, ++i)
+                        die_unequal(*it, 2 * i);
+                    die_unequal(i, 4000u);
+                    die_unless(snap.exists(2 * (r + t)));
+                }
+            }, std::move(s));
+    }
+
+    for (unsigned int i = 0; i < 4000; ++i) {
+        bt.insert(2 * i + 1);
+        bt.erase(2 * i);
+    }
+    for (std::thread& t : threads) t.join();
+
+    die_unequal(bt.size(), 4000u);
+    die_unless(bt.exists(1) && !bt.exists(0));
+}
+
+void test_snapshot() {
+    test_snapshot_multiset();
+    test_snapshot_map();
+    test_snapshot_concurrent();
+}
+
+/******************************************************************************/
+// Test Join, Merge and Split
+
+template <typename KeyType>
+struct traits_join : tlx::btree_default_traits<KeyType, KeyType> {
+    static const bool self_verify = false;
+    static const bool debug = false;
+
+    static const int leaf_slots = 4;
+    static const int inner_slots = 4;
+};
+
+//! insert n keys first, first + step, ... in random order, such that the
+//! nodes are not completely filled as by bulk_load()
+template <typename BTree>
+void fill_random(BTree& bt, std::vector<unsigned int>& ref,
+                 unsigned int first, size_t n, unsigned int step,
+                 std::mt19937& rng) {
+    std::vector<unsigned int> keys;
+    for (size_t i = 0; i < n; ++i)
+        keys.push_back(first + static_cast<unsigned int>(i) * step);
+    ref.insert(ref.end(), keys.begin(), keys.end());
+    std::shuffle(keys.begin(), keys.end(), rng);
+    for (size_t i = 0; i < keys.size(); ++i)
+        bt.insert(keys[i]);
+}
+
+template <typename BTree>
+void check_join_split(const BTree& bt, const std::vector<unsigned int>& ref) {
+    bt.verify();
+    die_unequal(bt.size(), ref.size());
+    die_unequal(bt.get_stats().size, ref.size());
+    die_unless(std::equal(ref.begin(), ref.end(), bt.begin()));
+    die_unless(std::equal(ref.rbegin(), ref.rend(), bt.rbegin()));
+}
+
+template <typename BTree>
+void test_join_split_instance(const std::vector<size_t>& sizes) {
+    std::mt19937 rng(1234);
+
+    // join trees of all combinations of heights, for multisets the last key
+    // of the left tree equals the first key of the right one.
+    for (size_t a : sizes)
+    {
+        for (size_t b : sizes)
+        {
+            BTree x, y;
+            std::vector<unsigned int> ref;
+            fill_random(x, ref, 0, a, 2, rng);
+            unsigned int first = static_cast<unsigned int>(2 * a);
+            if (BTree::allow_duplicates && a > 0) first -= 2;
+            fill_random(y, ref, first, b, 2, rng);
+
+            x.join(y);
+            die_unless(y.empty());
+            check_join_split(x, ref);
+            check_join_split(y, std::vector<unsigned int>());
+        }
+    }
+
+    // split at keys below, inside and above the range, then join again
+    for (size_t n : sizes)
+    {
+        BTree x;
+        std::vector<unsigned int> ref;
+        fill_random(x, ref, 2, n, 2, rng);
+        if (BTree::allow_duplicates)
+            fill_random(x, ref, 2, n, 4, rng);
+        std::sort(ref.begin(), ref.end());
+
+        unsigned int step = std::max<unsigned int>(
+            1, static_cast<unsigned int>(n / 20));
+        for (unsigned int k = 0; k <= 2 * n + 3; k += step)
+        {
+            BTree left = x, right;
+            left.split(k, right);
+
+            std::vector<unsigned int>::iterator mid =
+                std::lower_bound(ref.begin(), ref.end(), k);
+            check_join_split(left, std::vector<unsigned int>(ref.begin(), mid));
+            check_join_split(right, std::vector<unsigned int>(mid, ref.end()));
+
+            left.join(right);
+            check_join_split(left, ref);
+        }
+    }
+}
+
+template <typename BTree>
+void test_merge_instance(size_t n, unsigned int modulo) {
+    std::mt19937 rng(5678);
+
+    BTree x, y;
+    std::multiset<unsigned int> rx, ry;
+    for (size_t i = 0; i < n; ++i) {
+        unsigned int k = rng() % modulo;
+        if (BTree::allow_duplicates || !rx.count(k)) rx.insert(k);
+        x.insert(k);
+        k = rng() % modulo;
+        if (BTree::allow_duplicates || !ry.count(k)) ry.insert(k);
+        y.insert(k);
+    }
+
+    // expected results: sets keep existing keys of other in other
+    std::multiset<unsigned int> ex = rx, ey;
+    for (std::multiset<unsigned int>::const_iterator it = ry.begin();
+         it != ry.end(); ++it) {
+        if (!BTree::allow_duplicates && rx.count(*it))
+            ey.insert(*it);
+        else
+            ex.insert(*it);
+    }
+
+    x.merge(y);
+    check_join_split(x, std::vector<unsigned int>(ex.begin(), ex.end()));
+    check_join_split(y, std::vector<unsigned int>(ey.begin(), ey.end()));
+
+    // merging a tree with smaller keys joins it in front
+    BTree z;
+    std::vector<unsigned int> ref;
+    fill_random(z, ref, modulo, n, 1, rng);
+    z.merge(x);
+    ref.insert(ref.begin(), ex.begin(), ex.end());
+    die_unless(x.empty());
+    check_join_split(z, ref);
+}
+
+void test_join_split_snapshot() {
+    typedef tlx::btree_multiset<
+            unsigned int, std::less<unsigned int>,
+            traits_copy_on_write<unsigned int, unsigned int> > btree_type;
+
+    std::mt19937 rng(42);
+    btree_type x;
+    std::vector<unsigned int> ref;
+    fill_random(x, ref, 0, 300, 1, rng);
+
+    btree_type::snapshot_type snap = x.snapshot();
+
+    btree_type right;
+    x.split(100, right);
+    die_unequal(x.rank(100), 100u);
+    die_unequal(right.size(), 200u);
+    die_unequal(right.rank(250), 150u);
+
+    btree_type y;
+    std::vector<unsigned int> more;
+    fill_random(y, more, 300, 50, 1, rng);
+    btree_type::snapshot_type snap_y = y.snapshot();
+
+    right.join(y);
+    x.join(right);
+    ref.insert(ref.end(), more.begin(), more.end());
+    check_join_split(x, ref);
+    die_unequal(x.rank(320), 320u);
+
+    // the snapshots are unchanged
+    die_unequal(snap.size(), 300u);
+    die_unless(std::equal(snap.begin(), snap.end(), ref.begin()));
+    die_unequal(snap_y.size(), 50u);
+    die_unless(std::equal(snap_y.begin(), snap_y.end(), more.begin()));
+}
+
+void test_join_split_map() {
+    typedef tlx::btree_map<unsigned int, unsigned int, std::less<unsigned int>,
+                           traits_join<unsigned int> > btree_type;
+
+    btree_type x, y;
+    for (unsigned int i = 0; i < 1000; ++i)
+        x.insert2(i, 3 * i);
+
+    x.split(400, y);
+    die_unequal(x.size(), 400u);
+    die_unequal(y.size(), 600u);
+    die_unequal(y.begin()->first, 400u);
+    die_unequal(y.find(999)->second, 2997u);
+    die_unless(x.find(400) == x.end());
+
+    y.merge(x);
+    y.verify();
+    die_unequal(y.size(), 1000u);
+    for (unsigned int i = 0; i < 1000; ++i)
+        die_unequal(y.find(i)->second, 3 * i);
+}
+
+void test_join_split() {
+    typedef tlx::btree_set<unsigned int, std::less<unsigned int>,
+                           traits_join<unsigned int> > set_type;
+    typedef tlx::btree_multiset<unsigned int, std::less<unsigned int>,
+                                traits_join<unsigned int> > multiset_type;
+    typedef tlx::btree_set<unsigned int, std::less<unsigned int>,
+                           traits_order_statistics<unsigned int> > os_type;
+
+    const std::vector<size_t> sizes = {
+        0, 1, 2, 3, 4, 5, 9, 17, 40, 100, 300, 1000, 3000
+    };
+    const std::vector<size_t> small_sizes = { 0, 1, 3, 5, 17, 40, 100 };
+
+    test_join_split_instance<set_type>(sizes);
+    test_join_split_instance<multiset_type>(sizes);
+    test_join_split_instance<os_type>(small_sizes);
+
+    test_merge_instance<set_type>(2000, 3000);
+    test_merge_instance<multiset_type>(2000, 3000);
+
+    test_join_split_snapshot();
+    test_join_split_map();
+}
+
+/******************************************************************************/
+// Test Range Erase and Sorted Insert
+
+//! erase random ranges of positions from a multimap with unique values, which
+//! checks that the right items of runs of equal keys are erased.
+template <typename BTree>
+void test_erase_range_instance(unsigned int n, unsigned int modulo) {
+    typedef std::pair<unsigned int, unsigned int> pair_type;
+    std::mt19937 rng(n + modulo);
+
+    for (size_t round = 0; round < 40; ++round)
+    {
+        BTree bt;
+        for (unsigned int i = 0; i < n; ++i)
+            bt.insert2(rng() % modulo, i);
+        std::vector<pair_type> ref(bt.begin(), bt.end());
+
+        typename BTree::snapshot_type snap = bt.snapshot();
+
+        // every other range is short, which is erased item by item
+        size_t i = rng() % (n + 1), j = rng() % (n + 1);
+        if (i > j) std::swap(i, j);
+        if (round % 2 == 1) j = std::min<size_t>(n, i + rng() % 8);
+
+        typename BTree::iterator first = bt.begin(), last = bt.begin();
+        std::advance(first, i);
+        std::advance(last, j);
+        bt.erase(first, last);
+
+        // the snapshot keeps all items
+        die_unequal(snap.size(), ref.size());
+        die_unless(std::equal(ref.begin(), ref.end(), snap.begin()));
+
+        ref.erase(ref.begin() + i, ref.begin() + j);
+        bt.verify();
+        die_unequal(bt.size(), ref.size());
+        die_unless(std::equal(ref.begin(), ref.end(), bt.begin()));
+        if (!ref.empty())
+            die_unequal(bt.rank(ref.back().first),
+                        static_cast<size_t>(
+                            std::lower_bound(ref.begin(), ref.end(),
+                                             pair_type(ref.back().first, 0)) -
+                            ref.begin()));
+    }
+}
+
+//! insert sorted runs from random access and bidirectional iterators, and
+//! runs appended behind all keys.
+template <typename BTree, typename Reference>
+void test_insert_sorted_instance(unsigned int modulo, size_t max_run) {
+    std::mt19937 rng(modulo);
+    BTree bt;
+    Reference ref;
+
+    for (size_t round = 0; round < 60; ++round)
+    {
+        std::vector<unsigned int> run(rng() % max_run);
+        unsigned int offset = round % 3 == 2 ? modulo * (round / 3) : 0;
+        for (size_t i = 0; i < run.size(); ++i)
+            run[i] = offset + rng() % modulo;
+        std::sort(run.begin(), run.end());
+
+        if (round % 2 == 0) {
+            bt.insert_sorted(run.begin(), run.end());
+        }
+        else {
+            std::list<unsigned int> list(run.begin(), run.end());
+            bt.insert_sorted(list.begin(), list.end());
+        }
+        ref.insert(run.begin(), run.end());
+
+        bt.verify();
+        die_unequal(bt.size(), ref.size());
+        die_unless(std::equal(ref.begin(), ref.end(), bt.begin()));
+    }
+}
+
+void test_erase_range_insert_sorted() {
+    typedef tlx::btree_multimap<
+            unsigned int, unsigned int, std::less<unsigned int>,
+            traits_copy_on_write<
+                unsigned int, std::pair<unsigned int, unsigned int> > >
+        multimap_type;
+
+    test_erase_range_instance<multimap_type>(10, 3);
+    test_erase_range_instance<multimap_type>(300, 20);
+    test_erase_range_instance<multimap_type>(500, 100000);
+    test_erase_range_instance<multimap_type>(600, 2);
+
+    typedef tlx::btree_set<unsigned int, std::less<unsigned int>,
+                           traits_join<unsigned int> > set_type;
+    typedef tlx::btree_multiset<unsigned int, std::less<unsigned int>,
+                                traits_join<unsigned int> > multiset_type;
+    typedef tlx::btree_multiset<unsigned int, std::less<unsigned int>,
+                                traits_order_statistics<unsigned int> >
+        os_type;
+
+    test_insert_sorted_instance<set_type, std::set<unsigned int> >(1000, 300);
+    test_insert_sorted_instance<
+        multiset_type, std::multiset<unsigned int> >(1000, 300);
+    test_insert_sorted_instance<os_type, std::multiset<unsigned int> >(100, 40);
+
+    // sliding window of a time series: append new keys, erase old ones
+    set_type window;
+    for (unsigned int t = 0; t < 100; ++t)
+    {
+        std::vector<unsigned int> run;
+        for (unsigned int i = 0; i < 100; ++i)
+            run.push_back(t * 100 + i);
+        window.insert_sorted(run.begin(), run.end());
+        if (t >= 10)
+            window.erase(window.begin(), window.lower_bound((t - 9) * 100));
+
+        window.verify();
+        die_unequal(window.size(), (t >= 10 ? 10 : t + 1) * 100u);
+        die_unequal(*window.begin(), (t >= 10 ? t - 9 : 0) * 100u);
+    }
+}
+
+/******************************************************************************/
+// Test Subtree Aggregates
+
+//! sum and maximum of the mapped values
+struct SumMaxAggregate {
+    struct type {
+        uint64_t sum;
+        unsigned int max;
+        bool operator == (const type& b) const {
+            return sum == b.sum && max == b.max;
+        }
+    };
+
+    static type identity() { return type { 0, 0 }; }
+    static type item(const std::pair<unsigned int, unsigned int>& v) {
+        return type { v.second, v.second };
+    }
+    static type combine(const type& a, const type& b) {
+        return type { a.sum + b.sum, std::max(a.max, b.max) };
+    }
+};
+
+//! polynomial hash of the sequence of mapped values, which is not commutative
+//! and hence checks that items are combined in key order.
+struct HashAggregate {
+    //! pair of hash value and power of the multiplier
+    typedef std::pair<uint64_t, uint64_t> type;
+
+    static type identity() { return type(0, 1); }
+    static type item(const std::pair<unsigned int, unsigned int>& v) {
+        return type(v.second, 1000003);
+    }
+    static type combine(const type& a, const type& b) {
+        return type(a.first * b.second + b.first, a.second * b.second);
+    }
+};
+
+template <typename Aggregate, bool Shared>
+struct traits_aggregate : tlx::btree_default_traits<
+                              unsigned int,
+                              std::pair<unsigned int, unsigned int> > {
+    static const bool self_verify = false;
+    static const bool debug = false;
+
+    static const int leaf_slots = 4;
+    static const int inner_slots = 4;
+
+    static const bool order_statistics = Shared;
+    static const bool copy_on_write = Shared;
+
+    typedef Aggregate aggregate;
+};
+
+//! compare the aggregates of the whole tree and of random key ranges with
+//! those computed from a sorted reference vector.
+template <typename BTree>
+void check_aggregate(
+    const BTree& bt,
+    const std::vector<std::pair<unsigned int, unsigned int> >& ref,
+    unsigned int modulo, std::mt19937& rng) {
+    typedef typename BTree::btree_impl::aggregate_monoid monoid;
+
+    bt.verify();
+    die_unequal(bt.size(), ref.size());
+
+    typename BTree::aggregate_type all = monoid::identity();
+    for (size_t i = 0; i < ref.size(); ++i)
+        all = monoid::combine(all, monoid::item(ref[i]));
+    die_unless(bt.aggregate() == all);
+
+    for (size_t round = 0; round < 30; ++round)
+    {
+        unsigned int lo = rng() % (modulo + 2), hi = rng() % (modulo + 2);
+        typename BTree::aggregate_type agg = monoid::identity();
+        for (size_t i = 0; i < ref.size(); ++i) {
+            if (ref[i].first >= lo && ref[i].first < hi)
+                agg = monoid::combine(agg, monoid::item(ref[i]));
+        }
+        die_unless(bt.aggregate(lo, hi) == agg);
+    }
+}
+
+template <typename BTree>
+void test_aggregate_instance(unsigned int modulo) {
+    typedef std::pair<unsigned int, unsigned int> pair_type;
+    std::mt19937 rng(modulo);
+    BTree bt;
+    std::vector<pair_type> ref;
+
+    for (size_t round = 0; round < 300; ++round)
+    {
+        switch (round % 6)
+        {
+        case 0: // insert random items
+        case 1:
+            for (unsigned int i = rng() % 50; i != 0; --i)
+                bt.insert(pair_type(rng() % modulo, rng() % 1000));
+            break;
+        case 2: { // erase a key, a single item and a range of items
+            bt.erase(rng() % modulo);
+            if (bt.empty()) break;
+            typename BTree::iterator it = bt.begin();
+            std::advance(it, rng() % bt.size());
+            bt.erase(it);
+            typename BTree::iterator first = bt.begin(), last = bt.begin();
+            std::advance(first, rng() % (bt.size() / 2 + 1));
+            last = first;
+            std::advance(last, std::min<size_t>(
+                             rng() % 20, std::distance(first, bt.end())));
+            bt.erase(first, last);
+            break;
+        }
+        case 3: { // change mapped values in place
+            unsigned int key = rng() % modulo;
+            typename BTree::iterator it = bt.lower_bound(key);
+            for ( ; it != bt.end() && it->first == key; ++it)
+                it->second = rng() % 1000;
+            bt.update_aggregate(key);
+            break;
+        }
+        case 4: { // split and join again
+            BTree right;
+            bt.split(rng() % modulo, right);
+            bt.join(right);
+            break;
+        }
+        case 5: { // merge with a bulk loaded tree or insert a sorted run
+            std::vector<pair_type> run(rng() % 100);
+            for (size_t i = 0; i < run.size(); ++i)
+                run[i] = pair_type(rng() % modulo, rng() % 1000);
+            std::sort(run.begin(), run.end(),
+                      [](const pair_type& a, const pair_type& b) {
+                          return a.first < b.first;
+                      });
+            if (round % 12 == 5) {
+                BTree other;
+                other.bulk_load(run.begin(), run.end());
+                bt.merge(other);
+            }
+            else {
+                bt.insert_sorted(run.begin(), run.end());
+            }
+            break;
+        }
+        }
+
+        bt.verify();
+        ref.assign(bt.begin(), bt.end());
+        check_aggregate(bt, ref, modulo, rng);
+    }
+}
+
+void test_aggregate() {
+    typedef tlx::btree_map<
+            unsigned int, unsigned int, std::less<unsigned int>,
+            traits_aggregate<SumMaxAggregate, false> > map_type;
+    typedef tlx::btree_multimap<
+            unsigned int, unsigned int, std::less<unsigned int>,
+            traits_aggregate<HashAggregate, true> > multimap_type;
+
+    test_aggregate_instance<map_type>(1000);
+    test_aggregate_instance<multimap_type>(100);
+    test_aggregate_instance<multimap_type>(10000);
+
+    // items may be changed via iterators returned by insert(), which copy
+    // the nodes shared with a snapshot.
+    multimap_type bt;
+    for (unsigned int i = 0; i < 1000; ++i)
+        bt.insert2(i % 100, i);
+    multimap_type::snapshot_type snap = bt.snapshot();
+    multimap_type::iterator it = bt.insert2(50, 5);
+    multimap_type::aggregate_type agg = bt.aggregate(10, 90);
+    it->second = 7;
+    bt.update_aggregate(50);
+    die_unless(!(bt.aggregate(10, 90) == agg));
+    die_unequal(snap.size(), 1000u);
+
+    std::mt19937 rng(42);
+    std::vector<std::pair<unsigned int, unsigned int> > ref(
+        bt.begin(), bt.end());
+    check_aggregate(bt, ref, 100, rng);
+
+    // parallel bulk loading computes the aggregates of the inner nodes
+    std::vector<std::pair<unsigned int, unsigned int> > items;
+    for (unsigned int i = 0; i < 20000; ++i)
+        items.emplace_back(i, i % 7);
+    map_type map;
+    map.bulk_load(items.begin(), items.end(), 4);
+    check_aggregate(map, items, 20000, rng);
+    die_unequal(map.aggregate(100, 107).sum, 21u);
+}
+
+/******************************************************************************/
+// Test Partitioning and Parallel Iteration
+
+//! check that partition() returns parts + 1 sorted boundaries covering the
+//! tree, whose ranges are at most max_size large.
+template <typename BTree>
+void check_partition(const BTree& bt, size_t parts, size_t max_size) {
+    std::vector<typename BTree::const_iterator> bounds = bt.partition(parts);
+
+    die_unequal(bounds.size(), parts + 1);
+    die_unless(bounds.front() == bt.begin());
+    die_unless(bounds.back() == bt.end());
+
+    size_t total = 0;
+    for (size_t i = 0; i < parts; ++i)
+    {
+        size_t size = std::distance(bounds[i], bounds[i + 1]);
+        die_unless(size <= max_size);
+        total += size;
+    }
+    die_unequal(total, bt.size());
+}
+
+void test_partition() {
+    typedef tlx::btree_map<unsigned int, unsigned int> map_type;
+    typedef tlx::btree_multiset<unsigned int, std::less<unsigned int>,
+                                traits_order_statistics<unsigned int> >
+        os_type;
+
+    std::mt19937 rng(1234);
+    tlx::ThreadPool pool(4);
+
+    for (size_t n : { 0, 1, 10, 1000, 100000 })
+    {
+        // maps filled in random order and by bulk_load()
+        map_type map, loaded;
+        os_type os;
+        for (size_t i = 0; i < n; ++i)
+            map.insert2(rng(), static_cast<unsigned int>(i));
+        std::vector<std::pair<unsigned int, unsigned int> > items(
+            map.begin(), map.end());
+        loaded.bulk_load(items.begin(), items.end());
+
+        std::vector<unsigned int> keys(n);
+        for (size_t i = 0; i < n; ++i)
+            keys[i] = rng() % 100;
+        std::sort(keys.begin(), keys.end());
+        os.bulk_load(keys.begin(), keys.end());
+
+        for (size_t parts = 1; parts < 40; parts += 3)
+        {
+            check_partition(map, parts, n);
+            // nodes of bulk loaded trees differ in size by at most one item
+            check_partition(loaded, parts, 2 * n / parts + 64);
+            // with order statistics, ranges differ by at most one item
+            check_partition(os, parts, (n + parts - 1) / parts);
+        }
+
+        // visit all items, changing their data in place
+        std::atomic<uint64_t> sum(0);
+        map.parallel_for_each(
+            [&sum](map_type::value_type& v) {
+                v.second += 1;
+                sum += v.second;
+            }, pool);
+        die_unequal(sum.load(), n * (n + 1) / 2);
+
+        sum = 0;
+        const os_type& cos = os;
+        tlx::parallel_for_each(
+            cos, [&sum](const unsigned int& v) { sum += v; }, 3);
+        die_unequal(sum.load(), std::accumulate(os.begin(), os.end(),
+                                                uint64_t(0)));
+
+        // parallel_for_each() may run in a job of the same pool
+        tlx::ThreadPool single(1);
+        sum = 0;
+        single.enqueue([&]() {
+                           cos.parallel_for_each(
+                               [&sum](const unsigned int& v) { sum += v; },
+                               single);
+                       });
+        single.loop_until_empty();
+        die_unequal(sum.load(), std::accumulate(os.begin(), os.end(),
+                                                uint64_t(0)));
+    }
+}
+
+/******************************************************************************/
+// Test SIMD In-Node Search
+
+template <typename KeyType>
+void test_simd_kernels() {
+    std::vector<KeyType> keys;
+    for (int i = -20; i < 20; ++i)
+        keys.push_back(static_cast<KeyType>(i * 3));
+    std::sort(keys.begin(), keys.end());
+
+    for (size_t n = 0; n <= keys.size(); ++n)
+    {
+        for (int i = -70; i < 70; ++i)
+        {
+            KeyType key = static_cast<KeyType>(i);
+            die_unequal(
+                tlx::btree_simd::find_lower(keys.data(), n, key),
+                static_cast<size_t>(
+                    std::lower_bound(keys.begin(), keys.begin() + n, key) -
+                    keys.begin()));
+            die_unequal(
+                tlx::btree_simd::find_upper(keys.data(), n, key),
+                static_cast<size_t>(
+                    std::upper_bound(keys.begin(), keys.begin() + n, key) -
+                    keys.begin()));
+        }
+    }
+}
+
+template <typename KeyType, int Slots>
+struct traits_simd : tlx::btree_default_traits<KeyType, KeyType> {
+    static const bool self_verify = true;
+    static const int leaf_slots = Slots;
+    static const int inner_slots = Slots;
+    // use binary search above two keys to test the hybrid search.
+    static const size_t binsearch_threshold = 2 * sizeof(KeyType);
+};
+
+template <typename KeyType, int Slots>
+void test_simd_multiset(size_t numkeys) {
+    typedef tlx::btree_multiset<
+            KeyType, std::less<KeyType>, traits_simd<KeyType, Slots> >
+        btree_type;
+    static_assert(btree_type::btree_impl::simd_search,
+                  "SIMD search should be enabled");
+
+    btree_type bt;
+    std::multiset<KeyType> set;
+
+    std::default_random_engine rng(34234235);
+    for (size_t i = 0; i < numkeys; ++i)
+    {
+        // use values around zero and the sign bit of the key type
+        KeyType k = static_cast<KeyType>(
+            static_cast<KeyType>(rng() % 1000) - static_cast<KeyType>(500));
+        bt.insert(k);
+        set.insert(k);
+    }
+
+    for (int i = -600; i < 600; ++i)
+    {
+        KeyType k = static_cast<KeyType>(i);
+        die_unless(bt.count(k) == set.count(k));
+        die_unless(bt.exists(k) == (set.find(k) != set.end()));
+
+        typename btree_type::iterator bi = bt.lower_bound(k);
+        typename std::multiset<KeyType>::iterator si = set.lower_bound(k);
+        die_unless(bi == bt.end() ? si == set.end() : *bi == *si);
+
+        bi = bt.upper_bound(k);
+        si = set.upper_bound(k);
+        die_unless(bi == bt.end() ? si == set.end() : *bi == *si);
+    }
+}
+
+void test_simd() {
+    test_simd_kernels<int32_t>();
+    test_simd_kernels<uint32_t>();
+    test_simd_kernels<int64_t>();
+    test_simd_kernels<uint64_t>();
+    test_simd_kernels<float>();
+    test_simd_kernels<double>();
+
+    test_simd_multiset<int32_t, 8>(3200);
+    test_simd_multiset<uint32_t, 13>(3200);
+    test_simd_multiset<int64_t, 16>(3200);
+    test_simd_multiset<uint64_t, 31>(3200);
+    test_simd_multiset<float, 32>(3200);
+    test_simd_multiset<double, 65>(3200);
+
+    // maps cannot use SIMD in leaves, but they do in inner nodes
+    typedef tlx::btree_multimap<
+            uint64_t, std::string,
+            std::less<uint64_t>, traits_nodebug<uint64_t> > btree_map_type;
+    static_assert(btree_map_type::btree_impl::simd_search,
+                  "SIMD search should be enabled");
+
+    btree_map_type bt;
+    for (uint64_t i = 0; i < 3200; ++i)
+        bt.insert2(i * 2, "x");
+    for (uint64_t i = 0; i < 6400; ++i)
+        die_unless(bt.exists(i) == (i % 2 == 0));
+
+    // keys with other comparators must not use SIMD
+    static_assert(
+        !tlx::btree_multiset<
+            uint64_t, std::greater<uint64_t> >::btree_impl::simd_search,
+        "SIMD search should be disabled");
+    static_assert(
+        !tlx::btree_set<std::string>::btree_impl::simd_search,
+        "SIMD search should be disabled");
+}
+
 /******************************************************************************/
 
 int main() {
 
     test_simple();
+    test_simd();
+    test_bulkload_parallel();
+    test_find_batch();
+    test_order_statistics();
+    test_snapshot();
+    test_join_split();
+    test_erase_range_insert_sorted();
+    test_aggregate();
+    test_partition();
     if (tlx_more_tests) {
         test_large();
         test_large_sequence();
@@ -0,0 +1,180 @@
+/*******************************************************************************
+ * tests/container/concurrent_btree_map_test.cpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <tlx/container/concurrent_btree_map.hpp>
+
+#include <tlx/die.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+#if TLX_MORE_TESTS
+static const bool tlx_more_tests = true;
+#else
+static const bool tlx_more_tests = false;
+#endif
+
+/******************************************************************************/
+
+//! small nodes to force deep trees with many splits
+template <typename KeyType>
+struct traits_small : tlx::btree_default_traits<KeyType, KeyType> {
+    static const bool self_verify = false;
+    static const bool debug = false;
+
+    static const int leaf_slots = 8;
+    static const int inner_slots = 8;
+};
+
+//! single-threaded comparison against std::map
+template <typename KeyType>
+void test_sequential(size_t n) {
+    typedef tlx::concurrent_btree_map<
+            KeyType, uint32_t, std::less<KeyType>,
+            traits_small<KeyType> > map_type;
+
+    map_type bt;
+    std::map<KeyType, uint32_t> ref;
+    std::mt19937 rng(1234);
+
+    die_unless(bt.empty());
+
+    for (size_t i = 0; i < n; ++i) {
+        KeyType k = static_cast<KeyType>(rng() % (4 * n));
+        uint32_t v = static_cast<uint32_t>(rng());
+        die_unequal(bt.insert(k, v), ref.insert(std::make_pair(k, v)).second);
+    }
+    bt.verify();
+    die_unequal(bt.size(), ref.size());
+
+    for (size_t k = 0; k < 4 * n; ++k) {
+        uint32_t v = 0;
+        bool found = bt.find(static_cast<KeyType>(k), &v);
+        typename std::map<KeyType, uint32_t>::const_iterator it =
+            ref.find(static_cast<KeyType>(k));
+        die_unequal(found, it != ref.end());
+        if (found) die_unequal(v, it->second);
+    }
+
+    // scan all items and compare with reference
+    {
+        std::vector<KeyType> keys;
+        size_t cnt = bt.scan(
+            KeyType(0), ref.size() + 10,
+            [&](const KeyType& k, const uint32_t& v) {
+                die_unequal(ref[k], v);
+                keys.push_back(k);
+            });
+        die_unequal(cnt, ref.size());
+        die_unless(std::is_sorted(keys.begin(), keys.end()));
+    }
+
+    // scan a limited range from the middle
+    {
+        KeyType from = static_cast<KeyType>(2 * n + 1);
+        typename std::map<KeyType, uint32_t>::const_iterator it =
+            ref.lower_bound(from);
+        size_t cnt = bt.scan(
+            from, 20, [&](const KeyType& k, const uint32_t& v) {
+                die_unless(it != ref.end());
+                die_unequal(k, it->first);
+                die_unequal(v, it->second);
+                ++it;
+            });
+        die_unequal(cnt, std::min<size_t>(
+                        20, std::distance(ref.lower_bound(from), ref.end())));
+    }
+
+    // erase half of the keys
+    for (size_t k = 0; k < 4 * n; k += 2) {
+        die_unequal(bt.erase(static_cast<KeyType>(k)),
+                    ref.erase(static_cast<KeyType>(k)) != 0);
+    }
+    bt.verify();
+    die_unequal(bt.size(), ref.size());
+
+    size_t cnt = bt.scan(
+        KeyType(0), ref.size(), [&](const KeyType& k, const uint32_t&) {
+            die_unless(ref.count(k) == 1);
+        });
+    die_unequal(cnt, ref.size());
+
+    bt.clear();
+    die_unless(bt.empty());
+    bt.verify();
+}
+
+//! concurrent inserts, finds, erases and scans on disjoint key ranges.
+void test_concurrent(size_t num_threads, size_t n) {
+    typedef tlx::concurrent_btree_map<
+            uint64_t, uint64_t, std::less<uint64_t>,
+            traits_small<uint64_t> > map_type;
+
+    map_type bt;
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back(
+            [&bt, t, n, num_threads]() {
+                std::mt19937_64 rng(t);
+
+                // interleaved keys of all threads: k * num_threads + t
+                std::vector<uint64_t> keys(n);
+                for (size_t i = 0; i < n; ++i)
+                    keys[i] = i * num_threads + t;
+                std::shuffle(keys.begin(), keys.end(), rng);
+
+                for (size_t i = 0; i < n; ++i)
+                    die_unless(bt.insert(keys[i], keys[i] + 1));
+
+                for (size_t i = 0; i < n; ++i) {
+                    uint64_t v;
+                    die_unless(bt.find(keys[i], &v));
+                    die_unequal(v, keys[i] + 1);
+                }
+
+                // scans see consistent, sorted items
+                uint64_t last = 0;
+                bt.scan(keys[0], 100,
+                        [&](const uint64_t& k, const uint64_t& v) {
+                            die_unequal(v, k + 1);
+                            die_unless(last <= k);
+                            last = k;
+                        });
+
+                // erase the first half of this thread's keys
+                for (size_t i = 0; i < n / 2; ++i)
+                    die_unless(bt.erase(keys[i]));
+                for (size_t i = 0; i < n; ++i)
+                    die_unequal(bt.exists(keys[i]), i >= n / 2);
+            });
+    }
+    for (std::thread& t : threads) t.join();
+
+    bt.verify();
+    die_unequal(bt.size(), num_threads * (n - n / 2));
+}
+
+int main() {
+    test_sequential<uint32_t>(1000);
+    test_sequential<int64_t>(1000);
+    test_sequential<double>(1000);
+
+    test_concurrent(4, tlx_more_tests ? 100000 : 10000);
+
+    return 0;
+}
+
+/******************************************************************************/
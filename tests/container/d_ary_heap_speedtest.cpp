@@ -8,16 +8,23 @@
  * All rights reserved. Published under the Boost Software License, Version 1.0
  ******************************************************************************/
 
+#include <algorithm>
 #include <chrono>
 #include <cstdlib>
 #include <iomanip>
 #include <iostream>
+#include <random>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <queue>
 #include <tlx/container/d_ary_addressable_int_heap.hpp>
 #include <tlx/container/d_ary_heap.hpp>
+#include <tlx/container/pairing_heap.hpp>
+#include <tlx/slab_allocator.hpp>
 
+#include <tlx/cmdline_parser.hpp>
 #include <tlx/die.hpp>
 #include <tlx/timestamp.hpp>
 
@@ -118,6 +125,11 @@ struct TestFactory_Heap {
     template <int Arity>
     using DAryHeap = TestClass<tlx::DAryHeap<uint32_t, Arity> >;
 
+    //! Test the d-ary heap with SIMD child selection
+    template <int Arity>
+    using DArySimdHeap = TestClass<
+        tlx::DAryHeap<uint32_t, Arity, std::less<uint32_t>, true> >;
+
     //! Test the d-ary heap with a specific arity
     template <int Arity>
     using DAryAIntHeap =
@@ -191,6 +203,13 @@ void TestFactory_Heap<TestClass>::call_testrunner(size_t items) {
     testrunner_loop<DAryHeap<16> >(items, "tlx::DAryHeap<16> slots=16");
     testrunner_loop<DAryHeap<32> >(items, "tlx::DAryHeap<32> slots=32");
 
+    testrunner_loop<DArySimdHeap<4> >(items, "tlx::DArySimdHeap<4> slots=4");
+    testrunner_loop<DArySimdHeap<8> >(items, "tlx::DArySimdHeap<8> slots=8");
+    testrunner_loop<DArySimdHeap<16> >(
+        items, "tlx::DArySimdHeap<16> slots=16");
+    testrunner_loop<DArySimdHeap<32> >(
+        items, "tlx::DArySimdHeap<32> slots=32");
+
     testrunner_loop<DAryAIntHeap<2> >(items, "tlx::DAryAIntHeap<2> slots=2");
     testrunner_loop<DAryAIntHeap<3> >(items, "tlx::DAryAIntHeap<3> slots=3");
     testrunner_loop<DAryAIntHeap<4> >(items, "tlx::DAryAIntHeap<4> slots=4");
@@ -200,8 +219,177 @@ void TestFactory_Heap<TestClass>::call_testrunner(size_t items) {
     testrunner_loop<DAryAIntHeap<32> >(items, "tlx::DAryAIntHeap<32> slots=32");
 }
 
+// -----------------------------------------------------------------------------
+
+//! Random directed graph with edge weights as adjacency array.
+struct Graph {
+    std::vector<size_t> offsets;
+    std::vector<std::pair<uint32_t, uint32_t> > edges;
+
+    Graph(size_t n, size_t m) : offsets(n + 1) {
+        std::mt19937 prng(42);
+        std::vector<std::pair<uint32_t, std::pair<uint32_t, uint32_t> > > e(m);
+        for (auto& x : e) {
+            x.first = prng() % n;
+            x.second = std::make_pair(prng() % n, prng() % 1000 + 1);
+        }
+        std::sort(e.begin(), e.end());
+        for (auto& x : e) {
+            ++offsets[x.first + 1];
+            edges.push_back(x.second);
+        }
+        for (size_t i = 0; i < n; ++i) offsets[i + 1] += offsets[i];
+    }
+
+    size_t num_nodes() const { return offsets.size() - 1; }
+};
+
+//! Dijkstra with a heap of (distance, node) pairs and lazy deletion.
+template <typename HeapType>
+class Test_Dijkstra_Lazy
+{
+public:
+    static const char * op() { return "dijkstra"; }
+
+    static void run(const Graph& g, std::vector<uint64_t>& dist) {
+        HeapType heap;
+        dist[0] = 0, heap.push(std::make_pair(uint64_t(0), uint32_t(0)));
+        while (!heap.empty()) {
+            std::pair<uint64_t, uint32_t> x = heap.top();
+            heap.pop();
+            if (x.first != dist[x.second]) continue;
+            for (size_t i = g.offsets[x.second];
+                 i < g.offsets[x.second + 1]; ++i) {
+                const auto& e = g.edges[i];
+                if (x.first + e.second < dist[e.first]) {
+                    dist[e.first] = x.first + e.second;
+                    heap.push(std::make_pair(dist[e.first], e.first));
+                }
+            }
+        }
+    }
+};
+
+//! Dijkstra with a DAryAddressableIntHeap of nodes ordered by distance.
+template <unsigned Arity>
+class Test_Dijkstra_AInt
+{
+public:
+    static const char * op() { return "dijkstra"; }
+
+    struct DistCompare {
+        const uint64_t* dist;
+        bool operator () (uint32_t a, uint32_t b) const {
+            return dist[a] < dist[b];
+        }
+    };
+
+    static void run(const Graph& g, std::vector<uint64_t>& dist) {
+        tlx::DAryAddressableIntHeap<uint32_t, Arity, DistCompare> heap(
+            DistCompare { dist.data() });
+        dist[0] = 0, heap.push(0);
+        while (!heap.empty()) {
+            uint32_t v = heap.extract_top();
+            for (size_t i = g.offsets[v]; i < g.offsets[v + 1]; ++i) {
+                const auto& e = g.edges[i];
+                if (dist[v] + e.second < dist[e.first]) {
+                    dist[e.first] = dist[v] + e.second;
+                    heap.update(e.first);
+                }
+            }
+        }
+    }
+};
+
+//! Dijkstra with a PairingHeap and decrease_key().
+template <typename Allocator>
+class Test_Dijkstra_Pairing
+{
+public:
+    static const char * op() { return "dijkstra"; }
+
+    static void run(const Graph& g, std::vector<uint64_t>& dist) {
+        using item_type = std::pair<uint64_t, uint32_t>;
+        using heap_type =
+            tlx::PairingHeap<item_type, std::less<item_type>, Allocator>;
+        heap_type heap;
+        std::vector<typename heap_type::handle_type> handles(g.num_nodes());
+        std::vector<bool> done(g.num_nodes());
+
+        dist[0] = 0, handles[0] = heap.push(item_type(0, 0));
+        while (!heap.empty()) {
+            uint32_t v = heap.extract_top().second;
+            done[v] = true;
+            for (size_t i = g.offsets[v]; i < g.offsets[v + 1]; ++i) {
+                const auto& e = g.edges[i];
+                const uint64_t d = dist[v] + e.second;
+                if (done[e.first] || d >= dist[e.first]) continue;
+                dist[e.first] = d;
+                if (handles[e.first])
+                    heap.decrease_key(handles[e.first], item_type(d, e.first));
+                else
+                    handles[e.first] = heap.push(item_type(d, e.first));
+            }
+        }
+    }
+};
+
+//! Run Dijkstra from node 0 and check the result against the first heap.
+template <typename TestClass>
+void dijkstra_runner(const Graph& g, const std::string& container_name,
+                     std::vector<uint64_t>& ref) {
+    std::vector<uint64_t> dist(g.num_nodes(), ~uint64_t(0));
+
+    double ts1 = tlx::timestamp();
+    TestClass::run(g, dist);
+    double ts2 = tlx::timestamp();
+
+    if (ref.empty()) ref = dist;
+    die_unless(dist == ref);
+
+    std::cout << "RESULT"
+              << " container=" << container_name
+              << " op=" << TestClass::op()
+              << " nodes=" << g.num_nodes()
+              << " edges=" << g.edges.size()
+              << " time="
+              << std::fixed << std::setprecision(10) << (ts2 - ts1)
+              << std::endl;
+}
+
+void test_dijkstra(size_t n, size_t m) {
+    using item_type = std::pair<uint64_t, uint32_t>;
+    Graph g(n, m);
+    std::vector<uint64_t> ref;
+
+    dijkstra_runner<Test_Dijkstra_Lazy<
+                        std::priority_queue<
+                            item_type, std::vector<item_type>,
+                            std::greater<item_type> > > >(
+        g, "std::priority_queue", ref);
+    dijkstra_runner<Test_Dijkstra_Lazy<
+                        tlx::DAryHeap<item_type, 4> > >(
+        g, "tlx::DAryHeap<4>", ref);
+    dijkstra_runner<Test_Dijkstra_AInt<2> >(g, "tlx::DAryAIntHeap<2>", ref);
+    dijkstra_runner<Test_Dijkstra_AInt<4> >(g, "tlx::DAryAIntHeap<4>", ref);
+    dijkstra_runner<Test_Dijkstra_Pairing<std::allocator<item_type> > >(
+        g, "tlx::PairingHeap", ref);
+    dijkstra_runner<Test_Dijkstra_Pairing<tlx::SlabAllocator<item_type> > >(
+        g, "tlx::PairingHeap<SlabAllocator>", ref);
+}
+
 //! Speed test them!
-int main() {
+int main(int argc, char* argv[]) {
+    tlx::CmdlineParser cp;
+
+    size_t dijkstra_nodes = 1024 * 1024;
+    cp.add_size_t('n', "dijkstra-nodes", dijkstra_nodes,
+                  "Maximum number of nodes of the Dijkstra graphs, which have "
+                  "up to 16 edges per node, default: 1048576.");
+
+    if (!cp.process(argc, argv))
+        return -1;
+
     // Heap - speed test fill
     {
         repeat_until = min_items;
@@ -232,6 +420,13 @@ int main() {
         }
     }
 
+    // Dijkstra on random graphs with average degree 4 and 16
+    for (size_t n = 1024; n <= dijkstra_nodes; n *= 4) {
+        std::cout << "heap: dijkstra " << n << "\n";
+        test_dijkstra(n, 4 * n);
+        test_dijkstra(n, 16 * n);
+    }
+
     return 0;
 }
 
@@ -9,8 +9,10 @@
  ******************************************************************************/
 
 #include <algorithm>
+#include <map>
 #include <random>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 #include <tlx/container/d_ary_addressable_int_heap.hpp>
@@ -25,11 +27,23 @@ template class DAryHeap<uint16_t>;
 template class DAryHeap<uint32_t>;
 template class DAryHeap<uint64_t>;
 
+template class DAryHeap<int32_t, 8, std::less<int32_t>, true>;
+template class DAryHeap<uint32_t, 8, std::less<uint32_t>, true>;
+template class DAryHeap<int64_t, 4, std::less<int64_t>, true>;
+template class DAryHeap<uint64_t, 4, std::greater<uint64_t>, true>;
+template class DAryHeap<float, 16, std::less<float>, true>;
+template class DAryHeap<double, 8, std::greater<double>, true>;
+
 template class DAryAddressableIntHeap<uint8_t>;
 template class DAryAddressableIntHeap<uint16_t>;
 template class DAryAddressableIntHeap<uint32_t>;
 template class DAryAddressableIntHeap<uint64_t>;
 
+template class DAryAddressableIntHeap<
+        uint32_t, 2, std::less<uint32_t>, DAryHeapHashHandles<uint32_t> >;
+template class DAryAddressableIntHeap<
+        uint64_t, 4, std::less<uint64_t>, DAryHeapHashHandles<uint64_t> >;
+
 } // namespace tlx
 
 /******************************************************************************/
@@ -117,9 +131,9 @@ void fill_heap_and_set(DAryHeap& heap, Set& set, KeysVector& keys) {
 
 //! Basic APIs: push(), top(), and pop().
 template <typename KeyType, unsigned Arity = 2,
-          class Compare = std::less<KeyType> >
+          class Compare = std::less<KeyType>, bool Simd = false>
 void d_ary_heap_test(size_t size, uint32_t r_seed = 42) {
-    tlx::DAryHeap<KeyType, Arity, Compare> x;
+    tlx::DAryHeap<KeyType, Arity, Compare, Simd> x;
     die_unequal(x.size(), 0u);
     die_if(!x.empty());
 
@@ -145,19 +159,40 @@ void d_ary_heap_test(size_t size, uint32_t r_seed = 42) {
     x.build_heap(s.begin(), s.end());
     check_heap(x, s);
 
-    tlx::DAryHeap<KeyType, Arity, Compare> y, z;
+    tlx::DAryHeap<KeyType, Arity, Compare, Simd> y, z;
     y.build_heap(keys);
     check_heap(y, s);
 
+    // Test push_bulk() with batches of growing and of varying size, which
+    // are either sifted up or heapified.
+    tlx::DAryHeap<KeyType, Arity, Compare, Simd> w;
+    for (size_t i = 0, n = 1; i < keys.size(); i += n, n *= 2) {
+        size_t end = std::min(keys.size(), i + n);
+        w.push_bulk(keys.begin() + i, keys.begin() + end);
+        die_unless(w.sanity_check());
+        die_unequal(w.size(), end);
+    }
+    check_heap(w, s);
+
+    w.clear();
+    for (size_t i = 0, n = 1; i < keys.size(); i += n, n = 1 + i * 7 % 23) {
+        size_t end = std::min(keys.size(), i + n);
+        w.push_bulk(keys.begin() + i, keys.begin() + end);
+        die_unless(w.sanity_check());
+        die_unequal(w.size(), end);
+    }
+    check_heap(w, s);
+
     z.build_heap(std::move(keys));
     check_heap(z, s);
 }
 
 //! Basic APIs: push(), top(), pop(), and remove().
 template <typename KeyType, unsigned Arity = 2,
-          class Compare = std::less<KeyType> >
+          class Compare = std::less<KeyType>,
+          class Handles = tlx::DAryHeapDenseHandles<KeyType> >
 void d_ary_addressable_int_heap_test(size_t size, uint32_t r_seed = 42) {
-    tlx::DAryAddressableIntHeap<KeyType, Arity, Compare> x;
+    tlx::DAryAddressableIntHeap<KeyType, Arity, Compare, Handles> x;
     die_unequal(x.size(), 0u);
     die_if(!x.empty());
 
@@ -194,11 +229,37 @@ void d_ary_addressable_int_heap_test(size_t size, uint32_t r_seed = 42) {
     check_heap(x, s);
     check_handles(x, s);
 
-    tlx::DAryAddressableIntHeap<KeyType, Arity, Compare> y, z;
+    tlx::DAryAddressableIntHeap<KeyType, Arity, Compare, Handles> y, z;
     y.build_heap(s.begin(), s.end());
     check_heap(y, s);
     check_handles(y, s);
 
+    // Test push_bulk() with batches of growing and of varying size, which
+    // are either sifted up or heapified.
+    tlx::DAryAddressableIntHeap<KeyType, Arity, Compare, Handles> w;
+    for (size_t i = 0, n = 1; i < keys.size(); i += n, n *= 2) {
+        size_t end = std::min(keys.size(), i + n);
+        w.push_bulk(keys.begin() + i, keys.begin() + end);
+        die_unless(w.sanity_check());
+        die_unequal(w.size(), end);
+    }
+    check_heap(w, s);
+
+    w.clear();
+    for (size_t i = 0, n = 1; i < keys.size(); i += n, n = 1 + i * 7 % 23) {
+        size_t end = std::min(keys.size(), i + n);
+        w.push_bulk(keys.begin() + i, keys.begin() + end);
+        die_unless(w.sanity_check());
+        die_unequal(w.size(), end);
+    }
+    check_heap(w, s);
+    check_handles(w, s);
+
+    // Test build_heap() on a non-empty heap, which drops the old handles.
+    w.build_heap(keys.begin(), keys.begin() + keys.size() / 2);
+    die_unless(w.sanity_check());
+    die_unequal(w.size(), keys.size() / 2);
+
     z.build_heap(std::move(keys));
     check_heap(z, s);
     check_handles(z, s);
@@ -258,6 +319,141 @@ void d_ary_heap_test_update(size_t size, std::vector<double>& prio,
     prio = backup;
 }
 
+//! Compares the SIMD child selection with the scalar loop on short random
+//! sequences with many ties.
+template <typename KeyType, bool Max>
+void d_ary_heap_test_select_child(uint32_t r_seed = 42) {
+    std::mt19937 gen(r_seed);
+    std::uniform_int_distribution<int> dis(-4, 4);
+    std::vector<KeyType> keys(32);
+
+    for (size_t iter = 0; iter < 1000; ++iter) {
+        for (KeyType& k : keys) k = static_cast<KeyType>(dis(gen));
+        for (size_t n = 1; n <= 20; ++n) {
+            die_unequal(
+                (tlx::d_ary_heap_simd::select_child<Max>(keys.data(), n)),
+                (tlx::d_ary_heap_simd::select_scalar<Max>(keys.data(), n)));
+        }
+    }
+}
+
+//! Tests a SIMD heap with duplicate keys against a multiset and checks that
+//! the children of the root start on a cache line.
+template <typename KeyType, unsigned Arity, class Compare>
+void d_ary_heap_test_simd(size_t size, uint32_t r_seed = 42) {
+    tlx::DAryHeap<KeyType, Arity, Compare, true> x;
+    std::multiset<KeyType, Compare> s;
+
+    std::mt19937 gen(r_seed);
+    std::uniform_int_distribution<int> dis(0, static_cast<int>(size / 4));
+
+    for (size_t i = 0; i < size; ++i) {
+        KeyType key = static_cast<KeyType>(dis(gen));
+        x.push(key);
+        s.insert(key);
+        check_heap(x, s);
+    }
+    die_unequal(
+        reinterpret_cast<uintptr_t>(&x.top() + 1) % 64, uintptr_t(0));
+
+    while (!x.empty()) {
+        x.pop();
+        s.erase(s.begin());
+        check_heap(x, s);
+    }
+}
+
+//! Compares the hash handle store with std::unordered_map under random
+//! insertions, updates, and removals of few keys, which produce long probe
+//! sequences and many backward shifts.
+template <typename KeyType>
+void d_ary_heap_test_hash_handles(uint32_t r_seed = 42) {
+    tlx::DAryHeapHashHandles<KeyType> h;
+    std::unordered_map<KeyType, KeyType> m;
+
+    std::mt19937_64 gen(r_seed);
+    std::uniform_int_distribution<size_t> pick(0, 199);
+    std::vector<KeyType> universe(200);
+    for (KeyType& k : universe) {
+        do {
+            k = static_cast<KeyType>(gen());
+        } while (k == h.not_present());
+    }
+
+    for (size_t iter = 0; iter < 20000; ++iter) {
+        KeyType key = universe[pick(gen)];
+        KeyType pos = static_cast<KeyType>(iter);
+        if (m.count(key) && gen() % 2) {
+            h.erase(key);
+            m.erase(key);
+        }
+        else {
+            h.set(key, pos);
+            m[key] = pos;
+        }
+        die_unequal(h.size(), m.size());
+    }
+    for (KeyType key : universe) {
+        die_unequal(h.contains(key), m.count(key) != 0);
+        if (m.count(key))
+            die_unequal(h.get(key), m[key]);
+    }
+}
+
+//! Tests an addressable heap with sparse 64-bit keys and hash handles against
+//! a map of priorities.
+template <unsigned Arity>
+void d_ary_heap_test_sparse(size_t size, uint32_t r_seed = 42) {
+    std::map<uint64_t, double> prio;
+    struct Less {
+        const std::map<uint64_t, double>& prio;
+        bool operator () (uint64_t a, uint64_t b) const {
+            return prio.at(a) < prio.at(b);
+        }
+    };
+    tlx::DAryAddressableIntHeap<
+        uint64_t, Arity, Less, tlx::DAryHeapHashHandles<uint64_t> > x{
+        Less { prio }
+    };
+
+    std::mt19937_64 gen(r_seed);
+    std::uniform_real_distribution<> dis(0.0, 1.0);
+    std::vector<uint64_t> keys;
+    while (keys.size() < size) {
+        uint64_t key = gen();
+        if (key == ~uint64_t(0) || prio.count(key)) continue;
+        prio[key] = dis(gen);
+        keys.push_back(key);
+    }
+
+    x.push_bulk(keys.begin(), keys.begin() + size / 2);
+    for (size_t i = size / 2; i < size; ++i)
+        x.push(keys[i]);
+    die_unless(x.sanity_check());
+    die_unequal(x.size(), size);
+
+    // change priorities, and remove every third key.
+    for (size_t i = 0; i < size; ++i) {
+        if (i % 3 == 0) {
+            x.remove(keys[i]);
+            die_unless(!x.contains(keys[i]));
+        }
+        else {
+            prio[keys[i]] = dis(gen);
+            x.update(keys[i]);
+        }
+    }
+    die_unless(x.sanity_check());
+
+    double last = 0.0;
+    while (!x.empty()) {
+        die_unless(last <= prio[x.top()]);
+        last = prio[x.top()];
+        x.pop();
+    }
+    die_unless(x.sanity_check());
+}
+
 int main() {
     // Size of the tested heaps and random seed.
     size_t size = 100;
@@ -287,6 +483,32 @@ int main() {
     d_ary_heap_test<uint32_t, 2, std::greater<uint32_t> >(size, r_seed);
     d_ary_heap_test<uint64_t, 2, std::greater<uint64_t> >(size, r_seed);
 
+    // Heaps with SIMD child selection.
+    d_ary_heap_test<int32_t, 4, std::less<int32_t>, true>(size, r_seed);
+    d_ary_heap_test<uint32_t, 8, std::less<uint32_t>, true>(size, r_seed);
+    d_ary_heap_test<uint32_t, 16, std::greater<uint32_t>, true>(size, r_seed);
+    d_ary_heap_test<int64_t, 4, std::greater<int64_t>, true>(size, r_seed);
+    d_ary_heap_test<uint64_t, 8, std::less<uint64_t>, true>(size, r_seed);
+    d_ary_heap_test<float, 8, std::less<float>, true>(size, r_seed);
+    d_ary_heap_test<double, 4, std::greater<double>, true>(size, r_seed);
+
+    d_ary_heap_test_select_child<int32_t, false>(r_seed);
+    d_ary_heap_test_select_child<int32_t, true>(r_seed);
+    d_ary_heap_test_select_child<uint32_t, false>(r_seed);
+    d_ary_heap_test_select_child<uint32_t, true>(r_seed);
+    d_ary_heap_test_select_child<int64_t, false>(r_seed);
+    d_ary_heap_test_select_child<int64_t, true>(r_seed);
+    d_ary_heap_test_select_child<uint64_t, false>(r_seed);
+    d_ary_heap_test_select_child<uint64_t, true>(r_seed);
+    d_ary_heap_test_select_child<float, false>(r_seed);
+    d_ary_heap_test_select_child<float, true>(r_seed);
+    d_ary_heap_test_select_child<double, false>(r_seed);
+    d_ary_heap_test_select_child<double, true>(r_seed);
+
+    d_ary_heap_test_simd<uint32_t, 16, std::less<uint32_t> >(1000, r_seed);
+    d_ary_heap_test_simd<int64_t, 8, std::greater<int64_t> >(1000, r_seed);
+    d_ary_heap_test_simd<float, 4, std::less<float> >(1000, r_seed);
+
     // Basic heap API with custom struct.
     d_ary_heap_test<TestData, 2, TestCompare>(size, r_seed);
     d_ary_heap_test<TestData, 3, TestCompare>(size, r_seed);
@@ -315,6 +537,18 @@ int main() {
     d_ary_addressable_int_heap_test<uint32_t, 2, std::greater<uint32_t> >(size, r_seed);
     d_ary_addressable_int_heap_test<uint64_t, 2, std::greater<uint64_t> >(size, r_seed);
 
+    d_ary_addressable_int_heap_test<
+        uint32_t, 2, std::less<uint32_t>, tlx::DAryHeapHashHandles<uint32_t> >(
+        size, r_seed);
+    d_ary_addressable_int_heap_test<
+        uint64_t, 4, std::greater<uint64_t>,
+        tlx::DAryHeapHashHandles<uint64_t> >(size, r_seed);
+
+    d_ary_heap_test_hash_handles<uint16_t>(r_seed);
+    d_ary_heap_test_hash_handles<uint64_t>(r_seed);
+    d_ary_heap_test_sparse<2>(1000, r_seed);
+    d_ary_heap_test_sparse<8>(1000, r_seed);
+
     // Custom compare function.
     std::vector<double> prio(size);
     std::mt19937 gen(r_seed);
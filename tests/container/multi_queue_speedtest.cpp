@@ -0,0 +1,149 @@
+/*******************************************************************************
+ * tests/container/multi_queue_speedtest.cpp
+ *
+ * Throughput of the MultiQueue compared to a single locked DAryHeap.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <tlx/container/d_ary_heap.hpp>
+#include <tlx/container/multi_queue.hpp>
+#include <tlx/timestamp.hpp>
+
+// *** Settings
+
+//! number of items in the queue during the test
+const size_t prefill_items = 1000000;
+
+//! number of pop-push operations of each thread
+const size_t ops_per_thread = 2000000;
+
+// -----------------------------------------------------------------------------
+
+//! A single DAryHeap protected by a mutex, with the handle interface of the
+//! MultiQueue.
+class LockedHeap
+{
+public:
+    LockedHeap(size_t /* num_threads */) { }
+
+    class Handle
+    {
+    public:
+        explicit Handle(LockedHeap& lh) : lh_(lh) { }
+
+        void push(const uint64_t& key) {
+            std::unique_lock<std::mutex> lock(lh_.mutex_);
+            lh_.heap_.push(key);
+        }
+
+        bool try_pop(uint64_t& out) {
+            std::unique_lock<std::mutex> lock(lh_.mutex_);
+            if (lh_.heap_.empty()) return false;
+            out = lh_.heap_.extract_top();
+            return true;
+        }
+
+    private:
+        LockedHeap& lh_;
+    };
+
+    Handle get_handle(size_t /* seed */) { return Handle(*this); }
+
+private:
+    std::mutex mutex_;
+    tlx::DAryHeap<uint64_t, 4> heap_;
+};
+
+//! MultiQueue with fixed parameters.
+template <size_t Factor, size_t Stickiness, size_t BufferSize>
+class MultiQueueConfig : public tlx::MultiQueue<uint64_t, 4>
+{
+public:
+    explicit MultiQueueConfig(size_t num_threads)
+        : tlx::MultiQueue<uint64_t, 4>(
+              num_threads, Factor, Stickiness, BufferSize) { }
+};
+
+// -----------------------------------------------------------------------------
+
+/*!
+ * Hold model benchmark: after a prefill, each thread repeatedly pops an item
+ * and pushes it back with a random positive increment, as in a discrete event
+ * simulation or SSSP.
+ */
+template <typename Queue>
+void test_hold(size_t num_threads, const std::string& name) {
+    Queue queue(num_threads);
+    {
+        auto h = queue.get_handle(0);
+        std::mt19937_64 gen(42);
+        for (size_t i = 0; i < prefill_items; ++i)
+            h.push(gen() % (16 * prefill_items));
+    }
+
+    std::atomic<size_t> failed_pops(0);
+    std::vector<std::thread> threads;
+
+    double ts1 = tlx::timestamp();
+    for (size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back(
+            [&, t]() {
+                auto h = queue.get_handle(t + 1);
+                std::mt19937_64 gen(t);
+                uint64_t x;
+                size_t failed = 0;
+                for (size_t i = 0; i < ops_per_thread; ++i) {
+                    if (!h.try_pop(x)) {
+                        ++failed;
+                        x = 0;
+                    }
+                    h.push(x + 1 + gen() % 1024);
+                }
+                failed_pops += failed;
+            });
+    }
+    for (std::thread& t : threads) t.join();
+    double ts2 = tlx::timestamp();
+
+    std::cout << "RESULT"
+              << " queue=" << name
+              << " threads=" << num_threads
+              << " ops=" << num_threads * ops_per_thread
+              << " failed_pops=" << failed_pops
+              << " time=" << std::fixed << std::setprecision(6) << (ts2 - ts1)
+              << " mops=" << std::setprecision(3)
+              << (num_threads * ops_per_thread / (ts2 - ts1) / 1e6)
+              << std::endl;
+}
+
+//! Speed test them!
+int main() {
+    size_t max_threads =
+        std::max<size_t>(4, std::thread::hardware_concurrency());
+
+    for (size_t p = 1; p <= max_threads; p *= 2) {
+        test_hold<LockedHeap>(p, "LockedHeap");
+        test_hold<MultiQueueConfig<2, 1, 0> >(p, "MultiQueue(c=2,s=1,b=0)");
+        test_hold<MultiQueueConfig<2, 8, 0> >(p, "MultiQueue(c=2,s=8,b=0)");
+        test_hold<MultiQueueConfig<4, 8, 16> >(p, "MultiQueue(c=4,s=8,b=16)");
+    }
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -0,0 +1,146 @@
+/*******************************************************************************
+ * tests/container/multi_queue_test.cpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <tlx/container/multi_queue.hpp>
+#include <tlx/die.hpp>
+
+// Force instantiation.
+namespace tlx {
+
+template class MultiQueue<uint32_t>;
+template class MultiQueue<uint64_t, 8, std::greater<uint64_t> >;
+
+} // namespace tlx
+
+/******************************************************************************/
+
+//! With a single queue and no buffers, the MultiQueue is an exact priority
+//! queue.
+void test_sequential_exact() {
+    tlx::MultiQueue<uint32_t> mq(1, 1, 4);
+    auto h = mq.get_handle(0);
+
+    std::mt19937 gen(42);
+    std::vector<uint32_t> keys(1000);
+    for (uint32_t& k : keys) k = gen() % 500;
+    for (uint32_t k : keys) h.push(k);
+    die_unequal(mq.size(), keys.size());
+
+    std::sort(keys.begin(), keys.end());
+    uint32_t x;
+    for (uint32_t k : keys) {
+        die_unless(h.try_pop(x));
+        die_unequal(x, k);
+    }
+    die_unless(!h.try_pop(x));
+    die_unless(mq.empty());
+}
+
+//! Pops with many queues and buffers in one thread, which returns every item
+//! exactly once, roughly in order.
+void test_sequential_relaxed(size_t factor, size_t stickiness,
+                             size_t buffer_size) {
+    const size_t num = 10000;
+    tlx::MultiQueue<uint32_t, 2, std::greater<uint32_t> > mq(
+        4, factor, stickiness, buffer_size);
+    std::vector<unsigned char> seen(num);
+
+    {
+        auto h = mq.get_handle(1);
+        std::vector<uint32_t> keys(num);
+        for (size_t i = 0; i < num; ++i) keys[i] = static_cast<uint32_t>(i);
+        std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+
+        for (size_t i = 0; i < num / 2; ++i) h.push(keys[i]);
+
+        // interleave pushes and pops
+        uint32_t x;
+        size_t rank_sum = 0, popped = 0;
+        for (size_t i = num / 2; i < num; ++i) {
+            h.push(keys[i]);
+            die_unless(h.try_pop(x));
+            die_unless(!seen[x]);
+            seen[x] = 1, ++popped;
+            // items in a max-heap come out large first
+            rank_sum += num - 1 - x;
+        }
+        h.flush();
+        die_unequal(mq.size(), num - popped);
+        while (h.try_pop(x)) {
+            die_unless(!seen[x]);
+            seen[x] = 1;
+        }
+        // the relaxation should not degenerate to random order
+        die_unless(rank_sum / popped < num / 2);
+    }
+    for (size_t i = 0; i < num; ++i)
+        die_unless(seen[i]);
+    die_unless(mq.empty());
+}
+
+//! Concurrent pushes and pops, checks that no item is lost or duplicated.
+void test_concurrent(size_t num_threads, size_t stickiness,
+                     size_t buffer_size) {
+    const size_t per_thread = 20000;
+    tlx::MultiQueue<uint64_t> mq(num_threads, 2, stickiness, buffer_size);
+
+    std::vector<std::vector<uint64_t> > popped(num_threads);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+        threads.emplace_back(
+            [&, t]() {
+                auto h = mq.get_handle(t);
+                uint64_t x;
+                for (size_t i = 0; i < per_thread; ++i) {
+                    h.push(t * per_thread + i);
+                    if (i % 3 == 0 && h.try_pop(x))
+                        popped[t].push_back(x);
+                }
+            });
+    }
+    for (std::thread& t : threads) t.join();
+
+    // the destructors of the handles flushed all buffers
+    std::vector<uint64_t> all;
+    for (const std::vector<uint64_t>& p : popped)
+        all.insert(all.end(), p.begin(), p.end());
+    die_unequal(mq.size() + all.size(), num_threads * per_thread);
+
+    auto h = mq.get_handle(num_threads);
+    uint64_t x;
+    while (h.try_pop(x)) all.push_back(x);
+
+    std::sort(all.begin(), all.end());
+    die_unequal(all.size(), num_threads * per_thread);
+    for (size_t i = 0; i < all.size(); ++i)
+        die_unequal(all[i], i);
+}
+
+int main() {
+    test_sequential_exact();
+
+    test_sequential_relaxed(2, 1, 0);
+    test_sequential_relaxed(4, 8, 0);
+    test_sequential_relaxed(2, 1, 16);
+    test_sequential_relaxed(2, 4, 64);
+
+    test_concurrent(4, 1, 0);
+    test_concurrent(4, 8, 16);
+    test_concurrent(8, 2, 4);
+
+    return 0;
+}
+
+/******************************************************************************/
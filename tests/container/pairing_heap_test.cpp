@@ -0,0 +1,223 @@
+/*******************************************************************************
+ * tests/container/pairing_heap_test.cpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <algorithm>
+#include <queue>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <tlx/container/pairing_heap.hpp>
+#include <tlx/die.hpp>
+#include <tlx/slab_allocator.hpp>
+
+// Force instantiation.
+namespace tlx {
+
+template class PairingHeap<uint32_t>;
+template class PairingHeap<uint64_t, std::greater<uint64_t> >;
+template class PairingHeap<
+        std::pair<double, uint32_t>, std::less<std::pair<double, uint32_t> >,
+        SlabAllocator<std::pair<double, uint32_t> > >;
+
+} // namespace tlx
+
+/******************************************************************************/
+
+//! Random pushes, pops, decrease_key, update and erase calls on items with
+//! unique ids, checked against a std::set of (key, id) pairs.
+template <typename Allocator>
+void pairing_heap_test(size_t num_ops, uint32_t r_seed = 42) {
+    using item_type = std::pair<uint32_t, uint32_t>;
+    using heap_type = tlx::PairingHeap<
+        item_type, std::less<item_type>, Allocator>;
+    using handle_type = typename heap_type::handle_type;
+
+    heap_type heap;
+    std::set<item_type> set;
+    std::vector<handle_type> handles;
+    std::vector<uint32_t> keys;
+
+    std::mt19937 prng(r_seed);
+    std::uniform_int_distribution<uint32_t> dist(0, 1000000);
+
+    auto random_id = [&]() {
+                         uint32_t id;
+                         do id = prng() % handles.size();
+                         while (!handles[id]);
+                         return id;
+                     };
+
+    for (size_t i = 0; i < num_ops; ++i) {
+        uint32_t op = set.empty() ? 0 : prng() % 6;
+        if (op <= 1) {
+            uint32_t id = static_cast<uint32_t>(handles.size());
+            keys.push_back(dist(prng));
+            handles.push_back(heap.push(item_type(keys[id], id)));
+            set.emplace(keys[id], id);
+        }
+        else if (op == 2) {
+            die_unless(heap.top() == *set.begin());
+            uint32_t id = heap.top().second;
+            die_unless(heap.top_handle() == handles[id]);
+            die_unless(heap.extract_top() == *set.begin());
+            set.erase(set.begin());
+            handles[id] = handle_type();
+        }
+        else if (op == 3) {
+            uint32_t id = random_id();
+            set.erase(item_type(keys[id], id));
+            keys[id] -= std::min(keys[id], dist(prng) % 1000);
+            heap.decrease_key(handles[id], item_type(keys[id], id));
+            set.emplace(keys[id], id);
+        }
+        else if (op == 4) {
+            uint32_t id = random_id();
+            set.erase(item_type(keys[id], id));
+            keys[id] = dist(prng);
+            heap.update(handles[id], item_type(keys[id], id));
+            set.emplace(keys[id], id);
+        }
+        else {
+            uint32_t id = random_id();
+            die_unless(heap.key(handles[id]) == item_type(keys[id], id));
+            heap.erase(handles[id]);
+            set.erase(item_type(keys[id], id));
+            handles[id] = handle_type();
+        }
+
+        die_unequal(heap.size(), set.size());
+        if (!set.empty())
+            die_unless(heap.top() == *set.begin());
+        if (i % 1000 == 0)
+            die_unless(heap.sanity_check());
+    }
+    die_unless(heap.sanity_check());
+
+    while (!heap.empty()) {
+        die_unless(heap.top() == *set.begin());
+        heap.pop();
+        set.erase(set.begin());
+    }
+    die_unless(set.empty());
+}
+
+//! Melds heaps of a max-heap and checks that handles of the emptied heap
+//! remain valid in the melded one.
+void pairing_heap_test_meld(uint32_t r_seed = 42) {
+    using heap_type = tlx::PairingHeap<uint64_t, std::greater<uint64_t> >;
+
+    std::mt19937 prng(r_seed);
+    heap_type a, b;
+    std::vector<heap_type::handle_type> hb;
+    std::multiset<uint64_t> set;
+
+    for (size_t i = 0; i < 1000; ++i) {
+        uint64_t x = prng() % 100000;
+        a.push(x), set.insert(x);
+        x = prng() % 100000;
+        hb.push_back(b.push(x)), set.insert(x);
+    }
+    set.erase(set.find(a.extract_top()));
+
+    a.meld(b);
+    die_unless(b.empty() && b.sanity_check());
+    die_unequal(a.size(), set.size());
+    die_unless(a.sanity_check());
+
+    // increase the items of b in a max-heap, which is a decrease
+    for (size_t i = 0; i < hb.size(); i += 3) {
+        uint64_t x = a.key(hb[i]);
+        set.erase(set.find(x));
+        a.decrease_key(hb[i], x + 50000);
+        set.insert(x + 50000);
+    }
+    die_unless(a.sanity_check());
+
+    // the moved heap keeps all items and handles
+    heap_type c(std::move(a));
+    die_unless(a.empty());
+    set.erase(set.find(c.key(hb[1])));
+    c.erase(hb[1]);
+    die_unequal(c.size(), 2 * 1000u - 2);
+
+    for (auto it = set.rbegin(); it != set.rend(); ++it)
+        die_unequal(c.extract_top(), *it);
+    die_unless(c.empty());
+}
+
+//! Dijkstra's algorithm on a random graph with decrease_key() compared to a
+//! std::priority_queue with lazy deletion.
+template <typename Allocator>
+void pairing_heap_test_dijkstra(size_t n, size_t m, uint32_t r_seed = 42) {
+    std::mt19937 prng(r_seed);
+    std::vector<std::vector<std::pair<uint32_t, uint32_t> > > adj(n);
+    for (size_t i = 0; i < m; ++i)
+        adj[prng() % n].emplace_back(prng() % n, prng() % 1000);
+
+    const uint64_t infinity = ~uint64_t(0);
+
+    // reference
+    std::vector<uint64_t> ref(n, infinity);
+    {
+        using item_type = std::pair<uint64_t, uint32_t>;
+        std::priority_queue<item_type, std::vector<item_type>,
+                            std::greater<item_type> > pq;
+        ref[0] = 0, pq.emplace(0, 0);
+        while (!pq.empty()) {
+            item_type x = pq.top();
+            pq.pop();
+            if (x.first != ref[x.second]) continue;
+            for (const auto& e : adj[x.second]) {
+                if (x.first + e.second < ref[e.first]) {
+                    ref[e.first] = x.first + e.second;
+                    pq.emplace(ref[e.first], e.first);
+                }
+            }
+        }
+    }
+
+    using item_type = std::pair<uint64_t, uint32_t>;
+    using heap_type = tlx::PairingHeap<
+        item_type, std::less<item_type>, Allocator>;
+    heap_type heap;
+    std::vector<typename heap_type::handle_type> handles(n);
+    std::vector<uint64_t> dist(n, infinity);
+    std::vector<bool> done(n);
+
+    dist[0] = 0, handles[0] = heap.push(item_type(0, 0));
+    while (!heap.empty()) {
+        uint32_t v = heap.extract_top().second;
+        done[v] = true;
+        for (const auto& e : adj[v]) {
+            uint64_t d = dist[v] + e.second;
+            if (done[e.first] || d >= dist[e.first]) continue;
+            if (handles[e.first])
+                heap.decrease_key(handles[e.first], item_type(d, e.first));
+            else
+                handles[e.first] = heap.push(item_type(d, e.first));
+            dist[e.first] = d;
+        }
+    }
+    die_unless(dist == ref);
+}
+
+int main() {
+    pairing_heap_test<std::allocator<uint32_t> >(100000);
+    pairing_heap_test<tlx::SlabAllocator<uint32_t> >(100000, 7);
+    pairing_heap_test_meld();
+    pairing_heap_test_dijkstra<std::allocator<uint32_t> >(10000, 50000);
+    pairing_heap_test_dijkstra<tlx::SlabAllocator<uint32_t> >(10000, 80000);
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -9,11 +9,13 @@
  ******************************************************************************/
 
 #include <algorithm>
+#include <cmath>
 #include <functional>
 #include <iostream>
 #include <limits>
 #include <queue>
 #include <random>
+#include <stdexcept>
 #include <tuple>
 #include <vector>
 
@@ -203,6 +205,82 @@ void int_rank_test(std::mt19937& prng) {
     }
 }
 
+template <typename T>
+void float_rank_test(std::mt19937& prng) {
+    using FR = tlx::radix_heap_detail::FloatRank<T>;
+
+    // Special values in ascending order
+    const std::vector<T> ordered = {
+        -std::numeric_limits<T>::infinity(),
+        std::numeric_limits<T>::lowest(),
+        T(-1),
+        -std::numeric_limits<T>::min(),
+        -std::numeric_limits<T>::denorm_min(),
+        T(0),
+        std::numeric_limits<T>::denorm_min(),
+        std::numeric_limits<T>::min(),
+        T(1),
+        std::numeric_limits<T>::max(),
+        std::numeric_limits<T>::infinity()
+    };
+    for (size_t i = 0; i < ordered.size(); i++) {
+        die_unless(FR::int_at_rank(FR::rank_of_int(ordered[i])) == ordered[i]);
+        die_unless(std::signbit(FR::int_at_rank(FR::rank_of_int(ordered[i])))
+                   == std::signbit(ordered[i]));
+        if (i > 0)
+            die_unless(FR::rank_of_int(ordered[i - 1]) <
+                       FR::rank_of_int(ordered[i]));
+    }
+
+    // -0.0 compares equal to +0.0 and has the same rank
+    die_unless(FR::rank_of_int(T(-0.0)) == FR::rank_of_int(T(0)));
+    die_unless(!std::signbit(FR::int_at_rank(FR::rank_of_int(T(-0.0)))));
+
+    // Check that random pairs of different magnitudes keep their order
+    std::uniform_real_distribution<T> mantissa(-1, 1);
+    std::uniform_int_distribution<int> exponent(-60, 60);
+    for (size_t i = 0; i < 1000; i++) {
+        T a = std::ldexp(mantissa(prng), exponent(prng));
+        T b = std::ldexp(mantissa(prng), exponent(prng));
+        if (a == b) continue;
+        if (a > b) std::swap(a, b);
+
+        die_unless(FR::rank_of_int(a) < FR::rank_of_int(b));
+        die_unless(FR::int_at_rank(FR::rank_of_int(a)) == a);
+        die_unless(FR::int_at_rank(FR::rank_of_int(b)) == b);
+    }
+}
+
+#if defined(__SIZEOF_INT128__)
+template <typename T>
+void int128_rank_test(std::mt19937& prng) {
+    using IR = tlx::radix_heap_detail::Int128Rank<T>;
+    using U = unsigned __int128;
+
+    const bool is_signed = std::is_same<T, __int128>::value;
+    const U umax = ~U(0);
+    const T min = is_signed ? static_cast<T>(U(1) << 127) : T(0);
+    const T max = is_signed ? static_cast<T>(umax >> 1) : static_cast<T>(umax);
+
+    die_unless(IR::rank_of_int(min) == 0);
+    die_unless(IR::rank_of_int(max) == umax);
+    die_unless(IR::int_at_rank(IR::rank_of_int(min)) == min);
+    die_unless(IR::int_at_rank(IR::rank_of_int(max)) == max);
+
+    std::uniform_int_distribution<uint64_t> dist;
+    for (size_t i = 0; i < 1000; i++) {
+        T a = static_cast<T>((U(dist(prng)) << 64) | dist(prng));
+        T b = static_cast<T>((U(dist(prng)) << 64) | dist(prng));
+        if (a == b) continue;
+        if (a > b) std::swap(a, b);
+
+        die_unless(IR::rank_of_int(a) < IR::rank_of_int(b));
+        die_unless(IR::int_at_rank(IR::rank_of_int(a)) == a);
+        die_unless(IR::int_at_rank(IR::rank_of_int(b)) == b);
+    }
+}
+#endif
+
 void test_main_int_rank(std::mt19937& prng) {
     int_rank_test<uint16_t>(prng);
     int_rank_test<uint32_t>(prng);
@@ -211,6 +289,14 @@ void test_main_int_rank(std::mt19937& prng) {
     int_rank_test<int16_t>(prng);
     int_rank_test<int32_t>(prng);
     int_rank_test<int64_t>(prng);
+
+    float_rank_test<float>(prng);
+    float_rank_test<double>(prng);
+
+#if defined(__SIZEOF_INT128__)
+    int128_rank_test<unsigned __int128>(prng);
+    int128_rank_test<__int128>(prng);
+#endif
 }
 
 /******************************************************************************/
@@ -251,6 +337,33 @@ void test_bucket_bounds() {
     }
 }
 
+#if defined(__SIZEOF_INT128__)
+//! Same as test_bucket_bounds for 128-bit ranks, which cannot be printed.
+template <unsigned Radix>
+void test_bucket_bounds_128() {
+    using U = unsigned __int128;
+    using Comp = tlx::radix_heap_detail::BucketComputation<Radix, U>;
+    Comp comp;
+
+    die_unless(comp.lower_bound(0u) == 0);
+    die_unless(comp.upper_bound(comp.num_buckets - 1u) == ~U(0));
+
+    for (size_t i = 1; i < comp.num_buckets; i++) {
+        die_unless(comp.lower_bound(i - 1) < comp.lower_bound(i));
+    }
+
+    for (size_t i = 0; i < comp.num_buckets; i++) {
+        const U lb = comp.lower_bound(i);
+        const U ub = comp.upper_bound(i);
+        const U mid = (ub - lb) / 2 + lb;
+
+        die_unequal(comp(lb, 0u), i);
+        die_unequal(comp(mid, 0u), i);
+        die_unequal(comp(ub, 0u), i);
+    }
+}
+#endif
+
 void test_main_bucket(std::mt19937&) {
     test_bucket_bounds<2, uint32_t>();
     test_bucket_bounds<8, uint32_t>();
@@ -258,6 +371,12 @@ void test_main_bucket(std::mt19937&) {
     test_bucket_bounds<2, uint64_t>();
     test_bucket_bounds<8, uint64_t>();
     test_bucket_bounds<64, uint64_t>();
+
+#if defined(__SIZEOF_INT128__)
+    test_bucket_bounds_128<2>();
+    test_bucket_bounds_128<8>();
+    test_bucket_bounds_128<64>();
+#endif
 }
 
 /******************************************************************************/
@@ -668,6 +787,258 @@ void test_main_radix_heap_pair(std::mt19937& prng) {
 
 /******************************************************************************/
 
+//! Monotone interleaved pushes and pops as in Dijkstra's algorithm: each popped
+//! key is pushed again plus a non-negative increment drawn by Increment. The
+//! heap is checked against std::priority_queue using only == and <, hence it
+//! works for keys which cannot be printed.
+template <typename KeyType, unsigned Radix, typename Increment>
+void monotone_inout(std::mt19937& prng, const std::vector<KeyType>& initial,
+                    Increment increment, size_t iters) {
+    using pq_type = std::pair<KeyType, uint32_t>;
+    std::priority_queue<pq_type, std::vector<pq_type>, std::greater<pq_type> >
+    pq;
+    tlx::RadixHeapPair<KeyType, uint32_t, Radix> heap;
+
+    uint32_t payload = 0;
+    for (const KeyType& key : initial) {
+        pq.emplace(key, payload);
+        heap.emplace_keyfirst(key, payload);
+        ++payload;
+    }
+
+    std::uniform_int_distribution<int> fanout(0, 3);
+    for (size_t i = 0; !pq.empty(); i++) {
+        die_unequal(pq.size(), heap.size());
+
+        const KeyType key = pq.top().first;
+        die_unless(heap.peak_top_key() == key);
+        die_unless(heap.top().first == key);
+
+        // pop all items with the smallest key and compare their payloads
+        std::vector<uint32_t> ref_data, heap_data;
+        for ( ; !pq.empty() && pq.top().first == key; pq.pop())
+            ref_data.push_back(pq.top().second);
+        for ( ; !heap.empty() && heap.peak_top_key() == key; heap.pop())
+            heap_data.push_back(heap.top().second);
+        std::sort(ref_data.begin(), ref_data.end());
+        std::sort(heap_data.begin(), heap_data.end());
+        die_unless(ref_data == heap_data);
+
+        if (i >= iters) continue;
+        for (int j = fanout(prng); j > 0; --j) {
+            const KeyType next = key + increment(prng);
+            die_unless(!(next < key));
+            pq.emplace(next, payload);
+            heap.emplace_keyfirst(next, payload);
+            ++payload;
+        }
+    }
+    die_unless(heap.empty());
+}
+
+template <typename Float, unsigned Radix>
+void float_monotone_inout(std::mt19937& prng, Float min, Float max) {
+    std::uniform_real_distribution<Float> dist(min, max);
+    std::vector<Float> initial(200);
+    for (Float& x : initial) x = dist(prng);
+    // some duplicates and signed zeros
+    initial[0] = initial[1] = initial[2];
+    initial[3] = Float(-0.0), initial[4] = Float(0.0);
+
+    std::uniform_int_distribution<int> weight(0, 1000);
+    monotone_inout<Float, Radix>(
+        prng, initial,
+        [&](std::mt19937& g) { return static_cast<Float>(weight(g)) / 64; },
+        2000);
+}
+
+#if defined(__SIZEOF_INT128__)
+template <typename Int, unsigned Radix>
+void int128_monotone_inout(std::mt19937& prng) {
+    using U = unsigned __int128;
+    std::uniform_int_distribution<uint64_t> dist;
+    std::vector<Int> initial(200);
+    for (Int& x : initial) {
+        // keys in a window around zero, which spans more than 64 bits
+        x = static_cast<Int>((U(dist(prng) % 4) << 64) | dist(prng));
+        if (std::is_same<Int, __int128>::value)
+            x = x - static_cast<Int>(U(2) << 64);
+    }
+
+    monotone_inout<Int, Radix>(
+        prng, initial,
+        [&](std::mt19937& g) {
+            return static_cast<Int>(U(dist(g) % 3) << 63 | (dist(g) % 64));
+        },
+        2000);
+}
+#endif
+
+//! After popping +0.0, pushing -0.0 does not violate the monotonicity.
+template <typename Float>
+void float_signed_zero() {
+    tlx::RadixHeapPair<Float, uint32_t, 8> heap;
+    heap.emplace_keyfirst(Float(0.0), 0);
+    heap.emplace_keyfirst(Float(1.0), 1);
+    die_unequal(heap.top().second, 0u);
+    heap.pop();
+    heap.emplace_keyfirst(Float(-0.0), 2);
+    die_unequal(heap.top().second, 2u);
+    heap.pop();
+    die_unequal(heap.top().second, 1u);
+    heap.pop();
+    die_unless(heap.empty());
+}
+
+void test_main_radix_heap_float_int128(std::mt19937& prng) {
+    float_signed_zero<float>();
+    float_signed_zero<double>();
+    float_monotone_inout<double, 2>(prng, -1000, 1000);
+    float_monotone_inout<double, 64>(prng, -1e-3, 1e9);
+    float_monotone_inout<float, 8>(prng, 0, 100);
+    float_monotone_inout<float, 64>(prng, -100, 0);
+
+#if defined(__SIZEOF_INT128__)
+    int128_monotone_inout<unsigned __int128, 2>(prng);
+    int128_monotone_inout<unsigned __int128, 64>(prng);
+    int128_monotone_inout<__int128, 8>(prng);
+#endif
+}
+
+/******************************************************************************/
+
+//! Value without default constructor, for which parallel reorganization falls
+//! back to the sequential code.
+struct NoDefaultValue {
+    uint32_t key, payload;
+    NoDefaultValue(uint32_t k, uint32_t p) : key(k), payload(p) { }
+};
+
+struct NoDefaultKeyExtract {
+    uint32_t operator () (const NoDefaultValue& v) const { return v.key; }
+};
+
+//! Equal-key frontiers extracted with pop_top_bucket(). The heap with parallel
+//! reorganization must yield exactly the same buckets as the sequential one,
+//! and both must match std::priority_queue.
+template <unsigned Radix>
+void batch_inout(std::mt19937& prng, size_t num_threads) {
+    using pq_type = std::pair<uint32_t, uint32_t>;
+    using heap_type = tlx::RadixHeapPair<uint32_t, uint32_t, Radix>;
+    std::priority_queue<pq_type, std::vector<pq_type>, std::greater<pq_type> >
+    pq;
+    heap_type seq, par;
+    par.set_parallel_reorganize(num_threads, 16);
+
+    uint32_t payload = 0;
+    auto push = [&](uint32_t key) {
+                    pq.emplace(key, payload);
+                    seq.emplace_keyfirst(key, payload);
+                    par.emplace_keyfirst(key, payload);
+                    ++payload;
+                };
+
+    // few distinct keys spread over all rows, hence large frontiers
+    std::uniform_int_distribution<uint32_t> keys(0, 63);
+    for (size_t i = 0; i < 20000; ++i) push(keys(prng) << (i % 24));
+
+    std::uniform_int_distribution<uint32_t> increment(0, 1 << 12);
+    typename heap_type::bucket_data_type seq_out, par_out;
+    for (size_t i = 0; !pq.empty(); ++i) {
+        die_unequal(pq.size(), seq.size());
+        die_unequal(pq.size(), par.size());
+
+        const uint32_t key = pq.top().first;
+        die_unequal(seq.peak_top_key(), key);
+
+        // odd rounds append to a non-empty output bucket
+        seq_out.clear(), par_out.clear();
+        if (i % 2) {
+            seq_out.emplace_back(0, 0);
+            par_out.emplace_back(0, 0);
+        }
+        die_unequal(seq.pop_top_bucket(seq_out), key);
+        die_unequal(par.pop_top_bucket(par_out), key);
+        die_unless(seq_out == par_out);
+
+        std::vector<uint32_t> ref_data, heap_data;
+        for ( ; !pq.empty() && pq.top().first == key; pq.pop())
+            ref_data.push_back(pq.top().second);
+        for (size_t j = i % 2; j < seq_out.size(); ++j) {
+            die_unequal(seq_out[j].first, key);
+            heap_data.push_back(seq_out[j].second);
+        }
+        std::sort(ref_data.begin(), ref_data.end());
+        std::sort(heap_data.begin(), heap_data.end());
+        die_unless(ref_data == heap_data);
+
+        // relax some items, including ones with the current key
+        if (i >= 200) continue;
+        for (size_t j = 0; j < ref_data.size() && j < 64; ++j)
+            push(key + (j % 4 ? increment(prng) << (j % 16) : 0));
+    }
+    die_unless(seq.empty() && par.empty());
+}
+
+//! Key extractor which throws for the payload 777 once armed.
+struct ThrowingKeyExtract {
+    static bool armed;
+    uint32_t operator () (const std::pair<uint32_t, uint32_t>& v) const {
+        if (armed && v.second == 777)
+            throw std::runtime_error("ThrowingKeyExtract");
+        return v.first;
+    }
+};
+
+bool ThrowingKeyExtract::armed = false;
+
+//! Exceptions during parallel reorganization reach the caller of pop().
+void test_parallel_exception() {
+    tlx::RadixHeap<std::pair<uint32_t, uint32_t>, ThrowingKeyExtract,
+                   uint32_t> heap;
+    heap.set_parallel_reorganize(4, 2);
+    for (uint32_t i = 0; i < 1000; ++i)
+        heap.emplace(i * 1000, i * 1000, i);
+
+    ThrowingKeyExtract::armed = true;
+    bool thrown = false;
+    try {
+        while (!heap.empty()) heap.pop();
+    }
+    catch (std::runtime_error&) {
+        thrown = true;
+    }
+    ThrowingKeyExtract::armed = false;
+    die_unless(thrown);
+
+    heap.clear();
+    die_unless(heap.empty());
+}
+
+void test_main_radix_heap_batch(std::mt19937& prng) {
+    batch_inout<2>(prng, 1);
+    batch_inout<2>(prng, 4);
+    batch_inout<8>(prng, 3);
+    batch_inout<64>(prng, 2);
+
+    // fallback without default constructor
+    tlx::RadixHeap<NoDefaultValue, NoDefaultKeyExtract, uint32_t> heap;
+    heap.set_parallel_reorganize(4, 2);
+    for (uint32_t i = 0; i < 1000; ++i)
+        heap.emplace(i % 100 * 1000, i % 100 * 1000, i);
+    std::vector<NoDefaultValue> out;
+    for (uint32_t i = 0; i < 100; ++i) {
+        out.clear();
+        die_unequal(heap.pop_top_bucket(out), i * 1000);
+        die_unequal(out.size(), 10u);
+    }
+    die_unless(heap.empty());
+
+    test_parallel_exception();
+}
+
+/******************************************************************************/
+
 int main() {
     std::mt19937 prng(1);
 
@@ -675,6 +1046,8 @@ int main() {
     test_main_int_rank(prng);
     test_main_bucket(prng);
     test_main_radix_heap_pair(prng);
+    test_main_radix_heap_float_int128(prng);
+    test_main_radix_heap_batch(prng);
 
     return 0;
 }
@@ -0,0 +1,108 @@
+/*******************************************************************************
+ * tests/container/sequence_heap_test.cpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <functional>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <tlx/container/sequence_heap.hpp>
+#include <tlx/die.hpp>
+
+// Force instantiation.
+namespace tlx {
+
+template class SequenceHeap<uint32_t>;
+template class SequenceHeap<uint64_t, std::greater<uint64_t> >;
+
+} // namespace tlx
+
+/******************************************************************************/
+
+//! Random pushes and pops with tiny buffers, such that many runs are spilled
+//! and merged into higher levels, checked against std::priority_queue.
+template <typename KeyType, typename Compare>
+void sequence_heap_test(size_t num_ops, size_t insert_items,
+                        size_t block_items, size_t runs_per_level,
+                        unsigned push_percent, uint32_t r_seed = 42) {
+    tlx::SequenceHeap<KeyType, Compare> heap(
+        insert_items, block_items, runs_per_level);
+    // std::priority_queue is a max-heap w.r.t. its comparator
+    std::priority_queue<KeyType, std::vector<KeyType>,
+                        std::function<bool(KeyType, KeyType)> >
+    pq([](const KeyType& a, const KeyType& b) { return Compare()(b, a); });
+
+    std::mt19937_64 prng(r_seed);
+    size_t max_runs = 0;
+
+    for (size_t i = 0; i < num_ops; ++i) {
+        if (pq.empty() || prng() % 100 < push_percent) {
+            KeyType key = static_cast<KeyType>(prng() % (1u << 20));
+            heap.push(key);
+            pq.push(key);
+        }
+        else {
+            die_unequal(heap.top(), pq.top());
+            die_unequal(heap.extract_top(), pq.top());
+            pq.pop();
+        }
+        die_unequal(heap.size(), pq.size());
+        max_runs = std::max(max_runs, heap.num_runs());
+    }
+
+    // the number of runs is bounded by the levels.
+    die_unless(max_runs > 1);
+
+    while (!pq.empty()) {
+        die_unequal(heap.top(), pq.top());
+        heap.pop();
+        pq.pop();
+    }
+    die_unless(heap.empty());
+    die_unequal(heap.num_runs(), 0u);
+}
+
+//! Items with payload, and monotone keys as in an event simulation.
+void sequence_heap_test_events() {
+    using item_type = std::pair<uint64_t, uint32_t>;
+    tlx::SequenceHeap<item_type> heap(1000, 64, 4);
+
+    std::mt19937 prng(1);
+    for (uint32_t i = 0; i < 10000; ++i)
+        heap.push(item_type(prng() % 1000, i));
+
+    uint64_t now = 0;
+    size_t events = 0;
+    while (!heap.empty()) {
+        item_type x = heap.extract_top();
+        die_unless(x.first >= now);
+        now = x.first, ++events;
+        if (events < 200000)
+            heap.push(item_type(now + prng() % 5000, x.second));
+    }
+    die_unequal(events, 200000u + 10000u - 1u);
+}
+
+int main() {
+    sequence_heap_test<uint32_t, std::less<uint32_t> >(
+        200000, 100, 16, 4, 70);
+    sequence_heap_test<uint64_t, std::greater<uint64_t> >(
+        200000, 256, 7, 2, 60);
+    sequence_heap_test<uint32_t, std::less<uint32_t> >(
+        100000, 1000, 100, 3, 55, 7);
+    sequence_heap_test<int64_t, std::less<int64_t> >(
+        5000, 1, 1, 2, 90);
+    sequence_heap_test_events();
+
+    return 0;
+}
+
+/******************************************************************************/
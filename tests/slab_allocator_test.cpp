@@ -0,0 +1,149 @@
+/*******************************************************************************
+ * tests/slab_allocator_test.cpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include <list>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <tlx/container/btree_map.hpp>
+#include <tlx/die.hpp>
+#include <tlx/slab_allocator.hpp>
+
+namespace tlx {
+
+// forced instantiations
+template class SlabAllocator<int>;
+
+} // namespace tlx
+
+static void test_list() {
+    using IntAlloc = tlx::SlabAllocator<int>;
+
+    IntAlloc alloc;
+    const tlx::CountingPtr<tlx::SlabArena>& arena = alloc.arena();
+    {
+        std::list<int, IntAlloc> list(alloc);
+        for (int i = 0; i < 10000; ++i)
+            list.push_back(i);
+
+        die_unequal(arena->live(), 10000u);
+        die_unless(arena->reserved() >= 10000 * 2 * sizeof(void*));
+
+        // freed nodes are reused
+        size_t slabs = arena->num_slabs();
+        for (int i = 0; i < 5000; ++i)
+            list.pop_front();
+        for (int i = 0; i < 5000; ++i)
+            list.push_back(i);
+        die_unequal(arena->num_slabs(), slabs);
+
+        int i = 5000;
+        for (std::list<int, IntAlloc>::const_iterator it = list.begin();
+             it != list.end(); ++it, i = (i + 1) % 10000)
+            die_unequal(*it, i);
+    }
+
+    // all slabs are released with the last object
+    die_unequal(arena->live(), 0u);
+    die_unequal(arena->reserved(), 0u);
+    die_unequal(arena->num_slabs(), 0u);
+
+    // large objects are not pooled
+    int* p = alloc.allocate(100000);
+    p[99999] = 42;
+    die_unequal(arena->reserved(), 0u);
+    alloc.deallocate(p, 100000);
+}
+
+static void test_btree() {
+    typedef tlx::btree_map<
+            unsigned int, unsigned int, std::less<unsigned int>,
+            tlx::btree_default_traits<
+                unsigned int, std::pair<unsigned int, unsigned int> >,
+            tlx::SlabAllocator<std::pair<unsigned int, unsigned int> > >
+        btree_type;
+
+    btree_type bt;
+    std::map<unsigned int, unsigned int> ref;
+    std::mt19937 rng(1234);
+
+    // insert/erase mix
+    for (size_t i = 0; i < 100000; ++i) {
+        unsigned int k = rng() % 20000;
+        if (rng() % 3 != 0) {
+            bt.insert2(k, i);
+            ref.insert(std::make_pair(k, i));
+        }
+        else {
+            die_unequal(bt.erase(k), ref.erase(k));
+        }
+    }
+    bt.verify();
+    die_unequal(bt.size(), ref.size());
+    std::map<unsigned int, unsigned int>::const_iterator ri = ref.begin();
+    for (btree_type::const_iterator it = bt.begin(); it != bt.end();
+         ++it, ++ri) {
+        die_unequal(it->first, ri->first);
+        die_unequal(it->second, ri->second);
+    }
+
+    // leaves and inner nodes use separate size classes
+    tlx::CountingPtr<tlx::SlabArena> arena = bt.get_allocator().arena();
+    die_unequal(arena->live(),
+                bt.get_stats().leaves + bt.get_stats().inner_nodes);
+
+    btree_type bt2 = bt;
+    die_unless(bt2 == bt);
+
+    bt.clear();
+    bt2.clear();
+    die_unequal(arena->live(), 0u);
+    die_unequal(arena->reserved(), 0u);
+}
+
+static void test_threads() {
+    using IntAlloc = tlx::SlabAllocator<int>;
+
+    IntAlloc alloc;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; ++t) {
+        threads.emplace_back(
+            [alloc, t]() {
+                IntAlloc a(alloc);
+                std::vector<int*> ptrs;
+                for (int r = 0; r < 10; ++r) {
+                    for (int i = 0; i < 1000; ++i) {
+                        ptrs.push_back(a.allocate(1 + t));
+                        *ptrs.back() = i;
+                    }
+                    for (int i = 0; i < 1000; ++i) {
+                        die_unequal(*ptrs[i], i);
+                        a.deallocate(ptrs[i], 1 + t);
+                    }
+                    ptrs.clear();
+                }
+            });
+    }
+    for (std::thread& t : threads) t.join();
+
+    die_unequal(alloc.arena()->live(), 0u);
+}
+
+int main() {
+    test_list();
+    test_btree();
+    test_threads();
+
+    return 0;
+}
+
+/******************************************************************************/
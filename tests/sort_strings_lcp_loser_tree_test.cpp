@@ -0,0 +1,150 @@
+/*******************************************************************************
+ * tests/sort_strings_lcp_loser_tree_test.cpp
+ *
+ * Test merging of sorted string runs with LCP arrays
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#include "sort_strings_test.hpp"
+
+#include <tlx/sort/strings/lcp_loser_tree.hpp>
+#include <tlx/sort/strings/multikey_quicksort.hpp>
+#include <tlx/sort/strings/radix_sort.hpp>
+
+#include <tlx/die.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+//! create and free Strings of the string sets from std::string
+uint8_t* make_string(const std::string& s, uint8_t*) {
+    uint8_t* p = new uint8_t[s.size() + 1];
+    std::memcpy(p, s.c_str(), s.size() + 1);
+    return p;
+}
+void free_string(uint8_t* p) { delete[] p; }
+
+std::string make_string(const std::string& s, std::string) { return s; }
+void free_string(const std::string&) { }
+
+std::unique_ptr<std::string>
+make_string(const std::string& s, std::unique_ptr<std::string>) {
+    return std::unique_ptr<std::string>(new std::string(s));
+}
+void free_string(const std::unique_ptr<std::string>&) { }
+
+/*!
+ * Generates num_runs runs of random length with strings sharing long prefixes,
+ * sorts each with an LCP sorter, merges them with multiway_lcp_merge(), and
+ * checks the order and the output LCPs against std::sort.
+ */
+template <typename StringSet>
+void test_lcp_merge(size_t num_runs, size_t max_length,
+                    const std::string& letters) {
+    typedef typename StringSet::String String;
+    typedef StringLcpPtr<StringSet, uint32_t> LcpPtr;
+
+    std::default_random_engine rng(seed + num_runs);
+
+    std::vector<std::vector<String> > runs(num_runs);
+    std::vector<std::vector<uint32_t> > run_lcps(num_runs);
+    std::vector<std::string> all;
+    std::vector<LcpPtr> ptrs;
+
+    // strings are a prefix of random length of a long shared string, followed
+    // by a few random letters.
+    const std::string prefix(50, 'x');
+    for (size_t r = 0; r < num_runs; ++r) {
+        size_t n = rng() % (max_length + 1);
+        for (size_t i = 0; i < n; ++i) {
+            std::string s = prefix.substr(0, rng() % prefix.size());
+            size_t p = s.size();
+            s.resize(p + rng() % 4);
+            fill_random(rng, letters, s.begin() + p, s.end());
+            runs[r].push_back(make_string(s, String()));
+            all.push_back(s);
+        }
+        run_lcps[r].resize(n);
+
+        StringSet ss(runs[r].data(), runs[r].data() + n);
+        LcpPtr ptr(ss, run_lcps[r].data());
+        if (r % 2 == 0)
+            multikey_quicksort(ptr, /* depth */ 0, /* memory */ 0);
+        else
+            radixsort_CI3(ptr, /* depth */ 0, /* memory */ 0);
+        die_unless(n == 0 || ss.check_order());
+        ptrs.push_back(ptr);
+    }
+
+    std::vector<String> output(all.size());
+    std::vector<uint32_t> lcp(all.size());
+    StringSet out(output.data(), output.data() + output.size());
+
+    size_t count = multiway_lcp_merge(
+        ptrs.begin(), ptrs.end(), LcpPtr(out, lcp.data()));
+    die_unequal(count, all.size());
+
+    die_unless(all.empty() || out.check_order());
+    die_unless(check_lcp(out, lcp.data()));
+
+    std::sort(all.begin(), all.end());
+    for (size_t i = 0; i < all.size(); ++i)
+        die_unequal(out.get_string(output[i]), all[i]);
+
+    for (String& s : output) free_string(s);
+}
+
+//! Uses the LcpLoserTree directly and checks the run order of equal strings.
+void test_lcp_loser_tree_sources() {
+    std::vector<std::vector<std::string> > runs = {
+        { "a", "ab", "b" }, { }, { "a", "b", "b" }, { "ab" }, { "a", "c" }
+    };
+    std::vector<std::vector<uint32_t> > run_lcps;
+    std::vector<StringLcpPtr<StdStringSet, uint32_t> > ptrs;
+    for (std::vector<std::string>& run : runs) {
+        run_lcps.emplace_back(run.size());
+        StdStringSet ss(run.data(), run.data() + run.size());
+        ptrs.emplace_back(ss, run_lcps.back().data());
+        multikey_quicksort(ptrs.back(), /* depth */ 0, /* memory */ 0);
+    }
+
+    LcpLoserTree<StringLcpPtr<StdStringSet, uint32_t> > tree(
+        ptrs.begin(), ptrs.end());
+
+    const std::string strings[] = {
+        "a", "a", "a", "ab", "ab", "b", "b", "b", "c"
+    };
+    const size_t sources[] = { 0, 2, 4, 0, 3, 0, 2, 2, 4 };
+    const uint32_t lcps[] = { 0, 1, 1, 1, 2, 0, 1, 1, 0 };
+    for (size_t i = 0; i < 9; ++i) {
+        die_unless(!tree.done());
+        die_unequal(tree.min_string(), strings[i]);
+        die_unequal(tree.min_source(), sources[i]);
+        die_unequal(tree.min_lcp(), lcps[i]);
+        tree.next();
+    }
+    die_unless(tree.done());
+}
+
+int main() {
+    for (size_t k : { 0, 1, 2, 3, 5, 8, 16, 33, 100 }) {
+        test_lcp_merge<UCharStringSet>(k, 500, "abxy");
+        test_lcp_merge<StdStringSet>(k, 300, "abxy");
+        test_lcp_merge<UPtrStdStringSet>(k, 300, "abxy");
+    }
+    test_lcp_merge<UCharStringSet>(4, 20000, letters_alnum);
+    test_lcp_merge<StdStringSet>(37, 2000, letters_alnum);
+    test_lcp_loser_tree_sources();
+
+    return 0;
+}
+
+/******************************************************************************/
@@ -24,6 +24,7 @@ print "#include <$_>\n" foreach sort glob("tlx/algorithm/"."*.hpp");
 #include <tlx/algorithm/multisequence_partition.hpp>
 #include <tlx/algorithm/multisequence_selection.hpp>
 #include <tlx/algorithm/multiway_merge.hpp>
+#include <tlx/algorithm/multiway_merge_file.hpp>
 #include <tlx/algorithm/multiway_merge_splitting.hpp>
 #include <tlx/algorithm/parallel_multiway_merge.hpp>
 #include <tlx/algorithm/random_bipartition_shuffle.hpp>
@@ -0,0 +1,305 @@
+/*******************************************************************************
+ * tlx/algorithm/multiway_merge_file.hpp
+ *
+ * Streaming multiway merge of sorted runs stored in files, with block-buffered
+ * readers and writers doing asynchronous I/O in a ThreadPool.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_ALGORITHM_MULTIWAY_MERGE_FILE_HEADER
+#define TLX_ALGORITHM_MULTIWAY_MERGE_FILE_HEADER
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <tlx/block_file.hpp>
+#include <tlx/container/loser_tree.hpp>
+#include <tlx/thread_pool.hpp>
+
+namespace tlx {
+
+//! \addtogroup tlx_algorithm
+//! \{
+
+namespace multiway_merge_file_detail {
+
+//! Number of items in a block of block_size bytes, at least one.
+template <typename ValueType>
+size_t block_items(size_t block_size) {
+    return std::max<size_t>(1, block_size / sizeof(ValueType));
+}
+
+} // namespace multiway_merge_file_detail
+
+/*!
+ * Reads a file of trivially copyable items sequentially in blocks of
+ * block_size bytes. Up to read_ahead blocks beyond the current one are read
+ * asynchronously by the ThreadPool, such that a consumer like
+ * stream_multiway_merge() rarely waits for the disk. With read_ahead = 0, each
+ * block is read when it is needed. Memory usage is (read_ahead + 1) blocks.
+ *
+ * The interface of a stream for stream_multiway_merge() is empty(), current()
+ * and advance(), inherited from BlockReader. The reader is movable.
+ */
+template <typename ValueType>
+class FileBlockReader : public BlockReader<ValueType>
+{
+public:
+    //! Opens path and starts reading the first blocks.
+    FileBlockReader(const std::string& path, ThreadPool& pool,
+                    size_t block_size = 1024 * 1024, size_t read_ahead = 2)
+        : FileBlockReader(open(path), pool, block_size, read_ahead) { }
+
+private:
+    //! An opened file and its number of items.
+    struct OpenFile {
+        std::unique_ptr<BlockFile> file;
+        size_t size;
+    };
+
+    FileBlockReader(OpenFile f, ThreadPool& pool, size_t block_size,
+                    size_t read_ahead)
+        : BlockReader<ValueType>(
+              std::move(f.file), f.size, pool,
+              multiway_merge_file_detail::block_items<ValueType>(block_size),
+              read_ahead) { }
+
+    static OpenFile open(const std::string& path) {
+        OpenFile f;
+        f.file.reset(new BlockFile(path, false));
+        if (f.file->size() % sizeof(ValueType) != 0)
+            throw std::runtime_error(
+                      "FileBlockReader: size of " + path +
+                      " is not a multiple of the item size");
+        f.size = f.file->size() / sizeof(ValueType);
+        return f;
+    }
+};
+
+/*!
+ * Writes trivially copyable items sequentially to a file in blocks of
+ * block_size bytes. Full blocks are written asynchronously by the ThreadPool
+ * while the next one is filled, with up to write_behind blocks in flight.
+ * Can be used as the sink of stream_multiway_merge(). close() must be called
+ * to write the last block and to rethrow write errors.
+ */
+template <typename ValueType>
+class FileBlockWriter
+{
+    static_assert(std::is_trivially_copy_constructible<ValueType>::value,
+                  "FileBlockWriter requires trivially copyable items.");
+
+public:
+    using value_type = ValueType;
+
+    //! Creates or truncates path.
+    FileBlockWriter(const std::string& path, ThreadPool& pool,
+                    size_t block_size = 1024 * 1024, size_t write_behind = 1)
+        : impl_(new Impl(path, pool,
+                         multiway_merge_file_detail::block_items<ValueType>(
+                             block_size),
+                         write_behind)) { }
+
+    //! Appends an item.
+    void operator () (const value_type& v) {
+        Impl& i = *impl_;
+        std::vector<value_type>& block = i.slots_[i.slot_].data;
+        block.push_back(v);
+        if (block.size() == i.block_items_) i.flush_block();
+    }
+
+    //! Writes the last block and waits for all writes.
+    void close() {
+        impl_->flush_block();
+        impl_->wait_all();
+    }
+
+    //! Number of items appended.
+    size_t size() const { return impl_->written_ + impl_->current_size(); }
+
+private:
+    struct Slot {
+        std::vector<value_type> data;
+        block_file_detail::IoJob write;
+    };
+
+    struct Impl {
+        BlockFile file_;
+        ThreadPool& pool_;
+        size_t block_items_;
+        //! ring of write_behind + 1 blocks
+        std::vector<Slot> slots_;
+        size_t slot_ = 0;
+        //! items handed to writes
+        size_t written_ = 0;
+
+        Impl(const std::string& path, ThreadPool& pool, size_t block_items,
+             size_t write_behind)
+            : file_(path, true), pool_(pool), block_items_(block_items),
+              slots_(write_behind + 1) {
+            slots_[0].data.reserve(block_items_);
+        }
+
+        //! Waits for running writes and drops the others, errors are only
+        //! reported by close().
+        ~Impl() {
+            for (Slot& s : slots_) s.write.cancel();
+        }
+
+        size_t current_size() const { return slots_[slot_].data.size(); }
+
+        //! Starts writing the current block and switches to the next slot.
+        void flush_block() {
+            Slot& s = slots_[slot_];
+            if (s.data.empty()) return;
+            const value_type* data = s.data.data();
+            size_t n = s.data.size(), offset = written_;
+            BlockFile* file = &file_;
+            s.write.start(
+                pool_, [file, data, n, offset]() {
+                    file->write(data, n * sizeof(value_type),
+                                offset * sizeof(value_type));
+                });
+            written_ += n;
+
+            // wait until the next slot is free, or write it if the pool has
+            // not started to, and reuse its buffer
+            slot_ = (slot_ + 1) % slots_.size();
+            Slot& next = slots_[slot_];
+            next.write.wait();
+            next.data.clear();
+            next.data.reserve(block_items_);
+        }
+
+        void wait_all() {
+            for (Slot& s : slots_) s.write.wait();
+        }
+    };
+
+    std::unique_ptr<Impl> impl_;
+};
+
+/*!
+ * Multiway merge of sorted streams, like FileBlockReader, which define
+ * value_type and are consumed item by item via empty(), current() and
+ * advance() until all are empty. The items are passed in sorted order to
+ * sink(item). The heads of the streams are kept in a
+ * LoserTreeCopy, hence memory usage is independent of the stream lengths.
+ *
+ * \param streams_begin Begin iterator of the streams.
+ * \param streams_end End iterator of the streams.
+ * \param sink Function object receiving the merged items.
+ * \param comp Comparator.
+ * \tparam Stable Keep the order of the streams for equal items.
+ * \return Number of items merged.
+ */
+template <
+    bool Stable = false,
+    typename StreamIterator,
+    typename Sink,
+    typename Comparator = std::less<
+        typename std::iterator_traits<StreamIterator>::value_type::value_type> >
+size_t stream_multiway_merge(
+    StreamIterator streams_begin, StreamIterator streams_end, Sink&& sink,
+    Comparator comp = Comparator()) {
+    using Stream = typename std::iterator_traits<StreamIterator>::value_type;
+    using ValueType = typename Stream::value_type;
+    using LoserTree = LoserTreeCopy<Stable, ValueType, Comparator>;
+    using Source = typename LoserTree::Source;
+
+    const Source k = static_cast<Source>(streams_end - streams_begin);
+    if (k == 0) return 0;
+
+    // number of streams which are not empty
+    Source active = 0;
+
+    LoserTree lt(k, comp);
+    for (Source t = 0; t < k; ++t) {
+        Stream& s = streams_begin[t];
+        if (s.empty()) {
+            lt.insert_start(nullptr, t, true);
+        }
+        else {
+            lt.insert_start(&s.current(), t, false);
+            ++active;
+        }
+    }
+    lt.init();
+
+    size_t count = 0;
+    while (active != 0) {
+        Stream& s = streams_begin[lt.min_source()];
+        sink(s.current());
+        s.advance();
+        ++count;
+        if (s.empty()) {
+            lt.delete_min_insert(nullptr, true);
+            --active;
+        }
+        else {
+            lt.delete_min_insert(&s.current(), false);
+        }
+    }
+    return count;
+}
+
+/*!
+ * Merges the sorted runs of trivially copyable items in the input files into
+ * the output file with bounded memory: each input is read by a
+ * FileBlockReader, which reads ahead asynchronously, and the output is
+ * written by a FileBlockWriter. The I/O is done by a ThreadPool of io_threads
+ * threads.
+ *
+ * Memory usage is about (inputs * (read_ahead + 1) + 2) * block_size bytes.
+ *
+ * \param inputs Paths of the sorted input files.
+ * \param output Path of the output file, which is created or truncated.
+ * \param comp Comparator.
+ * \param block_size Size of the blocks read and written in bytes.
+ * \param read_ahead Number of blocks read ahead for each input.
+ * \param io_threads Number of threads doing I/O.
+ * \tparam Stable Keep the order of the inputs for equal items.
+ * \return Number of items merged.
+ */
+template <typename ValueType, bool Stable = false,
+          typename Comparator = std::less<ValueType> >
+size_t multiway_merge_files(
+    const std::vector<std::string>& inputs, const std::string& output,
+    Comparator comp = Comparator(), size_t block_size = 1024 * 1024,
+    size_t read_ahead = 2, size_t io_threads = 4) {
+
+    ThreadPool pool(std::max<size_t>(io_threads, 1));
+
+    std::vector<FileBlockReader<ValueType> > readers;
+    readers.reserve(inputs.size());
+    for (const std::string& path : inputs)
+        readers.emplace_back(path, pool, block_size, read_ahead);
+
+    FileBlockWriter<ValueType> writer(output, pool, block_size);
+    size_t count = stream_multiway_merge<Stable>(
+        readers.begin(), readers.end(), writer, comp);
+    writer.close();
+    return count;
+}
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_ALGORITHM_MULTIWAY_MERGE_FILE_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,429 @@
+/*******************************************************************************
+ * tlx/block_file.hpp
+ *
+ * File with positioned block reads and writes from multiple threads, and a
+ * block-buffered reader of trivially copyable items which reads ahead in a
+ * ThreadPool.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_BLOCK_FILE_HEADER
+#define TLX_BLOCK_FILE_HEADER
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TLX_BLOCK_FILE_PREAD 1
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define TLX_BLOCK_FILE_PREAD 0
+#include <filesystem>
+#endif
+
+#include <tlx/thread_pool.hpp>
+
+namespace tlx {
+
+/*!
+ * File opened for positioned reads or writes. On POSIX systems, pread() and
+ * pwrite() allow I/O of different blocks from multiple threads at once.
+ * Elsewhere, an std::fstream protected by a mutex is used.
+ *
+ * Errors are reported by throwing std::runtime_error.
+ */
+class BlockFile
+{
+public:
+    //! Opens path for reading, or creates or truncates it for writing.
+    BlockFile(const std::string& path, bool write) : path_(path) {
+#if TLX_BLOCK_FILE_PREAD
+        fd_ = write ? ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666)
+              : ::open(path.c_str(), O_RDONLY);
+        if (fd_ < 0) fail("open");
+        if (!write) {
+            struct stat st;
+            if (::fstat(fd_, &st) != 0) {
+                ::close(fd_);
+                fail("fstat");
+            }
+            size_ = static_cast<size_t>(st.st_size);
+        }
+#else
+        std::ios::openmode mode =
+            std::ios::binary | (write ? std::ios::out | std::ios::trunc
+                                : std::ios::in | std::ios::ate);
+        stream_.open(path.c_str(), mode);
+        if (!stream_.good()) fail("open");
+        if (!write) size_ = static_cast<size_t>(stream_.tellg());
+#endif
+    }
+
+    /*!
+     * Creates an empty temporary file for reading and writing in directory
+     * dir, or in the system's temporary directory if dir is empty. On POSIX
+     * systems, the file is created with mkstemp() in dir, TMPDIR or /tmp and
+     * unlinked at once. Elsewhere, a named file in dir or
+     * std::filesystem::temp_directory_path() is used, which is removed when it
+     * is closed.
+     */
+    static std::unique_ptr<BlockFile> temporary(const std::string& dir) {
+        std::unique_ptr<BlockFile> file(new BlockFile());
+#if TLX_BLOCK_FILE_PREAD
+        file->path_ = (dir.empty() ? temporary_dir() : dir)
+                      + "/tlx_block_file_XXXXXX";
+        std::vector<char> name(file->path_.begin(), file->path_.end());
+        name.push_back(0);
+        file->fd_ = ::mkstemp(name.data());
+        if (file->fd_ < 0) file->fail("mkstemp");
+        ::unlink(name.data());
+#else
+        static std::atomic<size_t> counter(0);
+        file->path_ = (dir.empty() ? temporary_dir() : dir)
+                      + "/tlx_block_file_" + std::to_string(++counter) + "_"
+                      + std::to_string(reinterpret_cast<uintptr_t>(file.get()));
+        file->stream_.open(file->path_.c_str(),
+                           std::ios::binary | std::ios::in | std::ios::out |
+                           std::ios::trunc);
+        if (!file->stream_.good()) file->fail("open");
+        file->remove_ = true;
+#endif
+        return file;
+    }
+
+    //! non-copyable: delete copy-constructor
+    BlockFile(const BlockFile&) = delete;
+    //! non-copyable: delete assignment operator
+    BlockFile& operator = (const BlockFile&) = delete;
+
+    //! Closes the file, and removes it if it is a named temporary file.
+    ~BlockFile() {
+#if TLX_BLOCK_FILE_PREAD
+        ::close(fd_);
+#else
+        stream_.close();
+        if (remove_) std::remove(path_.c_str());
+#endif
+    }
+
+    //! Size of the file in bytes when it was opened for reading.
+    size_t size() const { return size_; }
+
+    //! Reads bytes at offset into data. Reading beyond the end of the file
+    //! throws an std::runtime_error.
+    void read(void* data, size_t bytes, size_t offset) {
+        char* p = static_cast<char*>(data);
+#if TLX_BLOCK_FILE_PREAD
+        for (size_t done = 0; done != bytes; ) {
+            ssize_t r = ::pread(fd_, p + done, bytes - done,
+                                static_cast<off_t>(offset + done));
+            if (r < 0 && errno == EINTR) continue;
+            if (r < 0) fail("pread");
+            if (r == 0) fail_beyond_end(bytes, offset);
+            done += static_cast<size_t>(r);
+        }
+#else
+        std::unique_lock<std::mutex> lock(mutex_);
+        stream_.seekg(static_cast<std::streamoff>(offset));
+        if (!stream_.read(p, static_cast<std::streamsize>(bytes))) {
+            bool eof = stream_.eof();
+            stream_.clear();
+            if (eof) fail_beyond_end(bytes, offset);
+            fail("read");
+        }
+#endif
+    }
+
+    //! Writes bytes from data at offset.
+    void write(const void* data, size_t bytes, size_t offset) {
+        const char* p = static_cast<const char*>(data);
+#if TLX_BLOCK_FILE_PREAD
+        while (bytes != 0) {
+            ssize_t r = ::pwrite(fd_, p, bytes, static_cast<off_t>(offset));
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) fail("pwrite");
+            p += r, bytes -= static_cast<size_t>(r);
+            offset += static_cast<size_t>(r);
+        }
+#else
+        std::unique_lock<std::mutex> lock(mutex_);
+        stream_.seekp(static_cast<std::streamoff>(offset));
+        if (!stream_.write(p, static_cast<std::streamsize>(bytes)))
+            fail("write");
+#endif
+    }
+
+private:
+    //! path for error messages, and of named temporary files
+    std::string path_;
+    //! size in bytes of a file opened for reading
+    size_t size_ = 0;
+#if TLX_BLOCK_FILE_PREAD
+    int fd_ = -1;
+#else
+    std::fstream stream_;
+    std::mutex mutex_;
+    //! whether the file is removed when closed
+    bool remove_ = false;
+#endif
+
+    //! Used by temporary().
+    BlockFile() = default;
+
+    static std::string temporary_dir() {
+#if TLX_BLOCK_FILE_PREAD
+        const char* tmp = std::getenv("TMPDIR");
+        return tmp && *tmp ? std::string(tmp) : std::string("/tmp");
+#else
+        return std::filesystem::temp_directory_path().string();
+#endif
+    }
+
+    [[noreturn]] void fail(const char* op) const {
+        throw std::runtime_error(
+            std::string("BlockFile: ") + op + "(" + path_ + ") failed: " +
+            std::strerror(errno));
+    }
+
+    [[noreturn]] void fail_beyond_end(size_t bytes, size_t offset) const {
+        throw std::runtime_error(
+            "BlockFile: read of " + std::to_string(bytes) + " bytes at " +
+            "offset " + std::to_string(offset) + " is beyond the end of " +
+            path_);
+    }
+};
+
+namespace block_file_detail {
+
+/*!
+ * An I/O function enqueued into a ThreadPool, which is run by the thread
+ * waiting for it instead if no thread of the pool has started it yet. The
+ * function is claimed with an atomic flag by whichever thread comes first.
+ * Hence waiting never deadlocks, even if the waiting thread runs in a job of
+ * the same pool and all other threads of the pool are busy.
+ */
+class IoJob
+{
+public:
+    //! Enqueues func into pool. The job must not be pending.
+    template <typename Function>
+    void start(ThreadPool& pool, Function func) {
+        assert(!pending());
+        std::shared_ptr<State> state = std::make_shared<State>();
+        state->func = std::move(func);
+        future_ = state->done.get_future();
+        state_ = state;
+        pool.enqueue(
+            [state]() {
+                if (state->claimed.exchange(true)) return;
+                try {
+                    state->func();
+                    state->done.set_value();
+                }
+                catch (...) {
+                    state->done.set_exception(std::current_exception());
+                }
+            });
+    }
+
+    //! True if the job was started and not yet waited for.
+    bool pending() const { return state_ != nullptr; }
+
+    //! Runs the function in this thread if no thread of the pool has started
+    //! it, otherwise waits for it. Rethrows errors of the function.
+    void wait() {
+        if (!pending()) return;
+        std::shared_ptr<State> state = std::move(state_);
+        std::future<void> future = std::move(future_);
+        if (!state->claimed.exchange(true))
+            state->func();
+        else
+            future.get();
+    }
+
+    //! Drops the function if no thread of the pool has started it, otherwise
+    //! waits for it. Errors are ignored.
+    void cancel() {
+        if (!pending()) return;
+        std::shared_ptr<State> state = std::move(state_);
+        std::future<void> future = std::move(future_);
+        if (state->claimed.exchange(true)) future.wait();
+    }
+
+private:
+    struct State {
+        std::atomic<bool> claimed { false };
+        std::function<void()> func;
+        std::promise<void> done;
+    };
+
+    std::shared_ptr<State> state_;
+    std::future<void> future_;
+};
+
+} // namespace block_file_detail
+
+/*!
+ * Reads the first size items of a BlockFile of trivially copyable items
+ * sequentially in blocks of block_items items. Up to read_ahead blocks beyond
+ * the current one are read asynchronously by the ThreadPool, such that a
+ * consumer rarely waits for the disk. With read_ahead = 0, each block is read
+ * when it is needed. Memory usage is (read_ahead + 1) blocks. A block whose
+ * read was not yet started by the pool when it is needed is read by the
+ * consumer itself, hence the reader may also be used in a job of the pool.
+ *
+ * The interface of a stream is empty(), current() and advance(). The reader
+ * is movable, the pending reads refer to internal state which does not move.
+ */
+template <typename ValueType>
+class BlockReader
+{
+    static_assert(std::is_trivially_copy_constructible<ValueType>::value,
+                  "BlockReader requires trivially copyable items.");
+
+public:
+    using value_type = ValueType;
+
+    //! Takes over file, which must not be written anymore, and starts reading
+    //! its first blocks. Waits for the first block.
+    BlockReader(std::unique_ptr<BlockFile> file, size_t size,
+                ThreadPool& pool, size_t block_items, size_t read_ahead)
+        : impl_(new Impl(std::move(file), size, pool,
+                         std::max<size_t>(block_items, 1), read_ahead)) {
+        impl_->start();
+    }
+
+    //! Total number of items.
+    size_t size() const { return impl_->size_; }
+
+    //! Number of items not yet consumed.
+    size_t remaining() const { return impl_->remaining_; }
+
+    //! True if all items were consumed.
+    bool empty() const { return impl_->remaining_ == 0; }
+
+    //! The current item.
+    const value_type& current() const {
+        assert(!empty());
+        return impl_->current_[impl_->pos_];
+    }
+
+    //! Consumes the current item. Rethrows errors of the read of the next
+    //! block.
+    void advance() {
+        Impl& i = *impl_;
+        assert(!empty());
+        --i.remaining_;
+        if (++i.pos_ == i.current_size_ && i.remaining_ != 0)
+            i.next_block();
+    }
+
+private:
+    struct Slot {
+        std::vector<value_type> data;
+        block_file_detail::IoJob read;
+    };
+
+    struct Impl {
+        std::unique_ptr<BlockFile> file_;
+        ThreadPool& pool_;
+        //! items per block
+        size_t block_items_;
+        //! total items, and items not yet consumed
+        size_t size_, remaining_;
+        //! ring of read_ahead + 1 blocks
+        std::vector<Slot> slots_;
+        //! slot of the current block, its data and size, and position in it
+        size_t slot_ = 0;
+        const value_type* current_ = nullptr;
+        size_t current_size_ = 0, pos_ = 0;
+        //! next block to request
+        size_t next_request_ = 0;
+
+        Impl(std::unique_ptr<BlockFile> file, size_t size, ThreadPool& pool,
+             size_t block_items, size_t read_ahead)
+            : file_(std::move(file)), pool_(pool), block_items_(block_items),
+              size_(size), remaining_(size), slots_(read_ahead + 1) { }
+
+        //! Drops reads which have not started and waits for the others.
+        ~Impl() {
+            for (Slot& s : slots_) s.read.cancel();
+        }
+
+        size_t num_blocks() const {
+            return (size_ + block_items_ - 1) / block_items_;
+        }
+
+        //! Requests the next block into slot s.
+        void request(Slot& s) {
+            if (next_request_ >= num_blocks()) return;
+            size_t offset = next_request_++ * block_items_;
+            size_t n = std::min(block_items_, size_ - offset);
+            s.data.resize(n);
+            value_type* data = s.data.data();
+            BlockFile* file = file_.get();
+            s.read.start(
+                pool_, [file, data, n, offset]() {
+                    file->read(data, n * sizeof(value_type),
+                               offset * sizeof(value_type));
+                });
+        }
+
+        //! Requests the first blocks and waits for the first one.
+        void start() {
+            if (size_ == 0) return;
+            for (Slot& s : slots_) request(s);
+            activate();
+        }
+
+        //! Waits for the block in the current slot, or reads it if the pool has
+        //! not started to, and makes it current.
+        void activate() {
+            slots_[slot_].read.wait();
+            current_ = slots_[slot_].data.data();
+            current_size_ = slots_[slot_].data.size();
+            pos_ = 0;
+        }
+
+        //! Reuses the consumed slot for a new request, and switches to the
+        //! next block.
+        void next_block() {
+            request(slots_[slot_]);
+            slot_ = (slot_ + 1) % slots_.size();
+            activate();
+        }
+    };
+
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace tlx
+
+#endif // !TLX_BLOCK_FILE_HEADER
+
+/******************************************************************************/
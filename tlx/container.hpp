@@ -18,16 +18,23 @@
 print "#include <$_>\n" foreach sort glob("tlx/container/"."*.hpp");
 ]]]*/
 #include <tlx/container/btree.hpp>
+#include <tlx/container/btree_frozen.hpp>
 #include <tlx/container/btree_map.hpp>
 #include <tlx/container/btree_multimap.hpp>
 #include <tlx/container/btree_multiset.hpp>
 #include <tlx/container/btree_set.hpp>
+#include <tlx/container/btree_simd.hpp>
+#include <tlx/container/concurrent_btree_map.hpp>
 #include <tlx/container/d_ary_addressable_int_heap.hpp>
 #include <tlx/container/d_ary_heap.hpp>
+#include <tlx/container/d_ary_heap_simd.hpp>
 #include <tlx/container/loser_tree.hpp>
 #include <tlx/container/lru_cache.hpp>
+#include <tlx/container/multi_queue.hpp>
+#include <tlx/container/pairing_heap.hpp>
 #include <tlx/container/radix_heap.hpp>
 #include <tlx/container/ring_buffer.hpp>
+#include <tlx/container/sequence_heap.hpp>
 #include <tlx/container/simple_vector.hpp>
 #include <tlx/container/splay_tree.hpp>
 // [[[end]]]
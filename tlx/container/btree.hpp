@@ -11,18 +11,26 @@
 #ifndef TLX_CONTAINER_BTREE_HEADER
 #define TLX_CONTAINER_BTREE_HEADER
 
+#include <tlx/container/btree_frozen.hpp>
+#include <tlx/container/btree_simd.hpp>
+#include <tlx/define/prefetch.hpp>
 #include <tlx/die/core.hpp>
+#include <tlx/thread_pool.hpp>
 
 // *** Required Headers from the STL
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <functional>
 #include <istream>
+#include <iterator>
 #include <memory>
 #include <ostream>
+#include <type_traits>
 #include <utility>
+#include <vector>
 
 namespace tlx {
 
@@ -97,9 +105,83 @@ struct btree_default_traits {
     //! find_upper() instead of binary_search, unless the node size is larger
     //! than this threshold. See notes at
     //! http://panthema.net/2013/0504-STX-B+Tree-Binary-vs-Linear-Search
+    //! If the keys can be searched with SIMD (see btree_simd), then binary
+    //! search narrows the key range down to this many bytes and the rest is
+    //! scanned with vector comparisons.
     static const size_t binsearch_threshold = 256;
+
+    //! If true, each inner node additionally stores the number of items in the
+    //! subtrees of its children, which enables rank(), select(), index_of()
+    //! and count_range() in O(log n) time. All modifying operations maintain
+    //! the counts. If false, no memory or time is spent on them.
+    static const bool order_statistics = false;
+
+    //! If true, nodes carry an atomic reference count and snapshot() returns
+    //! read-only views sharing all nodes with the tree. Modifications of the
+    //! tree then copy only the shared nodes on the path they touch.
+    static const bool copy_on_write = false;
+
+    //! Monoid whose value is cached for each subtree in the inner nodes, which
+    //! enables aggregate() over key ranges in O(log n) node visits. void
+    //! disables it. Otherwise it must be a struct with a typedef type and the
+    //! static functions identity(), item(const value_type&) and an associative
+    //! combine(const type&, const type&), which is applied in key order.
+    typedef void aggregate;
+};
+
+//! Reads the optional order_statistics flag of B+ tree traits, which may be
+//! omitted by traits not derived from btree_default_traits.
+template <typename Traits, typename Enable = void>
+struct btree_traits_order_statistics : public std::false_type { };
+
+template <typename Traits>
+struct btree_traits_order_statistics<
+    Traits, typename std::enable_if<Traits::order_statistics>::type>
+    : public std::true_type { };
+
+//! Reads the optional copy_on_write flag of B+ tree traits, which may be
+//! omitted by traits not derived from btree_default_traits.
+template <typename Traits, typename Enable = void>
+struct btree_traits_copy_on_write : public std::false_type { };
+
+template <typename Traits>
+struct btree_traits_copy_on_write<
+    Traits, typename std::enable_if<Traits::copy_on_write>::type>
+    : public std::true_type { };
+
+//! Reads the optional aggregate monoid of B+ tree traits, which may be omitted
+//! or void. Without one, monoid is a placeholder which is never evaluated.
+template <typename Traits, typename Enable = void>
+struct btree_traits_aggregate : public std::false_type {
+    struct monoid {
+        typedef bool type;
+        static type identity() { return false; }
+        template <typename Value>
+        static type item(const Value&) { return false; }
+        static type combine(const type&, const type&) { return false; }
+    };
 };
 
+template <typename Traits>
+struct btree_traits_aggregate<
+    Traits, typename std::conditional<
+        true, void, typename Traits::aggregate::type>::type>
+    : public std::true_type {
+    typedef typename Traits::aggregate monoid;
+};
+
+//! Detects whether values of type T can be compared with operator ==, which is
+//! used by verify() to check cached aggregates.
+template <typename T, typename Enable = void>
+struct btree_is_equality_comparable : public std::false_type { };
+
+template <typename T>
+struct btree_is_equality_comparable<
+    T, typename std::conditional<
+        true, void, decltype(std::declval<const T&>() ==
+                             std::declval<const T&>())>::type>
+    : public std::true_type { };
+
 /*!
  * Basic class implementing a B+ tree data structure in memory.
  *
@@ -149,7 +231,9 @@ public:
     //! implement multiset and multimap.
     static const bool allow_duplicates = Duplicates;
 
-    //! Seventh template parameter: STL allocator for tree nodes
+    //! Seventh template parameter: STL allocator for tree nodes. Use
+    //! tlx::SlabAllocator to pool nodes in slabs instead of calling malloc()
+    //! for each node.
     typedef Allocator allocator_type;
 
     //! \}
@@ -202,15 +286,107 @@ public:
     //! with TLX_BTREE_DEBUG and the key type must be std::ostream printable.
     static const bool debug = traits::debug;
 
+    //! Computed B+ tree parameter: True if the in-node search can use the SIMD
+    //! kernels of btree_simd, which is the case for 32/64-bit integer, float
+    //! and double keys ordered by std::less.
+    static const bool simd_search =
+        btree_simd::is_supported<key_type, key_compare>::value;
+
+    //! Order statistics parameter: If true, inner nodes store the number of
+    //! items in each child's subtree. See btree_default_traits.
+    static const bool order_statistics =
+        btree_traits_order_statistics<traits>::value;
+
+    //! Copy-on-write parameter: If true, nodes are reference counted and may
+    //! be shared with snapshots. See btree_default_traits.
+    static const bool copy_on_write =
+        btree_traits_copy_on_write<traits>::value;
+
+    //! Aggregate parameter: If true, inner nodes store the aggregate of each
+    //! child's subtree. See btree_default_traits.
+    static const bool augmented = btree_traits_aggregate<traits>::value;
+
+    //! Monoid of the subtree aggregates, a placeholder unless augmented.
+    typedef typename btree_traits_aggregate<traits>::monoid aggregate_monoid;
+
+    //! Type of the subtree aggregates.
+    typedef typename aggregate_monoid::type aggregate_type;
+
     //! \}
 
 private:
     //! \name Node Classes for In-Memory Nodes
     //! \{
 
+    //! Subtree item counts of the children of an inner node. Empty unless
+    //! order_statistics is enabled, then counts() returns nullptr.
+    template <bool Enable, typename Dummy = void>
+    struct InnerNodeCounts {
+        //! Number of items in the subtree of each child
+        size_type childcount[inner_slotmax + 1]; // NOLINT
+
+        size_type * counts() { return childcount; }
+        const size_type * counts() const { return childcount; }
+    };
+
+    template <typename Dummy>
+    struct InnerNodeCounts<false, Dummy> {
+        size_type * counts() { return nullptr; }
+        const size_type * counts() const { return nullptr; }
+    };
+
+    //! Subtree aggregates of the children of an inner node. Empty unless
+    //! augmented, then aggregates() returns nullptr.
+    template <bool Enable, typename Dummy = void>
+    struct InnerNodeAggregates {
+        //! Aggregate of the items in the subtree of each child
+        aggregate_type childagg[inner_slotmax + 1]; // NOLINT
+
+        aggregate_type * aggregates() { return childagg; }
+        const aggregate_type * aggregates() const { return childagg; }
+    };
+
+    template <typename Dummy>
+    struct InnerNodeAggregates<false, Dummy> {
+        aggregate_type * aggregates() { return nullptr; }
+        const aggregate_type * aggregates() const { return nullptr; }
+    };
+
+    //! Reference count of a node, which is the number of parents, trees and
+    //! snapshots pointing to it. Empty if copy_on_write is disabled, as nodes
+    //! are then never shared.
+    template <bool Enable, typename Dummy = void>
+    struct NodeRefCount {
+        //! Number of references to this node
+        std::atomic<unsigned int> refs;
+
+        void init_refs() { refs.store(1, std::memory_order_relaxed); }
+
+        //! True if the node is referenced more than once and must therefore
+        //! be copied before it is modified.
+        bool is_shared() const {
+            return refs.load(std::memory_order_acquire) > 1;
+        }
+
+        void acquire_ref() { refs.fetch_add(1, std::memory_order_relaxed); }
+
+        //! Drop one reference, returns true if it was the last one.
+        bool release_ref() {
+            return refs.fetch_sub(1, std::memory_order_acq_rel) == 1;
+        }
+    };
+
+    template <typename Dummy>
+    struct NodeRefCount<false, Dummy> {
+        void init_refs() { }
+        bool is_shared() const { return false; }
+        void acquire_ref() { }
+        bool release_ref() { return true; }
+    };
+
     //! The header structure of each node in-memory. This structure is extended
     //! by InnerNode or LeafNode.
-    struct node {
+    struct node : public NodeRefCount<copy_on_write> {
         //! Level in the b-tree, if level == 0 -> leaf node
         unsigned short level;
 
@@ -222,6 +398,7 @@ private:
         void initialize(const unsigned short l) {
             level = l;
             slotuse = 0;
+            this->init_refs();
         }
 
         //! True if this is a leaf node.
@@ -232,7 +409,9 @@ private:
 
     //! Extended structure of a inner node in-memory. Contains only keys and no
     //! data items.
-    struct InnerNode : public node {
+    struct InnerNode : public node,
+                       public InnerNodeCounts<order_statistics>,
+                       public InnerNodeAggregates<augmented> {
         //! Define an related allocator for the InnerNode structs.
         typedef typename Allocator::template rebind<InnerNode>::other alloc_type;
 
@@ -247,11 +426,20 @@ private:
             node::initialize(l);
         }
 
+        //! Inner nodes store their keys contiguously, hence they can always
+        //! be searched using SIMD if the key type allows it.
+        static const bool simd_search = BTree::simd_search;
+
         //! Return key in slot s
         const key_type& key(size_t s) const {
             return slotkey[s];
         }
 
+        //! Return the contiguous array of keys for SIMD search.
+        const key_type* keys() const {
+            return slotkey;
+        }
+
         //! True if the node's slots are full.
         bool is_full() const {
             return (node::slotuse == inner_slotmax);
@@ -289,11 +477,22 @@ private:
             prev_leaf = next_leaf = nullptr;
         }
 
+        //! Leaves store their keys contiguously only in sets, where value_type
+        //! equals key_type, hence SIMD search is restricted to those.
+        static const bool simd_search =
+            BTree::simd_search && std::is_same<key_type, value_type>::value;
+
         //! Return key in slot s.
         const key_type& key(size_t s) const {
             return key_of_value::get(slotdata[s]);
         }
 
+        //! Return the contiguous array of keys for SIMD search. Only valid if
+        //! simd_search is true.
+        const key_type* keys() const {
+            return slotdata;
+        }
+
         //! True if the node's slots are full.
         bool is_full() const {
             return (node::slotuse == leaf_slotmax);
@@ -544,6 +743,11 @@ public:
         //! data items directly
         friend class const_reverse_iterator;
 
+        //! Also friendly to the base btree class, because index_of() needs to
+        //! read the curr_leaf and curr_slot values directly.
+        friend class BTree<key_type, value_type, key_of_value, key_compare,
+                           traits, allow_duplicates, allocator_type>;
+
         // The macro TLX_BTREE_FRIENDS can be used by outside class to access
         // the B+ tree internals. This was added for wxBTreeDemo to be able to
         // draw the tree.
@@ -1251,20 +1455,90 @@ private:
 
     //! Allocate and initialize a leaf node
     LeafNode * allocate_leaf() {
-        LeafNode* n = new (leaf_node_allocator().allocate(1)) LeafNode();
-        n->initialize();
+        LeafNode* n = construct_leaf();
         stats_.leaves++;
         return n;
     }
 
     //! Allocate and initialize an inner node
     InnerNode * allocate_inner(unsigned short level) {
+        InnerNode* n = construct_inner(level);
+        stats_.inner_nodes++;
+        return n;
+    }
+
+    //! Allocate and initialize a leaf without counting it in stats_, used by
+    //! the parallel bulk loader.
+    LeafNode * construct_leaf() {
+        LeafNode* n = new (leaf_node_allocator().allocate(1)) LeafNode();
+        n->initialize();
+        return n;
+    }
+
+    //! Allocate and initialize an inner node without counting it in stats_,
+    //! used by the parallel bulk loader.
+    InnerNode * construct_inner(unsigned short level) {
         InnerNode* n = new (inner_node_allocator().allocate(1)) InnerNode();
         n->initialize(level);
-        stats_.inner_nodes++;
         return n;
     }
 
+    //! Number of items in the subtree of n, computed from the slotuse of a
+    //! leaf or the children's subtree counts. Requires order_statistics.
+    static size_type subtree_size(const node* n) {
+        if (n->is_leafnode())
+            return n->slotuse;
+
+        const InnerNode* inner = static_cast<const InnerNode*>(n);
+        size_type size = 0;
+        for (unsigned short slot = 0; slot <= inner->slotuse; ++slot)
+            size += inner->counts()[slot];
+        return size;
+    }
+
+    //! Aggregate of the items in the subtree of n, computed from the items of
+    //! a leaf or the children's subtree aggregates. Requires augmented.
+    static aggregate_type subtree_aggregate(const node* n) {
+        aggregate_type agg = aggregate_monoid::identity();
+        if (n->is_leafnode())
+        {
+            const LeafNode* leaf = static_cast<const LeafNode*>(n);
+            for (unsigned short slot = 0; slot < leaf->slotuse; ++slot) {
+                agg = aggregate_monoid::combine(
+                    agg, aggregate_monoid::item(leaf->slotdata[slot]));
+            }
+            return agg;
+        }
+
+        const InnerNode* inner = static_cast<const InnerNode*>(n);
+        for (unsigned short slot = 0; slot <= inner->slotuse; ++slot)
+            agg = aggregate_monoid::combine(agg, inner->aggregates()[slot]);
+        return agg;
+    }
+
+    //! Recompute the subtree counts of the children [first,last] of inner, if
+    //! order_statistics is enabled, and their aggregates, if augmented.
+    static void update_counts(InnerNode* inner,
+                              unsigned int first, unsigned int last) {
+        if (!order_statistics && !augmented) return;
+        for (unsigned int slot = first; slot <= last; ++slot)
+        {
+            if (order_statistics)
+                inner->counts()[slot] = subtree_size(inner->childid[slot]);
+            if (augmented) {
+                inner->aggregates()[slot] =
+                    subtree_aggregate(inner->childid[slot]);
+            }
+        }
+    }
+
+    //! Recompute the subtree counts of a modified child and its two siblings,
+    //! which may have been shifted or merged with it.
+    static void update_counts_around(InnerNode* inner, unsigned int slot) {
+        update_counts(inner, slot > 0 ? slot - 1 : 0,
+                      std::min<unsigned int>(slot + 1, inner->slotuse));
+    }
+
     //! Correctly free either inner or leaf node, destructs all contained key
     //! and value objects.
     void free_node(node* n) {
@@ -1284,6 +1558,113 @@ private:
         }
     }
 
+    //! Drop one reference to a node which may be shared with snapshots. If it
+    //! was the last one, the node is freed and its children are released. Does
+    //! not change stats_, as the node may not belong to this tree anymore.
+    void release_node(node* n) {
+        if (!n->release_ref()) return;
+
+        if (n->is_leafnode()) {
+            LeafNode* ln = static_cast<LeafNode*>(n);
+            typename LeafNode::alloc_type a(leaf_node_allocator());
+            a.destroy(ln);
+            a.deallocate(ln, 1);
+        }
+        else {
+            InnerNode* in = static_cast<InnerNode*>(n);
+            for (unsigned short slot = 0; slot <= in->slotuse; ++slot)
+                release_node(in->childid[slot]);
+
+            typename InnerNode::alloc_type a(inner_node_allocator());
+            a.destroy(in);
+            a.deallocate(in, 1);
+        }
+    }
+
+    //! Replace the node referenced by ref (the root or a child pointer of an
+    //! unshared inner node) with a private copy if it is shared with a
+    //! snapshot, such that it may be modified in place. A copied inner node
+    //! shares all children, hence a descent copies only the nodes on its path.
+    //! A copied leaf takes over the original's place in the leaf list, which
+    //! is only maintained for the tree and never followed by snapshots.
+    node * unshare(node*& ref) {
+        if (!copy_on_write || !ref->is_shared())
+            return ref;
+
+        node* n = ref;
+        if (n->is_leafnode())
+        {
+            const LeafNode* leaf = static_cast<const LeafNode*>(n);
+            LeafNode* copy = construct_leaf();
+
+            copy->slotuse = leaf->slotuse;
+            std::copy(leaf->slotdata, leaf->slotdata + leaf->slotuse,
+                      copy->slotdata);
+
+            copy->prev_leaf = leaf->prev_leaf;
+            copy->next_leaf = leaf->next_leaf;
+
+            if (copy->prev_leaf)
+                copy->prev_leaf->next_leaf = copy;
+            else
+                head_leaf_ = copy;
+
+            if (copy->next_leaf)
+                copy->next_leaf->prev_leaf = copy;
+            else
+                tail_leaf_ = copy;
+
+            ref = copy;
+        }
+        else
+        {
+            const InnerNode* inner = static_cast<const InnerNode*>(n);
+            InnerNode* copy = construct_inner(inner->level);
+
+            copy->slotuse = inner->slotuse;
+            std::copy(inner->slotkey, inner->slotkey + inner->slotuse,
+                      copy->slotkey);
+            std::copy(inner->childid, inner->childid + inner->slotuse + 1,
+                      copy->childid);
+            if (order_statistics) {
+                std::copy(inner->counts(), inner->counts() + inner->slotuse + 1,
+                          copy->counts());
+            }
+            if (augmented) {
+                std::copy(inner->aggregates(),
+                          inner->aggregates() + inner->slotuse + 1,
+                          copy->aggregates());
+            }
+
+            for (unsigned short slot = 0; slot <= copy->slotuse; ++slot)
+                copy->childid[slot]->acquire_ref();
+
+            ref = copy;
+        }
+
+        // the snapshots keep the original
+        release_node(n);
+        return ref;
+    }
+
+    //! Unshare the siblings of a node below the same parent, as these are
+    //! modified by shifting or merging when the node underflows.
+    template <typename NodeType>
+    void unshare_siblings(NodeType*& left, NodeType*& right,
+                          InnerNode* left_parent, InnerNode* right_parent,
+                          InnerNode* parent, unsigned int parentslot) {
+        if (!copy_on_write) return;
+
+        if (left && left_parent == parent) {
+            left = static_cast<NodeType*>(
+                unshare(parent->childid[parentslot - 1]));
+        }
+        if (right && right_parent == parent) {
+            right = static_cast<NodeType*>(
+                unshare(parent->childid[parentslot + 1]));
+        }
+    }
+
     //! \}
 
 public:
@@ -1294,8 +1675,14 @@ public:
     void clear() {
         if (root_)
         {
-            clear_recursive(root_);
-            free_node(root_);
+            if (copy_on_write) {
+                // nodes shared with snapshots are kept alive by them
+                release_node(root_);
+            }
+            else {
+                clear_recursive(root_);
+                free_node(root_);
+            }
 
             root_ = nullptr;
             head_leaf_ = tail_leaf_ = nullptr;
@@ -1396,6 +1783,54 @@ private:
     //! places in LeafNode and InnerNode.
     template <typename node_type>
     int find_lower(const node_type* n, const key_type& key) const {
+        return find_lower(
+            n, key, std::integral_constant<bool, node_type::simd_search>());
+    }
+
+    //! Searches for the first key in the node n greater or equal to key using
+    //! the SIMD kernels. Large nodes are first narrowed down using binary
+    //! search until the remaining range is below binsearch_threshold bytes.
+    template <typename node_type>
+    int find_lower(const node_type* n, const key_type& key,
+                   std::true_type /* simd_search */) const {
+        const key_type* keys = n->keys();
+        int lo = 0, hi = n->slotuse;
+
+        while ((hi - lo) * sizeof(key_type) > traits::binsearch_threshold)
+        {
+            int mid = (lo + hi) >> 1;
+
+            if (key_lessequal(key, keys[mid])) {
+                hi = mid; // key <= mid
+            }
+            else {
+                lo = mid + 1; // key > mid
+            }
+        }
+
+        lo += static_cast<int>(btree_simd::find_lower(keys + lo, hi - lo, key));
+
+        TLX_BTREE_PRINT("BTree::find_lower: simd on " << n <<
+                        " key " << key << " -> " << lo);
+
+        // verify result using simple linear search
+        if (self_verify)
+        {
+            int i = 0;
+            while (i < n->slotuse && key_less(n->key(i), key)) ++i;
+
+            TLX_BTREE_PRINT("BTree::find_lower: testfind: " << i);
+            TLX_BTREE_ASSERT(i == lo);
+        }
+
+        return lo;
+    }
+
+    //! Searches for the first key in the node n greater or equal to key using
+    //! scalar comparisons.
+    template <typename node_type>
+    int find_lower(const node_type* n, const key_type& key,
+                   std::false_type /* simd_search */) const {
         if (sizeof(*n) > traits::binsearch_threshold)
         {
             if (n->slotuse == 0) return 0;
@@ -1443,6 +1878,54 @@ private:
     //! LeafNode and InnerNode.
     template <typename node_type>
     int find_upper(const node_type* n, const key_type& key) const {
+        return find_upper(
+            n, key, std::integral_constant<bool, node_type::simd_search>());
+    }
+
+    //! Searches for the first key in the node n greater than key using the
+    //! SIMD kernels. Large nodes are first narrowed down using binary search
+    //! until the remaining range is below binsearch_threshold bytes.
+    template <typename node_type>
+    int find_upper(const node_type* n, const key_type& key,
+                   std::true_type /* simd_search */) const {
+        const key_type* keys = n->keys();
+        int lo = 0, hi = n->slotuse;
+
+        while ((hi - lo) * sizeof(key_type) > traits::binsearch_threshold)
+        {
+            int mid = (lo + hi) >> 1;
+
+            if (key_less(key, keys[mid])) {
+                hi = mid; // key < mid
+            }
+            else {
+                lo = mid + 1; // key >= mid
+            }
+        }
+
+        lo += static_cast<int>(btree_simd::find_upper(keys + lo, hi - lo, key));
+
+        TLX_BTREE_PRINT("BTree::find_upper: simd on " << n <<
+                        " key " << key << " -> " << lo);
+
+        // verify result using simple linear search
+        if (self_verify)
+        {
+            int i = 0;
+            while (i < n->slotuse && key_lessequal(n->key(i), key)) ++i;
+
+            TLX_BTREE_PRINT("BTree::find_upper testfind: " << i);
+            TLX_BTREE_ASSERT(i == lo);
+        }
+
+        return lo;
+    }
+
+    //! Searches for the first key in the node n greater than key using scalar
+    //! comparisons.
+    template <typename node_type>
+    int find_upper(const node_type* n, const key_type& key,
+                   std::false_type /* simd_search */) const {
         if (sizeof(*n) > traits::binsearch_threshold)
         {
             if (n->slotuse == 0) return 0;
@@ -1611,6 +2094,132 @@ public:
         return num;
     }
 
+    /*!
+     * Batched lookup of all keys in [first,last): writes find(key) for each
+     * key in order to out and returns the final output iterator. Up to
+     * find_batch_width lookups descend together, one level at a time, and
+     * the child nodes of each level are prefetched before the first of them is
+     * searched, such that the cache misses of different lookups overlap. If
+     * the keys are sorted, consecutive keys falling into the leaf found by the
+     * previous lookup are answered from that leaf without descending.
+     */
+    template <typename KeyIterator, typename OutputIterator>
+    OutputIterator find_batch(KeyIterator first, KeyIterator last,
+                              OutputIterator out) {
+        find_batch_descend(
+            first, last,
+            [this, &out](const LeafNode* leaf, unsigned short slot) {
+                *out++ = leaf ? iterator(const_cast<LeafNode*>(leaf), slot)
+                         : end();
+            });
+        return out;
+    }
+
+    //! Batched lookup of all keys in [first,last): writes find(key) for each
+    //! key in order to out and returns the final output iterator. See the
+    //! non-const find_batch() for details.
+    template <typename KeyIterator, typename OutputIterator>
+    OutputIterator find_batch(KeyIterator first, KeyIterator last,
+                              OutputIterator out) const {
+        find_batch_descend(
+            first, last,
+            [this, &out](const LeafNode* leaf, unsigned short slot) {
+                *out++ = leaf ? const_iterator(leaf, slot) : end();
+            });
+        return out;
+    }
+
+private:
+    //! Number of lookups advanced together by find_batch().
+    static const size_t find_batch_width = 16;
+
+    //! Prefetch the cache lines of a node, but at most the first kilobyte.
+    template <typename node_type>
+    static void prefetch_node(const node* n) {
+        const char* p = reinterpret_cast<const char*>(n);
+        const size_t bytes = std::min(sizeof(node_type), size_t(1024));
+        for (size_t i = 0; i < bytes; i += 64)
+            TLX_PREFETCH(p + i);
+    }
+
+    //! Search key in the leaf and call result(leaf, slot) if found, or
+    //! result(nullptr, 0) if not.
+    template <typename Result>
+    void find_batch_leaf(const LeafNode* leaf, const key_type& key,
+                         Result& result) const {
+        int slot = find_lower(leaf, key);
+        if (slot < leaf->slotuse && key_equal(key, leaf->key(slot)))
+            result(leaf, static_cast<unsigned short>(slot));
+        else
+            result(nullptr, 0);
+    }
+
+    //! Group prefetching descent for find_batch(), calls result() for each key
+    //! in [first,last) in order.
+    template <typename KeyIterator, typename Result>
+    void find_batch_descend(KeyIterator first, KeyIterator last,
+                            Result result) const {
+        const node* root = root_;
+        if (!root) {
+            for ( ; first != last; ++first) result(nullptr, 0);
+            return;
+        }
+
+        // group of lookups currently descending
+        const node* group[find_batch_width]; // NOLINT
+        KeyIterator keys[find_batch_width];  // NOLINT
+
+        // leaf found by the previous lookup and its key
+        const LeafNode* prev_leaf = nullptr;
+        KeyIterator prev_key = first;
+
+        while (first != last)
+        {
+            // keys in (prev_key, max key of prev_leaf] must also be in
+            // prev_leaf, which happens often for sorted batches.
+            while (first != last && prev_leaf &&
+                   key_lessequal(*prev_key, *first) &&
+                   key_lessequal(
+                       *first, prev_leaf->key(prev_leaf->slotuse - 1)))
+            {
+                find_batch_leaf(prev_leaf, *first, result);
+                prev_key = first++;
+            }
+
+            size_t n = 0;
+            for ( ; n < find_batch_width && first != last; ++n, ++first) {
+                group[n] = root;
+                keys[n] = first;
+            }
+            if (n == 0) break;
+
+            // advance all lookups by one level, all leaves have the same depth
+            for (unsigned short level = root->level; level > 0; --level)
+            {
+                for (size_t i = 0; i < n; ++i)
+                {
+                    const InnerNode* inner =
+                        static_cast<const InnerNode*>(group[i]);
+                    group[i] = inner->childid[find_lower(inner, *keys[i])];
+
+                    if (level > 1)
+                        prefetch_node<InnerNode>(group[i]);
+                    else
+                        prefetch_node<LeafNode>(group[i]);
+                }
+            }
+
+            for (size_t i = 0; i < n; ++i) {
+                find_batch_leaf(static_cast<const LeafNode*>(group[i]),
+                                *keys[i], result);
+            }
+
+            prev_leaf = static_cast<const LeafNode*>(group[n - 1]);
+            prev_key = keys[n - 1];
+        }
+    }
+
+public:
     //! Searches the B+ tree and returns an iterator to the first pair equal to
     //! or greater than key, or end() if all keys are smaller.
     iterator lower_bound(const key_type& key) {
@@ -1707,62 +2316,305 @@ public:
     //! \}
 
 public:
-    //! \name B+ Tree Object Comparison Functions
+    //! \name Order Statistics, requires traits::order_statistics
     //! \{
 
-    //! Equality relation of B+ trees of the same type. B+ trees of the same
-    //! size and equal elements (both key and data) are considered equal. Beware
-    //! of the random ordering of duplicate keys.
-    bool operator == (const BTree& other) const {
-        return (size() == other.size()) &&
-               std::equal(begin(), end(), other.begin());
-    }
+    //! Returns the number of items with keys less than key, which is the index
+    //! of lower_bound(key). Runs in O(log n) time.
+    template <bool OrderStatistics = order_statistics>
+    size_type rank(const key_type& key) const {
+        static_assert(OrderStatistics,
+                      "rank() requires traits::order_statistics");
 
-    //! Inequality relation. Based on operator==.
-    bool operator != (const BTree& other) const {
-        return !(*this == other);
-    }
+        const node* n = root_;
+        if (!n) return 0;
 
-    //! Total ordering relation of B+ trees of the same type. It uses
-    //! std::lexicographical_compare() for the actual comparison of elements.
-    bool operator < (const BTree& other) const {
-        return std::lexicographical_compare(
-            begin(), end(), other.begin(), other.end());
-    }
+        size_type rank = 0;
+        while (!n->is_leafnode())
+        {
+            const InnerNode* inner = static_cast<const InnerNode*>(n);
+            int slot = find_lower(inner, key);
 
-    //! Greater relation. Based on operator<.
-    bool operator > (const BTree& other) const {
-        return other < *this;
-    }
+            for (int s = 0; s < slot; ++s)
+                rank += inner->counts()[s];
 
-    //! Less-equal relation. Based on operator<.
-    bool operator <= (const BTree& other) const {
-        return !(other < *this);
+            n = inner->childid[slot];
+        }
+
+        return rank + find_lower(static_cast<const LeafNode*>(n), key);
     }
 
-    //! Greater-equal relation. Based on operator<.
-    bool operator >= (const BTree& other) const {
-        return !(*this < other);
+    //! Returns an iterator to the item with index k in sorted order, or end()
+    //! if k >= size(). Runs in O(log n) time.
+    template <bool OrderStatistics = order_statistics>
+    iterator select(size_type k) {
+        const_iterator it = static_cast<const BTree*>(this)->select(k);
+        return iterator(const_cast<LeafNode*>(it.curr_leaf), it.curr_slot);
     }
 
-    //! \}
+    //! Returns a constant iterator to the item with index k in sorted order,
+    //! or end() if k >= size(). Runs in O(log n) time.
+    template <bool OrderStatistics = order_statistics>
+    const_iterator select(size_type k) const {
+        static_assert(OrderStatistics,
+                      "select() requires traits::order_statistics");
 
-public:
-    //! \name Fast Copy: Assign Operator and Copy Constructors
-    //! \{
+        if (k >= size()) return end();
 
-    //! Assignment operator. All the key/data pairs are copied.
-    BTree& operator = (const BTree& other) {
-        if (this != &other)
+        const node* n = root_;
+        while (!n->is_leafnode())
         {
-            clear();
+            const InnerNode* inner = static_cast<const InnerNode*>(n);
+            unsigned short slot = 0;
 
-            key_less_ = other.key_comp();
-            allocator_ = other.get_allocator();
+            while (k >= inner->counts()[slot])
+                k -= inner->counts()[slot++];
 
-            if (other.size() != 0)
-            {
-                stats_.leaves = stats_.inner_nodes = 0;
+            n = inner->childid[slot];
+        }
+
+        return const_iterator(static_cast<const LeafNode*>(n),
+                              static_cast<unsigned short>(k));
+    }
+
+    //! Returns the index of the item referenced by iter in sorted order, or
+    //! size() for end(). Runs in O(log n) time, plus the number of leaves
+    //! holding duplicates of the item's key before it.
+    template <bool OrderStatistics = order_statistics>
+    size_type index_of(const_iterator iter) const {
+        static_assert(OrderStatistics,
+                      "index_of() requires traits::order_statistics");
+
+        if (iter == end()) return size();
+
+        // descend to the first item with iter's key, like rank().
+        const key_type& key = iter.key();
+        const node* n = root_;
+
+        size_type index = 0;
+        while (!n->is_leafnode())
+        {
+            const InnerNode* inner = static_cast<const InnerNode*>(n);
+            int slot = find_lower(inner, key);
+
+            for (int s = 0; s < slot; ++s)
+                index += inner->counts()[s];
+
+            n = inner->childid[slot];
+        }
+
+        // walk the leaves with duplicates until reaching iter's leaf.
+        const LeafNode* leaf = static_cast<const LeafNode*>(n);
+        while (leaf != iter.curr_leaf)
+        {
+            index += leaf->slotuse;
+            leaf = leaf->next_leaf;
+        }
+
+        return index + iter.curr_slot;
+    }
+
+    //! Returns the number of items in the range [first,last), which is
+    //! std::distance(first, last) in O(log n) instead of O(n) time.
+    template <bool OrderStatistics = order_statistics>
+    size_type count_range(const_iterator first, const_iterator last) const {
+        return index_of(last) - index_of(first);
+    }
+
+    //! \}
+
+public:
+    //! \name Subtree Aggregates, requires traits::aggregate
+    //! \{
+
+    //! Returns the aggregate of all items, combined in key order, in O(B)
+    //! time.
+    template <bool Augmented = augmented>
+    aggregate_type aggregate() const {
+        static_assert(Augmented, "aggregate() requires traits::aggregate");
+        return root_ ? subtree_aggregate(root_) : aggregate_monoid::identity();
+    }
+
+    //! Returns the aggregate of the items with keys in the range [lo,hi),
+    //! combined in key order. Only the subtrees on the paths to the two bounds
+    //! are visited, hence this runs in O(B log n) instead of O(n) time.
+    template <bool Augmented = augmented>
+    aggregate_type aggregate(const key_type& lo, const key_type& hi) const {
+        static_assert(Augmented, "aggregate() requires traits::aggregate");
+
+        if (!root_ || !key_less(lo, hi))
+            return aggregate_monoid::identity();
+
+        return aggregate_descend(root_, &lo, &hi);
+    }
+
+    //! Recomputes the cached aggregates of all subtrees containing items with
+    //! the given key, which must be called after changing the data of these
+    //! items in place, e.g. via an iterator or operator[] of btree_map.
+    template <bool Augmented = augmented>
+    void update_aggregate(const key_type& key) {
+        static_assert(Augmented,
+                      "update_aggregate() requires traits::aggregate");
+
+        if (!root_ || root_->is_leafnode()) return;
+        update_aggregate_descend(
+            static_cast<InnerNode*>(unshare(root_)), key);
+    }
+
+private:
+    //! Aggregate of the items in the subtree n with keys in [*lo,*hi). A null
+    //! bound is unlimited, which is the case below the paths to the bounds.
+    aggregate_type aggregate_descend(const node* n, const key_type* lo,
+                                     const key_type* hi) const {
+        if (n->is_leafnode())
+        {
+            const LeafNode* leaf = static_cast<const LeafNode*>(n);
+            int first = lo ? find_lower(leaf, *lo) : 0;
+            int last = hi ? find_lower(leaf, *hi) : leaf->slotuse;
+
+            aggregate_type agg = aggregate_monoid::identity();
+            for (int slot = first; slot < last; ++slot) {
+                agg = aggregate_monoid::combine(
+                    agg, aggregate_monoid::item(leaf->slotdata[slot]));
+            }
+            return agg;
+        }
+
+        // children before first have only keys less than lo, and children
+        // after last only keys greater or equal to hi.
+        const InnerNode* inner = static_cast<const InnerNode*>(n);
+        int first = lo ? find_lower(inner, *lo) : 0;
+        int last = hi ? find_lower(inner, *hi) : inner->slotuse;
+
+        if (first == last)
+            return aggregate_descend(inner->childid[first], lo, hi);
+
+        aggregate_type agg =
+            lo ? aggregate_descend(inner->childid[first], lo, nullptr)
+            : inner->aggregates()[first];
+        for (int slot = first + 1; slot < last; ++slot)
+            agg = aggregate_monoid::combine(agg, inner->aggregates()[slot]);
+
+        return aggregate_monoid::combine(
+            agg, hi ? aggregate_descend(inner->childid[last], nullptr, hi)
+            : inner->aggregates()[last]);
+    }
+
+    //! Recompute the aggregates of the children of inner which may contain
+    //! items with key, after descending into them.
+    void update_aggregate_descend(InnerNode* inner, const key_type& key) {
+        int first = find_lower(inner, key);
+        int last = std::min<int>(find_upper(inner, key), inner->slotuse);
+
+        for (int slot = first; slot <= last; ++slot)
+        {
+            if (!inner->childid[slot]->is_leafnode()) {
+                update_aggregate_descend(
+                    static_cast<InnerNode*>(unshare(inner->childid[slot])),
+                    key);
+            }
+            inner->aggregates()[slot] =
+                subtree_aggregate(inner->childid[slot]);
+        }
+    }
+
+    //! \}
+
+public:
+    //! \name Copy-on-Write Snapshots, requires traits::copy_on_write
+    //! \{
+
+    class Snapshot;
+
+    //! Returns a read-only view of the current contents in O(1) time. The
+    //! snapshot shares all nodes with the tree, and subsequent modifications
+    //! of the tree copy only the shared nodes on the root-to-leaf paths they
+    //! touch. Snapshots may be read and destroyed by other threads while the
+    //! tree is modified, but snapshot() itself must not run concurrently with
+    //! modifications. Items must only be changed via insert(), erase() or the
+    //! iterators returned by insert(), as writing through other iterators
+    //! would also change the snapshots.
+    template <bool CopyOnWrite = copy_on_write>
+    Snapshot snapshot() const {
+        static_assert(CopyOnWrite, "snapshot() requires traits::copy_on_write");
+        return Snapshot(*this);
+    }
+
+    //! \}
+
+public:
+    //! \name Freezing into a Read-Only Tree
+    //! \{
+
+    //! Immutable, read-optimized copy of the tree, see FrozenBTree.
+    typedef FrozenBTree<key_type, value_type, key_of_value, key_compare>
+        frozen_type;
+
+    //! Returns an immutable copy of all items in one contiguous memory block
+    //! without pointers, which answers lookups faster than the B+ tree.
+    frozen_type freeze() const {
+        return frozen_type(begin(), end(), key_less_);
+    }
+
+    //! \}
+
+public:
+    //! \name B+ Tree Object Comparison Functions
+    //! \{
+
+    //! Equality relation of B+ trees of the same type. B+ trees of the same
+    //! size and equal elements (both key and data) are considered equal. Beware
+    //! of the random ordering of duplicate keys.
+    bool operator == (const BTree& other) const {
+        return (size() == other.size()) &&
+               std::equal(begin(), end(), other.begin());
+    }
+
+    //! Inequality relation. Based on operator==.
+    bool operator != (const BTree& other) const {
+        return !(*this == other);
+    }
+
+    //! Total ordering relation of B+ trees of the same type. It uses
+    //! std::lexicographical_compare() for the actual comparison of elements.
+    bool operator < (const BTree& other) const {
+        return std::lexicographical_compare(
+            begin(), end(), other.begin(), other.end());
+    }
+
+    //! Greater relation. Based on operator<.
+    bool operator > (const BTree& other) const {
+        return other < *this;
+    }
+
+    //! Less-equal relation. Based on operator<.
+    bool operator <= (const BTree& other) const {
+        return !(other < *this);
+    }
+
+    //! Greater-equal relation. Based on operator<.
+    bool operator >= (const BTree& other) const {
+        return !(*this < other);
+    }
+
+    //! \}
+
+public:
+    //! \name Fast Copy: Assign Operator and Copy Constructors
+    //! \{
+
+    //! Assignment operator. All the key/data pairs are copied.
+    BTree& operator = (const BTree& other) {
+        if (this != &other)
+        {
+            clear();
+
+            key_less_ = other.key_comp();
+            allocator_ = other.get_allocator();
+
+            if (other.size() != 0)
+            {
+                stats_.leaves = stats_.inner_nodes = 0;
                 if (other.root_) {
                     root_ = copy_recursive(other.root_);
                 }
@@ -1831,6 +2683,16 @@ private:
                 newinner->childid[slot] = copy_recursive(inner->childid[slot]);
             }
 
+            if (order_statistics) {
+                std::copy(inner->counts(), inner->counts() + inner->slotuse + 1,
+                          newinner->counts());
+            }
+            if (augmented) {
+                std::copy(inner->aggregates(),
+                          inner->aggregates() + inner->slotuse + 1,
+                          newinner->aggregates());
+            }
+
             return newinner;
         }
     }
@@ -1866,12 +2728,106 @@ public:
         }
     }
 
+    /*!
+     * Insert the sorted range [first,last) of value_type pairs. If all keys
+     * are greater than the tree's and Iterator is a random access iterator,
+     * the range is bulk loaded into a new tree which is appended by join().
+     * Otherwise the items are inserted in order, and while an item belongs
+     * into the leaf which received the previous one, it is put there without
+     * descending from the root. If duplicates are not allowed, items with
+     * existing keys are skipped.
+     */
+    template <typename Iterator>
+    void insert_sorted(Iterator first, Iterator last) {
+        insert_sorted(
+            first, last,
+            typename std::iterator_traits<Iterator>::iterator_category());
+
+        if (self_verify) verify();
+    }
+
     //! \}
 
 private:
     //! \name Private Insertion Functions
     //! \{
 
+    //! Insert a sorted random access range, see insert_sorted().
+    template <typename Iterator>
+    void insert_sorted(Iterator first, Iterator last,
+                       std::random_access_iterator_tag) {
+        if (first == last) return;
+
+        if (empty() || join_order(tail_leaf_->key(tail_leaf_->slotuse - 1),
+                                  key_of_value::get(*first)))
+        {
+            // bulk_load() requires unique keys if duplicates are not allowed
+            if (allow_duplicates ||
+                std::adjacent_find(
+                    first, last,
+                    [this](const value_type& a, const value_type& b) {
+                        return key_equal(key_of_value::get(a),
+                                         key_of_value::get(b));
+                    }) == last)
+            {
+                BTree run(key_less_, allocator_);
+                run.bulk_load(first, last);
+                return join(run);
+            }
+        }
+
+        insert_sorted(first, last, std::input_iterator_tag());
+    }
+
+    //! Insert a sorted range item by item, see insert_sorted().
+    template <typename Iterator>
+    void insert_sorted(Iterator first, Iterator last,
+                       std::input_iterator_tag) {
+        LeafNode* leaf = nullptr;
+        for ( ; first != last; ++first)
+        {
+            const value_type& value = *first;
+            if (!insert_sorted_leaf(leaf, value))
+                leaf = insert_start(key_of_value::get(value), value)
+                       .first.curr_leaf;
+        }
+    }
+
+    /*!
+     * Insert value into leaf, which received the previous item of a sorted
+     * run, if its key belongs there and the leaf is not full. All separators
+     * are maximum keys of non-last subtrees, hence keys up to the leaf's
+     * greatest key, or any key in the last leaf, do not change them. The
+     * subtree counts and aggregates on the path are unknown, thus this is
+     * never done with order_statistics or augmented. Returns false if value
+     * must be inserted from the root.
+     */
+    bool insert_sorted_leaf(LeafNode* leaf, const value_type& value) {
+        if (order_statistics || augmented || !leaf || leaf->is_full())
+            return false;
+
+        const key_type& key = key_of_value::get(value);
+        if (leaf != tail_leaf_ &&
+            key_less(leaf->key(leaf->slotuse - 1), key))
+            return false;
+
+        int slot = find_lower(leaf, key);
+
+        if (!allow_duplicates &&
+            slot < leaf->slotuse && key_equal(key, leaf->key(slot)))
+            return true;
+
+        std::copy_backward(
+            leaf->slotdata + slot, leaf->slotdata + leaf->slotuse,
+            leaf->slotdata + leaf->slotuse + 1);
+
+        leaf->slotdata[slot] = value;
+        leaf->slotuse++;
+
+        ++stats_.size;
+        return true;
+    }
+
     //! Start the insertion descent at the current root and handle root splits.
     //! Returns true if the item was inserted
     std::pair<iterator, bool>
@@ -1883,6 +2839,7 @@ private:
         if (root_ == nullptr) {
             root_ = head_leaf_ = tail_leaf_ = allocate_leaf();
         }
+        unshare(root_);
 
         std::pair<iterator, bool> r =
             insert_descend(root_, key, value, &newkey, &newchild);
@@ -1899,6 +2856,7 @@ private:
             newroot->childid[1] = newchild;
 
             newroot->slotuse = 1;
+            update_counts(newroot, 0, 1);
 
             root_ = newroot;
         }
@@ -1942,7 +2900,7 @@ private:
                 "BTree::insert_descend into " << inner->childid[slot]);
 
             std::pair<iterator, bool> r =
-                insert_descend(inner->childid[slot],
+                insert_descend(unshare(inner->childid[slot]),
                                key, value, &newkey, &newchild);
 
             if (newchild)
@@ -1993,6 +2951,9 @@ private:
                         split->childid[0] = newchild;
                         *splitkey = newkey;
 
+                        update_counts(inner, inner->slotuse, inner->slotuse);
+                        update_counts(split, 0, 0);
+
                         return r;
                     }
                     else if (slot >= inner->slotuse + 1)
@@ -2017,10 +2978,33 @@ private:
                 std::copy_backward(
                     inner->childid + slot, inner->childid + inner->slotuse + 1,
                     inner->childid + inner->slotuse + 2);
+                if (order_statistics) {
+                    std::copy_backward(
+                        inner->counts() + slot,
+                        inner->counts() + inner->slotuse + 1,
+                        inner->counts() + inner->slotuse + 2);
+                }
+                if (augmented) {
+                    std::copy_backward(
+                        inner->aggregates() + slot,
+                        inner->aggregates() + inner->slotuse + 1,
+                        inner->aggregates() + inner->slotuse + 2);
+                }
 
                 inner->slotkey[slot] = newkey;
                 inner->childid[slot + 1] = newchild;
                 inner->slotuse++;
+
+                update_counts(inner, slot, slot + 1);
+            }
+            else if (r.second)
+            {
+                if (order_statistics)
+                    inner->counts()[slot]++;
+                if (augmented) {
+                    inner->aggregates()[slot] =
+                        subtree_aggregate(inner->childid[slot]);
+                }
             }
 
             return r;
@@ -2136,6 +3120,16 @@ private:
                   newinner->slotkey);
         std::copy(inner->childid + mid + 1, inner->childid + inner->slotuse + 1,
                   newinner->childid);
+        if (order_statistics) {
+            std::copy(inner->counts() + mid + 1,
+                      inner->counts() + inner->slotuse + 1,
+                      newinner->counts());
+        }
+        if (augmented) {
+            std::copy(inner->aggregates() + mid + 1,
+                      inner->aggregates() + inner->slotuse + 1,
+                      newinner->aggregates());
+        }
 
         inner->slotuse = mid;
 
@@ -2233,68 +3227,966 @@ public:
                 n->childid[s] = leaf;
                 leaf = leaf->next_leaf;
             }
-            n->childid[n->slotuse] = leaf;
+            n->childid[n->slotuse] = leaf;
+            update_counts(n, 0, n->slotuse);
+
+            // track max key of any descendant.
+            nextlevel[i].first = n;
+            nextlevel[i].second = &leaf->key(leaf->slotuse - 1);
+
+            leaf = leaf->next_leaf;
+            num_leaves -= n->slotuse + 1;
+        }
+
+        TLX_BTREE_ASSERT(leaf == nullptr && num_leaves == 0);
+
+        // recursively build inner nodes pointing to inner nodes.
+        for (int level = 2; num_parents != 1; ++level)
+        {
+            size_t num_children = num_parents;
+            num_parents =
+                (num_children + (inner_slotmax + 1) - 1) / (inner_slotmax + 1);
+
+            TLX_BTREE_PRINT(
+                "BTree::bulk_load, level " << level <<
+                    ": " << num_children << " children in " <<
+                    num_parents << " inner nodes with up to " <<
+                ((num_children + num_parents - 1) / num_parents) <<
+                    " children per inner node.");
+
+            size_t inner_index = 0;
+            for (size_t i = 0; i < num_parents; ++i)
+            {
+                // allocate new inner node at level
+                InnerNode* n = allocate_inner(level);
+
+                n->slotuse = static_cast<int>(num_children / (num_parents - i));
+                TLX_BTREE_ASSERT(n->slotuse > 0);
+                // this counts keys, but an inner node has keys+1 children.
+                --n->slotuse;
+
+                // copy children and maxkeys from nextlevel
+                for (unsigned short s = 0; s < n->slotuse; ++s)
+                {
+                    n->slotkey[s] = *nextlevel[inner_index].second;
+                    n->childid[s] = nextlevel[inner_index].first;
+                    ++inner_index;
+                }
+                n->childid[n->slotuse] = nextlevel[inner_index].first;
+                update_counts(n, 0, n->slotuse);
+
+                // reuse nextlevel array for parents, because we can overwrite
+                // slots we've already consumed.
+                nextlevel[i].first = n;
+                nextlevel[i].second = nextlevel[inner_index].second;
+
+                ++inner_index;
+                num_children -= n->slotuse + 1;
+            }
+
+            TLX_BTREE_ASSERT(num_children == 0);
+        }
+
+        root_ = nextlevel[0].first;
+        delete[] nextlevel;
+
+        if (self_verify) verify();
+    }
+
+    /*!
+     * Bulk load a sorted range in parallel using the threads of pool. The
+     * resulting tree is identical to the one constructed by the sequential
+     * bulk_load(): it has the same number of levels, and each node has the same
+     * keys and slot counts. The leaves are filled by independent jobs, then
+     * each inner level is constructed in parallel from the level below. The
+     * calling thread takes part and waits only for the jobs of this call,
+     * hence it may itself run in a job of pool. The tree must be empty,
+     * Iterator must be a random access iterator, and the node allocator must
+     * be thread-safe.
+     */
+    template <typename Iterator>
+    void bulk_load(Iterator ibegin, Iterator iend, ThreadPool& pool) {
+        TLX_BTREE_ASSERT(empty());
+
+        size_t num_items = iend - ibegin;
+        size_t num_leaves = (num_items + leaf_slotmax - 1) / leaf_slotmax;
+
+        stats_.size = num_items;
+        if (num_leaves == 0) return;
+
+        TLX_BTREE_PRINT("BTree::bulk_load, level 0: " << stats_.size <<
+                        " items into " << num_leaves <<
+                        " leaves using " << pool.size() << " threads.");
+
+        // nodes and their maxkey, first of the leaves then of each level.
+        typedef std::pair<node*, const key_type*> nextlevel_type;
+        std::vector<nextlevel_type> level(num_leaves);
+
+        bulk_load_parallel(
+            pool, num_leaves, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i)
+                {
+                    size_t first =
+                        bulk_load_offset(i, num_items, num_leaves);
+                    size_t last =
+                        bulk_load_offset(i + 1, num_items, num_leaves);
+
+                    LeafNode* leaf = construct_leaf();
+                    leaf->slotuse = static_cast<unsigned short>(last - first);
+
+                    Iterator it = ibegin + first;
+                    for (size_t s = 0; s < leaf->slotuse; ++s, ++it)
+                        leaf->set_slot(s, *it);
+
+                    level[i].first = leaf;
+                    level[i].second = &leaf->key(leaf->slotuse - 1);
+                }
+            });
+
+        // link leaves, which may have been allocated by different jobs.
+        bulk_load_parallel(
+            pool, num_leaves, [&](size_t begin, size_t end) {
+                for (size_t i = std::max<size_t>(begin, 1); i < end; ++i)
+                {
+                    LeafNode* prev = static_cast<LeafNode*>(level[i - 1].first);
+                    LeafNode* leaf = static_cast<LeafNode*>(level[i].first);
+                    prev->next_leaf = leaf;
+                    leaf->prev_leaf = prev;
+                }
+            });
+
+        stats_.leaves += num_leaves;
+        head_leaf_ = static_cast<LeafNode*>(level.front().first);
+        tail_leaf_ = static_cast<LeafNode*>(level.back().first);
+
+        // build inner levels bottom-up, each from the one below.
+        for (unsigned short height = 1; level.size() != 1; ++height)
+        {
+            size_t num_children = level.size();
+            size_t num_parents =
+                (num_children + (inner_slotmax + 1) - 1) / (inner_slotmax + 1);
+
+            TLX_BTREE_PRINT(
+                "BTree::bulk_load, level " << height <<
+                    ": " << num_children << " children in " <<
+                    num_parents << " inner nodes.");
+
+            std::vector<nextlevel_type> parents(num_parents);
+
+            bulk_load_parallel(
+                pool, num_parents, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        size_t first =
+                            bulk_load_offset(i, num_children, num_parents);
+                        size_t last =
+                            bulk_load_offset(i + 1, num_children, num_parents);
+
+                        InnerNode* n = construct_inner(height);
+                        // this counts keys, an inner node has keys+1 children.
+                        n->slotuse = static_cast<unsigned short>(
+                            last - first - 1);
+
+                        for (unsigned short s = 0; s < n->slotuse; ++s)
+                        {
+                            n->slotkey[s] = *level[first + s].second;
+                            n->childid[s] = level[first + s].first;
+                        }
+                        n->childid[n->slotuse] = level[last - 1].first;
+                        update_counts(n, 0, n->slotuse);
+
+                        parents[i].first = n;
+                        parents[i].second = level[last - 1].second;
+                    }
+                });
+
+            stats_.inner_nodes += num_parents;
+            level.swap(parents);
+        }
+
+        root_ = level[0].first;
+
+        if (self_verify) verify();
+    }
+
+    //! Bulk load a sorted range in parallel using a new ThreadPool with
+    //! num_threads threads. See bulk_load(ibegin, iend, pool).
+    template <typename Iterator>
+    void bulk_load(Iterator ibegin, Iterator iend, size_t num_threads) {
+        ThreadPool pool(num_threads);
+        bulk_load(ibegin, iend, pool);
+    }
+
+private:
+    //! Offset of part i when splitting n items into parts like bulk_load():
+    //! the sequential loader assigns n_rem / parts_rem items to each part,
+    //! hence the last n % parts parts receive one item more.
+    static size_t bulk_load_offset(size_t i, size_t n, size_t parts) {
+        size_t base = n / parts, larger = parts - n % parts;
+        return i * base + (i > larger ? i - larger : 0);
+    }
+
+    //! Run func(begin, end) on a few ranges per thread splitting [0,n), and
+    //! wait for all of them. Small ranges are processed by the caller.
+    template <typename Functor>
+    static void bulk_load_parallel(ThreadPool& pool, size_t n,
+                                   const Functor& func) {
+        size_t num_jobs = std::min(n / 64, 4 * pool.size());
+        if (num_jobs <= 1)
+            return func(0, n);
+
+        run_parallel_jobs(
+            pool, num_jobs, [&func, n, num_jobs](size_t j) {
+                func(j * n / num_jobs, (j + 1) * n / num_jobs);
+            });
+    }
+
+    //! \}
+
+public:
+    //! \name Partitioning and Parallel Iteration
+    //! \{
+
+    /*!
+     * Split the items into parts consecutive ranges of about equal size and
+     * return their parts + 1 boundaries, which start with begin() and end with
+     * end(). With order_statistics, the sizes of the ranges differ by at most
+     * one and the boundaries are found by select(). Otherwise, the sizes of
+     * subtrees are estimated from the fan-out of their roots while descending
+     * to each boundary, hence the sizes of the ranges vary only with the fill
+     * of the nodes further below. Runs in O(parts B log n) time.
+     */
+    std::vector<const_iterator> partition(size_t parts) const {
+        std::vector<const_iterator> bounds;
+        bounds.reserve(parts + 1);
+        for (size_t i = 0; i < parts; ++i) {
+            bounds.push_back(partition_bound(
+                                 i, parts, std::integral_constant<
+                                     bool, order_statistics>()));
+        }
+        bounds.push_back(end());
+        return bounds;
+    }
+
+    //! Split the items into parts consecutive ranges of about equal size and
+    //! return their parts + 1 boundaries, see partition() const.
+    std::vector<iterator> partition(size_t parts) {
+        std::vector<const_iterator> cbounds =
+            static_cast<const BTree*>(this)->partition(parts);
+
+        std::vector<iterator> bounds;
+        bounds.reserve(cbounds.size());
+        for (size_t i = 0; i < cbounds.size(); ++i) {
+            bounds.push_back(
+                iterator(const_cast<LeafNode*>(cbounds[i].curr_leaf),
+                         cbounds[i].curr_slot));
+        }
+        return bounds;
+    }
+
+    //! Call func(value) for each item, where the items are split into a few
+    //! ranges per thread of pool by partition(). The ranges are processed
+    //! concurrently in no particular order, hence func must be thread-safe.
+    //! The tree must not be modified meanwhile, except for changing the data
+    //! of the items passed to func. The calling thread takes part and waits
+    //! only for the ranges of this call, hence it may itself run in a job of
+    //! pool.
+    template <typename Functor>
+    void parallel_for_each(const Functor& func, ThreadPool& pool) {
+        parallel_for_each_range(
+            partition(parallel_for_each_parts(pool)), func, pool);
+    }
+
+    //! Call func(value) for each item in parallel using the threads of pool,
+    //! see parallel_for_each(func, pool).
+    template <typename Functor>
+    void parallel_for_each(const Functor& func, ThreadPool& pool) const {
+        parallel_for_each_range(
+            partition(parallel_for_each_parts(pool)), func, pool);
+    }
+
+    //! Call func(value) for each item in parallel using a new ThreadPool with
+    //! num_threads threads, see parallel_for_each(func, pool).
+    template <typename Functor>
+    void parallel_for_each(const Functor& func, size_t num_threads) {
+        ThreadPool pool(num_threads);
+        parallel_for_each(func, pool);
+    }
+
+    //! Call func(value) for each item in parallel using a new ThreadPool with
+    //! num_threads threads, see parallel_for_each(func, pool).
+    template <typename Functor>
+    void parallel_for_each(const Functor& func, size_t num_threads) const {
+        ThreadPool pool(num_threads);
+        parallel_for_each(func, pool);
+    }
+
+private:
+    //! Boundary i of partition() found by select().
+    const_iterator partition_bound(size_t i, size_t parts,
+                                   std::true_type) const {
+        size_type n = size();
+        return select(n / parts * i + n % parts * i / parts);
+    }
+
+    //! Boundary i of partition() found by descending to the relative position
+    //! i / parts of the subtree in each node. The sizes of the children's
+    //! subtrees are estimated to be proportional to their fan-out.
+    const_iterator partition_bound(size_t i, size_t parts,
+                                   std::false_type) const {
+        if (i == 0 || empty()) return begin();
+
+        double pos = static_cast<double>(i) / static_cast<double>(parts);
+        const node* n = root_;
+        while (!n->is_leafnode())
+        {
+            const InnerNode* inner = static_cast<const InnerNode*>(n);
+            const unsigned short extra = inner->level > 1 ? 1 : 0;
+
+            size_t total = 0;
+            for (unsigned short s = 0; s <= inner->slotuse; ++s)
+                total += inner->childid[s]->slotuse + extra;
+
+            // find the child containing position x of the weighted children
+            double x = pos * static_cast<double>(total);
+            unsigned short slot = 0;
+            size_t weight = inner->childid[0]->slotuse + extra;
+            while (slot < inner->slotuse && x >= static_cast<double>(weight))
+            {
+                x -= static_cast<double>(weight);
+                weight = inner->childid[++slot]->slotuse + extra;
+            }
+
+            pos = std::min(x / static_cast<double>(weight), 1.0);
+            n = inner->childid[slot];
+        }
+
+        const LeafNode* leaf = static_cast<const LeafNode*>(n);
+        unsigned short slot = static_cast<unsigned short>(
+            std::min<double>(pos * leaf->slotuse, leaf->slotuse - 1));
+        return const_iterator(leaf, slot);
+    }
+
+    //! Number of ranges processed by parallel_for_each(): a few per thread
+    //! for load balancing, but at most one per 64 items.
+    size_t parallel_for_each_parts(const ThreadPool& pool) const {
+        return std::max<size_t>(1, std::min(size() / 64, 4 * pool.size()));
+    }
+
+    //! Call func for the items of the ranges between bounds in pool and the
+    //! calling thread, and wait for all of them, see run_parallel_jobs(). A
+    //! single range is processed by the caller.
+    template <typename Iterator, typename Functor>
+    static void parallel_for_each_range(
+        const std::vector<Iterator>& bounds, const Functor& func,
+        ThreadPool& pool) {
+        if (bounds.size() <= 2) {
+            for (Iterator it = bounds.front(); it != bounds.back(); ++it)
+                func(*it);
+            return;
+        }
+
+        run_parallel_jobs(
+            pool, bounds.size() - 1, [&bounds, &func](size_t i) {
+                for (Iterator it = bounds[i]; it != bounds[i + 1]; ++it)
+                    func(*it);
+            });
+    }
+
+    //! \}
+
+public:
+    //! \name Joining, Merging and Splitting Trees
+    //! \{
+
+    /*!
+     * Append all items of other to this tree and leave other empty. All keys
+     * in other must be greater than the keys in this tree, or greater or
+     * equal if duplicates are allowed. The root of the smaller tree is
+     * grafted onto the spine of the larger one, hence this takes O(log n)
+     * time. If the allocators differ, other's items are copied into a new
+     * tree first.
+     */
+    void join(BTree& other) {
+        if (other.empty()) return;
+
+        if (allocator_ != other.allocator_) {
+            // nodes cannot change allocators, rebuild other's items
+            BTree copy(key_less_, allocator_);
+            std::vector<value_type> items(other.begin(), other.end());
+            copy.bulk_load(items.begin(), items.end());
+            other.clear();
+            return join(copy);
+        }
+
+        if (empty()) {
+            swap(other);
+            return;
+        }
+
+        TLX_BTREE_ASSERT(
+            allow_duplicates ?
+            key_lessequal(tail_leaf_->key(tail_leaf_->slotuse - 1),
+                          other.head_leaf_->key(0)) :
+            key_less(tail_leaf_->key(tail_leaf_->slotuse - 1),
+                     other.head_leaf_->key(0)));
+
+        TLX_BTREE_PRINT("BTree::join() of " << size() <<
+                        " and " << other.size() << " items");
+
+        stats_.size += other.stats_.size;
+        stats_.leaves += other.stats_.leaves;
+        stats_.inner_nodes += other.stats_.inner_nodes;
+
+        other.stats_ = tree_stats();
+
+        join_tree(other);
+
+        if (self_verify) verify();
+    }
+
+    /*!
+     * Move all items of other into this tree. If the key ranges of the trees
+     * do not overlap, they are joined in O(log n) time by join(). Otherwise,
+     * the items of both are merged linearly and the tree is rebuilt bottom-up
+     * like in bulk_load(). As in std::set::merge(), if duplicates are not
+     * allowed, items of other whose keys already exist remain in other.
+     */
+    void merge(BTree& other) {
+        if (other.empty()) return;
+
+        if (empty() ||
+            join_order(tail_leaf_->key(tail_leaf_->slotuse - 1),
+                       other.head_leaf_->key(0))) {
+            return join(other);
+        }
+        if (allocator_ == other.allocator_ &&
+            join_order(other.tail_leaf_->key(other.tail_leaf_->slotuse - 1),
+                       head_leaf_->key(0))) {
+            other.join(*this);
+            return swap(other);
+        }
+
+        TLX_BTREE_PRINT("BTree::merge() of " << size() <<
+                        " and " << other.size() << " overlapping items");
+
+        std::vector<value_type> items, rest;
+        items.reserve(size() + other.size());
+
+        const BTree& ca = *this, & cb = other;
+        const_iterator a = ca.begin(), b = cb.begin();
+        while (a != ca.end() && b != cb.end())
+        {
+            if (key_less(b.key(), a.key()))
+                items.push_back(*b++);
+            else if (!allow_duplicates && !key_less(a.key(), b.key()))
+                rest.push_back(*b++);
+            else
+                items.push_back(*a++);
+        }
+        items.insert(items.end(), a, ca.end());
+        items.insert(items.end(), b, cb.end());
+
+        clear();
+        bulk_load(items.begin(), items.end());
+
+        other.clear();
+        other.bulk_load(rest.begin(), rest.end());
+    }
+
+    /*!
+     * Split the tree at key: all items with keys equal to or greater than key
+     * are moved into the empty tree right, the smaller ones remain. The tree is
+     * cut along the path to key and the fragments on either side are joined,
+     * such that restructuring takes O(log n) time. To keep get_stats() exact,
+     * the nodes of the part with fewer leaves are counted, hence split() takes
+     * O(log n + m) time in total, where m is the number of items in the smaller
+     * part. If the allocators differ, right is rebuilt from a copy of its
+     * items.
+     */
+    void split(const key_type& key, BTree& right) {
+        TLX_BTREE_ASSERT(right.empty());
+        right.clear();
+
+        if (!root_) return;
+
+        if (allocator_ != right.allocator_) {
+            // nodes cannot change allocators, split a temporary tree
+            BTree tmp(key_less_, allocator_);
+            split(key, tmp);
+            std::vector<value_type> items(tmp.begin(), tmp.end());
+            right.bulk_load(items.begin(), items.end());
+            return;
+        }
+
+        TLX_BTREE_PRINT("BTree::split() at " << key << " of " << size() <<
+                        " items");
+
+        split_tree(key, right);
+
+        // count the part with fewer leaves, found by walking both lists
+        const LeafNode* l = tail_leaf_, * r = right.head_leaf_;
+        while (l && r) {
+            l = l->prev_leaf;
+            r = r->next_leaf;
+        }
+
+        BTree& counted = l ? right : *this;
+        BTree& remaining = l ? *this : right;
+
+        // the node counts of both parts are still in stats_
+        tree_stats total = stats_, part;
+        if (counted.root_) count_nodes(counted.root_, part);
+
+        remaining.stats_.size = total.size - part.size;
+        remaining.stats_.leaves = total.leaves - part.leaves;
+        remaining.stats_.inner_nodes = total.inner_nodes - part.inner_nodes;
+        counted.stats_ = part;
+
+        if (self_verify) {
+            verify();
+            right.verify();
+        }
+    }
+
+    //! \}
+
+private:
+    //! \name Joining and Splitting Support Functions
+    //! \{
+
+    //! True if a tree with greatest key a can be joined with a tree with
+    //! smallest key b.
+    bool join_order(const key_type& a, const key_type& b) const {
+        return allow_duplicates ? key_lessequal(a, b) : key_less(a, b);
+    }
+
+    //! First leaf below n.
+    static LeafNode * first_leaf(node* n) {
+        while (!n->is_leafnode())
+            n = static_cast<InnerNode*>(n)->childid[0];
+        return static_cast<LeafNode*>(n);
+    }
+
+    //! Last leaf below n.
+    static LeafNode * last_leaf(node* n) {
+        while (!n->is_leafnode()) {
+            InnerNode* inner = static_cast<InnerNode*>(n);
+            n = inner->childid[inner->slotuse];
+        }
+        return static_cast<LeafNode*>(n);
+    }
+
+    //! Append the nodes of other to this tree, as in join(), but leave the
+    //! stats_ of both trees unchanged.
+    void join_tree(BTree& other) {
+        if (!other.root_) return;
+
+        if (!root_) {
+            std::swap(root_, other.root_);
+            std::swap(head_leaf_, other.head_leaf_);
+            std::swap(tail_leaf_, other.tail_leaf_);
+            return;
+        }
+
+        // the separator is the greatest key of the left tree
+        key_type sep = tail_leaf_->key(tail_leaf_->slotuse - 1);
+
+        tail_leaf_->next_leaf = other.head_leaf_;
+        other.head_leaf_->prev_leaf = tail_leaf_;
+        tail_leaf_ = other.tail_leaf_;
+
+        node* right = other.root_;
+        other.root_ = nullptr;
+        other.head_leaf_ = other.tail_leaf_ = nullptr;
+
+        root_ = join_nodes(root_, sep, right);
+    }
+
+    //! Move the nodes of all items with keys equal to or greater than key into
+    //! the empty tree right, as in split(), but leave the stats_ of both trees
+    //! unchanged. Nodes allocated or freed are counted in this tree's stats_.
+    void split_tree(const key_type& key, BTree& right) {
+        node* left_root = nullptr, * right_root = nullptr;
+        split_descend(unshare(root_), key, &left_root, &right_root);
+
+        // cut the leaf list between the two trees
+        LeafNode* left_tail = left_root ? last_leaf(left_root) : nullptr;
+        LeafNode* right_head = right_root ? first_leaf(right_root) : nullptr;
+        if (left_tail) left_tail->next_leaf = nullptr;
+        if (right_head) right_head->prev_leaf = nullptr;
+
+        root_ = left_root;
+        head_leaf_ = left_root ? first_leaf(left_root) : nullptr;
+        tail_leaf_ = left_tail;
+
+        right.root_ = right_root;
+        right.head_leaf_ = right_head;
+        right.tail_leaf_ = right_root ? last_leaf(right_root) : nullptr;
+    }
+
+    //! Count items, leaves and inner nodes of the subtree n.
+    static void count_nodes(const node* n, tree_stats& s) {
+        if (n->is_leafnode()) {
+            s.leaves++;
+            s.size += n->slotuse;
+            return;
+        }
+        const InnerNode* inner = static_cast<const InnerNode*>(n);
+        s.inner_nodes++;
+        for (unsigned short slot = 0; slot <= inner->slotuse; ++slot)
+            count_nodes(inner->childid[slot], s);
+    }
+
+    /*!
+     * Join the trees rooted at left and right, whose leaves are already linked,
+     * into one and return its root. sep must be the greatest key of left. If
+     * both have the same height, they become children of a new root. Otherwise
+     * the lower tree is added as the outermost child of the node on the facing
+     * spine of the higher tree, one level above it.
+     */
+    node * join_nodes(node* left, const key_type& sep, node* right) {
+        unshare(left);
+        unshare(right);
+
+        key_type key = sep;
+        if (left->level == right->level)
+        {
+            if (join_balance(left, key, right))
+                return left;
+
+            InnerNode* newroot = allocate_inner(left->level + 1);
+            newroot->slotkey[0] = key;
+            newroot->childid[0] = left;
+            newroot->childid[1] = right;
+            newroot->slotuse = 1;
+            update_counts(newroot, 0, 1);
+            return newroot;
+        }
+
+        node* root = left->level > right->level ? left : right;
+        node* newchild = nullptr;
+        key_type newkey = key_type();
+
+        if (left->level > right->level) {
+            join_descend(static_cast<InnerNode*>(left), false, right, sep,
+                         &newkey, &newchild);
+        }
+        else {
+            join_descend(static_cast<InnerNode*>(right), true, left, sep,
+                         &newkey, &newchild);
+        }
+
+        if (newchild)
+        {
+            InnerNode* newroot = allocate_inner(root->level + 1);
+            newroot->slotkey[0] = newkey;
+            newroot->childid[0] = root;
+            newroot->childid[1] = newchild;
+            newroot->slotuse = 1;
+            update_counts(newroot, 0, 1);
+            root = newroot;
+        }
+        return root;
+    }
+
+    /*!
+     * Descend the right spine of n (or the left spine if front) and add graft
+     * as the last (or first) child one level above it. sep is the key
+     * separating the two, which is the greatest key of the left one. Node
+     * splits are passed upward like in insert_descend().
+     */
+    void join_descend(InnerNode* n, bool front, node* graft,
+                      const key_type& sep,
+                      key_type* splitkey, node** splitnode) {
+        unsigned int slot = front ? 0 : n->slotuse;
+
+        if (n->level == graft->level + 1)
+        {
+            node* child = unshare(n->childid[slot]);
+            key_type key = sep;
+
+            if (front)
+            {
+                if (join_balance(graft, key, child)) {
+                    n->childid[0] = graft;
+                    update_counts(n, 0, 0);
+                    return;
+                }
+                // insert graft behind the first child, then swap the two
+                InnerNode* in = join_insert(n, 0, key, graft,
+                                            splitkey, splitnode);
+                std::swap(in->childid[0], in->childid[1]);
+                update_counts(in, 0, 1);
+            }
+            else
+            {
+                if (join_balance(child, key, graft)) {
+                    update_counts(n, slot, slot);
+                    return;
+                }
+                join_insert(n, slot, key, graft, splitkey, splitnode);
+            }
+            return;
+        }
+
+        node* newchild = nullptr;
+        key_type newkey = key_type();
+
+        join_descend(static_cast<InnerNode*>(unshare(n->childid[slot])),
+                     front, graft, sep, &newkey, &newchild);
+
+        if (newchild)
+            join_insert(n, slot, newkey, newchild, splitkey, splitnode);
+        else
+            update_counts(n, slot, slot);
+    }
+
+    //! Insert key and child behind the child at slot, which must be the first
+    //! or the last child of inner. If inner is full, it is split first and the
+    //! new node is returned in splitkey and splitnode. Returns the node into
+    //! which the child was inserted.
+    InnerNode * join_insert(InnerNode* inner, unsigned int slot,
+                            const key_type& key, node* child,
+                            key_type* splitkey, node** splitnode) {
+        if (inner->is_full())
+        {
+            split_inner_node(inner, splitkey, splitnode, slot);
+
+            if (slot > inner->slotuse) {
+                slot -= inner->slotuse + 1;
+                inner = static_cast<InnerNode*>(*splitnode);
+            }
+        }
+
+        std::copy_backward(
+            inner->slotkey + slot, inner->slotkey + inner->slotuse,
+            inner->slotkey + inner->slotuse + 1);
+        std::copy_backward(
+            inner->childid + slot + 1, inner->childid + inner->slotuse + 1,
+            inner->childid + inner->slotuse + 2);
+
+        inner->slotkey[slot] = key;
+        inner->childid[slot + 1] = child;
+        inner->slotuse++;
+
+        update_counts(inner, slot, inner->slotuse);
+        return inner;
+    }
+
+    /*!
+     * Balance two adjacent nodes of the same level, separated by key, which is
+     * the greatest key of left. If neither underflows, nothing is done. If
+     * their items fit into one node, right is merged into left and freed, and
+     * true is returned. Otherwise the items are distributed evenly and key is
+     * updated.
+     */
+    bool join_balance(node* left, key_type& key, node* right) {
+        if (left->is_leafnode())
+        {
+            LeafNode* l = static_cast<LeafNode*>(left);
+            LeafNode* r = static_cast<LeafNode*>(right);
+
+            if (!l->is_underflow() && !r->is_underflow())
+                return false;
+
+            unsigned int total = l->slotuse + r->slotuse;
+            if (total <= leaf_slotmax)
+            {
+                std::copy(r->slotdata, r->slotdata + r->slotuse,
+                          l->slotdata + l->slotuse);
+                l->slotuse = total;
+
+                l->next_leaf = r->next_leaf;
+                if (l->next_leaf)
+                    l->next_leaf->prev_leaf = l;
+                else
+                    tail_leaf_ = l;
+
+                free_node(r);
+                return true;
+            }
+
+            unsigned int target = total / 2;
+            if (l->slotuse > target) {
+                unsigned int shift = l->slotuse - target;
+                std::copy_backward(r->slotdata, r->slotdata + r->slotuse,
+                                   r->slotdata + r->slotuse + shift);
+                std::copy(l->slotdata + target, l->slotdata + l->slotuse,
+                          r->slotdata);
+            }
+            else {
+                unsigned int shift = target - l->slotuse;
+                std::copy(r->slotdata, r->slotdata + shift,
+                          l->slotdata + l->slotuse);
+                std::copy(r->slotdata + shift, r->slotdata + r->slotuse,
+                          r->slotdata);
+            }
+            r->slotuse = total - target;
+            l->slotuse = target;
+
+            key = l->key(l->slotuse - 1);
+            return false;
+        }
+        else
+        {
+            InnerNode* l = static_cast<InnerNode*>(left);
+            InnerNode* r = static_cast<InnerNode*>(right);
+
+            if (!l->is_underflow() && !r->is_underflow())
+                return false;
+
+            // number of keys, including the separator
+            unsigned int total = l->slotuse + r->slotuse + 1;
+            if (total <= inner_slotmax)
+            {
+                l->slotkey[l->slotuse] = key;
+                std::copy(r->slotkey, r->slotkey + r->slotuse,
+                          l->slotkey + l->slotuse + 1);
+                std::copy(r->childid, r->childid + r->slotuse + 1,
+                          l->childid + l->slotuse + 1);
+                if (order_statistics) {
+                    std::copy(r->counts(), r->counts() + r->slotuse + 1,
+                              l->counts() + l->slotuse + 1);
+                }
+                if (augmented) {
+                    std::copy(r->aggregates(), r->aggregates() + r->slotuse + 1,
+                              l->aggregates() + l->slotuse + 1);
+                }
+                l->slotuse = total;
+
+                free_node(r);
+                return true;
+            }
+
+            // left keeps target keys, one key moves up as separator
+            unsigned int target = (total + 1) / 2 - 1;
+            if (l->slotuse > target) {
+                unsigned int shift = l->slotuse - target;
+                std::copy_backward(
+                    r->slotkey, r->slotkey + r->slotuse,
+                    r->slotkey + r->slotuse + shift);
+                std::copy_backward(
+                    r->childid, r->childid + r->slotuse + 1,
+                    r->childid + r->slotuse + 1 + shift);
+
+                r->slotkey[shift - 1] = key;
+                std::copy(l->slotkey + target + 1, l->slotkey + l->slotuse,
+                          r->slotkey);
+                std::copy(l->childid + target + 1,
+                          l->childid + l->slotuse + 1, r->childid);
+
+                key = l->slotkey[target];
+                r->slotuse += shift;
+            }
+            else {
+                unsigned int shift = target - l->slotuse;
+                l->slotkey[l->slotuse] = key;
+                std::copy(r->slotkey, r->slotkey + shift - 1,
+                          l->slotkey + l->slotuse + 1);
+                std::copy(r->childid, r->childid + shift,
+                          l->childid + l->slotuse + 1);
+
+                key = r->slotkey[shift - 1];
+                std::copy(r->slotkey + shift, r->slotkey + r->slotuse,
+                          r->slotkey);
+                std::copy(r->childid + shift, r->childid + r->slotuse + 1,
+                          r->childid);
+                r->slotuse -= shift;
+            }
+            l->slotuse = target;
 
-            // track max key of any descendant.
-            nextlevel[i].first = n;
-            nextlevel[i].second = &leaf->key(leaf->slotuse - 1);
+            update_counts(l, 0, l->slotuse);
+            update_counts(r, 0, r->slotuse);
+            return false;
+        }
+    }
 
-            leaf = leaf->next_leaf;
-            num_leaves -= n->slotuse + 1;
+    //! Create a tree from the children [first,last) of inner with the keys
+    //! between them, or nullptr if the range is empty.
+    node * split_fragment(const InnerNode* inner,
+                          unsigned int first, unsigned int last) {
+        if (first == last) return nullptr;
+        if (first + 1 == last) return inner->childid[first];
+
+        InnerNode* n = allocate_inner(inner->level);
+        n->slotuse = static_cast<unsigned short>(last - first - 1);
+        std::copy(inner->slotkey + first, inner->slotkey + last - 1,
+                  n->slotkey);
+        std::copy(inner->childid + first, inner->childid + last,
+                  n->childid);
+        if (order_statistics) {
+            std::copy(inner->counts() + first, inner->counts() + last,
+                      n->counts());
         }
+        if (augmented) {
+            std::copy(inner->aggregates() + first, inner->aggregates() + last,
+                      n->aggregates());
+        }
+        return n;
+    }
 
-        TLX_BTREE_ASSERT(leaf == nullptr && num_leaves == 0);
+    //! Join two trees which may be empty, see join_nodes().
+    node * join_fragments(node* left, const key_type& sep, node* right) {
+        if (!left) return right;
+        if (!right) return left;
+        return join_nodes(left, sep, right);
+    }
 
-        // recursively build inner nodes pointing to inner nodes.
-        for (int level = 2; num_parents != 1; ++level)
+    /*!
+     * Split the unshared subtree n at the lower bound of key into the trees
+     * left, with all smaller items, and right, either of which may be nullptr.
+     * Each inner node on the path is cut into the fragments left and right of
+     * the path, which are joined with the parts of the child below. The leaf
+     * list stays linked.
+     */
+    void split_descend(node* n, const key_type& key,
+                       node** left, node** right) {
+        if (n->is_leafnode())
         {
-            size_t num_children = num_parents;
-            num_parents =
-                (num_children + (inner_slotmax + 1) - 1) / (inner_slotmax + 1);
+            LeafNode* leaf = static_cast<LeafNode*>(n);
+            unsigned short slot = find_lower(leaf, key);
 
-            TLX_BTREE_PRINT(
-                "BTree::bulk_load, level " << level <<
-                    ": " << num_children << " children in " <<
-                    num_parents << " inner nodes with up to " <<
-                ((num_children + num_parents - 1) / num_parents) <<
-                    " children per inner node.");
+            *left = slot > 0 ? leaf : nullptr;
+            *right = slot < leaf->slotuse ? leaf : nullptr;
+            if (!*left || !*right) return;
 
-            size_t inner_index = 0;
-            for (size_t i = 0; i < num_parents; ++i)
-            {
-                // allocate new inner node at level
-                InnerNode* n = allocate_inner(level);
+            LeafNode* newleaf = allocate_leaf();
+            newleaf->slotuse = leaf->slotuse - slot;
+            std::copy(leaf->slotdata + slot, leaf->slotdata + leaf->slotuse,
+                      newleaf->slotdata);
+            leaf->slotuse = slot;
 
-                n->slotuse = static_cast<int>(num_children / (num_parents - i));
-                TLX_BTREE_ASSERT(n->slotuse > 0);
-                // this counts keys, but an inner node has keys+1 children.
-                --n->slotuse;
+            newleaf->next_leaf = leaf->next_leaf;
+            if (newleaf->next_leaf)
+                newleaf->next_leaf->prev_leaf = newleaf;
+            else
+                tail_leaf_ = newleaf;
+            leaf->next_leaf = newleaf;
+            newleaf->prev_leaf = leaf;
 
-                // copy children and maxkeys from nextlevel
-                for (unsigned short s = 0; s < n->slotuse; ++s)
-                {
-                    n->slotkey[s] = *nextlevel[inner_index].second;
-                    n->childid[s] = nextlevel[inner_index].first;
-                    ++inner_index;
-                }
-                n->childid[n->slotuse] = nextlevel[inner_index].first;
+            *right = newleaf;
+            return;
+        }
 
-                // reuse nextlevel array for parents, because we can overwrite
-                // slots we've already consumed.
-                nextlevel[i].first = n;
-                nextlevel[i].second = nextlevel[inner_index].second;
+        InnerNode* inner = static_cast<InnerNode*>(n);
+        unsigned short slot = find_lower(inner, key);
 
-                ++inner_index;
-                num_children -= n->slotuse + 1;
-            }
+        node* child_left = nullptr, * child_right = nullptr;
+        split_descend(unshare(inner->childid[slot]), key,
+                      &child_left, &child_right);
 
-            TLX_BTREE_ASSERT(num_children == 0);
-        }
+        // greatest keys of the fragments left of and below the path
+        key_type sep_left = slot > 0 ? inner->slotkey[slot - 1] : key_type();
+        key_type sep_right =
+            slot < inner->slotuse ? inner->slotkey[slot] : key_type();
 
-        root_ = nextlevel[0].first;
-        delete[] nextlevel;
+        node* frag_left = split_fragment(inner, 0, slot);
+        node* frag_right = split_fragment(inner, slot + 1, inner->slotuse + 1);
+        free_node(inner);
 
-        if (self_verify) verify();
+        *left = join_fragments(frag_left, sep_left, child_left);
+        *right = join_fragments(child_right, sep_right, frag_right);
     }
 
     //! \}
@@ -2374,7 +4266,8 @@ public:
         if (!root_) return false;
 
         result_t result = erase_one_descend(
-            key, root_, nullptr, nullptr, nullptr, nullptr, nullptr, 0);
+            key, unshare(root_),
+            nullptr, nullptr, nullptr, nullptr, nullptr, 0);
 
         if (!result.has(btree_not_found))
             --stats_.size;
@@ -2410,6 +4303,12 @@ public:
 
         if (!root_) return;
 
+        // the iterator's leaf may be the root, which is copied if shared
+        if (copy_on_write && root_ == iter.curr_leaf)
+            iter.curr_leaf = static_cast<LeafNode*>(unshare(root_));
+        else
+            unshare(root_);
+
         result_t result = erase_iter_descend(
             iter, root_, nullptr, nullptr, nullptr, nullptr, nullptr, 0);
 
@@ -2422,13 +4321,100 @@ public:
         if (self_verify) verify();
     }
 
-#ifdef BTREE_TODO
-    //! Erase all key/data pairs in the range [first,last). This function is
-    //! currently not implemented by the B+ Tree.
-    void erase(iterator /* first */, iterator /* last */) {
-        abort();
+    /*!
+     * Erase all key/data pairs in the range [first,last). Short ranges are
+     * erased item by item. Otherwise, the keys in the range are cut out of the
+     * tree by two splits and the rest is rejoined, hence only the two boundary
+     * paths are restructured and the subtrees in between are freed as a whole.
+     * Only the nodes of the cut-out part are counted. If duplicates are
+     * allowed and first or last point into a run of equal keys, the cut
+     * includes these runs and their items outside the range are reinserted,
+     * which takes time linear in the length of the two runs.
+     */
+    void erase(iterator first, iterator last) {
+        if (first == last) return;
+        if (first == begin() && last == end()) return clear();
+
+        key_type first_key = first.key();
+
+        // if duplicates are allowed, erase_one() removes the items of a run
+        // in order only if the range starts a run.
+        iterator prev = first;
+        if (!allow_duplicates || first == begin() ||
+            !key_equal((--prev).key(), first_key))
+        {
+            std::vector<key_type> keys;
+            for (iterator it = first; it != last && keys.size() <= leaf_slotmax;
+                 ++it)
+                keys.push_back(it.key());
+
+            if (keys.size() <= leaf_slotmax) {
+                for (const key_type& k : keys)
+                    erase_one(k);
+                return;
+            }
+        }
+
+        // items of the runs of first's and last's keys outside the range
+        std::vector<value_type> kept;
+        if (allow_duplicates)
+            kept.assign(lower_bound(first_key), first);
+
+        // cut at last, or at the end of its run if last is inside it
+        bool to_end = (last == end());
+        key_type last_key = key_type();
+        if (!to_end)
+        {
+            iterator it = last;
+            if (allow_duplicates && key_equal((--it).key(), last.key())) {
+                it = upper_bound(last.key());
+                kept.insert(kept.end(), last, it);
+            }
+            else {
+                it = last;
+            }
+            to_end = (it == end());
+            if (!to_end) last_key = it.key();
+        }
+
+        BTree middle(key_less_, allocator_), right(key_less_, allocator_);
+        split_tree(first_key, middle);
+        if (!to_end) middle.split_tree(last_key, right);
+
+        // this tree's stats_ count the nodes of all three parts, except for
+        // those allocated or freed by middle.split_tree(), which are counted
+        // in middle.stats_. Only the cut-out part is counted.
+        tree_stats cut;
+        if (middle.root_) count_nodes(middle.root_, cut);
+
+        tree_stats rest;
+        rest.size = stats_.size - cut.size;
+        rest.leaves = stats_.leaves + middle.stats_.leaves - cut.leaves;
+        rest.inner_nodes =
+            stats_.inner_nodes + middle.stats_.inner_nodes - cut.inner_nodes;
+
+        middle.stats_ = cut;
+        middle.clear();
+
+        // rejoin the parts, nodes allocated or freed by join_tree() are
+        // counted from zero.
+        stats_ = tree_stats();
+        if (!kept.empty()) {
+            middle.bulk_load(kept.begin(), kept.end());
+            rest.size += middle.stats_.size;
+            rest.leaves += middle.stats_.leaves;
+            rest.inner_nodes += middle.stats_.inner_nodes;
+            middle.stats_ = tree_stats();
+            join_tree(middle);
+        }
+        join_tree(right);
+
+        stats_.size = rest.size;
+        stats_.leaves += rest.leaves;
+        stats_.inner_nodes += rest.inner_nodes;
+
+        if (self_verify) verify();
     }
-#endif
 
     //! \}
 
@@ -2503,6 +4489,9 @@ private:
 
             if (leaf->is_underflow() && !(leaf == root_ && leaf->slotuse >= 1))
             {
+                unshare_siblings(left_leaf, right_leaf,
+                                 left_parent, right_parent, parent, parentslot);
+
                 // determine what to do about the underflow
 
                 // case : if this empty leaf is the root, then delete all nodes
@@ -2618,7 +4607,7 @@ private:
 
             result_t result = erase_one_descend(
                 key,
-                inner->childid[slot],
+                unshare(inner->childid[slot]),
                 myleft, myright,
                 myleft_parent, myright_parent,
                 inner, slot);
@@ -2650,6 +4639,9 @@ private:
                 }
             }
 
+            // the erased child and its siblings may have shifted or merged
+            const unsigned int modslot = slot;
+
             if (result.has(btree_fixmerge))
             {
                 // either the current node or the next is empty and should be
@@ -2669,6 +4661,18 @@ private:
                     inner->childid + slot + 1,
                     inner->childid + inner->slotuse + 1,
                     inner->childid + slot);
+                if (order_statistics) {
+                    std::copy(
+                        inner->counts() + slot + 1,
+                        inner->counts() + inner->slotuse + 1,
+                        inner->counts() + slot);
+                }
+                if (augmented) {
+                    std::copy(
+                        inner->aggregates() + slot + 1,
+                        inner->aggregates() + inner->slotuse + 1,
+                        inner->aggregates() + slot);
+                }
 
                 inner->slotuse--;
 
@@ -2682,9 +4686,14 @@ private:
                 }
             }
 
+            update_counts_around(inner, modslot);
+
             if (inner->is_underflow() &&
                 !(inner == root_ && inner->slotuse >= 1))
             {
+                unshare_siblings(left_inner, right_inner,
+                                 left_parent, right_parent, parent, parentslot);
+
                 // case: the inner node is the root and has just one child. that
                 // child becomes the new root
                 if (left_inner == nullptr && right_inner == nullptr)
@@ -2842,6 +4851,9 @@ private:
 
             if (leaf->is_underflow() && !(leaf == root_ && leaf->slotuse >= 1))
             {
+                unshare_siblings(left_leaf, right_leaf,
+                                 left_parent, right_parent, parent, parentslot);
+
                 // determine what to do about the underflow
 
                 // case : if this empty leaf is the root, then delete all nodes
@@ -2969,11 +4981,26 @@ private:
                 TLX_BTREE_PRINT("erase_iter_descend into " <<
                                 inner->childid[slot]);
 
-                result = erase_iter_descend(iter,
-                                            inner->childid[slot],
-                                            myleft, myright,
-                                            myleft_parent, myright_parent,
-                                            inner, slot);
+                if (copy_on_write && inner->childid[slot] == iter.curr_leaf)
+                {
+                    // the iterator's leaf is copied if shared, continue the
+                    // erase on the copy
+                    LeafNode* leaf =
+                        static_cast<LeafNode*>(unshare(inner->childid[slot]));
+                    result = erase_iter_descend(iterator(leaf, iter.curr_slot),
+                                                leaf,
+                                                myleft, myright,
+                                                myleft_parent, myright_parent,
+                                                inner, slot);
+                }
+                else
+                {
+                    result = erase_iter_descend(iter,
+                                                unshare(inner->childid[slot]),
+                                                myleft, myright,
+                                                myleft_parent, myright_parent,
+                                                inner, slot);
+                }
 
                 if (!result.has(btree_not_found))
                     break;
@@ -3011,6 +5038,9 @@ private:
                 }
             }
 
+            // the erased child and its siblings may have shifted or merged
+            const unsigned int modslot = slot;
+
             if (result.has(btree_fixmerge))
             {
                 // either the current node or the next is empty and should be
@@ -3030,6 +5060,18 @@ private:
                     inner->childid + slot + 1,
                     inner->childid + inner->slotuse + 1,
                     inner->childid + slot);
+                if (order_statistics) {
+                    std::copy(
+                        inner->counts() + slot + 1,
+                        inner->counts() + inner->slotuse + 1,
+                        inner->counts() + slot);
+                }
+                if (augmented) {
+                    std::copy(
+                        inner->aggregates() + slot + 1,
+                        inner->aggregates() + inner->slotuse + 1,
+                        inner->aggregates() + slot);
+                }
 
                 inner->slotuse--;
 
@@ -3043,9 +5085,14 @@ private:
                 }
             }
 
+            update_counts_around(inner, modslot);
+
             if (inner->is_underflow() &&
                 !(inner == root_ && inner->slotuse >= 1))
             {
+                unshare_siblings(left_inner, right_inner,
+                                 left_parent, right_parent, parent, parentslot);
+
                 // case: the inner node is the root and has just one
                 // child. that child becomes the new root
                 if (left_inner == nullptr && right_inner == nullptr)
@@ -3202,6 +5249,15 @@ private:
                   left->slotkey + left->slotuse);
         std::copy(right->childid, right->childid + right->slotuse + 1,
                   left->childid + left->slotuse);
+        if (order_statistics) {
+            std::copy(right->counts(), right->counts() + right->slotuse + 1,
+                      left->counts() + left->slotuse);
+        }
+        if (augmented) {
+            std::copy(right->aggregates(),
+                      right->aggregates() + right->slotuse + 1,
+                      left->aggregates() + left->slotuse);
+        }
 
         left->slotuse += right->slotuse;
         right->slotuse = 0;
@@ -3306,6 +5362,14 @@ private:
                   left->slotkey + left->slotuse);
         std::copy(right->childid, right->childid + shiftnum,
                   left->childid + left->slotuse);
+        if (order_statistics) {
+            std::copy(right->counts(), right->counts() + shiftnum,
+                      left->counts() + left->slotuse);
+        }
+        if (augmented) {
+            std::copy(right->aggregates(), right->aggregates() + shiftnum,
+                      left->aggregates() + left->slotuse);
+        }
 
         left->slotuse += shiftnum - 1;
 
@@ -3319,6 +5383,15 @@ private:
         std::copy(
             right->childid + shiftnum, right->childid + right->slotuse + 1,
             right->childid);
+        if (order_statistics) {
+            std::copy(right->counts() + shiftnum,
+                      right->counts() + right->slotuse + 1, right->counts());
+        }
+        if (augmented) {
+            std::copy(right->aggregates() + shiftnum,
+                      right->aggregates() + right->slotuse + 1,
+                      right->aggregates());
+        }
 
         right->slotuse -= shiftnum;
     }
@@ -3422,6 +5495,16 @@ private:
         std::copy_backward(
             right->childid, right->childid + right->slotuse + 1,
             right->childid + right->slotuse + 1 + shiftnum);
+        if (order_statistics) {
+            std::copy_backward(
+                right->counts(), right->counts() + right->slotuse + 1,
+                right->counts() + right->slotuse + 1 + shiftnum);
+        }
+        if (augmented) {
+            std::copy_backward(
+                right->aggregates(), right->aggregates() + right->slotuse + 1,
+                right->aggregates() + right->slotuse + 1 + shiftnum);
+        }
 
         right->slotuse += shiftnum;
 
@@ -3437,6 +5520,16 @@ private:
         std::copy(left->childid + left->slotuse - shiftnum + 1,
                   left->childid + left->slotuse + 1,
                   right->childid);
+        if (order_statistics) {
+            std::copy(left->counts() + left->slotuse - shiftnum + 1,
+                      left->counts() + left->slotuse + 1,
+                      right->counts());
+        }
+        if (augmented) {
+            std::copy(left->aggregates() + left->slotuse - shiftnum + 1,
+                      left->aggregates() + left->slotuse + 1,
+                      right->aggregates());
+        }
 
         // copy the first to-be-removed key from the left node to the parent's
         // decision slot
@@ -3600,8 +5693,16 @@ private:
                 key_type submaxkey = key_type();
 
                 tlx_die_unless(subnode->level + 1 == inner->level);
+                size_type subsize = vstats.size;
                 verify_node(subnode, &subminkey, &submaxkey, vstats);
 
+                if (order_statistics) {
+                    tlx_die_unless(
+                        inner->counts()[slot] == vstats.size - subsize);
+                }
+
+                verify_aggregate(inner, slot);
+
                 TLX_BTREE_PRINT("verify subnode " << subnode <<
                                 ": " << subminkey <<
                                 " - " << submaxkey);
@@ -3649,6 +5750,28 @@ private:
         }
     }
 
+    //! Verify the cached aggregate of the child at slot of inner against the
+    //! aggregate recomputed from the child, if augmented and aggregate_type is
+    //! equality comparable. The child itself was verified before.
+    template <typename node_type>
+    static void verify_aggregate(const node_type* inner, unsigned short slot) {
+        verify_aggregate(
+            inner, slot, std::integral_constant<
+                bool, augmented &&
+                btree_is_equality_comparable<aggregate_type>::value>());
+    }
+
+    template <typename node_type>
+    static void verify_aggregate(const node_type* /* inner */,
+                                 unsigned short /* slot */, std::false_type) { }
+
+    template <typename node_type>
+    static void verify_aggregate(const node_type* inner, unsigned short slot,
+                                 std::true_type) {
+        tlx_die_unless(inner->aggregates()[slot] ==
+                       subtree_aggregate(inner->childid[slot]));
+    }
+
     //! Verify the double linked list of leaves.
     void verify_leaflinks() const {
         const LeafNode* n = head_leaf_;
@@ -3691,6 +5814,260 @@ private:
     //! \}
 };
 
+/*!
+ * Read-only view of a BTree with copy_on_write enabled, created in O(1) time
+ * by BTree::snapshot(). The snapshot holds references on the nodes of the tree
+ * at that time, which are therefore never modified. Iteration walks down from
+ * the root instead of following the leaf list, as that is maintained only for
+ * the tree.
+ */
+template <typename Key, typename Value, typename KeyOfValue, typename Compare,
+          typename Traits, bool Duplicates, typename Allocator>
+class BTree<Key, Value, KeyOfValue, Compare, Traits, Duplicates,
+            Allocator>::Snapshot
+{
+public:
+    //! \name Types
+    //! \{
+
+    typedef typename BTree::key_type key_type;
+    typedef typename BTree::value_type value_type;
+    typedef typename BTree::key_compare key_compare;
+    typedef typename BTree::size_type size_type;
+
+    //! \}
+
+    //! Read-only forward iterator over the items of a snapshot. It stores the
+    //! path of inner nodes from the root to its leaf.
+    class const_iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef typename Snapshot::value_type value_type;
+        typedef const value_type& reference;
+        typedef const value_type* pointer;
+        typedef ptrdiff_t difference_type;
+
+        //! Default-constructor of the end() iterator.
+        const_iterator() : leaf_(nullptr), slot_(0) { }
+
+        reference operator * () const {
+            return leaf_->slotdata[slot_];
+        }
+
+        pointer operator -> () const {
+            return &leaf_->slotdata[slot_];
+        }
+
+        //! Key of the current slot.
+        const key_type& key() const {
+            return leaf_->key(slot_);
+        }
+
+        //! Prefix++ advances the iterator to the next slot.
+        const_iterator& operator ++ () {
+            if (++slot_ >= leaf_->slotuse) next_leaf();
+            return *this;
+        }
+
+        //! Postfix++ advances the iterator to the next slot.
+        const_iterator operator ++ (int) {
+            const_iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        bool operator == (const const_iterator& x) const {
+            return (x.leaf_ == leaf_) && (x.slot_ == slot_);
+        }
+
+        bool operator != (const const_iterator& x) const {
+            return (x.leaf_ != leaf_) || (x.slot_ != slot_);
+        }
+
+    private:
+        friend class Snapshot;
+
+        //! Inner nodes from the root and the child slot taken in each.
+        std::vector<std::pair<const InnerNode*, unsigned short> > path_;
+
+        //! The current leaf or nullptr for end()
+        const LeafNode* leaf_;
+
+        //! Current slot in the leaf
+        unsigned short slot_;
+
+        //! Descend to the first slot of the leftmost leaf below n.
+        void descend_first(const node* n) {
+            while (!n->is_leafnode()) {
+                const InnerNode* inner = static_cast<const InnerNode*>(n);
+                path_.emplace_back(inner, 0);
+                n = inner->childid[0];
+            }
+            leaf_ = static_cast<const LeafNode*>(n);
+            slot_ = 0;
+        }
+
+        //! Advance to the first slot of the next leaf, or to end().
+        void next_leaf() {
+            while (!path_.empty()) {
+                const InnerNode* inner = path_.back().first;
+                unsigned short& slot = path_.back().second;
+                if (slot < inner->slotuse) {
+                    descend_first(inner->childid[++slot]);
+                    return;
+                }
+                path_.pop_back();
+            }
+            leaf_ = nullptr;
+            slot_ = 0;
+        }
+    };
+
+    //! \name Constructors and Destructor
+    //! \{
+
+    //! Constructs an empty snapshot.
+    Snapshot() { }
+
+    //! Copies share the same nodes.
+    Snapshot(const Snapshot& other)
+        : tree_(other.tree_.key_less_, other.tree_.allocator_) {
+        share(other.tree_);
+    }
+
+    Snapshot(Snapshot&& other)
+        : tree_(other.tree_.key_less_, other.tree_.allocator_) {
+        tree_.swap(other.tree_);
+    }
+
+    Snapshot& operator = (Snapshot other) {
+        tree_.swap(other.tree_);
+        return *this;
+    }
+
+    //! \}
+
+    //! \name Access Functions
+    //! \{
+
+    //! Number of items in the snapshot.
+    size_type size() const {
+        return tree_.size();
+    }
+
+    //! True if the snapshot is empty.
+    bool empty() const {
+        return tree_.empty();
+    }
+
+    //! Constant access to the key comparison object.
+    key_compare key_comp() const {
+        return tree_.key_comp();
+    }
+
+    //! Iterator to the first item.
+    const_iterator begin() const {
+        const_iterator it;
+        if (tree_.root_) it.descend_first(tree_.root_);
+        return it;
+    }
+
+    //! Iterator past the last item.
+    const_iterator end() const {
+        return const_iterator();
+    }
+
+    //! Iterator to the first item equal to or greater than key.
+    const_iterator lower_bound(const key_type& key) const {
+        return descend(key, false);
+    }
+
+    //! Iterator to the first item greater than key.
+    const_iterator upper_bound(const key_type& key) const {
+        return descend(key, true);
+    }
+
+    //! Iterator to the first item equal to key, or end().
+    const_iterator find(const key_type& key) const {
+        const_iterator it = lower_bound(key);
+        if (it != end() && tree_.key_equal(key, it.key())) return it;
+        return end();
+    }
+
+    //! True if an item equal to key is in the snapshot.
+    bool exists(const key_type& key) const {
+        return find(key) != end();
+    }
+
+    //! Number of items equal to key.
+    size_type count(const key_type& key) const {
+        size_type num = 0;
+        for (const_iterator it = lower_bound(key);
+             it != end() && tree_.key_equal(key, it.key()); ++it)
+            ++num;
+        return num;
+    }
+
+    //! \}
+
+private:
+    friend class BTree;
+
+    //! Tree object holding the shared root, used only for its search functions
+    //! and to release the nodes. Its leaf list pointers are unset.
+    BTree tree_;
+
+    //! Take a snapshot of tree.
+    explicit Snapshot(const BTree& tree)
+        : tree_(tree.key_less_, tree.allocator_) {
+        share(tree);
+    }
+
+    //! Acquire a reference on the root of tree.
+    void share(const BTree& tree) {
+        if (tree.root_) {
+            tree.root_->acquire_ref();
+            tree_.root_ = tree.root_;
+        }
+        tree_.stats_ = tree.stats_;
+    }
+
+    //! Descend to the lower or upper bound of key.
+    const_iterator descend(const key_type& key, bool upper) const {
+        const_iterator it;
+        const node* n = tree_.root_;
+        if (!n) return it;
+
+        while (!n->is_leafnode()) {
+            const InnerNode* inner = static_cast<const InnerNode*>(n);
+            unsigned short slot = static_cast<unsigned short>(
+                upper ? tree_.find_upper(inner, key)
+                : tree_.find_lower(inner, key));
+            it.path_.emplace_back(inner, slot);
+            n = inner->childid[slot];
+        }
+
+        it.leaf_ = static_cast<const LeafNode*>(n);
+        it.slot_ = static_cast<unsigned short>(
+            upper ? tree_.find_upper(it.leaf_, key)
+            : tree_.find_lower(it.leaf_, key));
+        if (it.slot_ >= it.leaf_->slotuse) it.next_leaf();
+
+        return it;
+    }
+};
+
+/*!
+ * Call func(value) for each item of tree, which may be a BTree or one of its
+ * wrappers, in parallel using num_threads threads. See
+ * BTree::parallel_for_each().
+ */
+template <typename Tree, typename Functor>
+void parallel_for_each(Tree& tree, const Functor& func, size_t num_threads) {
+    tree.parallel_for_each(func, num_threads);
+}
+
 //! \}
 //! \}
 
@@ -0,0 +1,787 @@
+/*******************************************************************************
+ * tlx/container/btree_frozen.hpp
+ *
+ * Immutable, read-optimized search tree in an implicit B+ tree (S+ tree) layout
+ * without pointers, created by freezing a tlx::BTree.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_CONTAINER_BTREE_FROZEN_HEADER
+#define TLX_CONTAINER_BTREE_FROZEN_HEADER
+
+#include <tlx/container/btree_simd.hpp>
+#include <tlx/counting_ptr.hpp>
+#include <tlx/define/prefetch.hpp>
+#include <tlx/mapped_file.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace tlx {
+
+//! \addtogroup tlx_container_btree
+//! \{
+
+/*!
+ * Immutable search tree built once from a sorted sequence, usually by
+ * BTree::freeze() or the freeze() methods of btree_set, btree_map, etc.
+ *
+ * All items are kept in one contiguous, cache-line-aligned memory block without
+ * any pointers. The items are stored sorted, hence iterators are plain
+ * pointers. Above them, an implicit B+ tree (S+ tree) of separator keys is laid
+ * out level by level: each block holds block_slots keys in one cache line and
+ * has block_slots + 1 children, which are found by index arithmetic. A lookup
+ * thus touches one cache line per level, and each block is searched using the
+ * SIMD kernels of btree_simd if the key type supports them.
+ *
+ * The lookup functions have the same interface as the const methods of BTree,
+ * such that the frozen tree can replace a btree_set or btree_map in read-only
+ * code paths. Duplicate keys are supported.
+ *
+ * For trivially copyable keys and items, save_file() writes the memory block
+ * behind a page-aligned header to a file, and map_file() maps such a file
+ * read-only and uses it directly: loading takes constant time, the pages are
+ * read lazily by the first lookups touching them, and processes mapping the
+ * same file share the page cache. The block contains only relative offsets,
+ * but the file format depends on the machine's byte order and type sizes.
+ */
+template <typename Key, typename Value, typename KeyOfValue,
+          typename Compare = std::less<Key> >
+class FrozenBTree
+{
+public:
+    //! \name Template Parameter Types
+    //! \{
+
+    //! First template parameter: The key type of the tree.
+    typedef Key key_type;
+
+    //! Second template parameter: Composition pair of key and data types, or
+    //! just the key for sets.
+    typedef Value value_type;
+
+    //! Third template parameter: key extractor class to pull key_type from
+    //! value_type.
+    typedef KeyOfValue key_of_value;
+
+    //! Fourth template parameter: key_type comparison function object
+    typedef Compare key_compare;
+
+    //! Size type used to count items
+    typedef size_t size_type;
+
+    //! Iterators are pointers into the sorted items.
+    typedef const value_type* const_iterator;
+
+    //! The tree is immutable, hence iterator equals const_iterator.
+    typedef const_iterator iterator;
+
+    //! Reverse iterator over the sorted items.
+    typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+    //! The tree is immutable, hence reverse_iterator equals
+    //! const_reverse_iterator.
+    typedef const_reverse_iterator reverse_iterator;
+
+    //! \}
+
+public:
+    //! \name Static Constant Options and Values of the Frozen Tree
+    //! \{
+
+    //! Alignment of the memory block and the size of a block of keys.
+    static const size_t cache_line_size = 64;
+
+    //! True if the keys can be searched with the SIMD kernels of btree_simd.
+    static const bool simd_search =
+        btree_simd::is_supported<key_type, key_compare>::value;
+
+    //! Number of keys in each block: one cache line of keys if they can be
+    //! searched with SIMD, otherwise 16 keys searched by binary search.
+    static const size_t block_slots =
+        simd_search ? cache_line_size / sizeof(key_type) : 16;
+
+    //! Sets use the sorted items as keys of the lowest level, maps store a
+    //! separate array of keys.
+    static const bool keys_in_values =
+        std::is_same<key_type, value_type>::value;
+
+    //! Number of lookups advanced together by find_batch().
+    static const size_t find_batch_width = 16;
+
+    //! True if the keys and items can be written by save_file() and loaded by
+    //! map_file(). std::pair is not trivially copyable due to its assignment
+    //! operator, hence only copy construction and destruction are checked.
+    static const bool file_compatible =
+        std::is_trivially_copy_constructible<key_type>::value &&
+        std::is_trivially_destructible<key_type>::value &&
+        std::is_trivially_copy_constructible<value_type>::value &&
+        std::is_trivially_destructible<value_type>::value;
+
+    //! \}
+
+public:
+    //! \name Constructors and Destructor
+    //! \{
+
+    //! Constructs an empty frozen tree.
+    explicit FrozenBTree(const key_compare& kcf = key_compare())
+        : key_less_(kcf)
+    { }
+
+    //! Constructs a frozen tree from the sorted range [first,last).
+    template <typename Iterator>
+    FrozenBTree(Iterator first, Iterator last,
+                const key_compare& kcf = key_compare())
+        : key_less_(kcf) {
+        build(first, last);
+    }
+
+    //! Copy constructor, which rebuilds the tree.
+    FrozenBTree(const FrozenBTree& other)
+        : key_less_(other.key_less_) {
+        build(other.begin(), other.end());
+    }
+
+    //! Move constructor.
+    FrozenBTree(FrozenBTree&& other) noexcept
+        : key_less_(other.key_less_) {
+        swap(other);
+    }
+
+    //! Assignment by copy-and-swap.
+    FrozenBTree& operator = (FrozenBTree other) noexcept {
+        swap(other);
+        return *this;
+    }
+
+    //! Frees the memory block.
+    ~FrozenBTree() {
+        destroy();
+    }
+
+    //! Fast swapping of two frozen trees.
+    void swap(FrozenBTree& other) noexcept {
+        std::swap(memory_, other.memory_);
+        std::swap(memory_size_, other.memory_size_);
+        std::swap(size_, other.size_);
+        std::swap(inner_, other.inner_);
+        std::swap(inner_slots_, other.inner_slots_);
+        std::swap(leaf_keys_, other.leaf_keys_);
+        std::swap(leaf_slots_, other.leaf_slots_);
+        std::swap(values_, other.values_);
+        std::swap(levels_, other.levels_);
+        std::swap(key_less_, other.key_less_);
+        mapping_.swap(other.mapping_);
+    }
+
+    //! \}
+
+public:
+    //! \name Access Functions
+    //! \{
+
+    //! Number of items in the tree.
+    size_type size() const { return size_; }
+
+    //! True if the tree is empty.
+    bool empty() const { return size_ == 0; }
+
+    //! Constant access to the key comparison object.
+    key_compare key_comp() const { return key_less_; }
+
+    //! Total size of the memory block in bytes.
+    size_t memory_usage() const { return memory_size_; }
+
+    //! True if the tree uses a file mapped by map_file().
+    bool is_mapped() const { return mapping_.valid(); }
+
+    //! Iterator to the first item.
+    const_iterator begin() const { return values_; }
+
+    //! Iterator past the last item.
+    const_iterator end() const { return values_ + size_; }
+
+    //! Reverse iterator to the last item.
+    const_reverse_iterator rbegin() const {
+        return const_reverse_iterator(end());
+    }
+
+    //! Reverse iterator before the first item.
+    const_reverse_iterator rend() const {
+        return const_reverse_iterator(begin());
+    }
+
+    //! Iterator to the first item equal to or greater than key, or end().
+    const_iterator lower_bound(const key_type& key) const {
+        return values_ + position<false>(key);
+    }
+
+    //! Iterator to the first item greater than key, or end().
+    const_iterator upper_bound(const key_type& key) const {
+        return values_ + position<true>(key);
+    }
+
+    //! Both lower_bound() and upper_bound().
+    std::pair<const_iterator, const_iterator>
+    equal_range(const key_type& key) const {
+        return std::pair<const_iterator, const_iterator>(
+            lower_bound(key), upper_bound(key));
+    }
+
+    //! Iterator to the first item equal to key, or end().
+    const_iterator find(const key_type& key) const {
+        size_t pos = position<false>(key);
+        if (pos < size_ && !key_less_(key, leaf_keys_[pos]))
+            return values_ + pos;
+        return end();
+    }
+
+    //! True if an item equal to key exists.
+    bool exists(const key_type& key) const {
+        return find(key) != end();
+    }
+
+    //! Number of items equal to key.
+    size_type count(const key_type& key) const {
+        return position<true>(key) - position<false>(key);
+    }
+
+    /*!
+     * Batched lookup of all keys in [first,last): writes find(key) for each
+     * key in order to out and returns the final output iterator. Up to
+     * find_batch_width lookups descend together, one level at a time, and
+     * the next block of each lookup is prefetched before the first of them is
+     * searched, such that the cache misses of different lookups overlap.
+     */
+    template <typename KeyIterator, typename OutputIterator>
+    OutputIterator find_batch(KeyIterator first, KeyIterator last,
+                              OutputIterator out) const {
+        if (size_ == 0) {
+            for ( ; first != last; ++first) *out++ = end();
+            return out;
+        }
+
+        size_t block[find_batch_width];     // NOLINT
+        KeyIterator keys[find_batch_width]; // NOLINT
+
+        while (first != last)
+        {
+            size_t n = 0;
+            for ( ; n < find_batch_width && first != last; ++n, ++first) {
+                block[n] = 0;
+                keys[n] = first;
+            }
+
+            for (size_t l = 0; l < levels_.size(); ++l)
+            {
+                for (size_t i = 0; i < n; ++i)
+                {
+                    block[i] = child_block<false>(levels_[l], block[i],
+                                                  *keys[i]);
+
+                    if (l + 1 < levels_.size()) {
+                        TLX_PREFETCH(inner_ + levels_[l + 1].offset +
+                                     block[i] * block_slots);
+                    }
+                    else {
+                        TLX_PREFETCH(leaf_keys_ + block[i] * block_slots);
+                    }
+                }
+            }
+
+            for (size_t i = 0; i < n; ++i)
+            {
+                size_t pos = leaf_position<false>(block[i], *keys[i]);
+                if (pos < size_ && !key_less_(*keys[i], leaf_keys_[pos]))
+                    *out++ = values_ + pos;
+                else
+                    *out++ = end();
+            }
+        }
+
+        return out;
+    }
+
+    //! \}
+
+public:
+    //! \name Persistence in Memory-Mapped Files
+    //! \{
+
+    /*!
+     * Write the tree to a file at path, which can be loaded by map_file().
+     * The file contains a header with the tree's shape, followed by the memory
+     * block starting at a multiple of MappedFile::page_size. Throws
+     * std::runtime_error if the file cannot be written.
+     */
+    void save_file(const std::string& path) const {
+        static_assert(file_compatible,
+                      "only trivially copyable types can be saved");
+
+        std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+        if (!out.good()) file_error(path, "cannot open for writing");
+
+        FileHeader h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, file_magic(), sizeof(h.magic));
+        h.byte_order = file_byte_order;
+        h.key_size = sizeof(key_type);
+        h.value_size = sizeof(value_type);
+        h.block_slots = block_slots;
+        h.size = size_;
+        h.inner_slots = inner_slots_;
+        h.leaf_slots = leaf_slots_;
+        h.num_levels = levels_.size();
+        h.data_offset = data_offset(levels_.size());
+        h.data_size = memory_size_;
+
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        for (const Level& level : levels_) {
+            uint64_t l[2] = { level.offset, level.children };
+            out.write(reinterpret_cast<const char*>(l), sizeof(l));
+        }
+        write_zeros(out, h.data_offset - sizeof(h) - 2 * 8 * levels_.size());
+
+        // the memory block with zeros instead of the uninitialized padding
+        out.write(reinterpret_cast<const char*>(inner_),
+                  inner_slots_ * sizeof(key_type));
+        write_zeros(out, round_up(inner_slots_ * sizeof(key_type))
+                    - inner_slots_ * sizeof(key_type));
+        if (!keys_in_values) {
+            out.write(reinterpret_cast<const char*>(leaf_keys_),
+                      leaf_slots_ * sizeof(key_type));
+            write_zeros(out, round_up(leaf_slots_ * sizeof(key_type))
+                        - leaf_slots_ * sizeof(key_type));
+        }
+        out.write(reinterpret_cast<const char*>(values_),
+                  size_ * sizeof(value_type));
+
+        out.close();
+        if (!out.good()) file_error(path, "write failed");
+    }
+
+    /*!
+     * Map a file written by save_file() read-only and return a frozen tree
+     * using it without copying. Nothing but the header is read, the file's
+     * pages are loaded on demand. The mapping is released when the tree is
+     * destroyed, copies of the tree are built in memory. Throws
+     * std::runtime_error if the file cannot be mapped or was written for
+     * different types, a different machine, or is corrupt: the header and
+     * levels must match the layout built for the number of items exactly.
+     */
+    static FrozenBTree map_file(const std::string& path,
+                                const key_compare& kcf = key_compare()) {
+        static_assert(file_compatible,
+                      "only trivially copyable types can be mapped");
+
+        FrozenBTree tree(kcf);
+        CountingPtr<MappedFile> file = make_counting<MappedFile>(path);
+
+        FileHeader h;
+        if (file->size() < sizeof(h)) file_error(path, "header truncated");
+        std::memcpy(&h, file->data(), sizeof(h));
+
+        if (std::memcmp(h.magic, file_magic(), sizeof(h.magic)) != 0)
+            file_error(path, "not a FrozenBTree file");
+        if (h.byte_order != file_byte_order)
+            file_error(path, "written with different byte order");
+        if (h.key_size != sizeof(key_type) ||
+            h.value_size != sizeof(value_type) ||
+            h.block_slots != block_slots)
+            file_error(path, "written for different types");
+
+        // the items must fit into the file, which bounds the shape below
+        uint64_t values_bytes;
+        if (!checked_mul(h.size, sizeof(value_type), values_bytes) ||
+            values_bytes > file->size())
+            file_error(path, "file truncated");
+
+        // the shape must be exactly the one build() lays out for h.size items
+        size_t inner_slots, leaf_slots;
+        layout(static_cast<size_t>(h.size), tree.levels_,
+               inner_slots, leaf_slots);
+        if (h.inner_slots != inner_slots || h.leaf_slots != leaf_slots ||
+            h.num_levels != tree.levels_.size())
+            file_error(path, "inconsistent header");
+
+        // num_levels is now small, hence data_offset() cannot overflow
+        if (h.data_offset != data_offset(h.num_levels) ||
+            h.data_offset > file->size() ||
+            h.data_size > file->size() - h.data_offset)
+            file_error(path, "file truncated");
+
+        uint64_t inner_bytes, leaf_bytes;
+        if (!checked_mul(h.inner_slots, sizeof(key_type), inner_bytes) ||
+            !checked_mul(h.leaf_slots, sizeof(key_type), leaf_bytes) ||
+            inner_bytes > h.data_size || leaf_bytes > h.data_size)
+            file_error(path, "inconsistent header");
+        inner_bytes = round_up(inner_bytes);
+        leaf_bytes = round_up(leaf_bytes);
+        if (h.data_size < inner_bytes ||
+            h.data_size - inner_bytes < leaf_bytes ||
+            h.data_size - inner_bytes - leaf_bytes != values_bytes)
+            file_error(path, "inconsistent header");
+
+        const char* levels = file->data() + sizeof(h);
+        for (size_t i = 0; i < h.num_levels; ++i) {
+            uint64_t l[2];
+            std::memcpy(l, levels + i * sizeof(l), sizeof(l));
+            if (l[0] != tree.levels_[i].offset ||
+                l[1] != tree.levels_[i].children)
+                file_error(path, "inconsistent levels");
+        }
+
+        // the mapping is read-only, the pointers are never written through.
+        char* base = const_cast<char*>(file->data() + h.data_offset);
+        tree.memory_size_ = h.data_size;
+        tree.size_ = h.size;
+        tree.inner_ = reinterpret_cast<key_type*>(base);
+        tree.inner_slots_ = h.inner_slots;
+        tree.leaf_slots_ = h.leaf_slots;
+        tree.values_ = reinterpret_cast<value_type*>(
+            base + inner_bytes + leaf_bytes);
+        if (keys_in_values) {
+            tree.leaf_keys_ =
+                reinterpret_cast<const key_type*>(tree.values_);
+        }
+        else {
+            tree.leaf_keys_ =
+                reinterpret_cast<const key_type*>(base + inner_bytes);
+        }
+        tree.mapping_ = std::move(file);
+
+        return tree;
+    }
+
+    //! \}
+
+private:
+    //! \name Tree Layout
+    //! \{
+
+    //! One level of separator blocks, stored from the root downwards.
+    struct Level {
+        //! index of the level's first key in inner_
+        size_t offset;
+        //! number of blocks in the level below
+        size_t children;
+    };
+
+    //! raw memory block
+    char* memory_ = nullptr;
+
+    //! size of the memory block
+    size_t memory_size_ = 0;
+
+    //! number of items
+    size_t size_ = 0;
+
+    //! separator keys of all levels
+    key_type* inner_ = nullptr;
+
+    //! number of keys in inner_
+    size_t inner_slots_ = 0;
+
+    //! keys of the lowest level, padded to whole blocks for maps
+    const key_type* leaf_keys_ = nullptr;
+
+    //! number of separately constructed keys in leaf_keys_
+    size_t leaf_slots_ = 0;
+
+    //! sorted items
+    value_type* values_ = nullptr;
+
+    //! separator levels, root first
+    std::vector<Level> levels_;
+
+    //! key comparison object
+    key_compare key_less_;
+
+    //! file containing the memory block if loaded by map_file()
+    CountingPtr<MappedFile> mapping_;
+
+    //! Number of keys in [keys,keys+n) less than key, or less than or equal to
+    //! key if Upper.
+    template <bool Upper>
+    size_t search(const key_type* keys, size_t n, const key_type& key) const {
+        return search<Upper>(keys, n, key,
+                             std::integral_constant<bool, simd_search>());
+    }
+
+    template <bool Upper>
+    size_t search(const key_type* keys, size_t n, const key_type& key,
+                  std::true_type /* simd_search */) const {
+        return Upper ? btree_simd::find_upper(keys, n, key)
+               : btree_simd::find_lower(keys, n, key);
+    }
+
+    template <bool Upper>
+    size_t search(const key_type* keys, size_t n, const key_type& key,
+                  std::false_type /* simd_search */) const {
+        return static_cast<size_t>(
+            (Upper ? std::upper_bound(keys, keys + n, key, key_less_)
+             : std::lower_bound(keys, keys + n, key, key_less_)) - keys);
+    }
+
+    //! Index of the child of block in the next lower level, which contains the
+    //! lower (or upper) bound of key.
+    template <bool Upper>
+    size_t child_block(const Level& level, size_t block,
+                       const key_type& key) const {
+        // only separators between existing children are valid
+        size_t first_child = block * (block_slots + 1);
+        size_t slots = level.children - first_child - 1;
+        if (slots > block_slots) slots = block_slots;
+        return first_child + search<Upper>(
+            inner_ + level.offset + block * block_slots, slots, key);
+    }
+
+    //! Index of the lower (or upper) bound of key in the leaf block.
+    template <bool Upper>
+    size_t leaf_position(size_t block, const key_type& key) const {
+        size_t begin = block * block_slots;
+        size_t slots = size_ - begin;
+        if (slots > block_slots) slots = block_slots;
+        return begin + search<Upper>(leaf_keys_ + begin, slots, key);
+    }
+
+    //! Index of the lower (or upper) bound of key in the sorted items.
+    template <bool Upper>
+    size_t position(const key_type& key) const {
+        if (size_ == 0) return 0;
+
+        size_t block = 0;
+        for (const Level& level : levels_)
+            block = child_block<Upper>(level, block, key);
+
+        return leaf_position<Upper>(block, key);
+    }
+
+    //! Round up bytes to whole cache lines.
+    static size_t round_up(size_t bytes) {
+        return (bytes + cache_line_size - 1) / cache_line_size
+               * cache_line_size;
+    }
+
+    /*!
+     * Compute the shape of a tree of n items: the separator levels, root
+     * first, and the number of keys in inner_ and of separate leaf keys.
+     * Returns the number of blocks of each level, from the lowest upwards.
+     */
+    static std::vector<size_t> layout(size_t n, std::vector<Level>& levels,
+                                      size_t& inner_slots,
+                                      size_t& leaf_slots) {
+        std::vector<size_t> blocks(1, (n + block_slots - 1) / block_slots);
+        while (blocks.back() > 1) {
+            blocks.push_back(
+                (blocks.back() + block_slots) / (block_slots + 1));
+        }
+
+        inner_slots = 0;
+        for (size_t i = 1; i < blocks.size(); ++i)
+            inner_slots += blocks[i] * block_slots;
+
+        leaf_slots = keys_in_values ? 0 : blocks[0] * block_slots;
+
+        // the levels are placed root first
+        levels.resize(blocks.size() - 1);
+        size_t offset = inner_slots;
+        for (size_t h = 1; h < blocks.size(); ++h)
+        {
+            offset -= blocks[h] * block_slots;
+
+            Level& level = levels[blocks.size() - 1 - h];
+            level.offset = offset;
+            level.children = blocks[h - 1];
+        }
+        return blocks;
+    }
+
+    //! Build the tree from a sorted range.
+    template <typename Iterator>
+    void build(Iterator first, Iterator last) {
+        size_t n = static_cast<size_t>(std::distance(first, last));
+        if (n == 0) return;
+
+        size_t inner_slots, leaf_slots;
+        std::vector<size_t> blocks =
+            layout(n, levels_, inner_slots, leaf_slots);
+
+        // layout of the memory block: separators, leaf keys, items
+        size_t inner_bytes = round_up(inner_slots * sizeof(key_type));
+        size_t leaf_bytes = round_up(leaf_slots * sizeof(key_type));
+        memory_size_ = inner_bytes + leaf_bytes + n * sizeof(value_type);
+        memory_ = static_cast<char*>(
+            ::operator new (memory_size_ + cache_line_size - 1));
+
+        char* base = reinterpret_cast<char*>(
+            round_up(reinterpret_cast<uintptr_t>(memory_)));
+        inner_ = reinterpret_cast<key_type*>(base);
+        values_ = reinterpret_cast<value_type*>(
+            base + inner_bytes + leaf_bytes);
+
+        try {
+            for ( ; first != last; ++first, ++size_)
+                new (values_ + size_)value_type(*first);
+
+            if (keys_in_values) {
+                leaf_keys_ = reinterpret_cast<const key_type*>(values_);
+            }
+            else {
+                key_type* leaf_keys =
+                    reinterpret_cast<key_type*>(base + inner_bytes);
+                for ( ; leaf_slots_ < leaf_slots; ++leaf_slots_) {
+                    if (leaf_slots_ < n) {
+                        new (leaf_keys + leaf_slots_)key_type(
+                            key_of_value::get(values_[leaf_slots_]));
+                    }
+                    else {
+                        new (leaf_keys + leaf_slots_)key_type();
+                    }
+                }
+                leaf_keys_ = leaf_keys;
+            }
+
+            // smallest key below each block of the current level
+            std::vector<const key_type*> mins(blocks[0]);
+            for (size_t b = 0; b < blocks[0]; ++b)
+                mins[b] = leaf_keys_ + b * block_slots;
+
+            for ( ; inner_slots_ < inner_slots; ++inner_slots_)
+                new (inner_ + inner_slots_)key_type();
+
+            // fill the separator levels upwards
+            for (size_t h = 1; h < blocks.size(); ++h)
+            {
+                size_t offset = levels_[blocks.size() - 1 - h].offset;
+
+                for (size_t b = 0; b < blocks[h]; ++b)
+                {
+                    for (size_t s = 0; s < block_slots; ++s)
+                    {
+                        // separator s is the smallest key of child s + 1
+                        size_t child = b * (block_slots + 1) + s + 1;
+                        if (child < mins.size())
+                            inner_[offset + b * block_slots + s] = *mins[child];
+                    }
+                    mins[b] = mins[b * (block_slots + 1)];
+                }
+                mins.resize(blocks[h]);
+            }
+        }
+        catch (...) {
+            destroy();
+            throw;
+        }
+    }
+
+    //! Destroy all keys and items and free the memory block, or release the
+    //! mapped file.
+    void destroy() {
+        if (!mapping_) {
+            for (size_t i = 0; i < size_; ++i)
+                values_[i].~value_type();
+            if (!keys_in_values) {
+                key_type* leaf_keys = const_cast<key_type*>(leaf_keys_);
+                for (size_t i = 0; i < leaf_slots_; ++i)
+                    leaf_keys[i].~key_type();
+            }
+            for (size_t i = 0; i < inner_slots_; ++i)
+                inner_[i].~key_type();
+
+            ::operator delete (memory_);
+        }
+        mapping_.reset();
+
+        memory_ = nullptr;
+        memory_size_ = size_ = inner_slots_ = leaf_slots_ = 0;
+        inner_ = nullptr;
+        leaf_keys_ = nullptr;
+        values_ = nullptr;
+        levels_.clear();
+    }
+
+    //! \}
+
+private:
+    //! \name File Format
+    //! \{
+
+    //! Header of a file written by save_file(), followed by num_levels pairs
+    //! of (offset, children) and the memory block at data_offset.
+    struct FileHeader {
+        //! identifies the file format and version
+        char magic[8];
+        //! file_byte_order as written by the machine
+        uint64_t byte_order;
+        //! sizes of the types and blocks
+        uint64_t key_size, value_size, block_slots;
+        //! shape of the tree
+        uint64_t size, inner_slots, leaf_slots, num_levels;
+        //! position and size of the memory block
+        uint64_t data_offset, data_size;
+    };
+
+    //! Magic bytes at the start of the file.
+    static const char * file_magic() { return "tlxFBT01"; }
+
+    //! Value whose byte order detects files from other machines.
+    static const uint64_t file_byte_order = 0x0102030405060708ull;
+
+    //! Offset of the memory block: header and levels rounded up to a page.
+    static uint64_t data_offset(uint64_t num_levels) {
+        uint64_t bytes = sizeof(FileHeader) + 2 * 8 * num_levels;
+        return (bytes + MappedFile::page_size - 1)
+               / MappedFile::page_size * MappedFile::page_size;
+    }
+
+    //! Set r = a * b, returns false if the product overflows.
+    static bool checked_mul(uint64_t a, uint64_t b, uint64_t& r) {
+        if (b != 0 && a > std::numeric_limits<uint64_t>::max() / b)
+            return false;
+        r = a * b;
+        return true;
+    }
+
+    //! Write n zero bytes.
+    static void write_zeros(std::ostream& out, uint64_t n) {
+        static const char zeros[256] = { 0 };
+        for ( ; n > sizeof(zeros); n -= sizeof(zeros))
+            out.write(zeros, sizeof(zeros));
+        out.write(zeros, static_cast<std::streamsize>(n));
+    }
+
+    [[noreturn]] static void file_error(const std::string& path,
+                                        const char* what) {
+        throw std::runtime_error("FrozenBTree: " + path + ": " + what);
+    }
+
+    //! \}
+};
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_CONTAINER_BTREE_FROZEN_HEADER
+
+/******************************************************************************/
@@ -14,6 +14,7 @@
 #include <functional>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include <tlx/container/btree.hpp>
 
@@ -94,6 +95,15 @@ public:
     //! Small structure containing statistics about the tree
     typedef typename btree_impl::tree_stats tree_stats;
 
+    //! Read-only view returned by snapshot(), requires traits::copy_on_write
+    typedef typename btree_impl::Snapshot snapshot_type;
+
+    //! Type of the subtree aggregates, requires traits::aggregate
+    typedef typename btree_impl::aggregate_type aggregate_type;
+
+    //! Immutable, read-optimized copy returned by freeze()
+    typedef typename btree_impl::frozen_type frozen_type;
+
     //! \}
 
 public:
@@ -354,6 +364,70 @@ public:
         return tree_.count(key);
     }
 
+    //! Batched lookup of all keys in [first,last), writes find(key) for each
+    //! key to out. Overlaps the cache misses of several lookups.
+    template <typename KeyIterator, typename OutputIterator>
+    OutputIterator find_batch(KeyIterator first, KeyIterator last,
+                              OutputIterator out) {
+        return tree_.find_batch(first, last, out);
+    }
+
+    //! Batched lookup of all keys in [first,last), writes find(key) for each
+    //! key to out. Overlaps the cache misses of several lookups.
+    template <typename KeyIterator, typename OutputIterator>
+    OutputIterator find_batch(KeyIterator first, KeyIterator last,
+                              OutputIterator out) const {
+        return tree_.find_batch(first, last, out);
+    }
+
+    //! Returns the number of items with keys less than key. Requires
+    //! traits::order_statistics.
+    template <bool OrderStatistics = btree_impl::order_statistics>
+    size_type rank(const key_type& key) const {
+        return tree_.rank(key);
+    }
+
+    //! Returns an iterator to the item with index k in sorted order, or end()
+    //! if k >= size(). Requires traits::order_statistics.
+    template <bool OrderStatistics = btree_impl::order_statistics>
+    iterator select(size_type k) {
+        return tree_.select(k);
+    }
+
+    //! Returns a constant iterator to the item with index k in sorted order,
+    //! or end() if k >= size(). Requires traits::order_statistics.
+    template <bool OrderStatistics = btree_impl::order_statistics>
+    const_iterator select(size_type k) const {
+        return tree_.select(k);
+    }
+
+    //! Returns the index of the item referenced by iter in sorted order.
+    //! Requires traits::order_statistics.
+    template <bool OrderStatistics = btree_impl::order_statistics>
+    size_type index_of(const_iterator iter) const {
+        return tree_.index_of(iter);
+    }
+
+    //! Returns the number of items in the range [first,last) in O(log n).
+    //! Requires traits::order_statistics.
+    template <bool OrderStatistics = btree_impl::order_statistics>
+    size_type count_range(const_iterator first, const_iterator last) const {
+        return tree_.count_range(first, last);
+    }
+
+    //! Returns the aggregate of all items. Requires traits::aggregate.
+    template <bool Augmented = btree_impl::augmented>
+    aggregate_type aggregate() const {
+        return tree_.aggregate();
+    }
+
+    //! Returns the aggregate of the items with keys in the range [lo,hi) in
+    //! O(log n) time. Requires traits::aggregate.
+    template <bool Augmented = btree_impl::augmented>
+    aggregate_type aggregate(const key_type& lo, const key_type& hi) const {
+        return tree_.aggregate(lo, hi);
+    }
+
     //! Searches the B+ tree and returns an iterator to the first pair equal to
     //! or greater than key, or end() if all keys are smaller.
     iterator lower_bound(const key_type& key) {
@@ -445,6 +519,20 @@ public:
         : tree_(other.tree_)
     { }
 
+    //! Returns a read-only snapshot of the current contents in O(1) time,
+    //! which shares all nodes until they are modified. Requires
+    //! traits::copy_on_write, see BTree::snapshot().
+    template <bool CopyOnWrite = btree_impl::copy_on_write>
+    snapshot_type snapshot() const {
+        return tree_.snapshot();
+    }
+
+    //! Returns an immutable copy of all items in one contiguous memory block
+    //! without pointers, which answers lookups faster than the B+ tree.
+    frozen_type freeze() const {
+        return tree_.freeze();
+    }
+
     //! \}
 
 public:
@@ -475,6 +563,14 @@ public:
         }
     }
 
+    //! Insert the sorted range [first,last) of keys. Appended ranges are bulk
+    //! loaded, other keys are inserted leaf by leaf, see
+    //! BTree::insert_sorted(). Keys which already exist are skipped.
+    template <typename Iterator>
+    void insert_sorted(Iterator first, Iterator last) {
+        return tree_.insert_sorted(first, last);
+    }
+
     //! Bulk load a sorted range [first,last). Loads items into leaves and
     //! constructs a B-tree above them. The tree must be empty when calling this
     //! function.
@@ -483,6 +579,93 @@ public:
         return tree_.bulk_load(first, last);
     }
 
+    //! Bulk load a sorted range [first,last) in parallel using the threads of
+    //! pool. Constructs the same B-tree as bulk_load(first, last). The tree
+    //! must be empty when calling this function.
+    template <typename Iterator>
+    void bulk_load(Iterator first, Iterator last, ThreadPool& pool) {
+        return tree_.bulk_load(first, last, pool);
+    }
+
+    //! Bulk load a sorted range [first,last) in parallel using num_threads
+    //! threads. Constructs the same B-tree as bulk_load(first, last). The tree
+    //! must be empty when calling this function.
+    template <typename Iterator>
+    void bulk_load(Iterator first, Iterator last, size_t num_threads) {
+        return tree_.bulk_load(first, last, num_threads);
+    }
+
+    //! \}
+
+public:
+    //! \name Partitioning and Parallel Iteration
+    //! \{
+
+    //! Split the items into parts consecutive ranges of about equal size and
+    //! return their parts + 1 boundaries, see BTree::partition().
+    std::vector<iterator> partition(size_t parts) {
+        return tree_.partition(parts);
+    }
+
+    //! Split the items into parts consecutive ranges of about equal size and
+    //! return their parts + 1 boundaries, see BTree::partition().
+    std::vector<const_iterator> partition(size_t parts) const {
+        return tree_.partition(parts);
+    }
+
+    //! Call func(value) for each item in parallel using the threads of pool.
+    //! func must be thread-safe, see BTree::parallel_for_each().
+    template <typename Functor>
+    void parallel_for_each(const Functor& func, ThreadPool& pool) {
+        return tree_.parallel_for_each(func, pool);
+    }
+
+    //! Call func(value) for each item in parallel using the threads of pool.
+    //! func must be thread-safe, see BTree::parallel_for_each().
+    template <typename Functor>
+    void parallel_for_each(const Functor& func, ThreadPool& pool) const {
+        return tree_.parallel_for_each(func, pool);
+    }
+
+    //! Call func(value) for each item in parallel using num_threads threads.
+    //! func must be thread-safe, see BTree::parallel_for_each().
+    template <typename Functor>
+    void parallel_for_each(const Functor& func, size_t num_threads) {
+        return tree_.parallel_for_each(func, num_threads);
+    }
+
+    //! Call func(value) for each item in parallel using num_threads threads.
+    //! func must be thread-safe, see BTree::parallel_for_each().
+    template <typename Functor>
+    void parallel_for_each(const Functor& func, size_t num_threads) const {
+        return tree_.parallel_for_each(func, num_threads);
+    }
+
+    //! \}
+
+public:
+    //! \name Joining, Merging and Splitting
+    //! \{
+
+    //! Append all items of other, whose keys must be greater than all keys
+    //! of this tree, in O(log n) time. Leaves other empty.
+    void join(btree_set& other) {
+        return tree_.join(other.tree_);
+    }
+
+    //! Move all items of other into this tree. Uses join() if the key ranges
+    //! do not overlap, otherwise merges linearly and rebuilds the tree. Items
+    //! of other whose keys already exist remain in other.
+    void merge(btree_set& other) {
+        return tree_.merge(other.tree_);
+    }
+
+    //! Move all items with keys equal to or greater than key into the empty
+    //! tree right. Restructuring takes O(log n) time.
+    void split(const key_type& key, btree_set& right) {
+        return tree_.split(key, right.tree_);
+    }
+
     //! \}
 
 public:
@@ -505,13 +688,11 @@ public:
         return tree_.erase(iter);
     }
 
-#ifdef TLX_BTREE_TODO
-    //! Erase all keys in the range [first,last). This function is currently
-    //! not implemented by the B+ Tree.
-    void erase(iterator /* first */, iterator /* last */) {
-        abort();
+    //! Erase all keys in the range [first,last). Whole subtrees are cut out of
+    //! the tree, see BTree::erase(iterator, iterator).
+    void erase(iterator first, iterator last) {
+        return tree_.erase(first, last);
     }
-#endif
 
     //! \}
 
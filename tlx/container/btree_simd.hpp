@@ -0,0 +1,449 @@
+/*******************************************************************************
+ * tlx/container/btree_simd.hpp
+ *
+ * SIMD kernels for searching the sorted key arrays inside B+ tree nodes. They
+ * compare a vector of keys at once and count the matching lanes with a
+ * movemask/popcount. The instruction set is selected at run-time.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_CONTAINER_BTREE_SIMD_HEADER
+#define TLX_CONTAINER_BTREE_SIMD_HEADER
+
+#include <tlx/math/popcount.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
+#if !defined(TLX_BTREE_NO_SIMD) && \
+    (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+//! Defined if the x86 SIMD search kernels are compiled in. Define
+//! TLX_BTREE_NO_SIMD to disable them.
+#define TLX_BTREE_HAVE_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace tlx {
+
+//! \addtogroup tlx_container_btree
+//! \{
+
+namespace btree_simd {
+
+//! Instruction sets for which search kernels are available.
+enum class Isa { scalar = 0, sse42 = 1, avx2 = 2 };
+
+#if TLX_BTREE_HAVE_SIMD
+
+//! Detect the best instruction set supported by the running CPU.
+static inline Isa detect_cpu_isa() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return Isa::avx2;
+    if (__builtin_cpu_supports("sse4.2"))
+        return Isa::sse42;
+    return Isa::scalar;
+}
+
+//! The best instruction set supported by the running CPU, determined once
+//! during static initialization.
+template <typename Dummy = void>
+struct CpuIsa {
+    static const Isa isa;
+};
+
+template <typename Dummy>
+const Isa CpuIsa<Dummy>::isa = detect_cpu_isa();
+
+//! Return the best instruction set supported by the running CPU.
+static inline Isa cpu_isa() {
+    return CpuIsa<>::isa;
+}
+
+/******************************************************************************/
+// Vector Operations for each Key Type and Instruction Set
+//
+// Each struct provides set1() and load() and two comparisons returning a lane
+// bit mask: less() sets bits for v < k and less_equal() for v <= k. Unsigned
+// integers are compared by flipping the sign bit, since SSE/AVX only offer
+// signed comparisons.
+
+#define TLX_BTREE_SIMD_AVX2 __attribute__ ((target("avx2")))
+#define TLX_BTREE_SIMD_SSE42 __attribute__ ((target("sse4.2")))
+
+template <typename Key>
+struct Avx2Ops;
+
+template <>
+struct Avx2Ops<int32_t> {
+    typedef __m256i vec;
+    static const size_t lanes = 8;
+    static const unsigned full = 0xFF;
+    static TLX_BTREE_SIMD_AVX2 vec set1(int32_t k) {
+        return _mm256_set1_epi32(k);
+    }
+    static TLX_BTREE_SIMD_AVX2 vec load(const int32_t* p) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+    static TLX_BTREE_SIMD_AVX2 unsigned less(vec v, vec k) {
+        return static_cast<unsigned>(_mm256_movemask_ps(
+                                         _mm256_castsi256_ps(
+                                             _mm256_cmpgt_epi32(k, v))));
+    }
+    static TLX_BTREE_SIMD_AVX2 unsigned less_equal(vec v, vec k) {
+        return ~static_cast<unsigned>(
+            _mm256_movemask_ps(_mm256_castsi256_ps(
+                                   _mm256_cmpgt_epi32(v, k)))) & full;
+    }
+};
+
+template <>
+struct Avx2Ops<uint32_t> : public Avx2Ops<int32_t>{
+    static TLX_BTREE_SIMD_AVX2 vec flip(vec v) {
+        return _mm256_xor_si256(
+            v, _mm256_set1_epi32(static_cast<int32_t>(0x80000000u)));
+    }
+    static TLX_BTREE_SIMD_AVX2 vec set1(uint32_t k) {
+        return flip(_mm256_set1_epi32(static_cast<int32_t>(k)));
+    }
+    static TLX_BTREE_SIMD_AVX2 vec load(const uint32_t* p) {
+        return flip(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+    }
+};
+
+template <>
+struct Avx2Ops<int64_t> {
+    typedef __m256i vec;
+    static const size_t lanes = 4;
+    static const unsigned full = 0xF;
+    static TLX_BTREE_SIMD_AVX2 vec set1(int64_t k) {
+        return _mm256_set1_epi64x(k);
+    }
+    static TLX_BTREE_SIMD_AVX2 vec load(const int64_t* p) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+    static TLX_BTREE_SIMD_AVX2 unsigned less(vec v, vec k) {
+        return static_cast<unsigned>(_mm256_movemask_pd(
+                                         _mm256_castsi256_pd(
+                                             _mm256_cmpgt_epi64(k, v))));
+    }
+    static TLX_BTREE_SIMD_AVX2 unsigned less_equal(vec v, vec k) {
+        return ~static_cast<unsigned>(
+            _mm256_movemask_pd(_mm256_castsi256_pd(
+                                   _mm256_cmpgt_epi64(v, k)))) & full;
+    }
+};
+
+template <>
+struct Avx2Ops<uint64_t> : public Avx2Ops<int64_t>{
+    static TLX_BTREE_SIMD_AVX2 vec flip(vec v) {
+        return _mm256_xor_si256(
+            v, _mm256_set1_epi64x(
+                static_cast<int64_t>(0x8000000000000000ull)));
+    }
+    static TLX_BTREE_SIMD_AVX2 vec set1(uint64_t k) {
+        return flip(_mm256_set1_epi64x(static_cast<int64_t>(k)));
+    }
+    static TLX_BTREE_SIMD_AVX2 vec load(const uint64_t* p) {
+        return flip(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+    }
+};
+
+template <>
+struct Avx2Ops<float> {
+    typedef __m256 vec;
+    static const size_t lanes = 8;
+    static const unsigned full = 0xFF;
+    static TLX_BTREE_SIMD_AVX2 vec set1(float k) {
+        return _mm256_set1_ps(k);
+    }
+    static TLX_BTREE_SIMD_AVX2 vec load(const float* p) {
+        return _mm256_loadu_ps(p);
+    }
+    static TLX_BTREE_SIMD_AVX2 unsigned less(vec v, vec k) {
+        return static_cast<unsigned>(
+            _mm256_movemask_ps(_mm256_cmp_ps(v, k, _CMP_LT_OQ)));
+    }
+    static TLX_BTREE_SIMD_AVX2 unsigned less_equal(vec v, vec k) {
+        return static_cast<unsigned>(
+            _mm256_movemask_ps(_mm256_cmp_ps(v, k, _CMP_LE_OQ)));
+    }
+};
+
+template <>
+struct Avx2Ops<double> {
+    typedef __m256d vec;
+    static const size_t lanes = 4;
+    static const unsigned full = 0xF;
+    static TLX_BTREE_SIMD_AVX2 vec set1(double k) {
+        return _mm256_set1_pd(k);
+    }
+    static TLX_BTREE_SIMD_AVX2 vec load(const double* p) {
+        return _mm256_loadu_pd(p);
+    }
+    static TLX_BTREE_SIMD_AVX2 unsigned less(vec v, vec k) {
+        return static_cast<unsigned>(
+            _mm256_movemask_pd(_mm256_cmp_pd(v, k, _CMP_LT_OQ)));
+    }
+    static TLX_BTREE_SIMD_AVX2 unsigned less_equal(vec v, vec k) {
+        return static_cast<unsigned>(
+            _mm256_movemask_pd(_mm256_cmp_pd(v, k, _CMP_LE_OQ)));
+    }
+};
+
+template <typename Key>
+struct Sse42Ops;
+
+template <>
+struct Sse42Ops<int32_t> {
+    typedef __m128i vec;
+    static const size_t lanes = 4;
+    static const unsigned full = 0xF;
+    static TLX_BTREE_SIMD_SSE42 vec set1(int32_t k) {
+        return _mm_set1_epi32(k);
+    }
+    static TLX_BTREE_SIMD_SSE42 vec load(const int32_t* p) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+    static TLX_BTREE_SIMD_SSE42 unsigned less(vec v, vec k) {
+        return static_cast<unsigned>(
+            _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(k, v))));
+    }
+    static TLX_BTREE_SIMD_SSE42 unsigned less_equal(vec v, vec k) {
+        return ~static_cast<unsigned>(
+            _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(v, k)))) & full;
+    }
+};
+
+template <>
+struct Sse42Ops<uint32_t> : public Sse42Ops<int32_t>{
+    static TLX_BTREE_SIMD_SSE42 vec flip(vec v) {
+        return _mm_xor_si128(
+            v, _mm_set1_epi32(static_cast<int32_t>(0x80000000u)));
+    }
+    static TLX_BTREE_SIMD_SSE42 vec set1(uint32_t k) {
+        return flip(_mm_set1_epi32(static_cast<int32_t>(k)));
+    }
+    static TLX_BTREE_SIMD_SSE42 vec load(const uint32_t* p) {
+        return flip(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    }
+};
+
+template <>
+struct Sse42Ops<int64_t> {
+    typedef __m128i vec;
+    static const size_t lanes = 2;
+    static const unsigned full = 0x3;
+    static TLX_BTREE_SIMD_SSE42 vec set1(int64_t k) {
+        return _mm_set1_epi64x(k);
+    }
+    static TLX_BTREE_SIMD_SSE42 vec load(const int64_t* p) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+    static TLX_BTREE_SIMD_SSE42 unsigned less(vec v, vec k) {
+        return static_cast<unsigned>(
+            _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(k, v))));
+    }
+    static TLX_BTREE_SIMD_SSE42 unsigned less_equal(vec v, vec k) {
+        return ~static_cast<unsigned>(
+            _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(v, k)))) & full;
+    }
+};
+
+template <>
+struct Sse42Ops<uint64_t> : public Sse42Ops<int64_t>{
+    static TLX_BTREE_SIMD_SSE42 vec flip(vec v) {
+        return _mm_xor_si128(
+            v, _mm_set1_epi64x(static_cast<int64_t>(0x8000000000000000ull)));
+    }
+    static TLX_BTREE_SIMD_SSE42 vec set1(uint64_t k) {
+        return flip(_mm_set1_epi64x(static_cast<int64_t>(k)));
+    }
+    static TLX_BTREE_SIMD_SSE42 vec load(const uint64_t* p) {
+        return flip(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    }
+};
+
+template <>
+struct Sse42Ops<float> {
+    typedef __m128 vec;
+    static const size_t lanes = 4;
+    static const unsigned full = 0xF;
+    static TLX_BTREE_SIMD_SSE42 vec set1(float k) {
+        return _mm_set1_ps(k);
+    }
+    static TLX_BTREE_SIMD_SSE42 vec load(const float* p) {
+        return _mm_loadu_ps(p);
+    }
+    static TLX_BTREE_SIMD_SSE42 unsigned less(vec v, vec k) {
+        return static_cast<unsigned>(_mm_movemask_ps(_mm_cmplt_ps(v, k)));
+    }
+    static TLX_BTREE_SIMD_SSE42 unsigned less_equal(vec v, vec k) {
+        return static_cast<unsigned>(_mm_movemask_ps(_mm_cmple_ps(v, k)));
+    }
+};
+
+template <>
+struct Sse42Ops<double> {
+    typedef __m128d vec;
+    static const size_t lanes = 2;
+    static const unsigned full = 0x3;
+    static TLX_BTREE_SIMD_SSE42 vec set1(double k) {
+        return _mm_set1_pd(k);
+    }
+    static TLX_BTREE_SIMD_SSE42 vec load(const double* p) {
+        return _mm_loadu_pd(p);
+    }
+    static TLX_BTREE_SIMD_SSE42 unsigned less(vec v, vec k) {
+        return static_cast<unsigned>(_mm_movemask_pd(_mm_cmplt_pd(v, k)));
+    }
+    static TLX_BTREE_SIMD_SSE42 unsigned less_equal(vec v, vec k) {
+        return static_cast<unsigned>(_mm_movemask_pd(_mm_cmple_pd(v, k)));
+    }
+};
+
+/******************************************************************************/
+// Search Kernels
+//
+// Since the keys are sorted, the lane mask of a comparison is a run of ones
+// followed by zeros, hence the number of matched keys is the sum of the
+// popcounts of all vectors. The kernels compare all vectors without branching
+// on the masks, and handle the remaining keys with scalar comparisons.
+
+//! Count keys in [keys,keys+n) which are less (or less-equal) than key.
+template <typename KType, bool Equal, typename Key>
+static inline TLX_BTREE_SIMD_AVX2
+size_t count_avx2(const Key* keys, size_t n, const Key& key) {
+    typedef Avx2Ops<KType> Ops;
+    const typename Ops::vec k = Ops::set1(static_cast<KType>(key));
+    size_t i = 0, count = 0;
+    for ( ; i + Ops::lanes <= n; i += Ops::lanes) {
+        typename Ops::vec v =
+            Ops::load(reinterpret_cast<const KType*>(keys + i));
+        count += popcount(Equal ? Ops::less_equal(v, k) : Ops::less(v, k));
+    }
+    for ( ; i < n; ++i)
+        count += Equal ? !(key < keys[i]) : keys[i] < key;
+    return count;
+}
+
+//! Count keys in [keys,keys+n) which are less (or less-equal) than key.
+template <typename KType, bool Equal, typename Key>
+static inline TLX_BTREE_SIMD_SSE42
+size_t count_sse42(const Key* keys, size_t n, const Key& key) {
+    typedef Sse42Ops<KType> Ops;
+    const typename Ops::vec k = Ops::set1(static_cast<KType>(key));
+    size_t i = 0, count = 0;
+    for ( ; i + Ops::lanes <= n; i += Ops::lanes) {
+        typename Ops::vec v =
+            Ops::load(reinterpret_cast<const KType*>(keys + i));
+        count += popcount(Equal ? Ops::less_equal(v, k) : Ops::less(v, k));
+    }
+    for ( ; i < n; ++i)
+        count += Equal ? !(key < keys[i]) : keys[i] < key;
+    return count;
+}
+
+#undef TLX_BTREE_SIMD_AVX2
+#undef TLX_BTREE_SIMD_SSE42
+
+#endif // TLX_BTREE_HAVE_SIMD
+
+//! Count keys in [keys,keys+n) which are less (or less-equal) than key using
+//! plain scalar comparisons.
+template <bool Equal, typename Key>
+static inline size_t count_scalar(const Key* keys, size_t n, const Key& key) {
+    size_t i = 0;
+    while (i < n && (Equal ? !(key < keys[i]) : keys[i] < key)) ++i;
+    return i;
+}
+
+/******************************************************************************/
+
+//! Maps a key type onto the fixed-width type used by the kernels, or void if
+//! the type is not supported.
+template <typename Key>
+struct KernelType {
+    typedef typename std::conditional<
+            std::is_same<Key, float>::value || std::is_same<Key, double>::value,
+            Key,
+            typename std::conditional<
+                !std::is_integral<Key>::value ||
+                std::is_same<Key, bool>::value, void,
+                typename std::conditional<
+                    sizeof(Key) == 4,
+                    typename std::conditional<
+                        std::is_signed<Key>::value, int32_t, uint32_t>::type,
+                    typename std::conditional<
+                        sizeof(Key) == 8,
+                        typename std::conditional<
+                            std::is_signed<Key>::value, int64_t, uint64_t
+                            >::type,
+                        void>::type>::type>::type>::type type;
+};
+
+/*!
+ * Determines whether the in-node search of a B+ tree with the given key type
+ * and comparison functor can use the SIMD kernels. This is the case for 32-
+ * and 64-bit integers, float and double, when sorted with std::less.
+ */
+template <typename Key, typename Compare>
+struct is_supported
+    : public std::integral_constant<
+          bool,
+          !std::is_same<typename KernelType<Key>::type, void>::value &&
+          std::is_same<Compare, std::less<Key> >::value>{ };
+
+//! Count the keys in the sorted array [keys,keys+n) which are less than key,
+//! which is the first slot with keys[slot] >= key.
+template <typename Key>
+static inline size_t find_lower(const Key* keys, size_t n, const Key& key) {
+    typedef typename KernelType<Key>::type KType;
+#if TLX_BTREE_HAVE_SIMD
+    switch (cpu_isa()) {
+    case Isa::avx2:
+        return count_avx2<KType, false>(keys, n, key);
+    case Isa::sse42:
+        return count_sse42<KType, false>(keys, n, key);
+    default:
+        break;
+    }
+#endif
+    return count_scalar<false>(keys, n, key);
+}
+
+//! Count the keys in the sorted array [keys,keys+n) which are less or equal to
+//! key, which is the first slot with keys[slot] > key.
+template <typename Key>
+static inline size_t find_upper(const Key* keys, size_t n, const Key& key) {
+    typedef typename KernelType<Key>::type KType;
+#if TLX_BTREE_HAVE_SIMD
+    switch (cpu_isa()) {
+    case Isa::avx2:
+        return count_avx2<KType, true>(keys, n, key);
+    case Isa::sse42:
+        return count_sse42<KType, true>(keys, n, key);
+    default:
+        break;
+    }
+#endif
+    return count_scalar<true>(keys, n, key);
+}
+
+} // namespace btree_simd
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_CONTAINER_BTREE_SIMD_HEADER
+
+/******************************************************************************/
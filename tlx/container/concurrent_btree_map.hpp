@@ -0,0 +1,757 @@
+/*******************************************************************************
+ * tlx/container/concurrent_btree_map.hpp
+ *
+ * A concurrent B+ tree map using optimistic lock coupling.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_CONTAINER_CONCURRENT_BTREE_MAP_HEADER
+#define TLX_CONTAINER_CONCURRENT_BTREE_MAP_HEADER
+
+#include <tlx/container/btree.hpp>
+#include <tlx/container/btree_simd.hpp>
+#include <tlx/die/core.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace tlx {
+
+//! \addtogroup tlx_container_btree
+//! \{
+
+/*!
+ * Concurrent B+ tree map using optimistic lock coupling (OLC), following V.
+ * Leis, M. Haubenschild, T. Neumann: "Optimistic Lock Coupling: A Scalable and
+ * Efficient General-Purpose Synchronization Method" (2019).
+ *
+ * The nodes have the same layout as InnerNode and LeafNode of BTree, plus a
+ * version counter, which doubles as a write lock. Readers never write shared
+ * memory: they descend the tree remembering node versions and validate them
+ * after reading a node. If a version changed, the operation restarts from the
+ * root. Writers lock only the leaf they modify, and additionally its parent if
+ * the leaf (or an inner node) must be split. Full nodes are split eagerly on
+ * the way down, hence a split never propagates upwards.
+ *
+ * All methods except clear(), verify() and the destructor can be called
+ * concurrently from any number of threads. Since readers may observe partially
+ * written slots before validating, key_type and data_type must be trivially
+ * copyable.
+ *
+ * erase() removes items from the leaves, but does not merge underflowing
+ * nodes, as in the original OLC B+ tree. Nodes are therefore never freed while
+ * the tree is in use, which makes optimistic reads of stale nodes safe without
+ * epoch-based memory reclamation. All memory is released by clear() or the
+ * destructor.
+ */
+template <typename Key_, typename Data_,
+          typename Compare_ = std::less<Key_>,
+          typename Traits_ =
+              btree_default_traits<Key_, std::pair<Key_, Data_> > >
+class concurrent_btree_map
+{
+public:
+    //! \name Template Parameter Types
+    //! \{
+
+    //! First template parameter: The key type of the map.
+    typedef Key_ key_type;
+
+    //! Second template parameter: The value type associated with each key.
+    typedef Data_ data_type;
+
+    //! Third template parameter: Key comparison function object
+    typedef Compare_ key_compare;
+
+    //! Fourth template parameter: Traits object used to define more parameters
+    //! of the B+ tree
+    typedef Traits_ traits;
+
+    //! \}
+
+    static_assert(std::is_trivially_copyable<key_type>::value,
+                  "concurrent_btree_map requires trivially copyable keys");
+    static_assert(std::is_trivially_copyable<data_type>::value,
+                  "concurrent_btree_map requires trivially copyable data");
+
+public:
+    //! \name Constructed Types
+    //! \{
+
+    //! Construct the STL-required value_type as a composition pair of key and
+    //! data types
+    typedef std::pair<key_type, data_type> value_type;
+
+    //! Size type used to count keys
+    typedef size_t size_type;
+
+    //! \}
+
+public:
+    //! \name Static Constant Options and Values of the B+ Tree
+    //! \{
+
+    //! Base B+ tree parameter: The number of key/data slots in each leaf
+    static const unsigned short leaf_slotmax = traits::leaf_slots;
+
+    //! Base B+ tree parameter: The number of key slots in each inner node.
+    static const unsigned short inner_slotmax = traits::inner_slots;
+
+    //! True if the in-node search can use the SIMD kernels of btree_simd.
+    static const bool simd_search =
+        btree_simd::is_supported<key_type, key_compare>::value;
+
+    //! \}
+
+private:
+    //! \name Node Classes for In-Memory Nodes
+    //! \{
+
+    //! The header structure of each node, extended by InnerNode or LeafNode.
+    struct node {
+        //! Version counter and write lock: bit 0 is set while the node is
+        //! locked, every unlock increments the version.
+        std::atomic<uint64_t> version;
+
+        //! Level in the b-tree, if level == 0 -> leaf node. Never changes.
+        unsigned short level;
+
+        //! Number of key slots in use. Atomic since optimistic readers may
+        //! load it while a writer modifies the node.
+        std::atomic<unsigned short> slotuse;
+
+        explicit node(unsigned short l)
+            : version(0), level(l), slotuse(0) { }
+
+        //! True if this is a leaf node.
+        bool is_leafnode() const {
+            return (level == 0);
+        }
+
+        //! Number of used slots, for writers holding the lock.
+        unsigned short used() const {
+            return slotuse.load(std::memory_order_relaxed);
+        }
+
+        //! Wait until the node is unlocked and return its version.
+        uint64_t read_lock() const {
+            uint64_t v = version.load(std::memory_order_acquire);
+            for (size_t spin = 0; v & 1; ++spin) {
+                if (spin >= 64) std::this_thread::yield();
+                v = version.load(std::memory_order_acquire);
+            }
+            return v;
+        }
+
+        //! Validate that the node was not modified since read_lock() returned
+        //! the version v.
+        bool check(uint64_t v) const {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return version.load(std::memory_order_relaxed) == v;
+        }
+
+        //! Try to acquire the write lock, if the node still has version v.
+        bool upgrade(uint64_t v) {
+            return version.compare_exchange_strong(
+                v, v + 1, std::memory_order_acquire);
+        }
+
+        //! Release the write lock and increment the version.
+        void write_unlock() {
+            version.fetch_add(1, std::memory_order_release);
+        }
+    };
+
+    //! Inner node: keys and child pointers, as in BTree.
+    struct InnerNode : public node {
+        //! Keys of children
+        key_type slotkey[inner_slotmax]; // NOLINT
+
+        //! Pointers to children
+        node* childid[inner_slotmax + 1]; // NOLINT
+
+        explicit InnerNode(unsigned short l)
+            : node(l) { }
+
+        //! True if the node's slots are full.
+        bool is_full() const {
+            return (node::used() == inner_slotmax);
+        }
+    };
+
+    //! Leaf node: keys and data items in separate arrays, such that the keys
+    //! are contiguous and can be searched using SIMD.
+    struct LeafNode : public node {
+        //! Singly linked list pointer to traverse the leaves
+        LeafNode* next_leaf;
+
+        //! Keys of data items
+        key_type slotkey[leaf_slotmax]; // NOLINT
+
+        //! Data items
+        data_type slotdata[leaf_slotmax]; // NOLINT
+
+        LeafNode()
+            : node(0), next_leaf(nullptr) { }
+
+        //! True if the node's slots are full.
+        bool is_full() const {
+            return (node::used() == leaf_slotmax);
+        }
+    };
+
+    //! \}
+
+    //! \name Tree Object Data Members
+    //! \{
+
+    //! Pointer to the B+ tree's root node, either leaf or inner node. Never
+    //! nullptr.
+    std::atomic<node*> root_;
+
+    //! Number of items in the tree.
+    std::atomic<size_type> size_;
+
+    //! Key comparison object.
+    key_compare key_less_;
+
+    //! \}
+
+public:
+    //! \name Constructors and Destructor
+    //! \{
+
+    //! Default constructor initializing an empty B+ tree.
+    explicit concurrent_btree_map(const key_compare& kcf = key_compare())
+        : root_(new LeafNode()), size_(0), key_less_(kcf) { }
+
+    //! non-copyable.
+    concurrent_btree_map(const concurrent_btree_map&) = delete;
+    //! non-copyable.
+    concurrent_btree_map& operator = (const concurrent_btree_map&) = delete;
+
+    //! Frees up all nodes. Not thread-safe.
+    ~concurrent_btree_map() {
+        free_recursive(root_.load());
+    }
+
+    //! Frees all key/data pairs and all nodes of the tree. Not thread-safe.
+    void clear() {
+        free_recursive(root_.load());
+        root_.store(new LeafNode());
+        size_.store(0);
+    }
+
+    //! \}
+
+    //! \name Access Functions
+    //! \{
+
+    //! Return the number of key/data pairs in the B+ tree. This is only a
+    //! snapshot if other threads modify the tree.
+    size_type size() const {
+        return size_.load(std::memory_order_relaxed);
+    }
+
+    //! Returns true if there is at least one key/data pair in the B+ tree
+    bool empty() const {
+        return (size() == size_type(0));
+    }
+
+    //! Constant access to the key comparison object sorting the B+ tree.
+    key_compare key_comp() const {
+        return key_less_;
+    }
+
+    //! Looks up key and copies its data item into *data if found. Returns true
+    //! if the key was found.
+    bool find(const key_type& key, data_type* data = nullptr) const {
+        for ( ; ; ) {
+            uint64_t v;
+            const LeafNode* leaf = descend(key, &v);
+            if (!leaf) continue;
+
+            unsigned short slotuse = clamp(leaf->slotuse, leaf_slotmax);
+            unsigned short slot = find_lower(leaf, slotuse, key);
+            bool found =
+                (slot < slotuse && key_equal(key, leaf->slotkey[slot]));
+            data_type d = found ? leaf->slotdata[slot] : data_type();
+
+            if (!leaf->check(v)) continue;
+
+            if (found && data) *data = d;
+            return found;
+        }
+    }
+
+    //! Returns true if key is in the B+ tree.
+    bool exists(const key_type& key) const {
+        return find(key);
+    }
+
+    /*!
+     * Range scan: calls func(key, data) for up to max_count items with keys
+     * greater or equal to from in ascending order. Each leaf is copied and
+     * validated before its items are passed to func, hence func always sees
+     * consistent items, but the scan as a whole is not a snapshot of the tree.
+     * Returns the number of items passed to func.
+     */
+    template <typename Functor>
+    size_type scan(const key_type& from, size_type max_count,
+                   Functor func) const {
+        value_type buffer[leaf_slotmax];
+
+        size_type count = 0;
+        key_type cursor = from;
+        bool inclusive = true;
+
+        const LeafNode* leaf = nullptr;
+        while (count < max_count)
+        {
+            uint64_t v;
+            if (!leaf) {
+                leaf = descend(cursor, &v);
+                if (!leaf) continue;
+            }
+            else {
+                v = leaf->read_lock();
+            }
+
+            unsigned short slotuse = clamp(leaf->slotuse, leaf_slotmax);
+            unsigned short slot = inclusive
+                                  ? find_lower(leaf, slotuse, cursor)
+                                  : find_upper(leaf, slotuse, cursor);
+
+            size_type num = 0;
+            for ( ; slot < slotuse && num < max_count - count; ++slot, ++num)
+            {
+                buffer[num].first = leaf->slotkey[slot];
+                buffer[num].second = leaf->slotdata[slot];
+            }
+            const LeafNode* next = leaf->next_leaf;
+
+            if (!leaf->check(v)) {
+                // restart descent at the current cursor
+                leaf = nullptr;
+                continue;
+            }
+
+            for (size_type i = 0; i < num; ++i)
+                func(buffer[i].first, buffer[i].second);
+
+            count += num;
+            if (num != 0) {
+                cursor = buffer[num - 1].first;
+                inclusive = false;
+            }
+
+            if (!next) break;
+            leaf = next;
+        }
+
+        return count;
+    }
+
+    //! \}
+
+    //! \name Modifying Functions
+    //! \{
+
+    //! Attempt to insert a key/data pair into the B+ tree. Returns false if
+    //! the key already exists.
+    bool insert(const key_type& key, const data_type& data) {
+        for ( ; ; ) {
+            int r = try_insert(key, data);
+            if (r >= 0) return (r != 0);
+        }
+    }
+
+    //! Attempt to insert a key/data pair into the B+ tree. Returns false if
+    //! the key already exists.
+    bool insert(const value_type& x) {
+        return insert(x.first, x.second);
+    }
+
+    //! Erases the key/data pair associated with key. Returns true if the key
+    //! was found.
+    bool erase(const key_type& key) {
+        for ( ; ; ) {
+            uint64_t v;
+            LeafNode* leaf = const_cast<LeafNode*>(descend(key, &v));
+            if (!leaf) continue;
+            if (!leaf->upgrade(v)) continue;
+
+            unsigned short slotuse = leaf->used();
+            unsigned short slot = find_lower(leaf, slotuse, key);
+
+            if (slot >= slotuse || !key_equal(key, leaf->slotkey[slot])) {
+                leaf->write_unlock();
+                return false;
+            }
+
+            std::copy(leaf->slotkey + slot + 1, leaf->slotkey + slotuse,
+                      leaf->slotkey + slot);
+            std::copy(leaf->slotdata + slot + 1, leaf->slotdata + slotuse,
+                      leaf->slotdata + slot);
+            leaf->slotuse.store(slotuse - 1, std::memory_order_relaxed);
+
+            leaf->write_unlock();
+            size_.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    //! \}
+
+private:
+    //! \name Key Comparison and Node Search
+    //! \{
+
+    //! True if a == b ? constructed from key_less_().
+    bool key_equal(const key_type& a, const key_type& b) const {
+        return !key_less_(a, b) && !key_less_(b, a);
+    }
+
+    //! Load a slotuse counter and clamp it to the node's capacity, since an
+    //! optimistic reader may see an intermediate value.
+    static unsigned short clamp(const std::atomic<unsigned short>& slotuse,
+                                unsigned short max) {
+        return std::min(slotuse.load(std::memory_order_relaxed), max);
+    }
+
+    //! Searches for the first key in [0,slotuse) of node n greater or equal to
+    //! key.
+    template <typename node_type>
+    unsigned short find_lower(const node_type* n, unsigned short slotuse,
+                              const key_type& key) const {
+        return find_lower(n, slotuse, key,
+                          std::integral_constant<bool, simd_search>());
+    }
+
+    template <typename node_type>
+    unsigned short find_lower(const node_type* n, unsigned short slotuse,
+                              const key_type& key, std::true_type) const {
+        return static_cast<unsigned short>(
+            btree_simd::find_lower(n->slotkey, slotuse, key));
+    }
+
+    template <typename node_type>
+    unsigned short find_lower(const node_type* n, unsigned short slotuse,
+                              const key_type& key, std::false_type) const {
+        return static_cast<unsigned short>(
+            std::lower_bound(n->slotkey, n->slotkey + slotuse, key,
+                             key_less_) - n->slotkey);
+    }
+
+    //! Searches for the first key in [0,slotuse) of node n greater than key.
+    template <typename node_type>
+    unsigned short find_upper(const node_type* n, unsigned short slotuse,
+                              const key_type& key) const {
+        return find_upper(n, slotuse, key,
+                          std::integral_constant<bool, simd_search>());
+    }
+
+    template <typename node_type>
+    unsigned short find_upper(const node_type* n, unsigned short slotuse,
+                              const key_type& key, std::true_type) const {
+        return static_cast<unsigned short>(
+            btree_simd::find_upper(n->slotkey, slotuse, key));
+    }
+
+    template <typename node_type>
+    unsigned short find_upper(const node_type* n, unsigned short slotuse,
+                              const key_type& key, std::false_type) const {
+        return static_cast<unsigned short>(
+            std::upper_bound(n->slotkey, n->slotkey + slotuse, key,
+                             key_less_) - n->slotkey);
+    }
+
+    //! \}
+
+    //! \name Optimistic Descent, Insertion and Splitting
+    //! \{
+
+    //! Optimistically descend to the leaf responsible for key. Returns the
+    //! leaf and its read version, or nullptr if the operation must restart.
+    const LeafNode * descend(const key_type& key, uint64_t* out_v) const {
+        const node* n = root_.load(std::memory_order_acquire);
+        uint64_t v = n->read_lock();
+        if (n != root_.load(std::memory_order_acquire)) return nullptr;
+
+        while (!n->is_leafnode())
+        {
+            const InnerNode* inner = static_cast<const InnerNode*>(n);
+            unsigned short slotuse = clamp(inner->slotuse, inner_slotmax);
+            const node* child = inner->childid[find_lower(inner, slotuse, key)];
+
+            // validate child pointer before dereferencing it
+            if (!inner->check(v)) return nullptr;
+
+            uint64_t cv = child->read_lock();
+            if (!inner->check(v)) return nullptr;
+
+            n = child, v = cv;
+        }
+
+        *out_v = v;
+        return static_cast<const LeafNode*>(n);
+    }
+
+    //! Single optimistic insertion attempt. Returns 1 if inserted, 0 if the
+    //! key exists, and -1 if the operation must restart.
+    int try_insert(const key_type& key, const data_type& data) {
+        node* n = root_.load(std::memory_order_acquire);
+        uint64_t v = n->read_lock();
+        if (n != root_.load(std::memory_order_acquire)) return -1;
+
+        InnerNode* parent = nullptr;
+        uint64_t pv = 0;
+
+        while (!n->is_leafnode())
+        {
+            InnerNode* inner = static_cast<InnerNode*>(n);
+
+            if (inner->is_full()) {
+                // split full inner nodes eagerly, then restart.
+                split_locked(inner, v, parent, pv);
+                return -1;
+            }
+
+            if (parent && !parent->check(pv)) return -1;
+
+            unsigned short slotuse = clamp(inner->slotuse, inner_slotmax);
+            node* child = inner->childid[find_lower(inner, slotuse, key)];
+            if (!inner->check(v)) return -1;
+
+            uint64_t cv = child->read_lock();
+
+            parent = inner, pv = v;
+            n = child, v = cv;
+        }
+
+        LeafNode* leaf = static_cast<LeafNode*>(n);
+
+        if (leaf->is_full()) {
+            split_locked(leaf, v, parent, pv);
+            return -1;
+        }
+
+        if (!leaf->upgrade(v)) return -1;
+
+        if (parent && !parent->check(pv)) {
+            leaf->write_unlock();
+            return -1;
+        }
+
+        unsigned short slotuse = leaf->used();
+        unsigned short slot = find_lower(leaf, slotuse, key);
+
+        if (slot < slotuse && key_equal(key, leaf->slotkey[slot])) {
+            leaf->write_unlock();
+            return 0;
+        }
+
+        std::copy_backward(leaf->slotkey + slot, leaf->slotkey + slotuse,
+                           leaf->slotkey + slotuse + 1);
+        std::copy_backward(leaf->slotdata + slot, leaf->slotdata + slotuse,
+                           leaf->slotdata + slotuse + 1);
+
+        leaf->slotkey[slot] = key;
+        leaf->slotdata[slot] = data;
+        leaf->slotuse.store(slotuse + 1, std::memory_order_relaxed);
+
+        leaf->write_unlock();
+        size_.fetch_add(1, std::memory_order_relaxed);
+        return 1;
+    }
+
+    //! Lock the full node n and its parent (or check that n is the root) and
+    //! split n. If any version check fails, nothing is changed and the caller
+    //! restarts anyway.
+    void split_locked(node* n, uint64_t v, InnerNode* parent, uint64_t pv) {
+        if (parent && !parent->upgrade(pv)) return;
+
+        if (!n->upgrade(v)) {
+            if (parent) parent->write_unlock();
+            return;
+        }
+
+        if (!parent && n != root_.load(std::memory_order_relaxed)) {
+            n->write_unlock();
+            return;
+        }
+
+        key_type splitkey;
+        node* right;
+        if (n->is_leafnode())
+            right = split_leaf_node(static_cast<LeafNode*>(n), &splitkey);
+        else
+            right = split_inner_node(static_cast<InnerNode*>(n), &splitkey);
+
+        if (parent) {
+            // parent is not full, since full inner nodes are split on descent
+            unsigned short slotuse = parent->used();
+            unsigned short slot = find_lower(parent, slotuse, splitkey);
+
+            std::copy_backward(
+                parent->slotkey + slot, parent->slotkey + slotuse,
+                parent->slotkey + slotuse + 1);
+            std::copy_backward(
+                parent->childid + slot + 1, parent->childid + slotuse + 1,
+                parent->childid + slotuse + 2);
+
+            parent->slotkey[slot] = splitkey;
+            parent->childid[slot + 1] = right;
+            parent->slotuse.store(slotuse + 1, std::memory_order_relaxed);
+        }
+        else {
+            InnerNode* newroot = new InnerNode(n->level + 1);
+            newroot->slotkey[0] = splitkey;
+            newroot->childid[0] = n;
+            newroot->childid[1] = right;
+            newroot->slotuse.store(1, std::memory_order_relaxed);
+            root_.store(newroot, std::memory_order_release);
+        }
+
+        n->write_unlock();
+        if (parent) parent->write_unlock();
+    }
+
+    //! Split up a locked leaf into two equally-filled sibling leaves. Returns
+    //! the new right leaf and the max key of the left one.
+    LeafNode * split_leaf_node(LeafNode* leaf, key_type* out_splitkey) {
+        unsigned short slotuse = leaf->used();
+        unsigned short mid = slotuse >> 1;
+
+        LeafNode* newleaf = new LeafNode();
+        std::copy(leaf->slotkey + mid, leaf->slotkey + slotuse,
+                  newleaf->slotkey);
+        std::copy(leaf->slotdata + mid, leaf->slotdata + slotuse,
+                  newleaf->slotdata);
+        newleaf->slotuse.store(slotuse - mid, std::memory_order_relaxed);
+        newleaf->next_leaf = leaf->next_leaf;
+
+        leaf->slotuse.store(mid, std::memory_order_relaxed);
+        leaf->next_leaf = newleaf;
+
+        *out_splitkey = leaf->slotkey[mid - 1];
+        return newleaf;
+    }
+
+    //! Split up a locked inner node into two sibling nodes. Returns the new
+    //! right node and the key separating them.
+    InnerNode * split_inner_node(InnerNode* inner, key_type* out_splitkey) {
+        unsigned short slotuse = inner->used();
+        unsigned short mid = slotuse >> 1;
+
+        InnerNode* newinner = new InnerNode(inner->level);
+        std::copy(inner->slotkey + mid + 1, inner->slotkey + slotuse,
+                  newinner->slotkey);
+        std::copy(inner->childid + mid + 1, inner->childid + slotuse + 1,
+                  newinner->childid);
+        newinner->slotuse.store(slotuse - (mid + 1), std::memory_order_relaxed);
+
+        inner->slotuse.store(mid, std::memory_order_relaxed);
+
+        *out_splitkey = inner->slotkey[mid];
+        return newinner;
+    }
+
+    //! Recursively free up nodes.
+    static void free_recursive(node* n) {
+        if (!n->is_leafnode()) {
+            InnerNode* inner = static_cast<InnerNode*>(n);
+            for (unsigned short slot = 0; slot <= inner->used(); ++slot)
+                free_recursive(inner->childid[slot]);
+            delete inner;
+        }
+        else {
+            delete static_cast<LeafNode*>(n);
+        }
+    }
+
+    //! \}
+
+public:
+    //! \name Verification of B+ Tree Invariants
+    //! \{
+
+    //! Run a thorough verification of all B+ tree invariants. Not thread-safe.
+    //! The program aborts via tlx_die_unless() if something is wrong.
+    void verify() const {
+        size_type items = 0;
+        const LeafNode* first = nullptr;
+        verify_node(root_.load(), nullptr, nullptr, &items, &first);
+        tlx_die_unless(items == size());
+
+        // verify the leaf chain
+        size_type chain = 0;
+        for (const LeafNode* leaf = first; leaf; leaf = leaf->next_leaf)
+        {
+            for (unsigned short s = 0; s < leaf->used(); ++s, ++chain) {
+                if (s != 0)
+                    tlx_die_unless(
+                        key_less_(leaf->slotkey[s - 1], leaf->slotkey[s]));
+            }
+        }
+        tlx_die_unless(chain == items);
+    }
+
+private:
+    //! Recursively verify a node: all keys must lie in (minkey, maxkey].
+    void verify_node(const node* n, const key_type* minkey,
+                     const key_type* maxkey, size_type* items,
+                     const LeafNode** first) const {
+        tlx_die_unless((n->version.load() & 1) == 0);
+
+        if (n->is_leafnode())
+        {
+            const LeafNode* leaf = static_cast<const LeafNode*>(n);
+            if (!*first) *first = leaf;
+
+            for (unsigned short s = 0; s < leaf->used(); ++s)
+            {
+                if (minkey)
+                    tlx_die_unless(key_less_(*minkey, leaf->slotkey[s]));
+                if (maxkey)
+                    tlx_die_unless(!key_less_(*maxkey, leaf->slotkey[s]));
+            }
+            *items += leaf->used();
+        }
+        else
+        {
+            const InnerNode* inner = static_cast<const InnerNode*>(n);
+            tlx_die_unless(inner->used() > 0);
+
+            for (unsigned short s = 0; s <= inner->used(); ++s)
+            {
+                tlx_die_unless(inner->childid[s]->level + 1 == inner->level);
+                verify_node(inner->childid[s],
+                            s == 0 ? minkey : &inner->slotkey[s - 1],
+                            s == inner->used() ? maxkey : &inner->slotkey[s],
+                            items, first);
+            }
+        }
+    }
+
+    //! \}
+};
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_CONTAINER_CONCURRENT_BTREE_MAP_HEADER
+
+/******************************************************************************/
@@ -12,8 +12,13 @@
 #ifndef TLX_CONTAINER_D_ARY_ADDRESSABLE_INT_HEAP_HEADER
 #define TLX_CONTAINER_D_ARY_ADDRESSABLE_INT_HEAP_HEADER
 
+#include <tlx/math/integer_log2.hpp>
+#include <tlx/math/round_to_power_of_two.hpp>
+
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <limits>
 #include <queue>
@@ -24,20 +29,206 @@ namespace tlx {
 //! \addtogroup tlx_container
 //! \{
 
+/*!
+ * Handle store of DAryAddressableIntHeap which keeps the positions of the keys
+ * in an array indexed by the keys, hence it requires a multiple of the highest
+ * integer key as space.
+ */
+template <typename KeyType>
+class DAryHeapDenseHandles
+{
+public:
+    using key_type = KeyType;
+
+    //! Marks a key that is not in the heap.
+    static constexpr key_type not_present() {
+        return static_cast<key_type>(-1);
+    }
+
+    //! Allocates handles for the keys [0, n).
+    void reserve(size_t n) {
+        if (pos_.size() < n)
+            pos_.resize(n, not_present());
+    }
+
+    //! Returns true if the key \c key has a position.
+    bool contains(key_type key) const {
+        return key < pos_.size() ? pos_[key] != not_present() : false;
+    }
+
+    //! Returns the position of the key \c key, which must be contained.
+    key_type get(key_type key) const {
+        assert(contains(key));
+        return pos_[key];
+    }
+
+    //! Sets the position of the key \c key, which may be a new key.
+    void set(key_type key, key_type pos) {
+        if (key >= pos_.size())
+            pos_.resize(static_cast<size_t>(key) + 1, not_present());
+        pos_[key] = pos;
+    }
+
+    //! Removes the key \c key, which must be contained.
+    void erase(key_type key) {
+        assert(contains(key));
+        pos_[key] = not_present();
+    }
+
+    //! Returns the number of contained keys, in time linear in the highest key.
+    size_t size() const {
+        return pos_.size() - static_cast<size_t>(
+            std::count(pos_.begin(), pos_.end(), not_present()));
+    }
+
+private:
+    //! Positions of the keys in the heap vector.
+    std::vector<key_type> pos_;
+};
+
+/*!
+ * Handle store of DAryAddressableIntHeap which keeps the positions of the keys
+ * in an open addressing hash table with linear probing, hence it requires
+ * space proportional to the number of items and supports sparse keys such as
+ * 64-bit identifiers. Removal shifts back the following entries of the probe
+ * sequence instead of leaving tombstones, hence all operations take expected
+ * constant time regardless of the history of the table.
+ */
+template <typename KeyType>
+class DAryHeapHashHandles
+{
+public:
+    using key_type = KeyType;
+
+    //! Marks an empty slot, this key cannot be stored in the heap.
+    static constexpr key_type not_present() {
+        return static_cast<key_type>(-1);
+    }
+
+    //! Allocates slots for n keys.
+    void reserve(size_t n) {
+        if (2 * n > slots_.size())
+            rehash(2 * n);
+    }
+
+    //! Returns true if the key \c key has a position.
+    bool contains(key_type key) const {
+        return !slots_.empty() && slots_[find(key)].key == key;
+    }
+
+    //! Returns the position of the key \c key, which must be contained.
+    key_type get(key_type key) const {
+        assert(contains(key));
+        return slots_[find(key)].pos;
+    }
+
+    //! Sets the position of the key \c key, which may be a new key.
+    void set(key_type key, key_type pos) {
+        assert(key != not_present());
+        if (slots_.empty())
+            rehash(min_slots);
+        size_t i = find(key);
+        if (slots_[i].key != key) {
+            // keep the load factor at most 1/2
+            if (2 * (size_ + 1) > slots_.size()) {
+                rehash(2 * slots_.size());
+                i = find(key);
+            }
+            slots_[i].key = key;
+            ++size_;
+        }
+        slots_[i].pos = pos;
+    }
+
+    //! Removes the key \c key, which must be contained.
+    void erase(key_type key) {
+        assert(contains(key));
+        size_t i = find(key);
+        // shift back following entries whose home slot is not in (i,j]
+        for (size_t j = (i + 1) & mask_; slots_[j].key != not_present();
+             j = (j + 1) & mask_) {
+            size_t h = home(slots_[j].key);
+            if (i <= j ? (i < h && h <= j) : (i < h || h <= j))
+                continue;
+            slots_[i] = slots_[j];
+            i = j;
+        }
+        slots_[i].key = not_present();
+        --size_;
+    }
+
+    //! Returns the number of contained keys.
+    size_t size() const { return size_; }
+
+private:
+    //! A slot of the table, empty if key == not_present().
+    struct Slot {
+        key_type key;
+        key_type pos;
+    };
+
+    //! Minimum number of slots of a non-empty table.
+    static constexpr size_t min_slots = 16;
+
+    //! Slots of the table, the number is a power of two.
+    std::vector<Slot> slots_;
+
+    //! Number of slots minus one.
+    size_t mask_ = 0;
+
+    //! Shift of the hash product, 64 minus the logarithm of the slots.
+    unsigned shift_ = 64;
+
+    //! Number of contained keys.
+    size_t size_ = 0;
+
+    //! Returns the home slot of a key by Fibonacci hashing.
+    size_t home(key_type key) const {
+        return static_cast<size_t>(
+            (static_cast<uint64_t>(key) * UINT64_C(0x9E3779B97F4A7C15)) >>
+            shift_);
+    }
+
+    //! Returns the slot of the key \c key, or the empty slot where it belongs.
+    size_t find(key_type key) const {
+        size_t i = home(key);
+        while (slots_[i].key != key && slots_[i].key != not_present())
+            i = (i + 1) & mask_;
+        return i;
+    }
+
+    //! Reinserts all keys into a table of at least n slots.
+    void rehash(size_t n) {
+        size_t slots = round_up_to_power_of_two(n < min_slots ? min_slots : n);
+        shift_ = 64 - integer_log2_floor(slots);
+        std::vector<Slot> old(slots, Slot { not_present(), 0 });
+        old.swap(slots_);
+        mask_ = slots - 1;
+        for (const Slot& s : old) {
+            if (s.key != not_present())
+                slots_[find(s.key)] = s;
+        }
+    }
+};
+
 /*!
  * This class implements an addressable integer priority queue, precisely a
  * d-ary heap.
  *
- * Keys must be unique unsigned integers. The addressable heap holds an array
+ * Keys must be unique unsigned integers. The positions of the keys in the heap
+ * are kept in a handle store. The default DAryHeapDenseHandles holds an array
  * indexed by the keys, hence it requires a multiple of the highest integer key
- * as space!
+ * as space! For sparse keys use DAryHeapHashHandles, which requires space
+ * proportional to the number of items.
  *
  * \tparam KeyType    Has to be an unsigned integer type.
  * \tparam Arity      A positive integer.
  * \tparam Compare    Function object.
+ * \tparam Handles    Handle store mapping keys to positions.
  */
 template <typename KeyType, unsigned Arity = 2,
-          class Compare = std::less<KeyType> >
+          class Compare = std::less<KeyType>,
+          class Handles = DAryHeapDenseHandles<KeyType> >
 class DAryAddressableIntHeap
 {
     static_assert(std::numeric_limits<KeyType>::is_integer &&
@@ -48,6 +239,7 @@ class DAryAddressableIntHeap
 public:
     using key_type = KeyType;
     using compare_type = Compare;
+    using handles_type = Handles;
 
     static constexpr size_t arity = Arity;
 
@@ -56,7 +248,7 @@ protected:
     std::vector<key_type> heap_;
 
     //! Positions of the keys in the heap vector.
-    std::vector<key_type> handles_;
+    handles_type handles_;
 
     //! Compare function.
     compare_type cmp_;
@@ -69,14 +261,12 @@ protected:
 public:
     //! Allocates an empty heap.
     explicit DAryAddressableIntHeap(compare_type cmp = compare_type())
-        : heap_(0), handles_(0), cmp_(cmp) { }
+        : heap_(0), cmp_(cmp) { }
 
     //! Allocates space for \c new_size items.
     void reserve(size_t new_size) {
-        if (handles_.size() < new_size) {
-            handles_.resize(new_size, not_present());
-            heap_.reserve(new_size);
-        }
+        handles_.reserve(new_size);
+        heap_.reserve(new_size);
     }
 
     //! Copy.
@@ -89,7 +279,8 @@ public:
 
     //! Empties the heap.
     void clear() {
-        std::fill(handles_.begin(), handles_.end(), not_present());
+        for (const key_type& key : heap_)
+            handles_.erase(key);
         heap_.clear();
     }
 
@@ -106,15 +297,10 @@ public:
     void push(const key_type& new_key) {
         // Avoid to add the key that we use to mark non present keys.
         assert(new_key != not_present());
-        if (new_key >= handles_.size()) {
-            handles_.resize(new_key + 1, not_present());
-        }
-        else {
-            assert(handles_[new_key] == not_present());
-        }
+        assert(!handles_.contains(new_key));
 
         // Insert the new item at the end of the heap.
-        handles_[new_key] = static_cast<key_type>(heap_.size());
+        handles_.set(new_key, static_cast<key_type>(heap_.size()));
         heap_.push_back(new_key);
         sift_up(heap_.size() - 1);
     }
@@ -123,26 +309,44 @@ public:
     void push(key_type&& new_key) {
         // Avoid to add the key that we use to mark non present keys.
         assert(new_key != not_present());
-        if (new_key >= handles_.size()) {
-            handles_.resize(new_key + 1, not_present());
-        }
-        else {
-            assert(handles_[new_key] == not_present());
-        }
+        assert(!handles_.contains(new_key));
 
         // Insert the new item at the end of the heap.
-        handles_[new_key] = static_cast<key_type>(heap_.size());
+        handles_.set(new_key, static_cast<key_type>(heap_.size()));
         heap_.push_back(std::move(new_key));
         sift_up(heap_.size() - 1);
     }
 
+    /*!
+     * Inserts the items of [first, last) and sets their handles. If many items
+     * are inserted compared to the size of the heap, the heap property is
+     * restored bottom-up by sifting down the ancestors of the new items, as in
+     * Floyd's heapify, which takes O(n) time. Otherwise, the new items are
+     * sifted up one by one.
+     */
+    template <class InputIterator>
+    void push_bulk(InputIterator first, InputIterator last) {
+        size_t begin = heap_.size();
+        heap_.insert(heap_.end(), first, last);
+        if (begin == heap_.size())
+            return;
+
+        for (size_t k = begin; k < heap_.size(); ++k) {
+            // Avoid to add the key that we use to mark non present keys.
+            assert(heap_[k] != not_present());
+            assert(!handles_.contains(heap_[k]));
+        }
+
+        restore_bulk(begin);
+    }
+
     //! Removes the item with key \c key.
     void remove(key_type key) {
         assert(contains(key));
-        key_type h = handles_[key];
+        key_type h = handles_.get(key);
         std::swap(heap_[h], heap_.back());
-        handles_[heap_[h]] = h;
-        handles_[heap_.back()] = not_present();
+        handles_.set(heap_[h], h);
+        handles_.erase(heap_.back());
         heap_.pop_back();
         // If we did not remove the last item in the heap vector.
         if (h < size()) {
@@ -174,6 +378,7 @@ public:
     //! Rebuilds the heap.
     void update_all() {
         heapify();
+        index_all();
     }
 
     /*!
@@ -185,43 +390,48 @@ public:
      * structure is undefined.
      */
     void update(key_type key) {
-        if (key >= handles_.size() || handles_[key] == not_present()) {
+        if (!handles_.contains(key)) {
             push(key);
+            return;
         }
-        else if (handles_[key] &&
-                 cmp_(heap_[handles_[key]], heap_[parent(handles_[key])])) {
-            sift_up(handles_[key]);
+        size_t h = handles_.get(key);
+        if (h && cmp_(heap_[h], heap_[parent(h)])) {
+            sift_up(h);
         }
         else {
-            sift_down(handles_[key]);
+            sift_down(h);
         }
     }
 
     //! Returns true if the key \c key is in the heap, false otherwise.
     bool contains(key_type key) const {
-        return key < handles_.size() ? handles_[key] != not_present() : false;
+        return handles_.contains(key);
     }
 
     //! Builds a heap from a container.
     template <class InputIterator>
     void build_heap(InputIterator first, InputIterator last) {
+        clear();
         heap_.assign(first, last);
         heapify();
+        index_all();
     }
 
     //! Builds a heap from the vector \c keys. Items of \c keys are copied.
     void build_heap(const std::vector<key_type>& keys) {
+        clear();
         heap_.resize(keys.size());
         std::copy(keys.begin(), keys.end(), heap_.begin());
         heapify();
+        index_all();
     }
 
     //! Builds a heap from the vector \c keys. Items of \c keys are moved.
     void build_heap(std::vector<key_type>&& keys) {
-        if (!empty())
-            heap_.clear();
+        clear();
         heap_ = std::move(keys);
         heapify();
+        index_all();
     }
 
     //! For debugging: runs a BFS from the root node and verifies that the heap
@@ -230,12 +440,11 @@ public:
         if (empty()) {
             return true;
         }
-        std::vector<unsigned char> mark(handles_.size());
         std::queue<size_t> q;
         // Explore from the root.
         q.push(0);
-        // mark first value as seen
-        mark.at(heap_[0]) = 1;
+        if (!handles_.contains(heap_[0]) || handles_.get(heap_[0]) != 0)
+            return false;
         while (!q.empty()) {
             size_t s = q.front();
             q.pop();
@@ -246,19 +455,13 @@ public:
                 if (cmp_(heap_[l], heap_[s]))
                     return false;
                 // check handle
-                if (handles_[heap_[l]] != l)
+                if (!handles_.contains(heap_[l]) || handles_.get(heap_[l]) != l)
                     return false;
-                // mark value as seen
-                mark.at(heap_[l]) = 1;
                 q.push(l++);
             }
         }
-        // check not_present handles
-        for (size_t i = 0; i < mark.size(); ++i) {
-            if (mark[i] != (handles_[i] != not_present()))
-                return false;
-        }
-        return true;
+        // check that there are no other handles
+        return handles_.size() == heap_.size();
     }
 
 private:
@@ -275,10 +478,10 @@ private:
         size_t p = parent(k);
         while (k > 0 && !cmp_(heap_[p], value)) {
             heap_[k] = std::move(heap_[p]);
-            handles_[heap_[k]] = k;
+            handles_.set(heap_[k], static_cast<key_type>(k));
             k = p, p = parent(k);
         }
-        handles_[value] = k;
+        handles_.set(value, static_cast<key_type>(k));
         heap_[k] = std::move(value);
     }
 
@@ -308,61 +511,87 @@ private:
 
             // Swap current item with the child with minimum priority.
             heap_[k] = std::move(heap_[c]);
-            handles_[heap_[k]] = k;
+            handles_.set(heap_[k], static_cast<key_type>(k));
+            k = c;
+        }
+        handles_.set(value, static_cast<key_type>(k));
+        heap_[k] = std::move(value);
+    }
+
+    //! Pushes the item at position \c k down like sift_down() but without
+    //! updating the handles, which are set afterwards for the whole heap.
+    void sift_down_unindexed(size_t k) {
+        key_type value = std::move(heap_[k]);
+        while (true) {
+            size_t l = left(k);
+            if (l >= heap_.size()) {
+                break;
+            }
+            // Get the min child.
+            size_t c = l;
+            size_t right = std::min(heap_.size(), c + arity);
+            while (++l < right) {
+                if (cmp_(heap_[l], heap_[c])) {
+                    c = l;
+                }
+            }
+
+            if (!cmp_(heap_[c], value)) {
+                break;
+            }
+            heap_[k] = std::move(heap_[c]);
             k = c;
         }
-        handles_[value] = k;
         heap_[k] = std::move(value);
     }
 
-    //! Reorganize heap_ into a heap.
+    //! Sets the handles of all items in the heap.
+    void index_all() {
+        for (size_t i = 0; i < heap_.size(); ++i)
+            handles_.set(heap_[i], static_cast<key_type>(i));
+    }
+
+    //! Restores the heap property after the items at [begin, size()) were
+    //! appended to a heap of begin items, and sets their handles.
+    void restore_bulk(size_t begin) {
+        size_t end = heap_.size();
+        if (begin == end)
+            return;
+        if ((end - begin) * arity < begin) {
+            for (size_t k = begin; k < end; ++k)
+                sift_up(k);
+            return;
+        }
+        // The ancestors of the new items on each level form a range [lo,hi],
+        // and the ranges of higher levels are at lower positions, hence they
+        // are sifted down in descending order, skipping those already done.
+        size_t lo = begin, hi = end - 1, limit = end;
+        while (hi > 0) {
+            lo = lo ? parent(lo) : 0;
+            hi = parent(hi);
+            for (size_t k = std::min(hi + 1, limit); k > lo; --k)
+                sift_down_unindexed(k - 1);
+            limit = lo;
+        }
+        index_all();
+    }
+
+    //! Reorganize heap_ into a heap, without setting the handles.
     void heapify() {
-        key_type max_key = heap_.empty() ? 0 : heap_.front();
         if (heap_.size() >= 2) {
             // Iterate from the last internal node up to the root.
-            size_t last_internal = (heap_.size() - 2) / arity;
-            for (size_t i = last_internal + 1; i; --i) {
-                // Index of the current internal node.
-                size_t cur = i - 1;
-                key_type value = std::move(heap_[cur]);
-                max_key = std::max(max_key, value);
-
-                do {
-                    size_t l = left(cur);
-                    max_key = std::max(max_key, heap_[l]);
-                    // Find the minimum child of cur.
-                    size_t min_elem = l;
-                    for (size_t j = l + 1;
-                         j - l < arity && j < heap_.size(); ++j) {
-                        if (cmp_(heap_[j], heap_[min_elem]))
-                            min_elem = j;
-                        max_key = std::max(max_key, heap_[j]);
-                    }
-
-                    // One of the children of cur is less then cur: swap and
-                    // do another iteration.
-                    if (cmp_(heap_[min_elem], value)) {
-                        heap_[cur] = std::move(heap_[min_elem]);
-                        cur = min_elem;
-                    }
-                    else
-                        break;
-                } while (cur <= last_internal);
-                heap_[cur] = std::move(value);
-            }
+            for (size_t i = (heap_.size() - 2) / arity + 1; i; --i)
+                sift_down_unindexed(i - 1);
         }
-        // initialize handles_ vector
-        handles_.resize(std::max(handles_.size(), static_cast<size_t>(max_key) + 1), not_present());
-        for (size_t i = 0; i < heap_.size(); ++i)
-            handles_[heap_[i]] = i;
     }
 };
 
 //! make template alias due to similarity with std::priority_queue
 template <typename KeyType, unsigned Arity = 2,
-          typename Compare = std::less<KeyType> >
+          typename Compare = std::less<KeyType>,
+          typename Handles = DAryHeapDenseHandles<KeyType> >
 using d_ary_addressable_int_heap =
-    DAryAddressableIntHeap<KeyType, Arity, Compare>;
+    DAryAddressableIntHeap<KeyType, Arity, Compare, Handles>;
 
 //! \}
 
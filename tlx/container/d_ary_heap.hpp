@@ -12,11 +12,16 @@
 #ifndef TLX_CONTAINER_D_ARY_HEAP_HEADER
 #define TLX_CONTAINER_D_ARY_HEAP_HEADER
 
+#include <tlx/container/d_ary_heap_simd.hpp>
+
 #include <cassert>
 #include <cstddef>
 #include <functional>
+#include <iterator>
 #include <limits>
+#include <memory>
 #include <queue>
+#include <type_traits>
 #include <vector>
 
 namespace tlx {
@@ -28,15 +33,26 @@ namespace tlx {
  * This class implements a d-ary comparison-based heap usable as a priority
  * queue. Higher arity yields better cache efficiency.
  *
+ * With Simd, the child with minimum priority is selected by vector comparisons
+ * of all children at once, and the cells are allocated such that each group of
+ * children starts on a cache line. This pays off for arities of 4 and more,
+ * and requires 32- or 64-bit integer or floating point keys ordered by
+ * std::less or std::greater, see d_ary_heap_simd::is_supported.
+ *
  * \tparam KeyType    Key type.
  * \tparam Arity      A positive integer.
  * \tparam Compare    Function object to order keys.
+ * \tparam Simd       Select children with SIMD kernels.
  */
 template <typename KeyType, unsigned Arity = 2,
-          typename Compare = std::less<KeyType> >
+          typename Compare = std::less<KeyType>, bool Simd = false>
 class DAryHeap
 {
     static_assert(Arity, "Arity must be greater than zero.");
+    static_assert(!Simd ||
+                  d_ary_heap_simd::is_supported<KeyType, Compare>::value,
+                  "Simd requires integer or floating point keys ordered by "
+                  "std::less or std::greater.");
 
 public:
     using key_type = KeyType;
@@ -44,9 +60,17 @@ public:
 
     static constexpr size_t arity = Arity;
 
+    //! True if children are selected with SIMD kernels.
+    static constexpr bool simd = Simd;
+
+    //! Allocator of the cells, which aligns the groups of children if Simd.
+    using allocator_type = typename std::conditional<
+        Simd, d_ary_heap_simd::ChildAlignedAllocator<key_type>,
+        std::allocator<key_type> >::type;
+
 protected:
     //! Cells in the heap.
-    std::vector<key_type> heap_;
+    std::vector<key_type, allocator_type> heap_;
 
     //! Compare function.
     compare_type cmp_;
@@ -97,6 +121,19 @@ public:
         sift_up(heap_.size() - 1);
     }
 
+    /*!
+     * Inserts the items of [first, last). If many items are inserted compared
+     * to the size of the heap, the heap property is restored bottom-up by
+     * sifting down the ancestors of the new items, as in Floyd's heapify, which
+     * takes O(n) time. Otherwise, the new items are sifted up one by one.
+     */
+    template <class InputIterator>
+    void push_bulk(InputIterator first, InputIterator last) {
+        size_t begin = heap_.size();
+        heap_.insert(heap_.end(), first, last);
+        restore_bulk(begin);
+    }
+
     //! Returns the top item.
     const key_type& top() const noexcept {
         assert(!empty());
@@ -119,6 +156,15 @@ public:
         return top_item;
     }
 
+    //! Moves all items to the end of \c out in heap order, which is not
+    //! sorted, and empties the heap. Takes O(n) time.
+    template <typename Alloc>
+    void extract_all(std::vector<key_type, Alloc>& out) {
+        out.insert(out.end(), std::make_move_iterator(heap_.begin()),
+                   std::make_move_iterator(heap_.end()));
+        heap_.clear();
+    }
+
     //! Rebuilds the heap.
     void update_all() {
         heapify();
@@ -142,7 +188,7 @@ public:
     void build_heap(std::vector<key_type>&& keys) {
         if (!empty())
             heap_.clear();
-        heap_ = std::move(keys);
+        take_keys(std::move(keys), std::integral_constant<bool, Simd>());
         heapify();
     }
 
@@ -177,6 +223,42 @@ private:
     //! Returns the position of the parent of the node at position \c k.
     size_t parent(size_t k) const { return (k - 1) / arity; }
 
+    //! Returns the position of the child with minimum priority among the
+    //! children [l, right) of a node.
+    size_t min_child(size_t l, size_t right) const {
+        return min_child(l, right, std::integral_constant<bool, Simd>());
+    }
+
+    size_t min_child(size_t l, size_t right, std::false_type) const {
+        size_t c = l;
+        while (++l < right) {
+            if (cmp_(heap_[l], heap_[c])) {
+                c = l;
+            }
+        }
+        return c;
+    }
+
+    //! SIMD version, a template such that it is only instantiated if used.
+    template <typename Key = key_type>
+    size_t min_child(size_t l, size_t right, std::true_type) const {
+        return l + d_ary_heap_simd::select_child<
+            std::is_same<compare_type, std::greater<key_type> >::value, Key>(
+            heap_.data() + l, right - l);
+    }
+
+    //! Takes over the items of \c keys, which are copied if the cells use a
+    //! different allocator.
+    template <typename Keys>
+    void take_keys(Keys&& keys, std::false_type) {
+        heap_ = std::move(keys);
+    }
+
+    template <typename Keys>
+    void take_keys(Keys&& keys, std::true_type) {
+        heap_.assign(keys.begin(), keys.end());
+    }
+
     //! Pushes the node at position \c k up until either it becomes the root or
     //! its parent has lower or equal priority.
     void sift_up(size_t k) {
@@ -199,13 +281,7 @@ private:
                 break;
             }
             // Get the min child.
-            size_t c = l;
-            size_t right = std::min(heap_.size(), c + arity);
-            while (++l < right) {
-                if (cmp_(heap_[l], heap_[c])) {
-                    c = l;
-                }
-            }
+            size_t c = min_child(l, std::min(heap_.size(), l + arity));
 
             // Current item has lower or equal priority than the child with
             // minimum priority, stop.
@@ -220,6 +296,30 @@ private:
         heap_[k] = std::move(value);
     }
 
+    //! Restores the heap property after the items at [begin, size()) were
+    //! appended to a heap of begin items.
+    void restore_bulk(size_t begin) {
+        size_t end = heap_.size();
+        if (begin == end)
+            return;
+        if ((end - begin) * arity < begin) {
+            for (size_t k = begin; k < end; ++k)
+                sift_up(k);
+            return;
+        }
+        // The ancestors of the new items on each level form a range [lo,hi],
+        // and the ranges of higher levels are at lower positions, hence they
+        // are sifted down in descending order, skipping those already done.
+        size_t lo = begin, hi = end - 1, limit = end;
+        while (hi > 0) {
+            lo = lo ? parent(lo) : 0;
+            hi = parent(hi);
+            for (size_t k = std::min(hi + 1, limit); k > lo; --k)
+                sift_down(k - 1);
+            limit = lo;
+        }
+    }
+
     //! Reorganize heap_ into a heap.
     void heapify() {
         if (heap_.size() >= 2) {
@@ -233,12 +333,8 @@ private:
                 do {
                     size_t l = left(cur);
                     // Find the minimum child of cur.
-                    size_t min_elem = l;
-                    for (size_t j = l + 1;
-                         j - l < arity && j < heap_.size(); ++j) {
-                        if (cmp_(heap_[j], heap_[min_elem]))
-                            min_elem = j;
-                    }
+                    size_t min_elem =
+                        min_child(l, std::min(heap_.size(), l + arity));
 
                     // One of the children of cur is less then cur: swap and
                     // do another iteration.
@@ -257,8 +353,8 @@ private:
 
 //! make template alias due to similarity with std::priority_queue
 template <typename KeyType, unsigned Arity = 2,
-          typename Compare = std::less<KeyType> >
-using d_ary_heap = DAryHeap<KeyType, Arity, Compare>;
+          typename Compare = std::less<KeyType>, bool Simd = false>
+using d_ary_heap = DAryHeap<KeyType, Arity, Compare, Simd>;
 
 //! \}
 
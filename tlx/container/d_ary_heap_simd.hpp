@@ -0,0 +1,487 @@
+/*******************************************************************************
+ * tlx/container/d_ary_heap_simd.hpp
+ *
+ * SIMD kernels selecting the minimum or maximum child of a node in a d-ary
+ * heap, and an allocator aligning the groups of children to cache lines. The
+ * instruction set is selected at run-time like in btree_simd.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_CONTAINER_D_ARY_HEAP_SIMD_HEADER
+#define TLX_CONTAINER_D_ARY_HEAP_SIMD_HEADER
+
+#include <tlx/container/btree_simd.hpp>
+#include <tlx/math/ctz.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <type_traits>
+
+namespace tlx {
+
+//! \addtogroup tlx_container
+//! \{
+
+namespace d_ary_heap_simd {
+
+#if TLX_BTREE_HAVE_SIMD
+
+/******************************************************************************/
+// Vector Operations for each Key Type and Instruction Set
+//
+// Each struct provides load(), min() and max() of two vectors, all_min() and
+// all_max() which broadcast the minimum or maximum lane to all lanes, and
+// equal() returning a lane bit mask. Unsigned 64-bit integers are compared by
+// flipping the sign bit, since there are no unsigned 64-bit comparisons.
+
+#define TLX_HEAP_SIMD_AVX2 __attribute__ ((target("avx2")))
+#define TLX_HEAP_SIMD_SSE42 __attribute__ ((target("sse4.2")))
+
+template <typename Key>
+struct Avx2Ops;
+
+//! Broadcast reductions of 32-bit lanes, shared by all 32-bit types.
+template <typename Derived>
+struct Avx2Reduce32 {
+    typedef __m256i vec;
+    static const size_t lanes = 8;
+    static TLX_HEAP_SIMD_AVX2 vec load(const void* p) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+    static TLX_HEAP_SIMD_AVX2 unsigned equal(vec a, vec b) {
+        return static_cast<unsigned>(_mm256_movemask_ps(
+                                         _mm256_castsi256_ps(
+                                             _mm256_cmpeq_epi32(a, b))));
+    }
+    static TLX_HEAP_SIMD_AVX2 vec all_min(vec v) {
+        v = Derived::min(v, _mm256_permute2x128_si256(v, v, 1));
+        v = Derived::min(v, _mm256_shuffle_epi32(v, 0x4E));
+        return Derived::min(v, _mm256_shuffle_epi32(v, 0xB1));
+    }
+    static TLX_HEAP_SIMD_AVX2 vec all_max(vec v) {
+        v = Derived::max(v, _mm256_permute2x128_si256(v, v, 1));
+        v = Derived::max(v, _mm256_shuffle_epi32(v, 0x4E));
+        return Derived::max(v, _mm256_shuffle_epi32(v, 0xB1));
+    }
+};
+
+template <>
+struct Avx2Ops<int32_t> : public Avx2Reduce32<Avx2Ops<int32_t> >{
+    static TLX_HEAP_SIMD_AVX2 vec min(vec a, vec b) {
+        return _mm256_min_epi32(a, b);
+    }
+    static TLX_HEAP_SIMD_AVX2 vec max(vec a, vec b) {
+        return _mm256_max_epi32(a, b);
+    }
+};
+
+template <>
+struct Avx2Ops<uint32_t> : public Avx2Reduce32<Avx2Ops<uint32_t> >{
+    static TLX_HEAP_SIMD_AVX2 vec min(vec a, vec b) {
+        return _mm256_min_epu32(a, b);
+    }
+    static TLX_HEAP_SIMD_AVX2 vec max(vec a, vec b) {
+        return _mm256_max_epu32(a, b);
+    }
+};
+
+template <>
+struct Avx2Ops<int64_t> {
+    typedef __m256i vec;
+    static const size_t lanes = 4;
+    static TLX_HEAP_SIMD_AVX2 vec load(const void* p) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+    static TLX_HEAP_SIMD_AVX2 vec min(vec a, vec b) {
+        return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+    }
+    static TLX_HEAP_SIMD_AVX2 vec max(vec a, vec b) {
+        return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(b, a));
+    }
+    static TLX_HEAP_SIMD_AVX2 unsigned equal(vec a, vec b) {
+        return static_cast<unsigned>(_mm256_movemask_pd(
+                                         _mm256_castsi256_pd(
+                                             _mm256_cmpeq_epi64(a, b))));
+    }
+    static TLX_HEAP_SIMD_AVX2 vec all_min(vec v) {
+        v = min(v, _mm256_permute4x64_epi64(v, 0x4E));
+        return min(v, _mm256_permute4x64_epi64(v, 0xB1));
+    }
+    static TLX_HEAP_SIMD_AVX2 vec all_max(vec v) {
+        v = max(v, _mm256_permute4x64_epi64(v, 0x4E));
+        return max(v, _mm256_permute4x64_epi64(v, 0xB1));
+    }
+};
+
+template <>
+struct Avx2Ops<uint64_t> : public Avx2Ops<int64_t>{
+    static TLX_HEAP_SIMD_AVX2 vec load(const void* p) {
+        return _mm256_xor_si256(
+            Avx2Ops<int64_t>::load(p),
+            _mm256_set1_epi64x(static_cast<int64_t>(0x8000000000000000ull)));
+    }
+};
+
+template <>
+struct Avx2Ops<float> {
+    typedef __m256 vec;
+    static const size_t lanes = 8;
+    static TLX_HEAP_SIMD_AVX2 vec load(const void* p) {
+        return _mm256_loadu_ps(static_cast<const float*>(p));
+    }
+    static TLX_HEAP_SIMD_AVX2 vec min(vec a, vec b) {
+        return _mm256_min_ps(a, b);
+    }
+    static TLX_HEAP_SIMD_AVX2 vec max(vec a, vec b) {
+        return _mm256_max_ps(a, b);
+    }
+    static TLX_HEAP_SIMD_AVX2 unsigned equal(vec a, vec b) {
+        return static_cast<unsigned>(
+            _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ)));
+    }
+    static TLX_HEAP_SIMD_AVX2 vec all_min(vec v) {
+        v = min(v, _mm256_permute2f128_ps(v, v, 1));
+        v = min(v, _mm256_permute_ps(v, 0x4E));
+        return min(v, _mm256_permute_ps(v, 0xB1));
+    }
+    static TLX_HEAP_SIMD_AVX2 vec all_max(vec v) {
+        v = max(v, _mm256_permute2f128_ps(v, v, 1));
+        v = max(v, _mm256_permute_ps(v, 0x4E));
+        return max(v, _mm256_permute_ps(v, 0xB1));
+    }
+};
+
+template <>
+struct Avx2Ops<double> {
+    typedef __m256d vec;
+    static const size_t lanes = 4;
+    static TLX_HEAP_SIMD_AVX2 vec load(const void* p) {
+        return _mm256_loadu_pd(static_cast<const double*>(p));
+    }
+    static TLX_HEAP_SIMD_AVX2 vec min(vec a, vec b) {
+        return _mm256_min_pd(a, b);
+    }
+    static TLX_HEAP_SIMD_AVX2 vec max(vec a, vec b) {
+        return _mm256_max_pd(a, b);
+    }
+    static TLX_HEAP_SIMD_AVX2 unsigned equal(vec a, vec b) {
+        return static_cast<unsigned>(
+            _mm256_movemask_pd(_mm256_cmp_pd(a, b, _CMP_EQ_OQ)));
+    }
+    static TLX_HEAP_SIMD_AVX2 vec all_min(vec v) {
+        v = min(v, _mm256_permute2f128_pd(v, v, 1));
+        return min(v, _mm256_permute_pd(v, 0x5));
+    }
+    static TLX_HEAP_SIMD_AVX2 vec all_max(vec v) {
+        v = max(v, _mm256_permute2f128_pd(v, v, 1));
+        return max(v, _mm256_permute_pd(v, 0x5));
+    }
+};
+
+template <typename Key>
+struct Sse42Ops;
+
+//! Broadcast reductions of 32-bit lanes, shared by all 32-bit types.
+template <typename Derived>
+struct Sse42Reduce32 {
+    typedef __m128i vec;
+    static const size_t lanes = 4;
+    static TLX_HEAP_SIMD_SSE42 vec load(const void* p) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+    static TLX_HEAP_SIMD_SSE42 unsigned equal(vec a, vec b) {
+        return static_cast<unsigned>(
+            _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b))));
+    }
+    static TLX_HEAP_SIMD_SSE42 vec all_min(vec v) {
+        v = Derived::min(v, _mm_shuffle_epi32(v, 0x4E));
+        return Derived::min(v, _mm_shuffle_epi32(v, 0xB1));
+    }
+    static TLX_HEAP_SIMD_SSE42 vec all_max(vec v) {
+        v = Derived::max(v, _mm_shuffle_epi32(v, 0x4E));
+        return Derived::max(v, _mm_shuffle_epi32(v, 0xB1));
+    }
+};
+
+template <>
+struct Sse42Ops<int32_t> : public Sse42Reduce32<Sse42Ops<int32_t> >{
+    static TLX_HEAP_SIMD_SSE42 vec min(vec a, vec b) {
+        return _mm_min_epi32(a, b);
+    }
+    static TLX_HEAP_SIMD_SSE42 vec max(vec a, vec b) {
+        return _mm_max_epi32(a, b);
+    }
+};
+
+template <>
+struct Sse42Ops<uint32_t> : public Sse42Reduce32<Sse42Ops<uint32_t> >{
+    static TLX_HEAP_SIMD_SSE42 vec min(vec a, vec b) {
+        return _mm_min_epu32(a, b);
+    }
+    static TLX_HEAP_SIMD_SSE42 vec max(vec a, vec b) {
+        return _mm_max_epu32(a, b);
+    }
+};
+
+template <>
+struct Sse42Ops<int64_t> {
+    typedef __m128i vec;
+    static const size_t lanes = 2;
+    static TLX_HEAP_SIMD_SSE42 vec load(const void* p) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+    static TLX_HEAP_SIMD_SSE42 vec min(vec a, vec b) {
+        return _mm_blendv_epi8(a, b, _mm_cmpgt_epi64(a, b));
+    }
+    static TLX_HEAP_SIMD_SSE42 vec max(vec a, vec b) {
+        return _mm_blendv_epi8(a, b, _mm_cmpgt_epi64(b, a));
+    }
+    static TLX_HEAP_SIMD_SSE42 unsigned equal(vec a, vec b) {
+        return static_cast<unsigned>(
+            _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(a, b))));
+    }
+    static TLX_HEAP_SIMD_SSE42 vec all_min(vec v) {
+        return min(v, _mm_shuffle_epi32(v, 0x4E));
+    }
+    static TLX_HEAP_SIMD_SSE42 vec all_max(vec v) {
+        return max(v, _mm_shuffle_epi32(v, 0x4E));
+    }
+};
+
+template <>
+struct Sse42Ops<uint64_t> : public Sse42Ops<int64_t>{
+    static TLX_HEAP_SIMD_SSE42 vec load(const void* p) {
+        return _mm_xor_si128(
+            Sse42Ops<int64_t>::load(p),
+            _mm_set1_epi64x(static_cast<int64_t>(0x8000000000000000ull)));
+    }
+};
+
+template <>
+struct Sse42Ops<float> {
+    typedef __m128 vec;
+    static const size_t lanes = 4;
+    static TLX_HEAP_SIMD_SSE42 vec load(const void* p) {
+        return _mm_loadu_ps(static_cast<const float*>(p));
+    }
+    static TLX_HEAP_SIMD_SSE42 vec min(vec a, vec b) {
+        return _mm_min_ps(a, b);
+    }
+    static TLX_HEAP_SIMD_SSE42 vec max(vec a, vec b) {
+        return _mm_max_ps(a, b);
+    }
+    static TLX_HEAP_SIMD_SSE42 unsigned equal(vec a, vec b) {
+        return static_cast<unsigned>(_mm_movemask_ps(_mm_cmpeq_ps(a, b)));
+    }
+    static TLX_HEAP_SIMD_SSE42 vec all_min(vec v) {
+        v = min(v, _mm_shuffle_ps(v, v, 0x4E));
+        return min(v, _mm_shuffle_ps(v, v, 0xB1));
+    }
+    static TLX_HEAP_SIMD_SSE42 vec all_max(vec v) {
+        v = max(v, _mm_shuffle_ps(v, v, 0x4E));
+        return max(v, _mm_shuffle_ps(v, v, 0xB1));
+    }
+};
+
+template <>
+struct Sse42Ops<double> {
+    typedef __m128d vec;
+    static const size_t lanes = 2;
+    static TLX_HEAP_SIMD_SSE42 vec load(const void* p) {
+        return _mm_loadu_pd(static_cast<const double*>(p));
+    }
+    static TLX_HEAP_SIMD_SSE42 vec min(vec a, vec b) {
+        return _mm_min_pd(a, b);
+    }
+    static TLX_HEAP_SIMD_SSE42 vec max(vec a, vec b) {
+        return _mm_max_pd(a, b);
+    }
+    static TLX_HEAP_SIMD_SSE42 unsigned equal(vec a, vec b) {
+        return static_cast<unsigned>(_mm_movemask_pd(_mm_cmpeq_pd(a, b)));
+    }
+    static TLX_HEAP_SIMD_SSE42 vec all_min(vec v) {
+        return min(v, _mm_shuffle_pd(v, v, 0x1));
+    }
+    static TLX_HEAP_SIMD_SSE42 vec all_max(vec v) {
+        return max(v, _mm_shuffle_pd(v, v, 0x1));
+    }
+};
+
+/******************************************************************************/
+// Selection Kernels
+//
+// The kernels reduce all vectors of [keys,keys+n) with min() or max(), where
+// a last partial vector is loaded overlapping the previous one, broadcast the
+// extreme lane and return the first position equal to it. They require n >=
+// lanes.
+
+//! Position of the first minimum (or maximum) in [keys,keys+n).
+template <typename KType, bool Max, typename Key>
+static inline TLX_HEAP_SIMD_AVX2
+size_t select_avx2(const Key* keys, size_t n) {
+    typedef Avx2Ops<KType> Ops;
+    const size_t last = n - Ops::lanes;
+    typename Ops::vec m = Ops::load(keys + last);
+    for (size_t i = 0; i < last; i += Ops::lanes) {
+        m = Max ? Ops::max(m, Ops::load(keys + i))
+            : Ops::min(m, Ops::load(keys + i));
+    }
+    m = Max ? Ops::all_max(m) : Ops::all_min(m);
+    for (size_t i = 0; i < last; i += Ops::lanes) {
+        unsigned mask = Ops::equal(Ops::load(keys + i), m);
+        if (mask) return i + ctz(mask);
+    }
+    return last + ctz(Ops::equal(Ops::load(keys + last), m));
+}
+
+//! Position of the first minimum (or maximum) in [keys,keys+n).
+template <typename KType, bool Max, typename Key>
+static inline TLX_HEAP_SIMD_SSE42
+size_t select_sse42(const Key* keys, size_t n) {
+    typedef Sse42Ops<KType> Ops;
+    const size_t last = n - Ops::lanes;
+    typename Ops::vec m = Ops::load(keys + last);
+    for (size_t i = 0; i < last; i += Ops::lanes) {
+        m = Max ? Ops::max(m, Ops::load(keys + i))
+            : Ops::min(m, Ops::load(keys + i));
+    }
+    m = Max ? Ops::all_max(m) : Ops::all_min(m);
+    for (size_t i = 0; i < last; i += Ops::lanes) {
+        unsigned mask = Ops::equal(Ops::load(keys + i), m);
+        if (mask) return i + ctz(mask);
+    }
+    return last + ctz(Ops::equal(Ops::load(keys + last), m));
+}
+
+#undef TLX_HEAP_SIMD_AVX2
+#undef TLX_HEAP_SIMD_SSE42
+
+#endif // TLX_BTREE_HAVE_SIMD
+
+//! Position of the first minimum (or maximum) in [keys,keys+n) using plain
+//! scalar comparisons.
+template <bool Max, typename Key>
+static inline size_t select_scalar(const Key* keys, size_t n) {
+    size_t c = 0;
+    for (size_t i = 1; i < n; ++i) {
+        if (Max ? keys[c] < keys[i] : keys[i] < keys[c])
+            c = i;
+    }
+    return c;
+}
+
+/******************************************************************************/
+
+/*!
+ * Determines whether the children of a d-ary heap with the given key type and
+ * comparison functor can be selected with the SIMD kernels. This is the case
+ * for 32- and 64-bit integers, float and double, ordered by std::less (a
+ * min-heap) or std::greater (a max-heap). Floating point keys must not be NaN.
+ */
+template <typename Key, typename Compare>
+struct is_supported
+    : public std::integral_constant<
+          bool,
+          !std::is_same<
+              typename btree_simd::KernelType<Key>::type, void>::value &&
+          (std::is_same<Compare, std::less<Key> >::value ||
+           std::is_same<Compare, std::greater<Key> >::value)>{ };
+
+//! Return the position of the first minimum of [keys,keys+n), or of the first
+//! maximum if Max, for n >= 1 keys.
+template <bool Max, typename Key>
+static inline size_t select_child(const Key* keys, size_t n) {
+    typedef typename btree_simd::KernelType<Key>::type KType;
+#if TLX_BTREE_HAVE_SIMD
+    switch (btree_simd::cpu_isa()) {
+    case btree_simd::Isa::avx2:
+        if (n >= Avx2Ops<KType>::lanes)
+            return select_avx2<KType, Max>(keys, n);
+    // fall through
+    case btree_simd::Isa::sse42:
+        if (n >= Sse42Ops<KType>::lanes)
+            return select_sse42<KType, Max>(keys, n);
+        break;
+    default:
+        break;
+    }
+#endif
+    return select_scalar<Max>(keys, n);
+}
+
+/*!
+ * Allocator returning memory such that the element following the first one
+ * starts at an Alignment boundary. In a d-ary heap, the children of node k
+ * are stored at arity * k + 1 and following, hence each group of children
+ * starts on a cache line if arity * sizeof(Type) divides the cache line size
+ * or is a multiple of it.
+ */
+template <typename Type, size_t Alignment = 64>
+class ChildAlignedAllocator
+{
+    static_assert(Alignment % sizeof(Type) == 0,
+                  "Alignment must be a multiple of the element size.");
+
+public:
+    using value_type = Type;
+
+    //! required rebind.
+    template <typename Other>
+    struct rebind { using other = ChildAlignedAllocator<Other, Alignment>; };
+
+    ChildAlignedAllocator() noexcept = default;
+
+    template <typename Other>
+    ChildAlignedAllocator(
+        const ChildAlignedAllocator<Other, Alignment>&) noexcept { }
+
+    //! Allocate n items, the address of the original allocation is stored in
+    //! front of the returned pointer.
+    Type * allocate(size_t n, const void* /* hint */ = nullptr) {
+        char* raw = static_cast<char*>(
+            ::operator new (n * sizeof(Type) + sizeof(void*) + Alignment));
+        uintptr_t start = reinterpret_cast<uintptr_t>(raw) +
+                          sizeof(void*) + sizeof(Type);
+        start = (start + Alignment - 1) / Alignment * Alignment;
+        char* p = reinterpret_cast<char*>(start - sizeof(Type));
+        std::memcpy(p - sizeof(void*), &raw, sizeof(void*));
+        return reinterpret_cast<Type*>(p);
+    }
+
+    void deallocate(Type* p, size_t /* n */) noexcept {
+        char* raw;
+        std::memcpy(&raw, reinterpret_cast<char*>(p) - sizeof(void*),
+                    sizeof(void*));
+        ::operator delete (raw);
+    }
+
+    template <typename Other>
+    bool operator == (
+        const ChildAlignedAllocator<Other, Alignment>&) const noexcept {
+        return true;
+    }
+
+    template <typename Other>
+    bool operator != (
+        const ChildAlignedAllocator<Other, Alignment>&) const noexcept {
+        return false;
+    }
+};
+
+} // namespace d_ary_heap_simd
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_CONTAINER_D_ARY_HEAP_SIMD_HEADER
+
+/******************************************************************************/
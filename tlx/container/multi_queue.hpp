@@ -0,0 +1,411 @@
+/*******************************************************************************
+ * tlx/container/multi_queue.hpp
+ *
+ * A relaxed concurrent priority queue made of many sequential DAryHeaps.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_CONTAINER_MULTI_QUEUE_HEADER
+#define TLX_CONTAINER_MULTI_QUEUE_HEADER
+
+#include <tlx/container/d_ary_heap.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+
+namespace tlx {
+
+//! \addtogroup tlx_container
+//! \{
+
+/*!
+ * A relaxed concurrent priority queue, the MultiQueue of H. Rihani, P. Sanders,
+ * R. Dementiev: "MultiQueues: Simple Relaxed Concurrent Priority Queues"
+ * (2015), with the stickiness and buffering of M. Williams, P. Sanders:
+ * "Engineering MultiQueues: Fast Relaxed Concurrent Priority Queues" (2021).
+ *
+ * The MultiQueue consists of factor * num_threads sequential DAryHeaps, each
+ * protected by its own mutex, which is only acquired with try_lock(). An item
+ * is pushed into a random heap, and pop removes the top of the better one of
+ * two random heaps. The items are hence not popped in exact priority order,
+ * but the expected rank of a popped item is O(num_queues()).
+ *
+ * All operations go through a Handle, which holds the state of one thread:
+ *
+ * - a random generator to select heaps,
+ *
+ * - the heaps it used last: with stickiness s, a handle reuses the same heaps
+ *   for s operations, unless one of their locks is taken, which improves cache
+ *   locality at the cost of a larger rank error,
+ *
+ * - with buffer_size b > 0, an insertion buffer of up to b items which are
+ *   pushed into a heap in one bulk operation, and a deletion buffer which is
+ *   refilled with the b top items of a heap. The handle's pops consider both
+ *   buffers. Buffered items are invisible to other threads until flush() is
+ *   called.
+ *
+\code
+MultiQueue<uint64_t> mq(num_threads);
+
+// in each thread
+MultiQueue<uint64_t>::Handle h = mq.get_handle(thread_id);
+h.push(42);
+uint64_t x;
+while (h.try_pop(x)) { ... }
+\endcode
+ *
+ * \tparam KeyType    Key type.
+ * \tparam Arity      Arity of the DAryHeaps.
+ * \tparam Compare    Function object to order keys, the smallest is on top.
+ */
+template <typename KeyType, unsigned Arity = 4,
+          typename Compare = std::less<KeyType> >
+class MultiQueue
+{
+public:
+    using key_type = KeyType;
+    using compare_type = Compare;
+
+    //! Sequential heap used for each queue.
+    using heap_type = DAryHeap<KeyType, Arity, Compare>;
+
+    class Handle;
+
+protected:
+    //! A heap with its lock. Each queue starts on its own cache line and its
+    //! size is rounded up to whole lines, which avoids false sharing between
+    //! neighbouring queues.
+    struct alignas(64) Queue {
+        //! Protects heap.
+        std::mutex mutex;
+        //! The items of this queue.
+        heap_type heap;
+        //! Number of items in heap, readable without holding mutex.
+        std::atomic<size_t> size { 0 };
+    };
+
+    //! The queues.
+    std::unique_ptr<Queue[]> queues_;
+
+    //! Number of queues.
+    size_t num_queues_;
+
+    //! Number of operations for which a handle keeps its queues.
+    size_t stickiness_;
+
+    //! Size of the insertion and deletion buffer of each handle.
+    size_t buffer_size_;
+
+    //! Compare function.
+    compare_type cmp_;
+
+public:
+    /*!
+     * Creates factor * num_threads empty queues.
+     *
+     * \param num_threads  Number of threads using the MultiQueue.
+     * \param factor       Number of queues per thread, c >= 2 is recommended.
+     * \param stickiness   Number of operations a handle reuses its queues.
+     * \param buffer_size  Size of the insertion and deletion buffers, or zero.
+     * \param cmp          Compare function.
+     */
+    explicit MultiQueue(size_t num_threads, size_t factor = 2,
+                        size_t stickiness = 1, size_t buffer_size = 0,
+                        compare_type cmp = compare_type())
+        : num_queues_(std::max<size_t>(1, factor * num_threads)),
+          stickiness_(std::max<size_t>(1, stickiness)),
+          buffer_size_(buffer_size), cmp_(cmp) {
+        queues_.reset(new Queue[num_queues_]);
+        for (size_t i = 0; i < num_queues_; ++i)
+            queues_[i].heap = heap_type(cmp_);
+    }
+
+    //! Non-copyable.
+    MultiQueue(const MultiQueue&) = delete;
+    MultiQueue& operator = (const MultiQueue&) = delete;
+
+    //! Returns a new handle, one for each thread. Handles must be destroyed
+    //! before the MultiQueue.
+    Handle get_handle(size_t seed) { return Handle(*this, seed); }
+
+    //! Returns the number of queues.
+    size_t num_queues() const noexcept { return num_queues_; }
+
+    //! Returns the number of operations a handle reuses its queues.
+    size_t stickiness() const noexcept { return stickiness_; }
+
+    //! Returns the size of the insertion and deletion buffers.
+    size_t buffer_size() const noexcept { return buffer_size_; }
+
+    //! Returns the number of items in the queues, excluding those in the
+    //! buffers of handles. Exact only if there are no concurrent operations.
+    size_t size() const {
+        size_t n = 0;
+        for (size_t i = 0; i < num_queues_; ++i)
+            n += queues_[i].size.load(std::memory_order_relaxed);
+        return n;
+    }
+
+    //! Returns true if the queues are empty, see size().
+    bool empty() const { return size() == 0; }
+
+    /*!
+     * Thread-local access to a MultiQueue, see the description of MultiQueue.
+     * A handle must only be used by one thread at a time. Its destructor
+     * flushes the buffers.
+     */
+    class Handle
+    {
+    public:
+        //! Move.
+        Handle(Handle&& other) noexcept
+            : mq_(other.mq_), rng_(other.rng_),
+              push_queue_(other.push_queue_), push_left_(other.push_left_),
+              pop_left_(other.pop_left_),
+              insert_buf_(std::move(other.insert_buf_)),
+              delete_buf_(std::move(other.delete_buf_)),
+              delete_pos_(other.delete_pos_) {
+            pop_queue_[0] = other.pop_queue_[0];
+            pop_queue_[1] = other.pop_queue_[1];
+            other.mq_ = nullptr;
+        }
+
+        //! Non-copyable.
+        Handle(const Handle&) = delete;
+        Handle& operator = (const Handle&) = delete;
+        Handle& operator = (Handle&&) = delete;
+
+        //! Flushes the buffers.
+        ~Handle() {
+            if (mq_) flush();
+        }
+
+        //! Inserts a new item into a random queue, or into the insertion
+        //! buffer.
+        void push(const key_type& key) {
+            if (mq_->buffer_size_ == 0) {
+                Queue& q = lock_push_queue();
+                q.heap.push(key);
+                q.size.store(q.heap.size(), std::memory_order_relaxed);
+                q.mutex.unlock();
+                return;
+            }
+            insert_buf_.push_back(key);
+            if (insert_buf_.size() >= mq_->buffer_size_)
+                flush_insertions();
+        }
+
+        /*!
+         * Removes an item of approximately minimum priority and stores it in
+         * \c out. Returns false if no item was found, which happens if all
+         * queues were observed empty.
+         */
+        bool try_pop(key_type& out) {
+            if (delete_pos_ == delete_buf_.size() && !refill())
+                return pop_insert_buffer(out);
+
+            // prefer a better item from the insertion buffer
+            if (!insert_buf_.empty()) {
+                size_t m = insert_min();
+                if (mq_->cmp_(insert_buf_[m], delete_buf_[delete_pos_])) {
+                    out = std::move(insert_buf_[m]);
+                    insert_buf_[m] = std::move(insert_buf_.back());
+                    insert_buf_.pop_back();
+                    return true;
+                }
+            }
+            out = std::move(delete_buf_[delete_pos_++]);
+            return true;
+        }
+
+        //! Moves the items of the insertion and deletion buffer into the
+        //! queues, where they are visible to all threads.
+        void flush() {
+            flush_insertions();
+            if (delete_pos_ < delete_buf_.size()) {
+                Queue& q = lock_push_queue();
+                q.heap.push_bulk(delete_buf_.begin() + delete_pos_,
+                                 delete_buf_.end());
+                q.size.store(q.heap.size(), std::memory_order_relaxed);
+                q.mutex.unlock();
+            }
+            delete_buf_.clear();
+            delete_pos_ = 0;
+        }
+
+    private:
+        //! The MultiQueue, nullptr if moved from.
+        MultiQueue* mq_;
+
+        //! Random generator to select queues.
+        std::minstd_rand rng_;
+
+        //! Queue for pushes and remaining number of uses.
+        size_t push_queue_ = 0, push_left_ = 0;
+
+        //! Queues for pops and remaining number of uses.
+        size_t pop_queue_[2] = { 0, 0 }, pop_left_ = 0;
+
+        //! Insertion buffer, unordered.
+        std::vector<key_type> insert_buf_;
+
+        //! Deletion buffer, ordered by priority from delete_pos_ on.
+        std::vector<key_type> delete_buf_;
+
+        //! Position of the next item in delete_buf_.
+        size_t delete_pos_ = 0;
+
+        //! Only MultiQueue creates handles.
+        Handle(MultiQueue& mq, size_t seed)
+            : mq_(&mq), rng_(static_cast<std::minstd_rand::result_type>(
+                                 seed * 0x9E3779B9u + 1)) {
+            insert_buf_.reserve(mq.buffer_size_);
+            delete_buf_.reserve(mq.buffer_size_);
+        }
+
+        friend class MultiQueue;
+
+        //! Returns a random queue index.
+        size_t random_queue() {
+            return static_cast<size_t>(rng_()) % mq_->num_queues_;
+        }
+
+        //! Locks the sticky push queue, or a new random one if its lock is
+        //! taken or its uses are exhausted.
+        Queue& lock_push_queue() {
+            while (true) {
+                if (push_left_ == 0) {
+                    push_queue_ = random_queue();
+                    push_left_ = mq_->stickiness_;
+                }
+                Queue& q = mq_->queues_[push_queue_];
+                if (q.mutex.try_lock()) {
+                    --push_left_;
+                    return q;
+                }
+                push_left_ = 0;
+            }
+        }
+
+        //! Pushes the insertion buffer into a queue.
+        void flush_insertions() {
+            if (insert_buf_.empty()) return;
+            Queue& q = lock_push_queue();
+            q.heap.push_bulk(insert_buf_.begin(), insert_buf_.end());
+            q.size.store(q.heap.size(), std::memory_order_relaxed);
+            q.mutex.unlock();
+            insert_buf_.clear();
+        }
+
+        //! Returns the position of the best item in the insertion buffer.
+        size_t insert_min() const {
+            size_t m = 0;
+            for (size_t i = 1; i < insert_buf_.size(); ++i) {
+                if (mq_->cmp_(insert_buf_[i], insert_buf_[m]))
+                    m = i;
+            }
+            return m;
+        }
+
+        //! Pops the best item of the insertion buffer, if any.
+        bool pop_insert_buffer(key_type& out) {
+            if (insert_buf_.empty()) return false;
+            size_t m = insert_min();
+            out = std::move(insert_buf_[m]);
+            insert_buf_[m] = std::move(insert_buf_.back());
+            insert_buf_.pop_back();
+            return true;
+        }
+
+        //! Moves the top items of the locked queue q into the deletion buffer
+        //! and unlocks it.
+        void take(Queue& q) {
+            delete_buf_.clear();
+            delete_pos_ = 0;
+            size_t n = std::max<size_t>(1, mq_->buffer_size_);
+            while (delete_buf_.size() < n && !q.heap.empty()) {
+                delete_buf_.push_back(q.heap.extract_top());
+            }
+            q.size.store(q.heap.size(), std::memory_order_relaxed);
+            q.mutex.unlock();
+        }
+
+        //! Refills the deletion buffer from the better of two random queues.
+        //! If they are empty, falls back to scanning all queues, and returns
+        //! false if all are empty.
+        bool refill() {
+            for (size_t attempt = 0; attempt < 4; ++attempt) {
+                if (pop_left_ == 0) {
+                    pop_queue_[0] = random_queue();
+                    pop_queue_[1] = random_queue();
+                    pop_left_ = mq_->stickiness_;
+                }
+                Queue& a = mq_->queues_[pop_queue_[0]];
+                Queue& b = mq_->queues_[pop_queue_[1]];
+                if (!a.mutex.try_lock()) {
+                    pop_left_ = 0;
+                    continue;
+                }
+                Queue* best = &a;
+                if (&b != &a && b.mutex.try_lock()) {
+                    if (!b.heap.empty() &&
+                        (a.heap.empty() ||
+                         mq_->cmp_(b.heap.top(), a.heap.top()))) {
+                        a.mutex.unlock();
+                        best = &b;
+                    }
+                    else {
+                        b.mutex.unlock();
+                    }
+                }
+                if (best->heap.empty()) {
+                    best->mutex.unlock();
+                    pop_left_ = 0;
+                    continue;
+                }
+                --pop_left_;
+                take(*best);
+                return true;
+            }
+            // few items are left: take them from any non-empty queue.
+            for (size_t i = 0; i < mq_->num_queues_; ++i) {
+                Queue& q = mq_->queues_[i];
+                if (q.size.load(std::memory_order_relaxed) == 0)
+                    continue;
+                q.mutex.lock();
+                if (q.heap.empty()) {
+                    q.mutex.unlock();
+                    continue;
+                }
+                take(q);
+                return true;
+            }
+            return false;
+        }
+    };
+};
+
+//! make template alias due to similarity with std::priority_queue
+template <typename KeyType, unsigned Arity = 4,
+          typename Compare = std::less<KeyType> >
+using multi_queue = MultiQueue<KeyType, Arity, Compare>;
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_CONTAINER_MULTI_QUEUE_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,423 @@
+/*******************************************************************************
+ * tlx/container/pairing_heap.hpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_CONTAINER_PAIRING_HEAP_HEADER
+#define TLX_CONTAINER_PAIRING_HEAP_HEADER
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace tlx {
+
+//! \addtogroup tlx_container
+//! \{
+
+/*!
+ * This class implements a pairing heap [Fredman, Sedgewick, Sleator, Tarjan
+ * 1986], a node-based addressable heap. push() returns a handle to the node of
+ * the item, which stays valid until the item is removed, and with which the
+ * item can be decreased by decrease_key() in amortized O(1) time, or removed by
+ * erase(). Two heaps are melded in O(1) time, keeping all handles valid. This
+ * suits decrease-key heavy graph algorithms like Dijkstra's or Prim's with
+ * arbitrary key types.
+ *
+ * Removing the top item combines its children by the two-pass method, which
+ * takes amortized O(log n) time.
+ *
+ * The nodes are allocated individually by the Allocator, such that a pooling
+ * allocator like tlx::SlabAllocator avoids going through malloc() for each
+ * push.
+ *
+ * \tparam KeyType    Key type.
+ * \tparam Compare    Function object to order keys.
+ * \tparam Allocator  Allocator, which is rebound to the node type.
+ */
+template <typename KeyType, typename Compare = std::less<KeyType>,
+          typename Allocator = std::allocator<KeyType> >
+class PairingHeap
+{
+public:
+    using key_type = KeyType;
+    using compare_type = Compare;
+    using allocator_type = Allocator;
+
+private:
+    //! Node of the heap: the children of a node are a doubly linked list, in
+    //! which the prev pointer of the first child points to the parent.
+    struct Node {
+        key_type key;
+        //! first child
+        Node* child;
+        //! next sibling
+        Node* next;
+        //! previous sibling, or parent for the first child
+        Node* prev;
+
+        template <typename... Args>
+        explicit Node(Args&& ... args)
+            : key(std::forward<Args>(args) ...),
+              child(nullptr), next(nullptr), prev(nullptr) { }
+    };
+
+    using node_allocator_type =
+        typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+    using node_alloc_traits = std::allocator_traits<node_allocator_type>;
+
+public:
+    //! Handle to an item, returned by push(). Valid until the item is removed.
+    class handle_type
+    {
+    public:
+        //! Constructs an invalid handle.
+        handle_type() noexcept : node_(nullptr) { }
+
+        //! Returns true if the handle refers to an item.
+        explicit operator bool () const noexcept { return node_ != nullptr; }
+
+        bool operator == (const handle_type& other) const noexcept {
+            return node_ == other.node_;
+        }
+        bool operator != (const handle_type& other) const noexcept {
+            return node_ != other.node_;
+        }
+
+    private:
+        explicit handle_type(Node* node) noexcept : node_(node) { }
+
+        Node* node_;
+
+        friend class PairingHeap;
+    };
+
+    //! Allocates an empty heap.
+    explicit PairingHeap(compare_type cmp = compare_type(),
+                         const allocator_type& alloc = allocator_type())
+        : alloc_(alloc), cmp_(cmp) { }
+
+    //! non-copyable: delete copy-constructor
+    PairingHeap(const PairingHeap&) = delete;
+    //! non-copyable: delete assignment operator
+    PairingHeap& operator = (const PairingHeap&) = delete;
+
+    //! Move. Handles remain valid.
+    PairingHeap(PairingHeap&& other) noexcept
+        : alloc_(std::move(other.alloc_)), cmp_(std::move(other.cmp_)),
+          root_(other.root_), size_(other.size_) {
+        other.root_ = nullptr;
+        other.size_ = 0;
+    }
+
+    //! Move. Handles remain valid.
+    PairingHeap& operator = (PairingHeap&& other) noexcept {
+        if (this == &other) return *this;
+        clear();
+        alloc_ = std::move(other.alloc_);
+        cmp_ = std::move(other.cmp_);
+        root_ = other.root_, size_ = other.size_;
+        other.root_ = nullptr;
+        other.size_ = 0;
+        return *this;
+    }
+
+    //! Frees all nodes.
+    ~PairingHeap() {
+        clear();
+    }
+
+    //! Empties the heap, which invalidates all handles.
+    void clear() {
+        if (!root_) return;
+        // free the tree iteratively, it may be very deep.
+        std::vector<Node*> stack(1, root_);
+        while (!stack.empty()) {
+            Node* n = stack.back();
+            stack.pop_back();
+            if (n->child) stack.push_back(n->child);
+            if (n->next) stack.push_back(n->next);
+            delete_node(n);
+        }
+        root_ = nullptr;
+        size_ = 0;
+    }
+
+    //! Returns the number of items in the heap.
+    size_t size() const noexcept { return size_; }
+
+    //! Returns true if the heap has no items, false otherwise.
+    bool empty() const noexcept { return size_ == 0; }
+
+    //! Returns the allocator.
+    allocator_type get_allocator() const { return allocator_type(alloc_); }
+
+    //! Inserts a new item and returns its handle.
+    handle_type push(const key_type& new_key) {
+        return emplace(new_key);
+    }
+
+    //! Inserts a new item and returns its handle.
+    handle_type push(key_type&& new_key) {
+        return emplace(std::move(new_key));
+    }
+
+    //! Constructs a new item in place and returns its handle.
+    template <typename... Args>
+    handle_type emplace(Args&& ... args) {
+        Node* n = new_node(std::forward<Args>(args) ...);
+        root_ = root_ ? link(root_, n) : n;
+        ++size_;
+        return handle_type(n);
+    }
+
+    //! Returns the top item.
+    const key_type& top() const noexcept {
+        assert(!empty());
+        return root_->key;
+    }
+
+    //! Returns the handle of the top item.
+    handle_type top_handle() const noexcept {
+        assert(!empty());
+        return handle_type(root_);
+    }
+
+    //! Removes the top item.
+    void pop() {
+        assert(!empty());
+        Node* old = root_;
+        root_ = combine_siblings(old->child);
+        delete_node(old);
+        --size_;
+    }
+
+    //! Removes and returns the top item.
+    key_type extract_top() {
+        assert(!empty());
+        key_type top_item = std::move(root_->key);
+        pop();
+        return top_item;
+    }
+
+    //! Returns the key of the item with handle \c h.
+    const key_type& key(handle_type h) const noexcept {
+        assert(h);
+        return h.node_->key;
+    }
+
+    //! Replaces the key of the item with handle \c h by \c new_key, which must
+    //! not be ordered after the old key. Takes amortized O(1) time.
+    void decrease_key(handle_type h, const key_type& new_key) {
+        assert(!cmp_(h.node_->key, new_key));
+        h.node_->key = new_key;
+        decrease(h.node_);
+    }
+
+    //! Replaces the key of the item with handle \c h by \c new_key, which must
+    //! not be ordered after the old key. Takes amortized O(1) time.
+    void decrease_key(handle_type h, key_type&& new_key) {
+        assert(!cmp_(h.node_->key, new_key));
+        h.node_->key = std::move(new_key);
+        decrease(h.node_);
+    }
+
+    //! Replaces the key of the item with handle \c h by an arbitrary new key.
+    //! An increased key is moved down by cutting the node's children.
+    void update(handle_type h, const key_type& new_key) {
+        Node* n = h.node_;
+        if (!cmp_(n->key, new_key)) {
+            n->key = new_key;
+            decrease(n);
+            return;
+        }
+        n->key = new_key;
+        if (n == root_) {
+            Node* rest = combine_siblings(n->child);
+            n->child = nullptr;
+            root_ = rest ? link(rest, n) : n;
+        }
+        else {
+            cut(n);
+            Node* rest = combine_siblings(n->child);
+            n->child = nullptr;
+            if (rest) root_ = link(root_, rest);
+            root_ = link(root_, n);
+        }
+    }
+
+    //! Removes the item with handle \c h.
+    void erase(handle_type h) {
+        Node* n = h.node_;
+        if (n == root_) {
+            pop();
+            return;
+        }
+        cut(n);
+        Node* rest = combine_siblings(n->child);
+        if (rest) root_ = link(root_, rest);
+        delete_node(n);
+        --size_;
+    }
+
+    /*!
+     * Moves all items of \c other into this heap in O(1) time, leaving other
+     * empty. Handles of other's items remain valid and now refer to this heap.
+     * Both heaps must use equal allocators.
+     */
+    void meld(PairingHeap& other) {
+        if (this == &other || !other.root_) return;
+        if (!(alloc_ == other.alloc_))
+            throw std::runtime_error(
+                      "PairingHeap::meld() requires equal allocators");
+        root_ = root_ ? link(root_, other.root_) : other.root_;
+        size_ += other.size_;
+        other.root_ = nullptr;
+        other.size_ = 0;
+    }
+
+    //! For debugging: runs a DFS from the root node and verifies the heap
+    //! property, the sibling pointers, and the number of items.
+    bool sanity_check() const {
+        if (!root_) return size_ == 0;
+        if (root_->next || root_->prev) return false;
+
+        size_t count = 0;
+        std::vector<Node*> stack(1, root_);
+        while (!stack.empty()) {
+            Node* n = stack.back();
+            stack.pop_back();
+            ++count;
+            Node* prev = n;
+            for (Node* c = n->child; c; prev = c, c = c->next) {
+                // check that the child is not strictly less than its parent.
+                if (cmp_(c->key, n->key) || c->prev != prev)
+                    return false;
+                stack.push_back(c);
+            }
+        }
+        return count == size_;
+    }
+
+private:
+    //! Allocator of the nodes.
+    node_allocator_type alloc_;
+
+    //! Compare function.
+    compare_type cmp_;
+
+    //! Root node, holding the top item.
+    Node* root_ = nullptr;
+
+    //! Number of items.
+    size_t size_ = 0;
+
+    template <typename... Args>
+    Node * new_node(Args&& ... args) {
+        Node* n = node_alloc_traits::allocate(alloc_, 1);
+        try {
+            node_alloc_traits::construct(
+                alloc_, n, std::forward<Args>(args) ...);
+        }
+        catch (...) {
+            node_alloc_traits::deallocate(alloc_, n, 1);
+            throw;
+        }
+        return n;
+    }
+
+    void delete_node(Node* n) {
+        node_alloc_traits::destroy(alloc_, n);
+        node_alloc_traits::deallocate(alloc_, n, 1);
+    }
+
+    //! Links two roots without siblings: the one ordered after becomes the
+    //! first child of the other, which is returned.
+    Node * link(Node* a, Node* b) {
+        if (cmp_(b->key, a->key)) std::swap(a, b);
+        b->prev = a;
+        b->next = a->child;
+        if (a->child) a->child->prev = b;
+        a->child = b;
+        return a;
+    }
+
+    //! Unlinks the non-root node \c n and its subtree from its parent.
+    void cut(Node* n) {
+        if (n->prev->child == n)
+            n->prev->child = n->next;
+        else
+            n->prev->next = n->next;
+        if (n->next) n->next->prev = n->prev;
+        n->next = n->prev = nullptr;
+    }
+
+    //! Moves the node \c n up after its key was decreased.
+    void decrease(Node* n) {
+        if (n == root_) return;
+        cut(n);
+        root_ = link(root_, n);
+    }
+
+    /*!
+     * Combines the sibling list starting at \c first into a single tree by the
+     * two-pass method: first link pairs from left to right, then link the
+     * resulting trees from right to left. Returns the new root.
+     */
+    Node * combine_siblings(Node* first) {
+        if (!first) return nullptr;
+
+        // first pass: link pairs, collect the results in a list reversed via
+        // the prev pointers.
+        Node* last = nullptr;
+        while (first) {
+            Node* a = first;
+            Node* b = a->next;
+            if (!b) {
+                a->next = nullptr;
+                a->prev = last;
+                last = a;
+                break;
+            }
+            first = b->next;
+            a->next = b->next = nullptr;
+            a = link(a, b);
+            a->prev = last;
+            last = a;
+        }
+
+        // second pass: link from right to left.
+        Node* root = last;
+        last = last->prev;
+        root->prev = nullptr;
+        while (last) {
+            Node* prev = last->prev;
+            last->prev = nullptr;
+            root = link(root, last);
+            last = prev;
+        }
+        return root;
+    }
+};
+
+//! make template alias due to similarity with std::priority_queue
+template <typename KeyType, typename Compare = std::less<KeyType>,
+          typename Allocator = std::allocator<KeyType> >
+using pairing_heap = PairingHeap<KeyType, Compare, Allocator>;
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_CONTAINER_PAIRING_HEAP_HEADER
+
+/******************************************************************************/
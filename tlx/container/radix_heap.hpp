@@ -13,7 +13,12 @@
 
 #include <array>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <limits>
+#include <memory>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -23,6 +28,7 @@
 #include <tlx/math/div_ceil.hpp>
 #include <tlx/math/ffs.hpp>
 #include <tlx/meta/log2.hpp>
+#include <tlx/thread_pool.hpp>
 
 namespace tlx {
 namespace radix_heap_detail {
@@ -82,6 +88,125 @@ private:
                   "Rank of maximum is not larger than rank of zero");
 };
 
+/*!
+ * Compute the rank of a floating point number x, i.e. map it to an unsigned
+ * integer of the same width such that the order is preserved, and vice versa.
+ *
+ * The IEEE 754 representation of non-negative numbers already orders like
+ * unsigned integers, hence the sign bit is set to move them above all negative
+ * numbers. For negative numbers, all bits are flipped, which reverses their
+ * order. Negative zero has the same rank as positive zero, since both compare
+ * equal, and NaNs are not supported.
+ */
+template <typename Float>
+class FloatRank
+{
+    static_assert(std::is_floating_point<Float>::value &&
+                  std::numeric_limits<Float>::is_iec559 &&
+                  (sizeof(Float) == 4 || sizeof(Float) == 8),
+                  "Float has to be an IEEE 754 float or double");
+
+public:
+    using int_type = Float;
+    using rank_type = typename std::conditional<
+        sizeof(Float) == 4, uint32_t, uint64_t>::type;
+
+    //! Maps value f to its rank. For any pair x < y the invariant
+    //! FloatRank<T>::rank_of_int(x) < FloatRank<T>::rank_of_int(y) holds, and
+    //! -0.0 and +0.0 have the same rank.
+    static rank_type rank_of_int(int_type f) {
+        rank_type r;
+        std::memcpy(&r, &f, sizeof(r));
+        // map -0.0 to +0.0
+        if (r == sign_bit_) r = 0;
+        return (r & sign_bit_) ? ~r : (r ^ sign_bit_);
+    }
+
+    //! Returns the number with rank r. It is the inverse of rank_of_int, i.e.
+    //! int_at_rank(rank_of_int(f)) == f for all f except NaN, and returns +0.0
+    //! for -0.0.
+    static int_type int_at_rank(rank_type r) {
+        r = (r & sign_bit_) ? (r ^ sign_bit_) : ~r;
+        int_type f;
+        std::memcpy(&f, &r, sizeof(f));
+        return f;
+    }
+
+private:
+    constexpr static rank_type sign_bit_
+        = (rank_type(1) << (8 * sizeof(rank_type) - 1));
+};
+
+#if defined(__SIZEOF_INT128__)
+
+/*!
+ * Compute the rank of a 128-bit integer, see IntegerRank. A separate class is
+ * needed since std::is_integral and std::make_unsigned do not cover __int128
+ * in strict ISO C++ mode.
+ */
+template <typename Int>
+class Int128Rank
+{
+    static_assert(std::is_same<Int, __int128>::value ||
+                  std::is_same<Int, unsigned __int128>::value,
+                  "Int has to be a 128-bit integer type");
+
+public:
+    using int_type = Int;
+    using rank_type = unsigned __int128;
+
+    //! Maps value i to its rank in int_type, preserving the order.
+    static constexpr rank_type rank_of_int(int_type i) {
+        return static_cast<rank_type>(i) ^ sign_bit_;
+    }
+
+    //! Returns the r-th smallest number of int_type, the inverse of
+    //! rank_of_int.
+    static constexpr int_type int_at_rank(rank_type r) {
+        return static_cast<int_type>(r ^ sign_bit_);
+    }
+
+private:
+    constexpr static rank_type sign_bit_ =
+        std::is_same<Int, __int128>::value ? (rank_type(1) << 127) : 0;
+};
+
+#endif
+
+//! Selects the rank computation of a key type: IntegerRank for integers,
+//! FloatRank for float and double, and Int128Rank for 128-bit integers.
+template <typename Key>
+struct KeyRank {
+    using type = typename std::conditional<
+        std::is_floating_point<Key>::value,
+        FloatRank<Key>, IntegerRank<Key> >::type;
+};
+
+#if defined(__SIZEOF_INT128__)
+template <>
+struct KeyRank<__int128> {
+    using type = Int128Rank<__int128>;
+};
+
+template <>
+struct KeyRank<unsigned __int128> {
+    using type = Int128Rank<unsigned __int128>;
+};
+#endif
+
+//! Number of leading zeros of a rank, which are also ranks of 128 bits.
+template <typename Int>
+static inline unsigned clz_rank(Int x) {
+    return clz(x);
+}
+
+#if defined(__SIZEOF_INT128__)
+static inline unsigned clz_rank(unsigned __int128 x) {
+    const uint64_t hi = static_cast<uint64_t>(x >> 64);
+    return hi ? clz(hi) : 64 + clz(static_cast<uint64_t>(x));
+}
+#endif
+
 //! Internal implementation of BitArray; do not invoke directly
 //! \tparam Size  Number of bits the data structure is supposed to store
 //! \tparam SizeIsAtmost64  Switch between inner node implementation (false)
@@ -273,7 +398,13 @@ private:
 template <unsigned Radix, typename Int>
 class BucketComputation
 {
+#if defined(__SIZEOF_INT128__)
+    static_assert(std::is_unsigned<Int>::value ||
+                  std::is_same<Int, unsigned __int128>::value,
+                  "Require unsigned integer");
+#else
     static_assert(std::is_unsigned<Int>::value, "Require unsigned integer");
+#endif
     static constexpr unsigned radix_bits = tlx::Log2<Radix>::floor;
 
 public:
@@ -286,10 +417,11 @@ public:
         const auto diff = x ^ insertion_limit;
         if (!diff) return 0;
 
-        const auto diff_in_bit = (8 * sizeof(Int) - 1) - clz(diff);
+        const auto diff_in_bit = (8 * sizeof(Int) - 1) - clz_rank(diff);
 
         const auto row = diff_in_bit / radix_bits;
-        const auto bucket_in_row = ((x >> (radix_bits * row)) & mask) - row;
+        const auto bucket_in_row = static_cast<size_t>(
+            (x >> (radix_bits * row)) & mask) - row;
 
         const auto result = row * Radix + bucket_in_row;
 
@@ -314,7 +446,7 @@ public:
         assert(idx < num_buckets);
 
         if (idx == num_buckets - 1)
-            return std::numeric_limits<Int>::max();
+            return static_cast<Int>(~Int(0));
 
         return lower_bound(idx + 1) - 1;
     }
@@ -329,7 +461,7 @@ private:
 public:
     //! Number of buckets required given Radix and the current data type Int
     static constexpr size_t num_buckets =
-        num_buckets_(std::numeric_limits<Int>::digits) + 1;
+        num_buckets_(8 * sizeof(Int)) + 1;
 };
 
 //! Used as an adapter to implement RadixHeapPair on top of RadixHeap.
@@ -351,11 +483,20 @@ struct PairKeyExtract {
  * This class implements a monotonic integer min priority queue, more specific
  * a multi-level radix heap.
  *
+ * Keys can be signed or unsigned integers, including 128-bit integers where
+ * the compiler supports __int128, and float or double. The keys are mapped to
+ * unsigned integers preserving their order by radix_heap_detail::KeyRank.
+ *
  * Here, monotonic refers to the fact that the heap maintains an insertion limit
  * and does not allow the insertion of keys smaller than this limit. The
  * frontier is increased to the current minimum when invoking the methods top(),
- * pop() and swap_top_bucket(). To query the currently smallest item without
- * updating the insertion limit use peak_top_key().
+ * pop(), swap_top_bucket() and pop_top_bucket(). To query the currently
+ * smallest item without updating the insertion limit use peak_top_key().
+ *
+ * All items in the top bucket share the smallest key. pop_top_bucket() hands
+ * them out at once, which avoids the per-item overhead of pop() for workloads
+ * with many equal keys. Very large buckets can be redistributed in parallel,
+ * see set_parallel_reorganize().
  *
  * We implement a two level radix heap. Let k=sizeof(KeyType)*8 be the number of
  * bits in a key. In contrast to an ordinary radix heap which contains k
@@ -367,7 +508,7 @@ struct PairKeyExtract {
  * of Priority Queues in External Memory" [Bregel et al.] and is also inspired
  * by https://github.com/iwiwi/radix-heap
  *
- * \tparam KeyType   Has to be an unsigned integer type
+ * \tparam KeyType   An integer or floating point type, see KeyRank
  * \tparam DataType  Type of data payload
  * \tparam Radix     A power of two <= 64.
  */
@@ -388,7 +529,7 @@ public:
     static constexpr unsigned radix = Radix;
 
 protected:
-    using Encoder = radix_heap_detail::IntegerRank<key_type>;
+    using Encoder = typename radix_heap_detail::KeyRank<key_type>::type;
     using ranked_key_type = typename Encoder::rank_type;
     using bucket_map_type =
         radix_heap_detail::BucketComputation<Radix, ranked_key_type>;
@@ -541,6 +682,50 @@ public:
         filled_.clear_bit(current_bucket_);
     }
 
+    //! Removes all items with the smallest key and appends them to the user
+    //! provided bucket, which need not be empty. If it is empty, the top bucket
+    //! is swapped in O(1). Returns the smallest key.
+    //! \warning Updates insertion limit; no smaller keys can be inserted later
+    key_type pop_top_bucket(bucket_data_type& out) {
+        reorganize_();
+
+        bucket_data_type& top = buckets_data_[current_bucket_];
+        const key_type key = Encoder::int_at_rank(mins_[current_bucket_]);
+        size_ -= top.size();
+
+        if (out.empty()) {
+            top.swap(out);
+        }
+        else {
+            out.insert(out.end(), std::make_move_iterator(top.begin()),
+                       std::make_move_iterator(top.end()));
+            top.clear();
+        }
+
+        filled_.clear_bit(current_bucket_);
+        return key;
+    }
+
+    //! Redistribute buckets holding at least min_items items with num_threads
+    //! threads: the calling one and those of a ThreadPool, which is shared by
+    //! copies of the heap. Values are only moved in parallel if value_type is
+    //! default constructible, and the KeyExtract must be safe to call
+    //! concurrently. The resulting bucket contents are the same as with one
+    //! thread. Exceptions thrown by KeyExtract or the value moves are rethrown
+    //! after all threads are finished, the heap is then in an unspecified
+    //! state and must be cleared.
+    void set_parallel_reorganize(size_t num_threads,
+                                 size_t min_items = 65536) {
+        reorganize_threads_ = num_threads == 0 ? 1 : num_threads;
+        reorganize_min_items_ = min_items;
+        if (reorganize_threads_ == 1)
+            reorganize_pool_.reset();
+        else if (!reorganize_pool_ ||
+                 reorganize_pool_->size() != reorganize_threads_ - 1)
+            reorganize_pool_ = std::make_shared<ThreadPool>(
+                reorganize_threads_ - 1);
+    }
+
     //! Clears all internal queues and resets insertion limit
     void clear() {
         for (auto& x : buckets_data_) x.clear();
@@ -560,13 +745,24 @@ protected:
     std::array<ranked_key_type, num_buckets> mins_;
     radix_heap_detail::BitArray<num_buckets> filled_;
 
+    //! number of threads and minimum bucket size for parallel reorganization
+    size_t reorganize_threads_ { 1 };
+    size_t reorganize_min_items_ { 65536 };
+    //! threads helping the calling one in parallel reorganization
+    std::shared_ptr<ThreadPool> reorganize_pool_;
+
+    //! Largest rank, which marks empty buckets in mins_.
+    static constexpr ranked_key_type max_rank_() {
+        return static_cast<ranked_key_type>(~ranked_key_type(0));
+    }
+
     void initialize_() {
         size_ = 0;
-        insertion_limit_ = std::numeric_limits<ranked_key_type>::min();
+        insertion_limit_ = ranked_key_type(0);
         current_bucket_ = 0;
 
         std::fill(mins_.begin(), mins_.end(),
-                  std::numeric_limits<ranked_key_type>::max());
+                  max_rank_());
 
         filled_.clear_all();
     }
@@ -581,7 +777,7 @@ protected:
         }
 
         // mark current bucket as empty
-        mins_[current_bucket_] = std::numeric_limits<ranked_key_type>::max();
+        mins_[current_bucket_] = max_rank_();
         filled_.clear_bit(current_bucket_);
 
         // find a non-empty bucket
@@ -592,7 +788,7 @@ protected:
 
             for (size_t i = 0; i < first_non_empty; i++) {
                 assert(buckets_data_[i].empty());
-                assert(mins_[i] == std::numeric_limits<ranked_key_type>::max());
+                assert(mins_[i] == max_rank_());
             }
 
             assert(!buckets_data_[first_non_empty].empty());
@@ -615,24 +811,21 @@ protected:
 
         auto& data_source = buckets_data_[first_non_empty];
 
-        for (auto& x : data_source) {
-            const ranked_key_type key = Encoder::rank_of_int(key_extract_(x));
-            assert(key >= mins_[first_non_empty]);
-            assert(first_non_empty == mins_.size() - 1
-                   || key < mins_[first_non_empty + 1]);
-            const auto idx = bucket_map_(key, insertion_limit_);
-            assert(idx < first_non_empty);
-
-            // insert into bucket
-            if (buckets_data_[idx].empty()) filled_.set_bit(idx);
-            buckets_data_[idx].push_back(std::move(x));
-            if (mins_[idx] > key) mins_[idx] = key;
+        if (reorganize_threads_ > 1 &&
+            data_source.size() >= reorganize_min_items_) {
+            redistribute_parallel_(
+                first_non_empty,
+                std::integral_constant<
+                    bool, std::is_default_constructible<value_type>::value>());
+        }
+        else {
+            redistribute_(first_non_empty);
         }
 
         data_source.clear();
 
         // mark consumed bucket as empty
-        mins_[first_non_empty] = std::numeric_limits<ranked_key_type>::max();
+        mins_[first_non_empty] = max_rank_();
         filled_.clear_bit(first_non_empty);
 
         // update global pointers and minima
@@ -641,6 +834,86 @@ protected:
         assert(!buckets_data_[current_bucket_].empty());
         assert(mins_[current_bucket_] >= insertion_limit_);
     }
+
+    //! Moves the items of bucket src into the buckets below it.
+    void redistribute_(const size_t src) {
+        for (auto& x : buckets_data_[src]) {
+            const ranked_key_type key = Encoder::rank_of_int(key_extract_(x));
+            assert(key >= mins_[src]);
+            assert(src == mins_.size() - 1 || key < mins_[src + 1]);
+            const auto idx = bucket_map_(key, insertion_limit_);
+            assert(idx < src);
+
+            // insert into bucket
+            if (buckets_data_[idx].empty()) filled_.set_bit(idx);
+            buckets_data_[idx].push_back(std::move(x));
+            if (mins_[idx] > key) mins_[idx] = key;
+        }
+    }
+
+    //! Runs func(t) for t in [0, reorganize_threads_) on the calling thread
+    //! and the reorganization pool, see run_parallel_jobs(). The first
+    //! exception thrown by func is rethrown after all calls are finished.
+    template <typename Func>
+    void run_threads_(const Func& func) const {
+        run_parallel_jobs(*reorganize_pool_, reorganize_threads_, func);
+    }
+
+    //! Without default construction the target buckets cannot be sized
+    //! upfront, hence fall back to the sequential version.
+    void redistribute_parallel_(const size_t src, std::false_type) {
+        redistribute_(src);
+    }
+
+    //! Moves the items of bucket src into the buckets below it using multiple
+    //! threads. Each thread processes a contiguous slice: it first computes the
+    //! target buckets and counts them, then after a prefix sum over the counts
+    //! it moves its items to disjoint ranges of the resized target buckets.
+    void redistribute_parallel_(const size_t src, std::true_type) {
+        bucket_data_type& source = buckets_data_[src];
+        const size_t n = source.size();
+        const size_t p = reorganize_threads_;
+
+        // target bucket of each item, per thread counts and minima of buckets
+        std::vector<unsigned> target(n);
+        std::vector<size_t> offset(p * src, 0);
+        std::vector<ranked_key_type> mins(p * src, max_rank_());
+
+        run_threads_([&](size_t t) {
+                size_t* count = offset.data() + t * src;
+                ranked_key_type* min = mins.data() + t * src;
+                for (size_t i = n * t / p; i < n * (t + 1) / p; ++i) {
+                    const ranked_key_type key =
+                        Encoder::rank_of_int(key_extract_(source[i]));
+                    const auto idx = bucket_map_(key, insertion_limit_);
+                    assert(idx < src);
+                    target[i] = static_cast<unsigned>(idx);
+                    ++count[idx];
+                    if (min[idx] > key) min[idx] = key;
+                }
+            });
+
+        // turn counts into start positions and resize the targets
+        for (size_t b = 0; b < src; ++b) {
+            size_t pos = buckets_data_[b].size();
+            for (size_t t = 0; t < p; ++t) {
+                const size_t count = offset[t * src + b];
+                offset[t * src + b] = pos;
+                pos += count;
+                if (mins_[b] > mins[t * src + b]) mins_[b] = mins[t * src + b];
+            }
+            if (pos == buckets_data_[b].size()) continue;
+            filled_.set_bit(b);
+            buckets_data_[b].resize(pos);
+        }
+
+        run_threads_([&](size_t t) {
+                size_t* pos = offset.data() + t * src;
+                for (size_t i = n * t / p; i < n * (t + 1) / p; ++i)
+                    buckets_data_[target[i]][pos[target[i]]++] =
+                        std::move(source[i]);
+            });
+    }
 };
 
 /*!
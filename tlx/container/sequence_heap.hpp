@@ -0,0 +1,406 @@
+/*******************************************************************************
+ * tlx/container/sequence_heap.hpp
+ *
+ * External memory priority queue which spills sorted runs to temporary files.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_CONTAINER_SEQUENCE_HEAP_HEADER
+#define TLX_CONTAINER_SEQUENCE_HEAP_HEADER
+
+#include <tlx/block_file.hpp>
+#include <tlx/container/d_ary_heap.hpp>
+#include <tlx/container/loser_tree.hpp>
+#include <tlx/thread_pool.hpp>
+#include <tlx/unused.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace tlx {
+
+//! \addtogroup tlx_container
+//! \{
+
+namespace sequence_heap_detail {
+
+/*!
+ * Reads a sorted run from its temporary file block by block. The next block is
+ * read ahead by the heap's I/O ThreadPool while the current one is consumed,
+ * such that merging mostly does not wait for the disk.
+ */
+template <typename Key>
+class RunReader : public BlockReader<Key>
+{
+public:
+    //! Takes over a completely written run file of size items and starts
+    //! reading it.
+    RunReader(std::unique_ptr<BlockFile> file, size_t size, ThreadPool& pool,
+              size_t block_items, size_t level)
+        : BlockReader<Key>(std::move(file), size, pool, block_items, 1),
+          level_(level) {
+        assert(size != 0);
+    }
+
+    //! Level of the run in the merge hierarchy.
+    size_t level() const { return level_; }
+
+private:
+    //! level in the merge hierarchy
+    size_t level_;
+};
+
+/*!
+ * Appends items to a temporary BlockFile holding one run.
+ */
+template <typename Key>
+class RunWriter
+{
+public:
+    //! Creates the temporary file in directory dir.
+    explicit RunWriter(const std::string& dir)
+        : file_(BlockFile::temporary(dir)) { }
+
+    //! Appends n items to the file.
+    void append(const Key* data, size_t n) {
+        file_->write(data, n * sizeof(Key), size_ * sizeof(Key));
+        size_ += n;
+    }
+
+    //! Number of items in the file.
+    size_t size() const { return size_; }
+
+    //! Releases the file for reading.
+    std::unique_ptr<BlockFile> release() { return std::move(file_); }
+
+private:
+    std::unique_ptr<BlockFile> file_;
+    //! number of items in the file
+    size_t size_ = 0;
+};
+
+} // namespace sequence_heap_detail
+
+/*!
+ * This class implements a priority queue for more items than fit into RAM,
+ * following the sequence heap design of [Sanders 2000, "Fast Priority Queues
+ * for Cached Memory"].
+ *
+ * New items are pushed into an insertion buffer, which is a DAryHeap. When it
+ * holds insert_items items, its contents are written as a sorted run into a
+ * temporary file. The smallest items of all runs are kept in a sorted deletion
+ * buffer, which is refilled by a multiway merge of the runs with a
+ * LoserTreeCopy. top() is the smaller of the insertion buffer's top and the
+ * deletion buffer's front. The runs are read in blocks of block_items items
+ * by BlockReader, and the next block of each run is read ahead by a ThreadPool
+ * of io_threads threads owned by the heap.
+ *
+ * To bound the number of runs and open files, runs are organized in levels.
+ * When runs_per_level runs of the same level exist, they are merged into one
+ * run of the next level. Each item is hence written O(log_k(n / m)) times for
+ * k = runs_per_level and m = insert_items.
+ *
+ * The items are written to files verbatim, hence they must be trivially copy
+ * constructible and destructible, which includes std::pair of such types.
+ * The memory used is about insert_items plus 2 * block_items per run and for
+ * the deletion buffer.
+ *
+ * \tparam KeyType    Key type, must be trivially copyable.
+ * \tparam Compare    Function object to order keys.
+ */
+template <typename KeyType, typename Compare = std::less<KeyType> >
+class SequenceHeap
+{
+    static_assert(std::is_trivially_copy_constructible<KeyType>::value &&
+                  std::is_trivially_destructible<KeyType>::value,
+                  "SequenceHeap requires trivially copyable keys.");
+
+public:
+    using key_type = KeyType;
+    using compare_type = Compare;
+
+private:
+    using Run = sequence_heap_detail::RunReader<key_type>;
+    using RunWriter = sequence_heap_detail::RunWriter<key_type>;
+
+public:
+    /*!
+     * Creates an empty heap.
+     *
+     * \param insert_items    Size of the insertion buffer, and hence the
+     *                        minimum length of runs.
+     * \param block_items     Number of items read or written at once.
+     * \param runs_per_level  Number of runs of one level merged into a run of
+     *                        the next level.
+     * \param tmp_dir         Directory of the temporary files, by default
+     *                        TMPDIR or /tmp.
+     * \param cmp             Compare function.
+     * \param io_threads      Number of threads reading runs ahead.
+     */
+    explicit SequenceHeap(size_t insert_items = 1024 * 1024,
+                          size_t block_items = 64 * 1024,
+                          size_t runs_per_level = 16,
+                          const std::string& tmp_dir = std::string(),
+                          compare_type cmp = compare_type(),
+                          size_t io_threads = 1)
+        : insert_items_(std::max<size_t>(insert_items, 1)),
+          block_items_(std::max<size_t>(block_items, 1)),
+          runs_per_level_(std::max<size_t>(runs_per_level, 2)),
+          tmp_dir_(tmp_dir), cmp_(cmp), insert_heap_(cmp),
+          pool_(std::max<size_t>(io_threads, 1)) {
+        insert_heap_.reserve(insert_items_);
+    }
+
+    //! non-copyable: delete copy-constructor
+    SequenceHeap(const SequenceHeap&) = delete;
+    //! non-copyable: delete assignment operator
+    SequenceHeap& operator = (const SequenceHeap&) = delete;
+
+    //! Empties the heap and deletes all run files.
+    void clear() {
+        insert_heap_.clear();
+        delete_buffer_.clear();
+        delete_pos_ = 0;
+        runs_.clear();
+        size_ = 0;
+    }
+
+    //! Returns the number of items in the heap.
+    size_t size() const noexcept { return size_; }
+
+    //! Returns true if the heap has no items, false otherwise.
+    bool empty() const noexcept { return size_ == 0; }
+
+    //! Returns the number of runs in files.
+    size_t num_runs() const noexcept { return runs_.size(); }
+
+    //! Inserts a new item.
+    void push(const key_type& new_key) {
+        if (insert_heap_.size() >= insert_items_)
+            spill();
+        insert_heap_.push(new_key);
+        ++size_;
+    }
+
+    //! Returns the top item.
+    const key_type& top() const noexcept {
+        assert(!empty());
+        if (delete_pos_ == delete_buffer_.size())
+            return insert_heap_.top();
+        if (insert_heap_.empty() ||
+            !cmp_(insert_heap_.top(), delete_buffer_[delete_pos_]))
+            return delete_buffer_[delete_pos_];
+        return insert_heap_.top();
+    }
+
+    //! Removes the top item.
+    void pop() {
+        assert(!empty());
+        --size_;
+        if (delete_pos_ == delete_buffer_.size() ||
+            (!insert_heap_.empty() &&
+             cmp_(insert_heap_.top(), delete_buffer_[delete_pos_]))) {
+            insert_heap_.pop();
+            return;
+        }
+        if (++delete_pos_ == delete_buffer_.size())
+            refill();
+    }
+
+    //! Removes and returns the top item.
+    key_type extract_top() {
+        key_type top_item = top();
+        pop();
+        return top_item;
+    }
+
+private:
+    //! size of the insertion buffer
+    size_t insert_items_;
+    //! items per block of the runs and the deletion buffer
+    size_t block_items_;
+    //! number of runs merged into one of the next level
+    size_t runs_per_level_;
+    //! directory of temporary files
+    std::string tmp_dir_;
+
+    //! Compare function.
+    compare_type cmp_;
+
+    //! insertion buffer
+    DAryHeap<key_type, 4, compare_type> insert_heap_;
+
+    //! deletion buffer: smallest items of all runs in ascending order, of
+    //! which the items before delete_pos_ were popped
+    std::vector<key_type> delete_buffer_;
+    size_t delete_pos_ = 0;
+
+    //! sorted contents of the insertion buffer while spilling
+    std::vector<key_type> spill_buffer_;
+
+    //! threads reading runs ahead, declared before runs_ such that the runs
+    //! wait for their reads before the threads are joined
+    ThreadPool pool_;
+
+    //! runs on disk which are not yet completely consumed
+    std::vector<std::unique_ptr<Run> > runs_;
+
+    //! total number of items
+    size_t size_ = 0;
+
+    //! Writes the insertion buffer and the deletion buffer as one sorted run of
+    //! level 0, then merges full levels and refills the deletion buffer.
+    void spill() {
+        RunWriter file(tmp_dir_);
+
+        // sort the insertion buffer and merge it with the deletion buffer.
+        spill_buffer_.clear();
+        insert_heap_.extract_all(spill_buffer_);
+        std::sort(spill_buffer_.begin(), spill_buffer_.end(), cmp_);
+
+        std::vector<key_type> block(block_items_);
+        auto out = block.begin();
+        auto a = spill_buffer_.begin();
+        auto b = delete_buffer_.begin() + delete_pos_;
+        while (a != spill_buffer_.end() || b != delete_buffer_.end()) {
+            if (b == delete_buffer_.end() ||
+                (a != spill_buffer_.end() && cmp_(*a, *b)))
+                *out++ = *a++;
+            else
+                *out++ = *b++;
+            if (out == block.end()) {
+                file.append(block.data(), block_items_);
+                out = block.begin();
+            }
+        }
+        if (out != block.begin())
+            file.append(block.data(),
+                        static_cast<size_t>(out - block.begin()));
+        delete_buffer_.clear();
+        delete_pos_ = 0;
+
+        runs_.emplace_back(
+            new Run(file.release(), file.size(), pool_, block_items_, 0));
+
+        // merge levels which are full, starting at the lowest level.
+        for (size_t level = 0; ; ++level) {
+            size_t count = 0;
+            for (const std::unique_ptr<Run>& r : runs_)
+                count += (r->level() == level);
+            if (count < runs_per_level_) break;
+            merge_level(level);
+        }
+
+        refill();
+    }
+
+    //! Merges all runs of a level into one run of the next level.
+    void merge_level(size_t level) {
+        std::vector<std::unique_ptr<Run> > inputs;
+        for (size_t i = 0; i < runs_.size(); ) {
+            if (runs_[i]->level() == level) {
+                inputs.emplace_back(std::move(runs_[i]));
+                runs_.erase(runs_.begin() + static_cast<std::ptrdiff_t>(i));
+            }
+            else {
+                ++i;
+            }
+        }
+
+        RunWriter file(tmp_dir_);
+        std::vector<key_type> block;
+        block.reserve(block_items_);
+        size_t total = merge_runs(
+            inputs, ~size_t(0),
+            [&](const key_type& key) {
+                block.push_back(key);
+                if (block.size() == block_items_) {
+                    file.append(block.data(), block.size());
+                    block.clear();
+                }
+            });
+        if (!block.empty())
+            file.append(block.data(), block.size());
+        assert(total == file.size());
+        tlx::unused(total);
+
+        runs_.emplace_back(new Run(file.release(), file.size(), pool_,
+                                   block_items_, level + 1));
+    }
+
+    //! Refills the deletion buffer with the smallest block_items items of all
+    //! runs, and drops consumed runs.
+    void refill() {
+        delete_buffer_.clear();
+        delete_pos_ = 0;
+        if (runs_.empty()) return;
+
+        merge_runs(runs_, block_items_,
+                   [this](const key_type& key) {
+                       delete_buffer_.push_back(key);
+                   });
+
+        runs_.erase(
+            std::remove_if(runs_.begin(), runs_.end(),
+                           [](const std::unique_ptr<Run>& r) {
+                               return r->empty();
+                           }),
+            runs_.end());
+    }
+
+    //! Merges at most limit items from the runs with a loser tree and passes
+    //! them to output in ascending order. Returns the number of items.
+    template <typename Output>
+    size_t merge_runs(std::vector<std::unique_ptr<Run> >& runs, size_t limit,
+                      Output output) {
+        using LoserTree = LoserTreeCopy<false, key_type, compare_type>;
+        using Source = typename LoserTree::Source;
+
+        size_t total = 0;
+        for (const std::unique_ptr<Run>& r : runs)
+            total += r->remaining();
+        total = std::min(total, limit);
+        if (total == 0) return 0;
+
+        LoserTree lt(static_cast<Source>(runs.size()), cmp_);
+        for (size_t i = 0; i < runs.size(); ++i) {
+            if (runs[i]->empty())
+                lt.insert_start(nullptr, static_cast<Source>(i), true);
+            else
+                lt.insert_start(&runs[i]->current(),
+                                static_cast<Source>(i), false);
+        }
+        lt.init();
+
+        for (size_t j = 0; j < total; ++j) {
+            Run& r = *runs[lt.min_source()];
+            output(r.current());
+            r.advance();
+            if (r.empty())
+                lt.delete_min_insert(nullptr, true);
+            else
+                lt.delete_min_insert(&r.current(), false);
+        }
+        return total;
+    }
+};
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_CONTAINER_SEQUENCE_HEAP_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,35 @@
+/*******************************************************************************
+ * tlx/define/prefetch.hpp
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_DEFINE_PREFETCH_HEADER
+#define TLX_DEFINE_PREFETCH_HEADER
+
+namespace tlx {
+
+//! \addtogroup tlx_define
+//! \{
+
+/******************************************************************************/
+// __builtin_prefetch
+
+//! Hint the CPU to fetch the cache line at address addr for reading.
+#if defined(__GNUC__) || defined(__clang__)
+#define TLX_PREFETCH(addr) __builtin_prefetch((addr), 0, 3)
+#else
+#define TLX_PREFETCH(addr) ((void)(addr))
+#endif
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_DEFINE_PREFETCH_HEADER
+
+/******************************************************************************/
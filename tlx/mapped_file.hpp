@@ -0,0 +1,142 @@
+/*******************************************************************************
+ * tlx/mapped_file.hpp
+ *
+ * Read-only memory mapping of a whole file, with a fallback to reading the file
+ * into memory on systems without mmap().
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_MAPPED_FILE_HEADER
+#define TLX_MAPPED_FILE_HEADER
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define TLX_MAPPED_FILE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define TLX_MAPPED_FILE_MMAP 0
+#endif
+
+#include <tlx/counting_ptr.hpp>
+
+namespace tlx {
+
+/*!
+ * Read-only view of a whole file. On POSIX systems the file is mapped with
+ * mmap(MAP_SHARED), hence pages are read lazily on first access and the page
+ * cache is shared by all processes mapping the same file. On other systems,
+ * the file is read into a page-aligned memory buffer.
+ *
+ * The start of the data is aligned to page_size bytes. Errors are reported by
+ * throwing std::runtime_error.
+ */
+class MappedFile : public ReferenceCounter
+{
+public:
+    //! Alignment of the data start, and of offsets expected to be aligned.
+    static constexpr size_t page_size = 4096;
+
+    //! Map the file at path.
+    explicit MappedFile(const std::string& path) {
+#if TLX_MAPPED_FILE_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) fail("open", path);
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            fail("fstat", path);
+        }
+        size_ = static_cast<size_t>(st.st_size);
+
+        if (size_ != 0) {
+            void* p = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                fail("mmap", path);
+            }
+            data_ = static_cast<const char*>(p);
+        }
+        ::close(fd);
+#else
+        std::ifstream in(path.c_str(), std::ios::binary | std::ios::ate);
+        if (!in.good()) fail("open", path);
+        size_ = static_cast<size_t>(in.tellg());
+        in.seekg(0);
+
+        buffer_ = static_cast<char*>(::operator new (size_ + page_size - 1));
+        char* data = reinterpret_cast<char*>(
+            (reinterpret_cast<uintptr_t>(buffer_) + page_size - 1)
+            / page_size * page_size);
+        if (!in.read(data, static_cast<std::streamsize>(size_))) {
+            ::operator delete (buffer_);
+            fail("read", path);
+        }
+        data_ = data;
+#endif
+    }
+
+    //! non-copyable: delete copy-constructor
+    MappedFile(const MappedFile&) = delete;
+    //! non-copyable: delete assignment operator
+    MappedFile& operator = (const MappedFile&) = delete;
+
+    //! Unmap the file.
+    ~MappedFile() {
+#if TLX_MAPPED_FILE_MMAP
+        if (data_)
+            ::munmap(const_cast<char*>(data_), size_);
+#else
+        ::operator delete (buffer_);
+#endif
+    }
+
+    //! Start of the file's contents.
+    const char * data() const noexcept { return data_; }
+
+    //! Size of the file in bytes.
+    size_t size() const noexcept { return size_; }
+
+    //! True if the file was mapped with mmap() instead of being read.
+    static constexpr bool is_mapped() { return TLX_MAPPED_FILE_MMAP != 0; }
+
+private:
+    //! start of the mapping
+    const char* data_ = nullptr;
+
+    //! size of the file
+    size_t size_ = 0;
+
+#if !TLX_MAPPED_FILE_MMAP
+    //! unaligned buffer holding the file's contents
+    char* buffer_ = nullptr;
+#endif
+
+    [[noreturn]] static void fail(const char* op, const std::string& path) {
+        throw std::runtime_error(
+            std::string("MappedFile: ") + op + "(" + path + ") failed: " +
+            std::strerror(errno));
+    }
+};
+
+} // namespace tlx
+
+#endif // !TLX_MAPPED_FILE_HEADER
+
+/******************************************************************************/
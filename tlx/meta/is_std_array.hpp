@@ -12,6 +12,8 @@
 #define TLX_META_IS_STD_ARRAY_HEADER
 
 #include <array>
+#include <cstddef>
+#include <type_traits>
 
 namespace tlx {
 
@@ -0,0 +1,334 @@
+/*******************************************************************************
+ * tlx/slab_allocator.hpp
+ *
+ * A pooling allocator which carves small objects out of large slabs and keeps
+ * a free list for each object size, intended for the nodes of tlx::BTree.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_SLAB_ALLOCATOR_HEADER
+#define TLX_SLAB_ALLOCATOR_HEADER
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include <tlx/allocator_base.hpp>
+#include <tlx/counting_ptr.hpp>
+
+namespace tlx {
+
+/*!
+ * Memory pool of a SlabAllocator. Objects of each size are served from a
+ * separate free list, which is refilled from slabs of that size class. Slabs
+ * grow geometrically up to the huge page size, and full-size slabs are aligned
+ * and advised to be backed by transparent huge pages on Linux.
+ *
+ * When the last object is deallocated, e.g. because the container was cleared,
+ * all slabs are returned to the system. The arena is protected by a spin lock,
+ * such that allocators sharing it may be used from multiple threads.
+ */
+class SlabArena : public ReferenceCounter
+{
+public:
+    //! Objects larger than this are allocated with malloc() directly.
+    static constexpr size_t max_object_size = 64 * 1024;
+
+    //! Alignment and granularity of object sizes.
+    static constexpr size_t alignment = 16;
+
+    //! Size of the first slab of each size class.
+    static constexpr size_t min_slab_size = 64 * 1024;
+
+    //! Maximum slab size, which is also the huge page size.
+    static constexpr size_t huge_page_size = 2 * 1024 * 1024;
+
+    SlabArena() noexcept = default;
+
+    //! non-copyable: delete copy-constructor
+    SlabArena(const SlabArena&) = delete;
+    //! non-copyable: delete assignment operator
+    SlabArena& operator = (const SlabArena&) = delete;
+
+    //! Returns all slabs to the system.
+    ~SlabArena() {
+        release_slabs();
+    }
+
+    //! Allocate an object of size bytes.
+    void * allocate(size_t size) {
+        if (size > max_object_size) {
+            void* p = std::malloc(size);
+            if (!p) throw std::bad_alloc();
+            return p;
+        }
+
+        size = round_size(size);
+        LockGuard lock(lock_);
+
+        SizeClass& sc = size_class(size);
+        void* p = sc.free_list;
+        if (p) {
+            sc.free_list = *static_cast<void**>(p);
+        }
+        else {
+            if (sc.slab_end - sc.slab_ptr < static_cast<ptrdiff_t>(size))
+                new_slab(sc);
+            p = sc.slab_ptr;
+            sc.slab_ptr += size;
+        }
+
+        ++live_;
+        return p;
+    }
+
+    //! Return an object of size bytes to its free list. If it was the last
+    //! object, all slabs are released.
+    void deallocate(void* p, size_t size) noexcept {
+        if (size > max_object_size) {
+            std::free(p);
+            return;
+        }
+
+        size = round_size(size);
+        LockGuard lock(lock_);
+
+        SizeClass& sc = size_class(size);
+        *static_cast<void**>(p) = sc.free_list;
+        sc.free_list = p;
+
+        if (--live_ == 0)
+            release_slabs();
+    }
+
+    //! Number of pooled objects currently allocated.
+    size_t live() const noexcept { return live_; }
+
+    //! Number of bytes reserved in slabs.
+    size_t reserved() const noexcept { return reserved_; }
+
+    //! Number of slabs allocated.
+    size_t num_slabs() const noexcept { return slabs_.size(); }
+
+private:
+    //! Free list and current slab of objects with the same size
+    struct SizeClass {
+        //! object size in bytes
+        size_t size;
+        //! singly linked list of freed objects
+        void* free_list;
+        //! unused area of the current slab
+        char* slab_ptr, * slab_end;
+        //! size of the next slab
+        size_t next_slab_size;
+    };
+
+    //! RAII spin lock on the arena
+    class LockGuard
+    {
+    public:
+        explicit LockGuard(std::atomic_flag& flag) : flag_(flag) {
+            while (flag_.test_and_set(std::memory_order_acquire))
+                std::this_thread::yield();
+        }
+        ~LockGuard() { flag_.clear(std::memory_order_release); }
+
+    private:
+        std::atomic_flag& flag_;
+    };
+
+    //! size classes, usually only a few
+    std::vector<SizeClass> classes_;
+
+    //! all slabs with their sizes
+    std::vector<std::pair<char*, size_t> > slabs_;
+
+    //! number of objects allocated
+    size_t live_ = 0;
+
+    //! bytes in slabs
+    size_t reserved_ = 0;
+
+    //! spin lock protecting all fields
+    std::atomic_flag lock_ = ATOMIC_FLAG_INIT;
+
+    static size_t round_size(size_t size) {
+        if (size < sizeof(void*)) size = sizeof(void*);
+        return (size + alignment - 1) / alignment * alignment;
+    }
+
+    //! Find or create the size class of objects with size bytes.
+    SizeClass& size_class(size_t size) {
+        for (SizeClass& sc : classes_) {
+            if (sc.size == size) return sc;
+        }
+        classes_.push_back(
+            SizeClass { size, nullptr, nullptr, nullptr, min_slab_size });
+        return classes_.back();
+    }
+
+    //! Allocate the next slab for a size class, doubling its size up to the
+    //! huge page size.
+    void new_slab(SizeClass& sc) {
+        size_t bytes = sc.next_slab_size;
+        char* slab = static_cast<char*>(allocate_slab(bytes));
+        try {
+            slabs_.emplace_back(slab, bytes);
+        }
+        catch (...) {
+            std::free(slab);
+            throw;
+        }
+        reserved_ += bytes;
+
+        sc.slab_ptr = slab;
+        sc.slab_end = slab + bytes;
+        if (sc.next_slab_size < huge_page_size) sc.next_slab_size *= 2;
+    }
+
+    //! Allocate bytes of memory, full-size slabs are backed by huge pages if
+    //! the system supports it.
+    static void * allocate_slab(size_t bytes) {
+        void* p = nullptr;
+#if defined(__linux__)
+        if (bytes >= huge_page_size) {
+            if (posix_memalign(&p, huge_page_size, bytes) != 0)
+                throw std::bad_alloc();
+#if defined(MADV_HUGEPAGE)
+            // only a hint, ignore failures.
+            madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+            return p;
+        }
+#endif
+        p = std::malloc(bytes);
+        if (!p) throw std::bad_alloc();
+        return p;
+    }
+
+    //! Free all slabs and reset the size classes.
+    void release_slabs() noexcept {
+        for (std::pair<char*, size_t>& s : slabs_)
+            std::free(s.first);
+        slabs_.clear();
+        reserved_ = 0;
+
+        for (SizeClass& sc : classes_) {
+            sc.free_list = nullptr;
+            sc.slab_ptr = sc.slab_end = nullptr;
+            sc.next_slab_size = min_slab_size;
+        }
+    }
+};
+
+/*!
+ * STL allocator taking memory from a SlabArena. Default-constructed allocators
+ * create a new private arena, and copies or rebinds share it. Used as the
+ * Allocator parameter of tlx::btree_map and friends, leaf and inner nodes get
+ * separate free lists, node allocation does not go through malloc(), and all
+ * memory is released when the tree is cleared.
+ *
+ * Only allocations of single objects up to SlabArena::max_object_size are
+ * pooled, hence this allocator does not help vectors or strings.
+ */
+template <typename Type>
+class SlabAllocator : public AllocatorBase<Type>
+{
+public:
+    using value_type = Type;
+    using pointer = Type *;
+    using const_pointer = const Type *;
+    using reference = Type&;
+    using const_reference = const Type&;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    //! C++11 type flag
+    using is_always_equal = std::false_type;
+    //! C++11 type flag
+    using propagate_on_container_copy_assignment = std::true_type;
+    //! C++11 type flag
+    using propagate_on_container_swap = std::true_type;
+
+    static_assert(alignof(Type) <= SlabArena::alignment,
+                  "SlabAllocator cannot align Type");
+
+    //! required rebind.
+    template <typename Other>
+    struct rebind { using other = SlabAllocator<Other>; };
+
+    //! default constructor: creates a new arena
+    SlabAllocator()
+        : arena_(make_counting<SlabArena>()) { }
+
+    //! constructor with explicit arena reference
+    explicit SlabAllocator(const CountingPtr<SlabArena>& arena) noexcept
+        : arena_(arena) { }
+
+    //! constructor from another allocator sharing its arena
+    template <typename Other>
+    SlabAllocator(const SlabAllocator<Other>& other) noexcept
+        : arena_(other.arena_) { }
+
+    //! copy-constructor: default
+    SlabAllocator(const SlabAllocator&) noexcept = default;
+
+#if !defined(_MSC_VER)
+    //! copy-assignment: default
+    SlabAllocator& operator = (const SlabAllocator&) noexcept = default;
+
+    //! move-constructor: default
+    SlabAllocator(SlabAllocator&&) noexcept = default;
+
+    //! move-assignment: default
+    SlabAllocator& operator = (SlabAllocator&&) noexcept = default;
+#endif
+
+    //! allocate method: get memory from arena
+    pointer allocate(size_t n) {
+        return static_cast<Type*>(arena_->allocate(n * sizeof(Type)));
+    }
+
+    //! deallocate method: release to arena
+    void deallocate(pointer p, size_t n) noexcept {
+        arena_->deallocate(p, n * sizeof(Type));
+    }
+
+    //! the shared arena
+    const CountingPtr<SlabArena>& arena() const noexcept { return arena_; }
+
+    template <typename Other>
+    bool operator == (const SlabAllocator<Other>& other) const noexcept {
+        return arena_ == other.arena_;
+    }
+
+    template <typename Other>
+    bool operator != (const SlabAllocator<Other>& other) const noexcept {
+        return !operator == (other);
+    }
+
+    template <typename Other>
+    friend class SlabAllocator;
+
+private:
+    CountingPtr<SlabArena> arena_;
+};
+
+} // namespace tlx
+
+#endif // !TLX_SLAB_ALLOCATOR_HEADER
+
+/******************************************************************************/
@@ -0,0 +1,240 @@
+/*******************************************************************************
+ * tlx/sort/strings/lcp_loser_tree.hpp
+ *
+ * LCP-aware loser tree for merging sorted runs of strings with LCP arrays, and
+ * multiway_lcp_merge() built on it. This is an internal implementation header.
+ *
+ * Based on the LCP loser tree described in
+ *
+ * T. Bingmann, A. Eberle, and P. Sanders. "Engineering Parallel String
+ * Sorting." Algorithmica 77(1), 2017.
+ *
+ * Part of tlx - http://panthema.net/tlx
+ *
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * All rights reserved. Published under the Boost Software License, Version 1.0
+ ******************************************************************************/
+
+#ifndef TLX_SORT_STRINGS_LCP_LOSER_TREE_HEADER
+#define TLX_SORT_STRINGS_LCP_LOSER_TREE_HEADER
+
+#include <tlx/math/round_to_power_of_two.hpp>
+#include <tlx/simple_vector.hpp>
+#include <tlx/sort/strings/string_ptr.hpp>
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace tlx {
+
+//! \addtogroup tlx_sort
+//! \{
+
+namespace sort_strings_detail {
+
+/******************************************************************************/
+
+/*!
+ * Loser tree which merges k sorted runs of strings, given as StringLcpPtr with
+ * their LCP arrays, and outputs the merged strings together with their LCPs.
+ *
+ * Each node stores the loser of its game together with the LCP of the loser
+ * and the winner of the game. When the winner is removed, all losers on the
+ * path from its run to the root hold their LCP relative to the removed string,
+ * and the next string of the run has its LCP relative to it in the run's LCP
+ * array. Two strings are hence first compared by their LCPs, and characters
+ * are only compared beyond the common LCP if both are equal. The LCP of the
+ * new winner with the removed string is the LCP of the output.
+ *
+ * The merge is stable: equal strings are output in the order of their runs.
+ * The input LCP arrays must contain the LCP of each string with its
+ * predecessor in the run, lcp[0] is ignored, as produced by the string sorters
+ * with StringLcpPtr.
+ */
+template <typename StringLcpPtr>
+class LcpLoserTree
+{
+public:
+    typedef typename StringLcpPtr::StringSet StringSet;
+    typedef typename StringLcpPtr::LcpType LcpType;
+    typedef typename StringSet::String String;
+    typedef typename StringSet::CharIterator CharIterator;
+
+    //! Constructs the tree over the runs in [begin, end) and plays the initial
+    //! games, which compare the first strings of all runs.
+    template <typename StringLcpPtrIterator>
+    LcpLoserTree(StringLcpPtrIterator begin, StringLcpPtrIterator end)
+        : ik_(static_cast<size_t>(std::distance(begin, end))),
+          k_(ik_ == 0 ? 1 : round_up_to_power_of_two(ik_)),
+          runs_(begin, end), pos_(ik_, 0), nodes_(k_) {
+        nodes_[0] = init_winner(1);
+    }
+
+    //! non-copyable: delete copy-constructor
+    LcpLoserTree(const LcpLoserTree&) = delete;
+    //! non-copyable: delete assignment operator
+    LcpLoserTree& operator = (const LcpLoserTree&) = delete;
+
+    //! Returns true if all runs are exhausted.
+    bool done() const { return is_done(nodes_[0].source); }
+
+    //! Returns the index of the run holding the smallest string.
+    size_t min_source() const { return nodes_[0].source; }
+
+    //! Returns the smallest string, which remains in its run.
+    String& min_string() const {
+        assert(!done());
+        const Node& w = nodes_[0];
+        const StringSet& ss = runs_[w.source].active();
+        return ss[ss.begin() + pos_[w.source]];
+    }
+
+    //! Returns the LCP of the smallest string with the string removed before
+    //! it, or zero for the first string.
+    LcpType min_lcp() const { return nodes_[0].lcp; }
+
+    //! Removes the smallest string by advancing its run, and replays the games
+    //! on the path from the run to the root. The removed string is not
+    //! compared again, hence it may have been moved out of its run before.
+    void next() {
+        assert(!done());
+        size_t source = nodes_[0].source;
+        Node cand;
+        cand.source = source, cand.lcp = 0;
+        if (++pos_[source] < runs_[source].size())
+            cand.lcp = runs_[source].get_lcp(pos_[source]);
+        else
+            cand.source = invalid_;
+
+        for (size_t idx = (k_ + source) / 2; idx > 0; idx /= 2)
+            play(cand, nodes_[idx]);
+        nodes_[0] = cand;
+    }
+
+private:
+    //! Loser (or winner at node 0) and its LCP with the winner of its game.
+    struct Node {
+        size_t source;
+        LcpType lcp;
+    };
+
+    //! marker for exhausted runs
+    static const size_t invalid_ = static_cast<size_t>(-1);
+
+    //! the number of runs
+    const size_t ik_;
+    //! the number of runs rounded up to a power of two
+    const size_t k_;
+
+    //! the runs to merge
+    std::vector<StringLcpPtr> runs_;
+    //! the current position in each run
+    std::vector<size_t> pos_;
+
+    //! nodes of the tree, node 0 holds the overall winner, the leaf of run i
+    //! is the virtual index k_ + i.
+    SimpleVector<Node> nodes_;
+
+    bool is_done(size_t source) const { return source == invalid_; }
+
+    //! Plays the games of the subtree below root and returns its winner, with
+    //! the LCP of the winner relative to the empty string.
+    Node init_winner(size_t root) {
+        if (root >= k_) {
+            Node leaf;
+            leaf.source = root - k_;
+            leaf.lcp = 0;
+            if (leaf.source >= ik_ || runs_[leaf.source].size() == 0)
+                leaf.source = invalid_;
+            return leaf;
+        }
+        Node winner = init_winner(2 * root);
+        nodes_[root] = init_winner(2 * root + 1);
+        play(winner, nodes_[root]);
+        return winner;
+    }
+
+    /*!
+     * Plays the game of the candidate a, which advances towards the root,
+     * against the loser b stored in a node. Both LCPs are relative to the same
+     * string, which is not greater than either of them. Afterwards, a holds
+     * the winner with its LCP unchanged, and b the loser with its LCP relative
+     * to the winner.
+     */
+    void play(Node& a, Node& b) const {
+        if (is_done(b.source)) return;
+        if (is_done(a.source) || a.lcp < b.lcp) {
+            std::swap(a, b);
+            return;
+        }
+        // a.lcp > b.lcp: a is smaller, and the LCP of b is also its LCP to a.
+        if (a.lcp > b.lcp) return;
+
+        // equal LCPs: compare characters beyond the common prefix.
+        const StringSet& sa = runs_[a.source].active();
+        const StringSet& sb = runs_[b.source].active();
+        const String& s = sa[sa.begin() + pos_[a.source]];
+        const String& t = sb[sb.begin() + pos_[b.source]];
+
+        LcpType h = a.lcp;
+        CharIterator cs = sa.get_chars(s, h), ct = sb.get_chars(t, h);
+        while (!sa.is_end(s, cs) && !sb.is_end(t, ct) && *cs == *ct)
+            ++cs, ++ct, ++h;
+
+        bool b_less;
+        if (sb.is_end(t, ct))
+            // t is a prefix of s, on equality the lower run wins.
+            b_less = !sa.is_end(s, cs) || b.source < a.source;
+        else
+            b_less = !sa.is_end(s, cs) && *ct < *cs;
+
+        if (b_less) std::swap(a, b);
+        b.lcp = h;
+    }
+};
+
+/******************************************************************************/
+
+/*!
+ * Merges the sorted runs [begin, end) of StringLcpPtr with their LCP arrays
+ * into output, which must be large enough to hold all strings, using an
+ * LcpLoserTree. The strings are moved from the runs. Fills the LCP array of
+ * output except for lcp[0], and returns the number of merged strings.
+ */
+template <typename StringLcpPtrIterator, typename OutputPtr>
+static inline
+size_t multiway_lcp_merge(StringLcpPtrIterator begin, StringLcpPtrIterator end,
+                          const OutputPtr& output) {
+    typedef typename std::iterator_traits<StringLcpPtrIterator>::value_type
+        StringLcpPtr;
+    typedef typename OutputPtr::LcpType OutputLcpType;
+
+    LcpLoserTree<StringLcpPtr> tree(begin, end);
+
+    const typename OutputPtr::StringSet& out = output.active();
+    typename OutputPtr::StringSet::Iterator oi = out.begin();
+
+    size_t i = 0;
+    for ( ; !tree.done(); ++i, ++oi) {
+        assert(i < output.size());
+        out[oi] = std::move(tree.min_string());
+        if (i != 0)
+            output.set_lcp(i, static_cast<OutputLcpType>(tree.min_lcp()));
+        tree.next();
+    }
+    return i;
+}
+
+} // namespace sort_strings_detail
+
+//! \}
+
+} // namespace tlx
+
+#endif // !TLX_SORT_STRINGS_LCP_LOSER_TREE_HEADER
+
+/******************************************************************************/
@@ -11,10 +11,13 @@
 #ifndef TLX_THREAD_POOL_HEADER
 #define TLX_THREAD_POOL_HEADER
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include <condition_variable>
 #include <deque>
+#include <exception>
+#include <memory>
 #include <mutex>
 #include <thread>
 
@@ -140,6 +143,72 @@ private:
     void worker();
 };
 
+namespace thread_pool_detail {
+
+//! Shared state of the jobs of run_parallel_jobs().
+struct ParallelJobs {
+    //! next job to claim
+    std::atomic<size_t> next { 0 };
+    //! number of finished jobs, guarded by mutex
+    size_t done = 0;
+    //! first exception thrown by a job, guarded by mutex
+    std::exception_ptr exception;
+    std::mutex mutex;
+    std::condition_variable cv;
+};
+
+} // namespace thread_pool_detail
+
+/*!
+ * Run job(j) for all j in [0,num_jobs) on the threads of pool and on the
+ * calling thread, and wait for these jobs only, not for unrelated jobs of the
+ * pool. The jobs are claimed from a shared counter, hence the caller processes
+ * all remaining jobs itself if the threads of the pool are busy. It may thus be
+ * called from within a job of the same pool. The first exception thrown by a
+ * job is rethrown after all jobs are finished.
+ */
+template <typename Job>
+void run_parallel_jobs(ThreadPool& pool, size_t num_jobs, const Job& job) {
+    using thread_pool_detail::ParallelJobs;
+    std::shared_ptr<ParallelJobs> state = std::make_shared<ParallelJobs>();
+    const Job* jobp = &job;
+
+    // job is only accessed after claiming an index, hence helpers which start
+    // after all jobs are done only touch the shared state.
+    auto work = [state, jobp, num_jobs]() {
+                    size_t j, finished = 0;
+                    std::exception_ptr exception;
+                    while ((j = state->next++) < num_jobs) {
+                        try {
+                            (*jobp)(j);
+                        }
+                        catch (...) {
+                            if (!exception)
+                                exception = std::current_exception();
+                        }
+                        ++finished;
+                    }
+                    if (finished == 0) return;
+                    std::unique_lock<std::mutex> lock(state->mutex);
+                    if (exception && !state->exception)
+                        state->exception = exception;
+                    state->done += finished;
+                    if (state->done == num_jobs) state->cv.notify_one();
+                };
+
+    size_t helpers = std::min(num_jobs - 1, pool.size());
+    for (size_t i = 0; i < helpers; ++i)
+        pool.enqueue(work);
+    work();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&state, num_jobs]() {
+                       return state->done == num_jobs;
+                   });
+    if (state->exception)
+        std::rethrow_exception(state->exception);
+}
+
 } // namespace tlx
 
 #endif // !TLX_THREAD_POOL_HEADER